@@ -0,0 +1,72 @@
+// Inputs the benchmarks share: request frames, in-memory segments and scratch log directories.
+// Log contents come from loggen, the synthetic log directory generator.
+#pragma once
+
+#include "protocol/base/include/codec.hpp"
+#include "records.hpp"
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+namespace bench {
+
+// A complete request frame: size, header v1 or v2 with client id "bench", then `message`
+template <typename Message>
+std::vector<uint8_t> requestFrame(int16_t api_key, int16_t version, const Message &message) {
+  ResponseBuffer buffer;
+  KafkaProtocol::Codec::Writer writer(buffer);
+  writer.skipBytes(4).writeInt16(api_key).writeInt16(version).writeInt32(1);
+  writer.writeString<false>("bench");
+  if (Message::headerVersion(version) >= 2) {
+    writer.writeUnsignedVarint(0);
+  }
+  message.write(writer, version);
+  writer.updateMessageSize();
+  auto bytes = buffer.toVector();
+  return {bytes.begin(), bytes.end()};
+}
+
+// `batches` batches of `records` records of `value_bytes` bytes each, back to back
+inline std::vector<uint8_t> segment(size_t batches, size_t records, size_t value_bytes) {
+  std::vector<uint8_t> value(value_bytes, 'v');
+  loggen::RecordBatchBuilder builder;
+  std::vector<uint8_t> out;
+  for (size_t i = 0; i < batches; i++) {
+    for (size_t r = 0; r < records; r++) {
+      builder.add(value);
+    }
+    builder.finish(static_cast<int64_t>(i * records), out);
+  }
+  return out;
+}
+
+// A scratch log directory, removed with everything in it when the benchmark is done
+class LogDir {
+public:
+  explicit LogDir(const std::string &name)
+      : path_(std::filesystem::temp_directory_path() /
+              ("kafka_bench_" + name + "_" + std::to_string(::getpid()))) {
+    std::filesystem::remove_all(path_);
+  }
+  ~LogDir() { std::filesystem::remove_all(path_); }
+  LogDir(const LogDir &) = delete;
+  LogDir &operator=(const LogDir &) = delete;
+
+  // Write `bytes` to `file`, a path inside this directory
+  static void write(const std::filesystem::path &file, const std::vector<uint8_t> &bytes) {
+    std::filesystem::create_directories(file.parent_path());
+    std::ofstream out(file, std::ios::binary | std::ios::trunc);
+    out.write(reinterpret_cast<const char *>(bytes.data()),
+              static_cast<std::streamsize>(bytes.size()));
+  }
+
+  [[nodiscard]] std::string path() const { return path_.string(); }
+
+private:
+  std::filesystem::path path_;
+};
+
+} // namespace bench
@@ -0,0 +1,168 @@
+// Request-sized tasks through the work-stealing ThreadPool against the mutex/condvar queue it
+// replaced. Most iterations enqueue a burst of tasks and wait for all of them to run; the latency
+// benchmark times single tasks instead.
+#include "thread_pool.hpp"
+#include <atomic>
+#include <benchmark/benchmark.h>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// The pool as it was: one std::function queue behind one mutex, notify_one per task
+class MutexThreadPool {
+public:
+  explicit MutexThreadPool(size_t threads) {
+    for (size_t i = 0; i < threads; ++i) {
+      workers.emplace_back([this] {
+        while (true) {
+          std::function<void()> task;
+          {
+            std::unique_lock lock(queue_mutex);
+            condition.wait(lock, [this] { return stop || !tasks.empty(); });
+            if (stop && tasks.empty())
+              return;
+            task = std::move(tasks.front());
+            tasks.pop();
+          }
+          task();
+        }
+      });
+    }
+  }
+
+  ~MutexThreadPool() {
+    {
+      std::unique_lock lock(queue_mutex);
+      stop = true;
+    }
+    condition.notify_all();
+    for (auto &w : workers) {
+      w.join();
+    }
+  }
+
+  void enqueue(std::function<void()> task) {
+    {
+      std::unique_lock lock(queue_mutex);
+      tasks.push(std::move(task));
+    }
+    condition.notify_one();
+  }
+
+private:
+  std::vector<std::thread> workers;
+  std::queue<std::function<void()>> tasks;
+  std::mutex queue_mutex;
+  std::condition_variable condition;
+  bool stop {false};
+};
+
+constexpr int64_t BURST = 10000;
+constexpr size_t WORKERS = 4;
+
+// Stands in for the request batch a real task captures alongside the server pointer
+struct Batch {
+  std::atomic<int64_t> *done;
+};
+
+void waitFor(const std::atomic<int64_t> &done, int64_t expected) {
+  while (done.load(std::memory_order_acquire) < expected) {
+    std::this_thread::yield();
+  }
+}
+
+template <typename Pool> void BM_EnqueueBurst(benchmark::State &state) {
+  Pool pool(WORKERS);
+  std::atomic<int64_t> done {0};
+  auto batch = std::make_shared<Batch>(Batch {&done});
+  int64_t expected = 0;
+  for (auto _ : state) {
+    for (int64_t i = 0; i < BURST; i++) {
+      pool.enqueue([batch, server = &pool] {
+        benchmark::DoNotOptimize(server);
+        batch->done->fetch_add(1, std::memory_order_release);
+      });
+    }
+    expected += BURST;
+    waitFor(done, expected);
+  }
+  state.SetItemsProcessed(state.iterations() * BURST);
+}
+
+template <typename Pool> void BM_ManyProducers(benchmark::State &state) {
+  auto producers = static_cast<int64_t>(state.range(0));
+  Pool pool(WORKERS);
+  std::atomic<int64_t> done {0};
+  int64_t expected = 0;
+  for (auto _ : state) {
+    std::vector<std::thread> threads;
+    for (int64_t p = 0; p < producers; p++) {
+      threads.emplace_back([&] {
+        for (int64_t i = 0; i < BURST / producers; i++) {
+          pool.enqueue([&done] { done.fetch_add(1, std::memory_order_release); });
+        }
+      });
+    }
+    for (auto &thread : threads) {
+      thread.join();
+    }
+    expected += BURST / producers * producers;
+    waitFor(done, expected);
+  }
+  state.SetItemsProcessed(state.iterations() * (BURST / producers * producers));
+}
+
+// Tasks enqueued from inside the pool, as purgatory completions are
+template <typename Pool> void BM_FanOut(benchmark::State &state) {
+  Pool pool(WORKERS);
+  std::atomic<int64_t> done {0};
+  int64_t expected = 0;
+  for (auto _ : state) {
+    pool.enqueue([&] {
+      for (int64_t i = 0; i < BURST; i++) {
+        pool.enqueue([&done] { done.fetch_add(1, std::memory_order_release); });
+      }
+    });
+    expected += BURST;
+    waitFor(done, expected);
+  }
+  state.SetItemsProcessed(state.iterations() * BURST);
+}
+
+// Time from enqueue until the task starts running on an otherwise idle pool, i.e. the wake-up
+// cost a lone request pays
+template <typename Pool> void BM_EnqueueLatency(benchmark::State &state) {
+  Pool pool(WORKERS);
+  std::atomic<int64_t> started {0};
+  for (auto _ : state) {
+    auto enqueued = std::chrono::steady_clock::now();
+    pool.enqueue([&started] {
+      started.store(std::chrono::steady_clock::now().time_since_epoch().count(),
+                    std::memory_order_release);
+    });
+    int64_t ran;
+    while ((ran = started.exchange(0, std::memory_order_acquire)) == 0) {
+      std::this_thread::yield();
+    }
+    auto latency = std::chrono::steady_clock::duration(ran) - enqueued.time_since_epoch();
+    state.SetIterationTime(std::chrono::duration<double>(latency).count());
+  }
+}
+
+} // namespace
+
+BENCHMARK(BM_EnqueueLatency<MutexThreadPool>)->UseManualTime();
+BENCHMARK(BM_EnqueueLatency<ThreadPool>)->UseManualTime();
+BENCHMARK(BM_EnqueueBurst<MutexThreadPool>)->UseRealTime();
+BENCHMARK(BM_EnqueueBurst<ThreadPool>)->UseRealTime();
+BENCHMARK(BM_ManyProducers<MutexThreadPool>)->Arg(1)->Arg(4)->UseRealTime();
+BENCHMARK(BM_ManyProducers<ThreadPool>)->Arg(1)->Arg(4)->UseRealTime();
+BENCHMARK(BM_FanOut<MutexThreadPool>)->UseRealTime();
+BENCHMARK(BM_FanOut<ThreadPool>)->UseRealTime();
@@ -0,0 +1,120 @@
+// Latency histogram with HdrHistogram's bucket layout: values up to `highest` are kept to 3
+// significant decimal digits in a fixed array, so recording is a couple of shifts and an
+// increment, and histograms from several threads merge by adding counts.
+#pragma once
+
+#include "hdr_buckets.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+namespace bench {
+
+class HdrHistogram {
+public:
+  // Values from 1 to `highest`; larger ones are clamped to it
+  explicit HdrHistogram(int64_t highest = 60'000'000'000)
+      : highest_(highest), counts_(Buckets::countFor(static_cast<uint64_t>(highest)), 0) {}
+
+  void record(int64_t value, int64_t count = 1) {
+    value = std::clamp<int64_t>(value, 0, highest_);
+    counts_[indexOf(static_cast<uint64_t>(value))] += count;
+    total_ += count;
+    max_ = std::max(max_, value);
+    min_ = std::min(min_, value);
+    sum_ += static_cast<double>(value) * static_cast<double>(count);
+    sum_squares_ += static_cast<double>(value) * static_cast<double>(value) *
+                    static_cast<double>(count);
+  }
+
+  void merge(const HdrHistogram &other) {
+    for (size_t i = 0; i < counts_.size() && i < other.counts_.size(); i++) {
+      counts_[i] += other.counts_[i];
+    }
+    total_ += other.total_;
+    max_ = std::max(max_, other.max_);
+    min_ = std::min(min_, other.min_);
+    sum_ += other.sum_;
+    sum_squares_ += other.sum_squares_;
+  }
+
+  // Smallest recorded value that `percentile` percent of all values are at or below, as the
+  // highest value its bucket can hold
+  [[nodiscard]] int64_t valueAt(double percentile) const {
+    if (total_ == 0) {
+      return 0;
+    }
+    auto wanted = static_cast<int64_t>(percentile / 100.0 * static_cast<double>(total_) + 0.5);
+    wanted = std::clamp<int64_t>(wanted, 1, total_);
+    int64_t seen = 0;
+    for (size_t i = 0; i < counts_.size(); i++) {
+      seen += counts_[i];
+      if (seen >= wanted) {
+        return std::min(highestEquivalent(i), max_);
+      }
+    }
+    return max_;
+  }
+
+  [[nodiscard]] int64_t count() const { return total_; }
+  [[nodiscard]] int64_t max() const { return max_; }
+  [[nodiscard]] int64_t min() const { return total_ ? min_ : 0; }
+  [[nodiscard]] double mean() const { return total_ ? sum_ / static_cast<double>(total_) : 0; }
+  [[nodiscard]] double stddev() const {
+    double m = mean();
+    return total_ ? std::sqrt(std::max(0.0, sum_squares_ / static_cast<double>(total_) - m * m))
+                  : 0;
+  }
+
+  // Percentile distribution in HdrHistogram's .hgrm text format, which its plotting tools read.
+  // Values are divided by `scale` (1000 for microseconds from nanoseconds).
+  void writePercentiles(std::FILE *out, double scale) const {
+    std::fprintf(out, "%12s %14s %10s %14s\n\n", "Value", "Percentile", "TotalCount",
+                 "1/(1-Percentile)");
+    int64_t seen = 0;
+    double next = 0;
+    for (size_t i = 0; i < counts_.size() && seen < total_; i++) {
+      if (counts_[i] == 0) {
+        continue;
+      }
+      seen += counts_[i];
+      double percentile = static_cast<double>(seen) / static_cast<double>(total_);
+      // Ticks get closer together towards the tail: each closes a fifth of the gap to 100%
+      if (percentile < next && seen < total_) {
+        continue;
+      }
+      double value = static_cast<double>(std::min(highestEquivalent(i), max_)) / scale;
+      if (seen < total_) {
+        std::fprintf(out, "%12.3f %2.12f %10lld %14.2f\n", value, percentile,
+                     static_cast<long long>(seen), 1 / (1 - percentile));
+      } else {
+        std::fprintf(out, "%12.3f %2.12f %10lld\n", value, 1.0, static_cast<long long>(seen));
+      }
+      double left = 1 - percentile;
+      next = percentile + left / 5;
+    }
+    std::fprintf(out, "#[Mean    = %12.3f, StdDeviation   = %12.3f]\n", mean() / scale,
+                 stddev() / scale);
+    std::fprintf(out, "#[Max     = %12.3f, Total count    = %12lld]\n",
+                 static_cast<double>(max_) / scale, static_cast<long long>(total_));
+  }
+
+private:
+  static constexpr int SIGNIFICANT_BITS = 11; // 2048 sub-buckets: 3 decimal digits
+  using Buckets = common::HdrBuckets<SIGNIFICANT_BITS>;
+
+  static size_t indexOf(uint64_t value) { return Buckets::indexOf(value); }
+  static int64_t highestEquivalent(size_t index) { return Buckets::highestEquivalent(index); }
+
+  int64_t highest_;
+  std::vector<int64_t> counts_;
+  int64_t total_ {0};
+  int64_t max_ {0};
+  int64_t min_ {INT64_MAX};
+  double sum_ {0};
+  double sum_squares_ {0};
+};
+
+} // namespace bench
@@ -0,0 +1,471 @@
+// End-to-end load against an in-process KafkaServer. Many pipelined connections send a weighted
+// mix of ApiVersions, DescribeTopicPartitions and Fetch requests over loopback to a server
+// reading a generated log directory. The latency of every response, from its request being
+// written to the response being read in full, goes into an HDR histogram per API.
+//
+//   kafka_loadgen [--connections 64] [--pipeline 8] [--threads 4] [--duration 10] [--warmup 2]
+//                 [--mix api_versions=1,describe=1,fetch=8] [--topics 4] [--partitions 4]
+//                 [--batches 100] [--fetch-bytes 65536] [--io auto|readiness|io_uring]
+//                 [--port 19092] [--histograms DIR]
+//
+// --histograms writes each API's percentile distribution, in microseconds, as DIR/<api>.hgrm.
+#include "bench_data.hpp"
+#include "hdr_histogram.hpp"
+#include "kafka_server.hpp"
+#include "log_generator.hpp"
+#include "storage/include/storage_service.hpp"
+#include <arpa/inet.h>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <iostream>
+#include <map>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <sys/socket.h>
+#include <thread>
+#include <vector>
+
+namespace KP = KafkaProtocol;
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+enum Api : size_t { API_VERSIONS, DESCRIBE, FETCH, API_COUNT };
+constexpr std::array<const char *, API_COUNT> API_NAMES {"ApiVersions",
+                                                         "DescribeTopicPartitions", "Fetch"};
+
+struct Options {
+  size_t connections {64};
+  size_t pipeline {8};
+  size_t threads {4};
+  double duration {10};
+  double warmup {2};
+  std::array<double, API_COUNT> mix {1, 1, 8};
+  size_t topics {4};
+  size_t partitions {4};
+  size_t batches {100};
+  int32_t fetch_bytes {64 * 1024};
+  IoBackend::Kind io {IoBackend::Kind::Auto};
+  uint16_t port {19092};
+  std::string histograms;
+};
+
+std::array<double, API_COUNT> parseMix(const std::string &spec) {
+  std::array<double, API_COUNT> mix {};
+  std::stringstream entries(spec);
+  std::string entry;
+  while (std::getline(entries, entry, ',')) {
+    auto equals = entry.find('=');
+    if (equals == std::string::npos) {
+      throw std::invalid_argument("bad --mix entry: " + entry);
+    }
+    std::string name = entry.substr(0, equals);
+    double weight = std::stod(entry.substr(equals + 1));
+    if (name == "api_versions") {
+      mix[API_VERSIONS] = weight;
+    } else if (name == "describe") {
+      mix[DESCRIBE] = weight;
+    } else if (name == "fetch") {
+      mix[FETCH] = weight;
+    } else {
+      throw std::invalid_argument("unknown API in --mix: " + name);
+    }
+  }
+  return mix;
+}
+
+Options parseOptions(int argc, char **argv) {
+  Options options;
+  for (int i = 1; i < argc; i += 2) {
+    std::string flag = argv[i];
+    if (i + 1 >= argc) {
+      throw std::invalid_argument("missing value for " + flag);
+    }
+    std::string value = argv[i + 1];
+    if (flag == "--connections") {
+      options.connections = std::stoul(value);
+    } else if (flag == "--pipeline") {
+      options.pipeline = std::stoul(value);
+    } else if (flag == "--threads") {
+      options.threads = std::stoul(value);
+    } else if (flag == "--duration") {
+      options.duration = std::stod(value);
+    } else if (flag == "--warmup") {
+      options.warmup = std::stod(value);
+    } else if (flag == "--mix") {
+      options.mix = parseMix(value);
+    } else if (flag == "--topics") {
+      options.topics = std::stoul(value);
+    } else if (flag == "--partitions") {
+      options.partitions = std::stoul(value);
+    } else if (flag == "--batches") {
+      options.batches = std::stoul(value);
+    } else if (flag == "--fetch-bytes") {
+      options.fetch_bytes = std::stoi(value);
+    } else if (flag == "--io") {
+      static const std::map<std::string, IoBackend::Kind> kinds {
+          {"auto", IoBackend::Kind::Auto},
+          {"readiness", IoBackend::Kind::Readiness},
+          {"io_uring", IoBackend::Kind::IoUring}};
+      auto kind = kinds.find(value);
+      if (kind == kinds.end()) {
+        throw std::invalid_argument("unknown --io backend: " + value);
+      }
+      options.io = kind->second;
+    } else if (flag == "--port") {
+      options.port = static_cast<uint16_t>(std::stoul(value));
+    } else if (flag == "--histograms") {
+      options.histograms = value;
+    } else {
+      throw std::invalid_argument("unknown option: " + flag);
+    }
+  }
+  if (options.connections == 0 || options.pipeline == 0 || options.threads == 0 ||
+      options.topics == 0 || options.partitions == 0) {
+    throw std::invalid_argument("counts must be positive");
+  }
+  return options;
+}
+
+// Topics "topic-<n>", each partition holding `batches` batches of ten 100-byte records
+std::vector<storage::TopicInfo> writeLogs(const bench::LogDir &dir, const Options &options) {
+  loggen::LogDirSpec spec;
+  spec.topics = options.topics;
+  spec.partitions = static_cast<int32_t>(options.partitions);
+  spec.records_per_partition = options.batches * 10;
+  auto written = loggen::generateLogDir(dir.path(), spec);
+  if (!written) {
+    throw written.error();
+  }
+  return loggen::topicsFor(spec);
+}
+
+// Request frames per API; a connection sends a copy with its own correlation id
+using Frames = std::array<std::vector<std::vector<uint8_t>>, API_COUNT>;
+
+Frames buildFrames(const Options &options, const std::vector<storage::TopicInfo> &topics) {
+  Frames frames;
+
+  ApiVersionRequest versions;
+  versions.client_software_name = "kafka-loadgen";
+  versions.client_software_version = "1.0";
+  frames[API_VERSIONS].push_back(bench::requestFrame(KP::API_VERSIONS, 4, versions));
+
+  DescribeTopicsRequest describe;
+  for (const auto &topic : topics) {
+    describe.topics.emplace_back().name = topic.name;
+  }
+  frames[DESCRIBE].push_back(bench::requestFrame(KP::DESCRIBE_TOPIC_PARTITIONS, 0, describe));
+
+  // One sessionless fetch per topic, of all its partitions from the start of the log
+  for (const auto &topic_info : topics) {
+    FetchRequest fetch;
+    fetch.max_bytes = options.fetch_bytes * static_cast<int32_t>(options.partitions);
+    auto &topic = fetch.topics.emplace_back();
+    topic.topic_id = topic_info.topic_id.value;
+    for (size_t p = 0; p < options.partitions; p++) {
+      auto &partition = topic.partitions.emplace_back();
+      partition.partition = static_cast<int32_t>(p);
+      partition.partition_max_bytes = options.fetch_bytes;
+    }
+    frames[FETCH].push_back(bench::requestFrame(KP::FETCH, 16, fetch));
+  }
+  return frames;
+}
+
+SocketFd connectTo(uint16_t port) {
+  auto socket = SocketFd::create();
+  sockaddr_in addr {};
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  addr.sin_port = htons(port);
+  if (::connect(socket.get(), reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) < 0) {
+    return {};
+  }
+  int one = 1;
+  setsockopt(socket.get(), IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+  return socket;
+}
+
+struct Stats {
+  std::array<bench::HdrHistogram, API_COUNT> latency;
+  std::array<uint64_t, API_COUNT> bytes {};
+  uint64_t errors {0};
+};
+
+// Shared between the client threads and main, which flips them as the run goes on
+struct Run {
+  std::atomic<bool> recording {false};
+  std::atomic<bool> stopping {false};
+};
+
+// Keeps `pipeline` requests in flight on each of its connections until the run stops
+class Client {
+public:
+  Client(const Options &options, const Frames &frames, Run &run, uint32_t seed)
+      : options_(options), frames_(frames), run_(run), random_(seed),
+        pick_(options.mix.begin(), options.mix.end()) {}
+
+  void connect(size_t connections) {
+    for (size_t i = 0; i < connections; i++) {
+      auto socket = connectTo(options_.port);
+      if (!socket.valid()) {
+        throw std::runtime_error("cannot connect to the server");
+      }
+      connections_.emplace_back().socket = std::move(socket);
+    }
+  }
+
+  void run() {
+    for (auto &connection : connections_) {
+      for (size_t i = 0; i < options_.pipeline; i++) {
+        send(connection);
+      }
+    }
+    std::vector<pollfd> fds;
+    for (auto &connection : connections_) {
+      fds.push_back({connection.socket.get(), POLLIN, 0});
+    }
+    while (!run_.stopping.load(std::memory_order_relaxed)) {
+      if (poll(fds.data(), fds.size(), 100) < 0) {
+        throw std::runtime_error("poll failed");
+      }
+      for (size_t i = 0; i < fds.size(); i++) {
+        if (fds[i].revents & (POLLIN | POLLERR | POLLHUP)) {
+          receive(connections_[i]);
+        }
+      }
+    }
+  }
+
+  [[nodiscard]] const Stats &stats() const { return stats_; }
+
+private:
+  struct InFlight {
+    Api api;
+    int32_t correlation_id;
+    Clock::time_point sent;
+  };
+
+  struct Connection {
+    SocketFd socket;
+    std::vector<uint8_t> in = std::vector<uint8_t>(64 * 1024);
+    size_t filled {0};
+    std::deque<InFlight> in_flight;
+    int32_t next_correlation_id {0};
+    std::vector<uint8_t> out;
+  };
+
+  void send(Connection &connection) {
+    auto api = static_cast<Api>(pick_(random_));
+    const auto &variants = frames_[api];
+    connection.out = variants[random_() % variants.size()];
+    int32_t correlation_id = connection.next_correlation_id++;
+    uint32_t be = htonl(static_cast<uint32_t>(correlation_id));
+    std::memcpy(connection.out.data() + 8, &be, sizeof(be));
+
+    connection.in_flight.push_back({api, correlation_id, Clock::now()});
+    size_t sent = 0;
+    while (sent < connection.out.size()) {
+      ssize_t n = ::send(connection.socket.get(), connection.out.data() + sent,
+                         connection.out.size() - sent, MSG_NOSIGNAL);
+      if (n <= 0) {
+        throw std::runtime_error("send failed");
+      }
+      sent += static_cast<size_t>(n);
+    }
+  }
+
+  void receive(Connection &connection) {
+    if (connection.filled == connection.in.size()) {
+      connection.in.resize(connection.in.size() * 2);
+    }
+    ssize_t n = ::recv(connection.socket.get(), connection.in.data() + connection.filled,
+                       connection.in.size() - connection.filled, MSG_DONTWAIT);
+    if (n == 0) {
+      throw std::runtime_error("server closed a connection");
+    }
+    if (n < 0) {
+      return; // nothing after all
+    }
+    connection.filled += static_cast<size_t>(n);
+
+    size_t consumed = 0;
+    while (connection.filled - consumed >= 8) {
+      const uint8_t *frame = connection.in.data() + consumed;
+      uint32_t size;
+      std::memcpy(&size, frame, sizeof(size));
+      size = ntohl(size);
+      if (connection.filled - consumed < 4 + size) {
+        if (connection.in.size() < 4 + size) {
+          connection.in.resize(4 + size);
+        }
+        break;
+      }
+      auto now = Clock::now();
+      InFlight request = connection.in_flight.front();
+      connection.in_flight.pop_front();
+
+      uint32_t correlation_id;
+      std::memcpy(&correlation_id, frame + 4, sizeof(correlation_id));
+      if (run_.recording.load(std::memory_order_relaxed)) {
+        if (static_cast<int32_t>(ntohl(correlation_id)) != request.correlation_id) {
+          stats_.errors++;
+        }
+        stats_.latency[request.api].record(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(now - request.sent).count());
+        stats_.bytes[request.api] += 4 + size;
+      }
+      consumed += 4 + size;
+      if (!run_.stopping.load(std::memory_order_relaxed)) {
+        send(connection);
+      }
+    }
+    std::memmove(connection.in.data(), connection.in.data() + consumed,
+                 connection.filled - consumed);
+    connection.filled -= consumed;
+  }
+
+  const Options &options_;
+  const Frames &frames_;
+  Run &run_;
+  std::mt19937 random_;
+  std::discrete_distribution<size_t> pick_;
+  std::vector<Connection> connections_;
+  Stats stats_;
+};
+
+void printRow(const char *name, const bench::HdrHistogram &latency, uint64_t bytes,
+              double seconds) {
+  auto micros = [&](double percentile) {
+    return static_cast<double>(latency.valueAt(percentile)) / 1000.0;
+  };
+  std::printf("%-24s %10lld %11.0f %9.1f %9.1f %9.1f %9.1f %9.1f %9.1f\n", name,
+              static_cast<long long>(latency.count()),
+              static_cast<double>(latency.count()) / seconds,
+              static_cast<double>(bytes) / seconds / (1024 * 1024), micros(50), micros(90),
+              micros(99), micros(99.9), static_cast<double>(latency.max()) / 1000.0);
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  Options options;
+  try {
+    options = parseOptions(argc, argv);
+  } catch (const std::exception &e) {
+    std::cerr << "kafka_loadgen: " << e.what() << std::endl;
+    return 2;
+  }
+
+  bench::LogDir dir("loadgen");
+  std::vector<storage::TopicInfo> topics;
+  try {
+    topics = writeLogs(dir, options);
+  } catch (const std::exception &e) {
+    std::cerr << "kafka_loadgen: " << e.what() << std::endl;
+    return 1;
+  }
+  auto frames = buildFrames(options, topics);
+
+  KafkaServer server(options.port, storage::createStorageService(dir.path()), options.io);
+  std::thread server_thread([&server] { server.start(); });
+  // Wait for the listener
+  for (int attempt = 0; !connectTo(options.port).valid(); attempt++) {
+    if (attempt == 100) {
+      std::cerr << "kafka_loadgen: server did not start listening" << std::endl;
+      server.stop();
+      server_thread.join();
+      return 1;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  }
+
+  Run run;
+  std::vector<std::unique_ptr<Client>> clients;
+  size_t threads = std::min(options.threads, options.connections);
+  for (size_t t = 0; t < threads; t++) {
+    clients.push_back(
+        std::make_unique<Client>(options, frames, run, static_cast<uint32_t>(t + 1)));
+    clients.back()->connect(options.connections / threads +
+                            (t < options.connections % threads ? 1 : 0));
+  }
+
+  std::atomic<bool> failed {false};
+  std::vector<std::thread> workers;
+  for (auto &client : clients) {
+    workers.emplace_back([&client, &run, &failed] {
+      try {
+        client->run();
+      } catch (const std::exception &e) {
+        std::cerr << "kafka_loadgen: " << e.what() << std::endl;
+        failed = true;
+        run.stopping = true;
+      }
+    });
+  }
+
+  std::this_thread::sleep_for(std::chrono::duration<double>(options.warmup));
+  run.recording = true;
+  auto started = Clock::now();
+  std::this_thread::sleep_for(std::chrono::duration<double>(options.duration));
+  run.recording = false;
+  double seconds = std::chrono::duration<double>(Clock::now() - started).count();
+  run.stopping = true;
+  for (auto &worker : workers) {
+    worker.join();
+  }
+
+  Stats total;
+  for (const auto &client : clients) {
+    for (size_t api = 0; api < API_COUNT; api++) {
+      total.latency[api].merge(client->stats().latency[api]);
+      total.bytes[api] += client->stats().bytes[api];
+    }
+    total.errors += client->stats().errors;
+  }
+  clients.clear(); // closes the connections before the server goes away
+  server.stop();
+  server_thread.join();
+
+  std::printf("%zu connections x %zu in flight, %zu client threads, %.1f s\n\n",
+              options.connections, options.pipeline, threads, seconds);
+  std::printf("%-24s %10s %11s %9s %9s %9s %9s %9s %9s\n", "api", "responses", "per second",
+              "MiB/s", "p50 us", "p90 us", "p99 us", "p99.9 us", "max us");
+  bench::HdrHistogram all;
+  uint64_t all_bytes = 0;
+  for (size_t api = 0; api < API_COUNT; api++) {
+    if (total.latency[api].count() == 0) {
+      continue;
+    }
+    printRow(API_NAMES[api], total.latency[api], total.bytes[api], seconds);
+    all.merge(total.latency[api]);
+    all_bytes += total.bytes[api];
+  }
+  printRow("all", all, all_bytes, seconds);
+  if (total.errors > 0) {
+    std::printf("\n%llu responses out of order\n", static_cast<unsigned long long>(total.errors));
+  }
+
+  if (!options.histograms.empty()) {
+    std::filesystem::create_directories(options.histograms);
+    for (size_t api = 0; api < API_COUNT; api++) {
+      auto path =
+          std::filesystem::path(options.histograms) / (std::string(API_NAMES[api]) + ".hgrm");
+      if (std::FILE *out = std::fopen(path.c_str(), "w")) {
+        total.latency[api].writePercentiles(out, 1000.0);
+        std::fclose(out);
+      }
+    }
+  }
+  return failed || total.errors > 0 ? 1 : 0;
+}
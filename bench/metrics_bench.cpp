@@ -0,0 +1,71 @@
+// Cost of recording a metric on the request path: a sharded counter add and a latency histogram
+// record, from one thread and from several at once, a full scrape of a server-sized registry, and
+// a trace span with tracing off and on.
+#include "counter.hpp"
+#include "latency_histogram.hpp"
+#include "registry.hpp"
+#include "trace.hpp"
+#include <benchmark/benchmark.h>
+
+namespace {
+
+void BM_CounterAdd(benchmark::State &state) {
+  static metrics::Counter counter;
+  for (auto _ : state) {
+    counter.add();
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+void BM_HistogramRecord(benchmark::State &state) {
+  static metrics::LatencyHistogram histogram;
+  int64_t value = 1000 + state.thread_index() * 7919;
+  for (auto _ : state) {
+    histogram.record(value);
+    value = (value * 31 + 17) & 0xfffffff; // spread over buckets up to about 270 ms
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+// Four APIs with three counters and three histograms each, as the server registers them
+void BM_Exposition(benchmark::State &state) {
+  metrics::Registry registry;
+  for (const char *api : {"Produce", "Fetch", "ApiVersions", "DescribeTopicPartitions"}) {
+    metrics::Labels labels {{"api", api}};
+    for (const char *name : {"requests_total", "request_bytes_total", "response_bytes_total"}) {
+      registry.counter(name, "help", labels).add(12345);
+    }
+    for (const char *name : {"parse_seconds", "handler_seconds", "send_seconds"}) {
+      auto &histogram = registry.histogram(name, "help", labels);
+      for (int64_t value = 100; value < 100'000'000; value *= 3) {
+        histogram.record(value);
+      }
+    }
+  }
+  for (auto _ : state) {
+    auto text = registry.exposition();
+    benchmark::DoNotOptimize(text);
+  }
+}
+
+// Argument 1 enables tracing
+void BM_TraceSpan(benchmark::State &state) {
+  if (state.thread_index() == 0 && state.range(0) != 0) {
+    common::trace::enable();
+  }
+  for (auto _ : state) {
+    common::trace::Span span("bench");
+  }
+  state.SetItemsProcessed(state.iterations());
+  if (state.thread_index() == 0) {
+    common::trace::disable();
+    common::trace::clear();
+  }
+}
+
+} // namespace
+
+BENCHMARK(BM_CounterAdd)->Threads(1)->Threads(4);
+BENCHMARK(BM_HistogramRecord)->Threads(1)->Threads(4);
+BENCHMARK(BM_Exposition);
+BENCHMARK(BM_TraceSpan)->Arg(0)->Arg(1)->Threads(1)->Threads(4);
@@ -0,0 +1,131 @@
+// Request parsing per API and response encoding, the per-request protocol work a broker thread
+// does around each storage call.
+#include "bench_data.hpp"
+#include "protocol/api_versions/include/api_versions_request.hpp"
+#include "protocol/base/include/api_keys.hpp"
+#include "protocol/describe_topic_partitions/include/describe_topic_partitions_request.hpp"
+#include "protocol/describe_topic_partitions/include/describe_topic_partitions_response.hpp"
+#include "protocol/fetch/include/fetch_request.hpp"
+#include "protocol/fetch/include/fetch_response.hpp"
+#include "protocol/parser/include/kafka_parser.hpp"
+#include "protocol/produce/include/produce_request.hpp"
+#include <array>
+#include <benchmark/benchmark.h>
+#include <memory_resource>
+#include <string>
+#include <vector>
+
+namespace KP = KafkaProtocol;
+
+namespace {
+
+// Decodes into an arena released after every request, as the server does
+void parseLoop(benchmark::State &state, const std::vector<uint8_t> &frame) {
+  std::array<std::byte, 8192> buffer;
+  std::pmr::monotonic_buffer_resource arena(buffer.data(), buffer.size());
+  for (auto _ : state) {
+    arena.release();
+    auto request = Parser::parse(frame.data(), frame.size(), &arena);
+    benchmark::DoNotOptimize(request);
+  }
+  state.SetItemsProcessed(state.iterations());
+  state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(frame.size()));
+}
+
+void BM_ParseApiVersions(benchmark::State &state) {
+  ApiVersionRequest request;
+  request.client_software_name = "kafka-bench";
+  request.client_software_version = "1.0";
+  parseLoop(state, bench::requestFrame(KP::API_VERSIONS, 4, request));
+}
+
+// range(0) topics
+void BM_ParseDescribeTopicPartitions(benchmark::State &state) {
+  // Request strings are views, so the names must outlive the request
+  std::vector<std::string> names;
+  for (int64_t t = 0; t < state.range(0); t++) {
+    names.push_back("topic-" + std::to_string(t));
+  }
+  DescribeTopicsRequest request;
+  for (const auto &name : names) {
+    request.topics.emplace_back().name = name;
+  }
+  parseLoop(state, bench::requestFrame(KP::DESCRIBE_TOPIC_PARTITIONS, 0, request));
+}
+
+// One topic with range(0) partitions
+void BM_ParseFetch(benchmark::State &state) {
+  FetchRequest request;
+  auto &topic = request.topics.emplace_back();
+  topic.topic_id = 1;
+  for (int64_t p = 0; p < state.range(0); p++) {
+    auto &partition = topic.partitions.emplace_back();
+    partition.partition = static_cast<int32_t>(p);
+    partition.fetch_offset = 1000;
+    partition.partition_max_bytes = 1 << 20;
+  }
+  parseLoop(state, bench::requestFrame(KP::FETCH, 16, request));
+}
+
+// One partition receiving a batch of range(0) 100-byte records
+void BM_ParseProduce(benchmark::State &state) {
+  ProduceRequest request;
+  request.acks = -1;
+  auto &topic = request.topic_data.emplace_back();
+  topic.name = "topic";
+  auto &partition = topic.partition_data.emplace_back();
+  partition.records = bench::segment(1, static_cast<size_t>(state.range(0)), 100);
+  parseLoop(state, bench::requestFrame(KP::PRODUCE, 9, request));
+}
+
+// range(0) partitions, each answered with a 16 KiB batch already in memory
+void BM_EncodeFetchResponse(benchmark::State &state) {
+  auto batch = common::SharedBytes::from(bench::segment(1, 160, 100));
+  FetchResponse response;
+  auto &topic = response.responses.emplace_back();
+  topic.topic_id = 1;
+  for (int64_t p = 0; p < state.range(0); p++) {
+    auto &partition = topic.partitions.emplace_back();
+    partition.partition_index = static_cast<int32_t>(p);
+    partition.high_watermark = 1000;
+    partition.records = {batch};
+  }
+  for (auto _ : state) {
+    ResponseBuffer buffer;
+    KP::Codec::encodeResponse(buffer, 1, 16, response);
+    benchmark::DoNotOptimize(buffer.segments().data());
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+// range(0) topics of 3 partitions each
+void BM_EncodeDescribeTopicPartitionsResponse(benchmark::State &state) {
+  DescribeTopicPartitionsResponse response;
+  for (int64_t t = 0; t < state.range(0); t++) {
+    auto &topic = response.topics.emplace_back();
+    topic.name = "topic-" + std::to_string(t);
+    topic.topic_id = static_cast<uint128_t>(t + 1);
+    for (int32_t p = 0; p < 3; p++) {
+      auto &partition = topic.partitions.emplace_back();
+      partition.partition_index = p;
+      partition.leader_id = 1;
+      partition.replica_nodes = {1};
+      partition.isr_nodes = {1};
+    }
+  }
+  for (auto _ : state) {
+    ResponseBuffer buffer;
+    KP::Codec::encodeResponse(buffer, 1, 0, response);
+    benchmark::DoNotOptimize(buffer.segments().data());
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+} // namespace
+
+BENCHMARK(BM_ParseApiVersions);
+BENCHMARK(BM_ParseDescribeTopicPartitions)->Arg(1)->Arg(100);
+BENCHMARK(BM_ParseFetch)->Arg(1)->Arg(100)->Arg(1000);
+BENCHMARK(BM_ParseProduce)->Arg(10)->Arg(1000);
+BENCHMARK(BM_EncodeFetchResponse)->Arg(1)->Arg(100)->Arg(1000);
+BENCHMARK(BM_EncodeDescribeTopicPartitionsResponse)->Arg(1)->Arg(100);
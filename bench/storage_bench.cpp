@@ -0,0 +1,93 @@
+// Storage work over generated logs of increasing size: walking a segment's batch headers,
+// indexing a partition on first fetch, loading the cluster metadata and pulling record values
+// out of a metadata batch.
+#include "bench_data.hpp"
+#include "log_generator.hpp"
+#include "storage/include/io/path_resolver.hpp"
+#include "storage/include/log/log_store.hpp"
+#include "storage/include/log/segment_reader.hpp"
+#include "storage/include/metadata/metadata_store.hpp"
+#include "storage/include/metadata/record_extractor.hpp"
+#include <benchmark/benchmark.h>
+
+using namespace storage;
+
+namespace {
+
+// range(0) batches of 10 records of 100 bytes
+void BM_SegmentScan(benchmark::State &state) {
+  auto segment = bench::segment(static_cast<size_t>(state.range(0)), 10, 100);
+  for (auto _ : state) {
+    log::SegmentReader reader(segment);
+    int64_t last_offset = 0;
+    while (auto batch = reader.next()) {
+      last_offset = batch->header.last_offset;
+    }
+    benchmark::DoNotOptimize(last_offset);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+  state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(segment.size()));
+}
+
+// First fetch from a partition of range(0) batches: map, index, then find the offset range
+void BM_IndexPartition(benchmark::State &state) {
+  bench::LogDir dir("index");
+  loggen::LogDirSpec spec;
+  spec.records_per_partition = static_cast<uint64_t>(state.range(0)) * 10;
+  if (!loggen::generateLogDir(dir.path(), spec)) {
+    state.SkipWithError("failed to write the log directory");
+    return;
+  }
+
+  for (auto _ : state) {
+    log::LogStore store {io::PathResolver(dir.path())};
+    auto range = store.readPartitionRange("topic-0", 0, state.range(0) * 5, 1 << 20);
+    benchmark::DoNotOptimize(range);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+// Cold load of a metadata log with range(0) topics of 8 partitions each
+void BM_LoadClusterSnapshot(benchmark::State &state) {
+  bench::LogDir dir("metadata");
+  io::PathResolver resolver(dir.path());
+  loggen::LogDirSpec spec;
+  spec.topics = static_cast<size_t>(state.range(0));
+  spec.partitions = 8;
+  spec.replication_factor = 3;
+  bench::LogDir::write(resolver.clusterMetadataPath(),
+                       loggen::metadataLog(loggen::topicsFor(spec)));
+
+  for (auto _ : state) {
+    metadata::MetadataStore store(resolver);
+    auto snapshot = store.loadClusterSnapshot();
+    benchmark::DoNotOptimize(snapshot);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+// One batch of range(0) partition records
+void BM_ExtractRecordValues(benchmark::State &state) {
+  storage::PartitionInfo partition;
+  partition.topic_id = TopicId {1};
+  partition.replicas = partition.isr = {1};
+  loggen::RecordBatchBuilder builder;
+  for (int64_t p = 0; p < state.range(0); p++) {
+    partition.partition_id = static_cast<int32_t>(p);
+    builder.add(loggen::partitionRecord(partition));
+  }
+  std::vector<uint8_t> batch;
+  builder.finish(0, batch);
+  for (auto _ : state) {
+    auto values = metadata::extractRecordValues(batch);
+    benchmark::DoNotOptimize(values);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+} // namespace
+
+BENCHMARK(BM_SegmentScan)->Arg(100)->Arg(10000);
+BENCHMARK(BM_IndexPartition)->Arg(100)->Arg(10000);
+BENCHMARK(BM_LoadClusterSnapshot)->Arg(10)->Arg(1000)->Arg(10000);
+BENCHMARK(BM_ExtractRecordValues)->Arg(10)->Arg(1000);
@@ -0,0 +1,79 @@
+// Decoding a stream of varints with the shared word-at-a-time decoder against the byte loops it
+// replaced in the record extractor and the protocol reader. Small values are what record fields
+// and compact lengths mostly hold; the wide mix exercises every length up to ten bytes.
+#include "varint.hpp"
+#include <benchmark/benchmark.h>
+#include <random>
+#include <span>
+#include <vector>
+
+namespace {
+
+constexpr size_t COUNT = 4096;
+
+// record_extractor.cpp's loop: no length cap, stops quietly at the end of the input
+uint64_t loopVarint(std::span<const uint8_t> &data) {
+  uint64_t value = 0;
+  int shift = 0;
+  while (!data.empty() && shift < 64) {
+    uint8_t byte = data[0];
+    data = data.subspan(1);
+    value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+    if (!(byte & 0x80)) {
+      break;
+    }
+    shift += 7;
+  }
+  return value;
+}
+
+std::vector<uint8_t> makeStream(int max_bits) {
+  std::mt19937_64 random(7);
+  std::vector<uint8_t> out;
+  for (size_t i = 0; i < COUNT; i++) {
+    uint64_t value = random() >> (64 - 1 - random() % static_cast<uint64_t>(max_bits));
+    while (value >= 0x80) {
+      out.push_back(static_cast<uint8_t>(value | 0x80));
+      value >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(value));
+  }
+  return out;
+}
+
+void BM_ByteLoop(benchmark::State &state) {
+  auto stream = makeStream(static_cast<int>(state.range(0)));
+  for (auto _ : state) {
+    std::span<const uint8_t> data(stream);
+    uint64_t sum = 0;
+    while (!data.empty()) {
+      sum += loopVarint(data);
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * COUNT));
+}
+
+void BM_WordDecode(benchmark::State &state) {
+  auto stream = makeStream(static_cast<int>(state.range(0)));
+  for (auto _ : state) {
+    const uint8_t *p = stream.data();
+    size_t left = stream.size();
+    uint64_t sum = 0;
+    while (left > 0) {
+      uint64_t value = 0;
+      size_t used = common::decodeVarint64(p, left, value);
+      sum += value;
+      p += used;
+      left -= used;
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * COUNT));
+}
+
+} // namespace
+
+// Values up to 7 bits (one byte), 21 bits (up to three) and 64 bits (up to ten)
+BENCHMARK(BM_ByteLoop)->Arg(7)->Arg(21)->Arg(64);
+BENCHMARK(BM_WordDecode)->Arg(7)->Arg(21)->Arg(64);
@@ -10,3 +10,4 @@ option(ENABLE_COVERAGE "Enable coverage instrumentation" OFF)
 option(ENABLE_ASAN "Enable AddressSanitizer" OFF)
 option(ENABLE_UBSAN "Enable UndefinedBehaviorSanitizer" OFF)
 option(ENABLE_TSAN "Enable ThreadSanitizer" OFF)
+option(ENABLE_BENCHMARKS "Build the kafka_bench benchmark suite" OFF)
@@ -0,0 +1,108 @@
+#include "crc32c.hpp"
+#include <array>
+#include <cstring>
+
+#if defined(__x86_64__)
+#include <nmmintrin.h>
+#elif defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+#include <arm_acle.h>
+#endif
+
+namespace common {
+
+namespace {
+constexpr uint32_t POLYNOMIAL = 0x82f63b78; // reflected Castagnoli polynomial
+
+using Table = std::array<std::array<uint32_t, 256>, 8>;
+
+constexpr Table makeTable() {
+  Table table {};
+  for (uint32_t i = 0; i < 256; i++) {
+    uint32_t crc = i;
+    for (int bit = 0; bit < 8; bit++) {
+      crc = (crc & 1) ? (crc >> 1) ^ POLYNOMIAL : crc >> 1;
+    }
+    table[0][i] = crc;
+  }
+  for (uint32_t i = 0; i < 256; i++) {
+    for (size_t slice = 1; slice < 8; slice++) {
+      table[slice][i] = (table[slice - 1][i] >> 8) ^ table[0][table[slice - 1][i] & 0xff];
+    }
+  }
+  return table;
+}
+
+constexpr Table TABLE = makeTable();
+
+uint32_t crc32cSoftware(const uint8_t *p, size_t length, uint32_t crc) {
+  while (length >= 8) {
+    uint64_t word;
+    std::memcpy(&word, p, sizeof(word));
+    word ^= crc; // little-endian hosts only, like the rest of the hardware paths
+    crc = TABLE[7][word & 0xff] ^ TABLE[6][(word >> 8) & 0xff] ^ TABLE[5][(word >> 16) & 0xff] ^
+          TABLE[4][(word >> 24) & 0xff] ^ TABLE[3][(word >> 32) & 0xff] ^
+          TABLE[2][(word >> 40) & 0xff] ^ TABLE[1][(word >> 48) & 0xff] ^ TABLE[0][word >> 56];
+    p += 8;
+    length -= 8;
+  }
+  while (length-- > 0) {
+    crc = (crc >> 8) ^ TABLE[0][(crc ^ *p++) & 0xff];
+  }
+  return crc;
+}
+
+#if defined(__x86_64__)
+__attribute__((target("sse4.2"))) uint32_t crc32cHardware(const uint8_t *p, size_t length,
+                                                          uint32_t crc) {
+  uint64_t crc64 = crc;
+  while (length >= 8) {
+    uint64_t word;
+    std::memcpy(&word, p, sizeof(word));
+    crc64 = _mm_crc32_u64(crc64, word);
+    p += 8;
+    length -= 8;
+  }
+  crc = static_cast<uint32_t>(crc64);
+  while (length-- > 0) {
+    crc = _mm_crc32_u8(crc, *p++);
+  }
+  return crc;
+}
+
+bool hasHardwareCrc() {
+  static const bool supported = __builtin_cpu_supports("sse4.2");
+  return supported;
+}
+#elif defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+uint32_t crc32cHardware(const uint8_t *p, size_t length, uint32_t crc) {
+  while (length >= 8) {
+    uint64_t word;
+    std::memcpy(&word, p, sizeof(word));
+    crc = __crc32cd(crc, word);
+    p += 8;
+    length -= 8;
+  }
+  while (length-- > 0) {
+    crc = __crc32cb(crc, *p++);
+  }
+  return crc;
+}
+
+bool hasHardwareCrc() { return true; }
+#else
+uint32_t crc32cHardware(const uint8_t *p, size_t length, uint32_t crc) {
+  return crc32cSoftware(p, length, crc);
+}
+
+bool hasHardwareCrc() { return false; }
+#endif
+} // namespace
+
+uint32_t crc32c(const void *data, size_t length, uint32_t crc) {
+  const auto *p = static_cast<const uint8_t *>(data);
+  crc = ~crc;
+  crc = hasHardwareCrc() ? crc32cHardware(p, length, crc) : crc32cSoftware(p, length, crc);
+  return ~crc;
+}
+
+} // namespace common
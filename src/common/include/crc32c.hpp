@@ -0,0 +1,13 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace common {
+
+// CRC-32C (Castagnoli), the checksum Kafka record batches carry. Pass the previous result as
+// `crc` to extend a checksum over several buffers. Uses the SSE4.2 / ARMv8 CRC instructions when
+// the CPU has them and a slicing-by-8 table otherwise.
+uint32_t crc32c(const void *data, size_t length, uint32_t crc = 0);
+
+} // namespace common
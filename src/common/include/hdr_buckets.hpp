@@ -0,0 +1,46 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+
+namespace common {
+
+// HdrHistogram's bucket layout, shared by every histogram that counts values in a flat array.
+// Values below 2^SignificantBits get a slot each; above that, every power of two is split into
+// 2^(SignificantBits - 1) slots, so a value is kept to SignificantBits bits of precision.
+//
+// Bucket 0 holds [0, SUB_BUCKETS) in steps of 1. Every later bucket b holds
+// [SUB_BUCKETS << (b - 1), SUB_BUCKETS << b) in steps of 1 << b, which takes HALF slots.
+template <int SignificantBits> struct HdrBuckets {
+  static_assert(SignificantBits >= 2 && SignificantBits < 32);
+
+  static constexpr int64_t SUB_BUCKETS = int64_t {1} << SignificantBits;
+  static constexpr int64_t HALF = SUB_BUCKETS / 2;
+
+  // Slots needed for every value up to and including `largest`
+  static constexpr size_t countFor(uint64_t largest) {
+    int bucket = std::max(0, static_cast<int>(std::bit_width(largest)) - SignificantBits);
+    return static_cast<size_t>(bucket + 2) * static_cast<size_t>(HALF);
+  }
+
+  static constexpr size_t indexOf(uint64_t value) {
+    int bucket = std::max(0, static_cast<int>(std::bit_width(value)) - SignificantBits);
+    auto sub = static_cast<int64_t>(value >> bucket);
+    return static_cast<size_t>(((bucket + 1) << (SignificantBits - 1)) + (sub - HALF));
+  }
+
+  // Largest value that lands in slot `index`
+  static constexpr int64_t highestEquivalent(size_t index) {
+    int64_t bucket = static_cast<int64_t>(index >> (SignificantBits - 1)) - 1;
+    int64_t sub = static_cast<int64_t>(index & (HALF - 1)) + HALF;
+    if (bucket < 0) {
+      sub -= HALF;
+      bucket = 0;
+    }
+    return ((sub + 1) << bucket) - 1;
+  }
+};
+
+} // namespace common
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <utility>
+#include <vector>
+
+namespace common {
+
+// Read-only view of bytes that live elsewhere: a mapped log segment, a pooled buffer, a vector.
+// Copies share `owner`, which keeps that storage alive until the last view of it is gone, so bytes
+// can be handed from storage to a response without being copied on the way.
+class SharedBytes {
+public:
+  SharedBytes() = default;
+  SharedBytes(std::span<const uint8_t> bytes, std::shared_ptr<const void> owner)
+      : bytes_(bytes), owner_(std::move(owner)) {}
+
+  // A view that owns `bytes` itself
+  static SharedBytes from(std::vector<uint8_t> bytes) {
+    auto owner = std::make_shared<const std::vector<uint8_t>>(std::move(bytes));
+    return {std::span<const uint8_t>(*owner), owner};
+  }
+
+  // `length` bytes from `offset`, kept alive by the same owner
+  [[nodiscard]] SharedBytes slice(size_t offset, size_t length) const {
+    return {bytes_.subspan(offset, length), owner_};
+  }
+
+  [[nodiscard]] std::span<const uint8_t> bytes() const { return bytes_; }
+  [[nodiscard]] const uint8_t *data() const { return bytes_.data(); }
+  [[nodiscard]] size_t size() const { return bytes_.size(); }
+  [[nodiscard]] bool empty() const { return bytes_.empty(); }
+  [[nodiscard]] const std::shared_ptr<const void> &owner() const { return owner_; }
+
+private:
+  std::span<const uint8_t> bytes_;
+  std::shared_ptr<const void> owner_;
+};
+
+} // namespace common
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace common::trace {
+
+// Spans of work on each thread, for finding out where a slow request spent its time. Every
+// thread records into its own fixed-size ring, overwriting its oldest spans once the ring is
+// full, without locks or allocation; chromeTraceJson() reads all rings while they are written.
+// While tracing is off a span costs one relaxed load and a branch.
+//
+//   common::trace::Span span("LogStore::readPartitionRange");
+
+namespace detail {
+inline std::atomic<bool> enabled {false};
+void record(const char *name, uint64_t start, uint64_t end, uint32_t thread);
+uint32_t threadId();
+} // namespace detail
+
+// The CPU's timestamp counter where there is one, which is cheaper to read than the clock
+inline uint64_t ticks() {
+#if defined(__x86_64__) || defined(__i386__)
+  return __rdtsc();
+#elif defined(__aarch64__)
+  uint64_t value;
+  asm volatile("mrs %0, cntvct_el0" : "=r"(value));
+  return value;
+#else
+  return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                   std::chrono::steady_clock::now().time_since_epoch())
+                                   .count());
+#endif
+}
+
+inline bool enabled() { return detail::enabled.load(std::memory_order_relaxed); }
+
+// Start recording; threads that record for the first time get rings of `events_per_thread`
+// spans, rounded up to a power of two
+void enable(size_t events_per_thread = 1 << 16);
+void disable();
+
+// Forget every span recorded so far
+void clear();
+
+// Recorded spans in Chrome's trace-event format, for chrome://tracing or Perfetto
+std::string chromeTraceJson();
+
+// Records the time from construction to destruction under `name`, which must outlive the trace
+// (a string literal). A span ending on another thread, like a coroutine resumed elsewhere, is
+// shown on the thread it started on.
+class Span {
+public:
+  explicit Span(const char *name) : name_(name) {
+    if (enabled()) {
+      thread_ = detail::threadId();
+      start_ = ticks();
+    }
+  }
+
+  ~Span() {
+    if (start_ != 0) {
+      detail::record(name_, start_, ticks(), thread_);
+    }
+  }
+
+  Span(const Span &) = delete;
+  Span &operator=(const Span &) = delete;
+
+private:
+  const char *name_;
+  uint64_t start_ {0};
+  uint32_t thread_ {0};
+};
+
+} // namespace common::trace
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
+namespace common {
+
+// Kafka's variable-length integers: 7 bits per byte, least significant group first, the high bit
+// set on every byte but the last. Signed varints (record fields) are zigzag encoded first.
+//
+// Each decode reads at most `length` bytes from `data`, stores the value and returns how many
+// bytes it took. 0 means the varint is truncated or longer than its type allows (5 bytes for 32
+// bits, 10 for 64), and `value` is left alone. Single-byte varints, by far the most common
+// (lengths, counts, small deltas), return straight away; longer ones are decoded from one 8-byte
+// load whenever 8 bytes of input are left.
+
+namespace varint_detail {
+
+inline constexpr uint64_t STOP_BITS = 0x8080808080808080ULL;
+
+// The varint at the start of `word` (the next 8 input bytes, little-endian), or 0 when none of
+// them ends one. Finds the end with one mask instead of a branch per byte, then packs the 7-bit
+// groups together in three steps.
+inline size_t decodeWord(uint64_t word, uint64_t &value) {
+  uint64_t stops = ~word & STOP_BITS;
+  if (stops == 0) {
+    return 0;
+  }
+  auto length = static_cast<size_t>(std::countr_zero(stops) / 8 + 1);
+  word &= (stops ^ (stops - 1)) & ~STOP_BITS;
+  word = ((word & 0x7f007f007f007f00ULL) >> 1) | (word & 0x007f007f007f007fULL);
+  word = ((word & 0x3fff00003fff0000ULL) >> 2) | (word & 0x00003fff00003fffULL);
+  word = ((word & 0x0fffffff00000000ULL) >> 4) | (word & 0x000000000fffffffULL);
+  value = word;
+  return length;
+}
+
+// One byte at a time, for the end of a buffer and the 9- and 10-byte varints
+template <typename T> size_t decodeScalar(const uint8_t *data, size_t length, T &value) {
+  constexpr size_t BITS = std::numeric_limits<T>::digits;
+  constexpr size_t MAX_BYTES = (BITS + 6) / 7;
+  T result = 0;
+  for (size_t i = 0; i < MAX_BYTES && i < length; i++) {
+    auto group = static_cast<T>(data[i] & 0x7f);
+    // The last byte a type allows may only hold the bits that are left
+    if (i == MAX_BYTES - 1 && (group >> (BITS - 7 * i)) != 0) {
+      return 0;
+    }
+    result |= static_cast<T>(group << (7 * i));
+    if (!(data[i] & 0x80)) {
+      value = result;
+      return i + 1;
+    }
+  }
+  return 0;
+}
+
+} // namespace varint_detail
+
+inline size_t decodeVarint64(const uint8_t *data, size_t length, uint64_t &value) {
+  if (length > 0 && data[0] < 0x80) {
+    value = data[0];
+    return 1;
+  }
+  if constexpr (std::endian::native == std::endian::little) {
+    if (length >= sizeof(uint64_t)) {
+      uint64_t word;
+      std::memcpy(&word, data, sizeof(word));
+      if (size_t used = varint_detail::decodeWord(word, value)) {
+        return used;
+      }
+    }
+  }
+  return varint_detail::decodeScalar(data, length, value);
+}
+
+inline size_t decodeVarint32(const uint8_t *data, size_t length, uint32_t &value) {
+  if (length > 0 && data[0] < 0x80) {
+    value = data[0];
+    return 1;
+  }
+  if constexpr (std::endian::native == std::endian::little) {
+    if (length >= sizeof(uint64_t)) {
+      uint64_t word;
+      std::memcpy(&word, data, sizeof(word));
+      uint64_t wide;
+      size_t used = varint_detail::decodeWord(word, wide);
+      if (used == 0 || used > 5 || wide > std::numeric_limits<uint32_t>::max()) {
+        return 0;
+      }
+      value = static_cast<uint32_t>(wide);
+      return used;
+    }
+  }
+  return varint_detail::decodeScalar(data, length, value);
+}
+
+constexpr int64_t zigzagDecode(uint64_t n) {
+  return static_cast<int64_t>(n >> 1) ^ -static_cast<int64_t>(n & 1);
+}
+
+inline size_t decodeZigZag64(const uint8_t *data, size_t length, int64_t &value) {
+  uint64_t n;
+  size_t used = decodeVarint64(data, length, n);
+  if (used != 0) {
+    value = zigzagDecode(n);
+  }
+  return used;
+}
+
+inline size_t decodeZigZag32(const uint8_t *data, size_t length, int32_t &value) {
+  uint32_t n;
+  size_t used = decodeVarint32(data, length, n);
+  if (used != 0) {
+    value = static_cast<int32_t>(zigzagDecode(n));
+  }
+  return used;
+}
+
+} // namespace common
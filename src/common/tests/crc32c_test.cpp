@@ -0,0 +1,25 @@
+#include "crc32c.hpp"
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+
+using common::crc32c;
+
+TEST(Crc32cTest, KnownVectors) {
+  EXPECT_EQ(crc32c("", 0), 0u);
+  EXPECT_EQ(crc32c("123456789", 9), 0xe3069283u);
+
+  std::vector<uint8_t> zeros(32, 0);
+  EXPECT_EQ(crc32c(zeros.data(), zeros.size()), 0x8a9136aau);
+  std::vector<uint8_t> ones(32, 0xff);
+  EXPECT_EQ(crc32c(ones.data(), ones.size()), 0x62a8ab43u);
+}
+
+TEST(Crc32cTest, ExtendsAcrossBuffers) {
+  std::string text = "The quick brown fox jumps over the lazy dog, again and again.";
+  uint32_t whole = crc32c(text.data(), text.size());
+  for (size_t split = 0; split <= text.size(); split += 7) {
+    uint32_t part = crc32c(text.data(), split);
+    EXPECT_EQ(crc32c(text.data() + split, text.size() - split, part), whole);
+  }
+}
@@ -0,0 +1,37 @@
+#include "hdr_buckets.hpp"
+#include <cstdint>
+#include <gtest/gtest.h>
+
+using Buckets7 = common::HdrBuckets<7>;
+using Buckets11 = common::HdrBuckets<11>;
+
+TEST(HdrBucketsTest, SmallValuesGetASlotEach) {
+  for (uint64_t value = 0; value < 128; value++) {
+    EXPECT_EQ(Buckets7::indexOf(value), value);
+    EXPECT_EQ(Buckets7::highestEquivalent(value), static_cast<int64_t>(value));
+  }
+}
+
+TEST(HdrBucketsTest, EveryValueIsKeptToItsSignificantBits) {
+  size_t previous = 0;
+  for (uint64_t value = 1; value < (uint64_t {1} << 40); value += value / 7 + 1) {
+    size_t index = Buckets7::indexOf(value);
+    int64_t top = Buckets7::highestEquivalent(index);
+    EXPECT_GE(index, previous);
+    EXPECT_GE(top, static_cast<int64_t>(value));
+    // Slot widths are at most 1/64 of the values they hold
+    EXPECT_LE(static_cast<double>(top - static_cast<int64_t>(value)),
+              static_cast<double>(value) / 64.0);
+    EXPECT_EQ(Buckets7::indexOf(static_cast<uint64_t>(top)), index);
+    previous = index;
+  }
+}
+
+TEST(HdrBucketsTest, CountCoversTheLargestValue) {
+  for (uint64_t largest : {uint64_t {1}, uint64_t {2047}, uint64_t {2048}, uint64_t {4096},
+                           uint64_t {60'000'000'000}, (uint64_t {1} << 37) - 1}) {
+    EXPECT_LT(Buckets11::indexOf(largest), Buckets11::countFor(largest)) << largest;
+    EXPECT_LT(Buckets7::indexOf(largest), Buckets7::countFor(largest)) << largest;
+  }
+  EXPECT_EQ(Buckets11::countFor(2047), 2048u);
+}
@@ -0,0 +1,41 @@
+#include "shared_bytes.hpp"
+#include <gtest/gtest.h>
+#include <memory>
+#include <vector>
+
+TEST(SharedBytesTest, OwnsVectorItWasMadeFrom) {
+  auto bytes = common::SharedBytes::from({1, 2, 3, 4});
+  ASSERT_EQ(bytes.size(), 4u);
+  EXPECT_EQ(bytes.data()[0], 1);
+  EXPECT_EQ(bytes.data()[3], 4);
+  EXPECT_NE(bytes.owner(), nullptr);
+}
+
+TEST(SharedBytesTest, SlicesShareTheOwner) {
+  auto bytes = common::SharedBytes::from({1, 2, 3, 4, 5});
+  auto middle = bytes.slice(1, 3);
+  ASSERT_EQ(middle.size(), 3u);
+  EXPECT_EQ(middle.data(), bytes.data() + 1);
+  EXPECT_EQ(middle.owner(), bytes.owner());
+}
+
+TEST(SharedBytesTest, KeepsStorageAliveUntilLastView) {
+  auto storage = std::make_shared<std::vector<uint8_t>>(8, 0x5a);
+  std::weak_ptr<std::vector<uint8_t>> alive = storage;
+  common::SharedBytes view(*storage, storage);
+  storage.reset();
+
+  auto copy = view.slice(2, 2);
+  view = {};
+  ASSERT_FALSE(alive.expired());
+  EXPECT_EQ(copy.data()[0], 0x5a);
+
+  copy = {};
+  EXPECT_TRUE(alive.expired());
+}
+
+TEST(SharedBytesTest, DefaultIsEmpty) {
+  common::SharedBytes bytes;
+  EXPECT_TRUE(bytes.empty());
+  EXPECT_EQ(bytes.owner(), nullptr);
+}
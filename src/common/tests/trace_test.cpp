@@ -0,0 +1,136 @@
+#include "trace.hpp"
+#include <atomic>
+#include <gtest/gtest.h>
+#include <regex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace trace = common::trace;
+
+namespace {
+
+struct Event {
+  std::string name;
+  double ts;
+  double dur;
+  unsigned tid;
+};
+
+std::vector<Event> events() {
+  static const std::regex EVENT(
+      R"re(\{"name":"([^"]*)","cat":"kafka","ph":"X","ts":([0-9.]+),"dur":([0-9.]+),)re"
+      R"re("pid":1,"tid":([0-9]+)\})re");
+  std::string json = trace::chromeTraceJson();
+  std::vector<Event> found;
+  for (std::sregex_iterator it(json.begin(), json.end(), EVENT), end; it != end; ++it) {
+    found.push_back({(*it)[1], std::stod((*it)[2]), std::stod((*it)[3]),
+                     static_cast<unsigned>(std::stoul((*it)[4]))});
+  }
+  return found;
+}
+
+class TraceTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    trace::enable();
+    trace::clear();
+  }
+  void TearDown() override { trace::disable(); }
+};
+
+} // namespace
+
+TEST_F(TraceTest, DisabledRecordsNothing) {
+  trace::disable();
+  { trace::Span span("off"); }
+  EXPECT_TRUE(events().empty());
+  EXPECT_EQ(trace::chromeTraceJson(), R"({"traceEvents":[],"displayTimeUnit":"ns"})");
+}
+
+TEST_F(TraceTest, RecordsNestedSpans) {
+  {
+    trace::Span outer("outer");
+    trace::Span inner("inner");
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+  }
+  auto recorded = events();
+  ASSERT_EQ(recorded.size(), 2u);
+  EXPECT_EQ(recorded[0].name, "outer");
+  EXPECT_EQ(recorded[1].name, "inner");
+  EXPECT_EQ(recorded[0].tid, recorded[1].tid);
+  EXPECT_LE(recorded[0].ts, recorded[1].ts);
+  EXPECT_GE(recorded[0].dur, recorded[1].dur);
+  // Ticks are converted to microseconds
+  EXPECT_GE(recorded[1].dur, 1500.0);
+  EXPECT_LT(recorded[1].dur, 1e6);
+}
+
+TEST_F(TraceTest, ThreadsRecordUnderTheirOwnIds) {
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; t++) {
+    threads.emplace_back([] { trace::Span span("worker"); });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  // Spans of threads that have exited are kept
+  auto recorded = events();
+  ASSERT_EQ(recorded.size(), 4u);
+  std::set<unsigned> tids;
+  for (const auto &event : recorded) {
+    tids.insert(event.tid);
+  }
+  EXPECT_EQ(tids.size(), 4u);
+}
+
+TEST_F(TraceTest, FullRingKeepsLatestSpans) {
+  static const char *const NAMES[] = {"s0", "s1", "s2", "s3", "s4", "s5", "s6", "s7", "s8", "s9"};
+  trace::enable(3); // rounded up to 4
+  std::thread([] {
+    for (const char *name : NAMES) {
+      trace::Span span(name);
+    }
+  }).join();
+  trace::enable();
+
+  auto recorded = events();
+  ASSERT_EQ(recorded.size(), 4u);
+  EXPECT_EQ(recorded[0].name, "s6");
+  EXPECT_EQ(recorded[3].name, "s9");
+}
+
+TEST_F(TraceTest, ClearForgetsRecordedSpans) {
+  { trace::Span span("before"); }
+  trace::clear();
+  { trace::Span span("after"); }
+  auto recorded = events();
+  ASSERT_EQ(recorded.size(), 1u);
+  EXPECT_EQ(recorded[0].name, "after");
+}
+
+TEST_F(TraceTest, ReadsWhileThreadsRecord) {
+  trace::enable(64);
+  std::atomic<bool> stop {false};
+  std::atomic<int> spans {0};
+  std::thread writer([&stop, &spans] {
+    while (!stop.load(std::memory_order_relaxed)) {
+      { trace::Span span("busy"); }
+      spans.fetch_add(1, std::memory_order_relaxed);
+    }
+  });
+  // Read while the writer laps its ring
+  while (spans.load(std::memory_order_relaxed) < 64) {
+    std::this_thread::yield();
+  }
+  for (int i = 0; i < 100; i++) {
+    for (const auto &event : events()) {
+      EXPECT_EQ(event.name, "busy");
+    }
+  }
+  stop = true;
+  writer.join();
+  trace::enable();
+  EXPECT_EQ(events().size(), 64u);
+}
@@ -0,0 +1,109 @@
+#include "varint.hpp"
+#include <gtest/gtest.h>
+#include <initializer_list>
+#include <random>
+#include <vector>
+
+using namespace common;
+
+namespace {
+
+std::vector<uint8_t> encode(uint64_t value) {
+  std::vector<uint8_t> out;
+  while (value >= 0x80) {
+    out.push_back(static_cast<uint8_t>(value | 0x80));
+    value >>= 7;
+  }
+  out.push_back(static_cast<uint8_t>(value));
+  return out;
+}
+
+// `bytes` followed by `padding` bytes, so both the word and the byte-at-a-time paths run
+std::vector<uint8_t> padded(std::vector<uint8_t> bytes, size_t padding) {
+  bytes.insert(bytes.end(), padding, 0xff);
+  return bytes;
+}
+
+} // namespace
+
+TEST(VarintTest, DecodesBoundaries64) {
+  for (uint64_t value : {0ULL, 1ULL, 127ULL, 128ULL, 16383ULL, 16384ULL, 0xffffffffULL,
+                         (1ULL << 56) - 1, 1ULL << 56, 1ULL << 63, ~0ULL}) {
+    auto bytes = encode(value);
+    for (size_t padding : {0, 8}) {
+      SCOPED_TRACE(value);
+      auto input = padded(bytes, padding);
+      uint64_t decoded = 0;
+      EXPECT_EQ(decodeVarint64(input.data(), input.size(), decoded), bytes.size());
+      EXPECT_EQ(decoded, value);
+    }
+  }
+}
+
+TEST(VarintTest, DecodesBoundaries32) {
+  for (uint32_t value : {0U, 127U, 128U, 0x0fffffffU, 0x10000000U, 0xffffffffU}) {
+    auto bytes = encode(value);
+    for (size_t padding : {0, 8}) {
+      SCOPED_TRACE(value);
+      auto input = padded(bytes, padding);
+      uint32_t decoded = 0;
+      EXPECT_EQ(decodeVarint32(input.data(), input.size(), decoded), bytes.size());
+      EXPECT_EQ(decoded, value);
+    }
+  }
+}
+
+TEST(VarintTest, WordAndScalarPathsAgree) {
+  std::mt19937_64 random(42);
+  for (int i = 0; i < 10000; i++) {
+    uint64_t value = random() >> (random() % 64);
+    auto bytes = encode(value);
+    auto input = padded(bytes, 10);
+    uint64_t fast = 0;
+    uint64_t slow = 0;
+    ASSERT_EQ(decodeVarint64(input.data(), input.size(), fast), bytes.size());
+    ASSERT_EQ(varint_detail::decodeScalar(bytes.data(), bytes.size(), slow), bytes.size());
+    ASSERT_EQ(fast, value);
+    ASSERT_EQ(slow, value);
+  }
+}
+
+TEST(VarintTest, RejectsTruncated) {
+  std::vector<uint8_t> bytes {0x80, 0x80};
+  uint64_t value = 7;
+  EXPECT_EQ(decodeVarint64(bytes.data(), bytes.size(), value), 0u);
+  EXPECT_EQ(value, 7u);
+  EXPECT_EQ(decodeVarint64(bytes.data(), 0, value), 0u);
+}
+
+TEST(VarintTest, RejectsTooLong) {
+  for (size_t padding : {0, 8}) {
+    auto six = padded({0x80, 0x80, 0x80, 0x80, 0x80, 0x00}, padding);
+    uint32_t value32;
+    EXPECT_EQ(decodeVarint32(six.data(), six.size(), value32), 0u);
+
+    // Five bytes, but more than 32 bits
+    auto wide = padded({0xff, 0xff, 0xff, 0xff, 0x1f}, padding);
+    EXPECT_EQ(decodeVarint32(wide.data(), wide.size(), value32), 0u);
+
+    auto eleven = padded(std::vector<uint8_t>(10, 0x80), padding);
+    eleven.insert(eleven.begin() + 10, 0x00);
+    uint64_t value64;
+    EXPECT_EQ(decodeVarint64(eleven.data(), eleven.size(), value64), 0u);
+  }
+}
+
+TEST(VarintTest, ZigZag) {
+  for (int64_t value : std::initializer_list<int64_t> {0, -1, 1, -64, 63, INT64_MIN, INT64_MAX}) {
+    auto zigzag = (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+    auto bytes = padded(encode(zigzag), 8);
+    int64_t decoded = 0;
+    EXPECT_EQ(decodeZigZag64(bytes.data(), bytes.size(), decoded), encode(zigzag).size());
+    EXPECT_EQ(decoded, value);
+  }
+
+  auto minus_one = padded({0x01}, 8);
+  int32_t decoded = 0;
+  EXPECT_EQ(decodeZigZag32(minus_one.data(), minus_one.size(), decoded), 1u);
+  EXPECT_EQ(decoded, -1);
+}
@@ -0,0 +1,195 @@
+#include "trace.hpp"
+#include <algorithm>
+#include <bit>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace common::trace {
+
+namespace {
+
+// One span, guarded by a sequence number like a seqlock: odd while the owning thread writes it,
+// 2 * (index + 1) once span `index` of the ring is in it
+struct Slot {
+  std::atomic<uint64_t> sequence {0};
+  std::atomic<const char *> name {nullptr};
+  std::atomic<uint64_t> start {0};
+  std::atomic<uint64_t> end {0};
+  std::atomic<uint32_t> thread {0};
+};
+
+// Spans recorded on one thread, which is the only writer; readers copy them out on any thread
+// and drop the ones overwritten while they read
+struct Ring {
+  Ring(size_t capacity, uint32_t thread)
+      : slots(std::make_unique<Slot[]>(capacity)), mask(capacity - 1), thread(thread) {}
+
+  std::unique_ptr<Slot[]> slots;
+  const uint64_t mask;
+  const uint32_t thread;
+  std::atomic<uint64_t> head {0}; // index of the next span
+  std::atomic<uint64_t> floor {0}; // spans before it were cleared
+};
+
+struct Event {
+  const char *name;
+  uint64_t start;
+  uint64_t end;
+  uint32_t thread;
+};
+
+// Rings outlive their threads so spans of threads that have exited still show
+struct Rings {
+  std::mutex mutex;
+  std::vector<std::shared_ptr<Ring>> rings;
+  size_t capacity {1 << 16};
+  // Ticks and steady clock nanoseconds when tracing was first enabled, to convert ticks
+  bool calibrated {false};
+  uint64_t origin_ticks {0};
+  int64_t origin_nanos {0};
+};
+
+Rings &rings() {
+  static Rings instance;
+  return instance;
+}
+
+int64_t steadyNanos() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+Ring &threadRing() {
+  thread_local std::shared_ptr<Ring> ring;
+  if (!ring) {
+    auto &all = rings();
+    std::lock_guard lock(all.mutex);
+    ring = std::make_shared<Ring>(all.capacity, static_cast<uint32_t>(all.rings.size() + 1));
+    all.rings.push_back(ring);
+  }
+  return *ring;
+}
+
+void collect(const Ring &ring, std::vector<Event> &out) {
+  uint64_t head = ring.head.load(std::memory_order_acquire);
+  uint64_t capacity = ring.mask + 1;
+  uint64_t first = std::max(ring.floor.load(std::memory_order_relaxed),
+                            head > capacity ? head - capacity : 0);
+  for (uint64_t index = first; index < head; index++) {
+    const Slot &slot = ring.slots[index & ring.mask];
+    uint64_t before = slot.sequence.load(std::memory_order_acquire);
+    Event event {slot.name.load(std::memory_order_relaxed),
+                 slot.start.load(std::memory_order_relaxed),
+                 slot.end.load(std::memory_order_relaxed),
+                 slot.thread.load(std::memory_order_relaxed)};
+    std::atomic_thread_fence(std::memory_order_acquire);
+    uint64_t after = slot.sequence.load(std::memory_order_relaxed);
+    // Otherwise the writer has lapped the reader and the slot holds, or is getting, a later span
+    if (before == after && before == 2 * (index + 1)) {
+      out.push_back(event);
+    }
+  }
+}
+
+void appendEscaped(std::string &out, const char *text) {
+  for (; *text; text++) {
+    if (*text == '"' || *text == '\\') {
+      out += '\\';
+    }
+    out += *text;
+  }
+}
+
+} // namespace
+
+namespace detail {
+
+void record(const char *name, uint64_t start, uint64_t end, uint32_t thread) {
+  Ring &ring = threadRing();
+  uint64_t index = ring.head.load(std::memory_order_relaxed);
+  Slot &slot = ring.slots[index & ring.mask];
+  slot.sequence.store(2 * index + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  slot.name.store(name, std::memory_order_relaxed);
+  slot.start.store(start, std::memory_order_relaxed);
+  slot.end.store(end, std::memory_order_relaxed);
+  slot.thread.store(thread, std::memory_order_relaxed);
+  slot.sequence.store(2 * (index + 1), std::memory_order_release);
+  ring.head.store(index + 1, std::memory_order_release);
+}
+
+uint32_t threadId() { return threadRing().thread; }
+
+} // namespace detail
+
+void enable(size_t events_per_thread) {
+  auto &all = rings();
+  {
+    std::lock_guard lock(all.mutex);
+    all.capacity = std::bit_ceil(std::max<size_t>(events_per_thread, 2));
+    if (!all.calibrated) {
+      all.origin_ticks = ticks();
+      all.origin_nanos = steadyNanos();
+      all.calibrated = true;
+    }
+  }
+  detail::enabled.store(true, std::memory_order_relaxed);
+}
+
+void disable() { detail::enabled.store(false, std::memory_order_relaxed); }
+
+void clear() {
+  auto &all = rings();
+  std::lock_guard lock(all.mutex);
+  for (auto &ring : all.rings) {
+    ring->floor.store(ring->head.load(std::memory_order_acquire), std::memory_order_relaxed);
+  }
+}
+
+std::string chromeTraceJson() {
+  auto &all = rings();
+  std::vector<Event> events;
+  uint64_t origin_ticks = 0;
+  int64_t origin_nanos = 0;
+  {
+    std::lock_guard lock(all.mutex);
+    for (const auto &ring : all.rings) {
+      collect(*ring, events);
+    }
+    origin_ticks = all.origin_ticks;
+    origin_nanos = all.origin_nanos;
+  }
+  std::sort(events.begin(), events.end(),
+            [](const Event &a, const Event &b) { return a.start < b.start; });
+
+  // Nanoseconds per tick, measured over the time since tracing was first enabled
+  uint64_t elapsed_ticks = ticks() - origin_ticks;
+  int64_t elapsed_nanos = steadyNanos() - origin_nanos;
+  double nanos_per_tick = elapsed_ticks > 0 && elapsed_nanos > 0
+                              ? static_cast<double>(elapsed_nanos) /
+                                    static_cast<double>(elapsed_ticks)
+                              : 1.0;
+
+  std::string out = "{\"traceEvents\":[";
+  char numbers[160];
+  for (size_t i = 0; i < events.size(); i++) {
+    const Event &event = events[i];
+    double ts = static_cast<double>(event.start - origin_ticks) * nanos_per_tick / 1000.0;
+    uint64_t span_ticks = event.end > event.start ? event.end - event.start : 0;
+    double dur = static_cast<double>(span_ticks) * nanos_per_tick / 1000.0;
+    out += i > 0 ? ",{\"name\":\"" : "{\"name\":\"";
+    appendEscaped(out, event.name);
+    std::snprintf(numbers, sizeof(numbers),
+                  "\",\"cat\":\"kafka\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,"
+                  "\"pid\":1,\"tid\":%u}",
+                  ts, dur, event.thread);
+    out += numbers;
+  }
+  out += "],\"displayTimeUnit\":\"ns\"}";
+  return out;
+}
+
+} // namespace common::trace
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "storage_error.hpp"
+#include "storage_types.hpp"
+#include <cstdint>
+#include <expected>
+#include <string>
+#include <vector>
+
+namespace loggen {
+
+// Shape of a synthetic log directory. Everything is derived from the spec and `seed`, so the
+// same spec always produces the same bytes.
+struct LogDirSpec {
+  size_t topics {1};
+  int32_t partitions {1};         // per topic
+  int32_t replication_factor {1}; // brokers 1..N; leaders are spread round robin
+  std::string topic_prefix {"topic-"};
+
+  uint64_t records_per_partition {0};
+  size_t records_per_batch {10};
+  size_t key_bytes {0}; // 0 writes null keys
+  size_t value_bytes {100};
+  uint64_t segment_bytes {1ULL << 30}; // a new segment starts once a batch would cross this
+
+  uint64_t seed {1};
+  int64_t base_timestamp {1'700'000'000'000}; // first record, in ms; later ones 1 ms apart
+};
+
+struct LogDirSummary {
+  size_t topics {0};
+  size_t partitions {0};
+  uint64_t records {0};
+  uint64_t batches {0};
+  uint64_t segments {0};
+  uint64_t bytes {0}; // partition logs only
+};
+
+// Topics the spec describes, with their partitions and ids, in the order they are written
+std::vector<storage::TopicInfo> topicsFor(const LogDirSpec &spec);
+
+// The __cluster_metadata log: a metadata.version feature record, then one batch per topic with
+// its TopicRecord and PartitionRecords
+std::vector<uint8_t> metadataLog(const std::vector<storage::TopicInfo> &topics);
+
+// Write the metadata log and every partition's segments under `directory`, laid out as
+// storage::io::PathResolver expects. Partition data is generated and written a batch at a time,
+// so memory use does not grow with the record count.
+std::expected<LogDirSummary, storage::StorageError> generateLogDir(const std::string &directory,
+                                                                    const LogDirSpec &spec);
+
+} // namespace loggen
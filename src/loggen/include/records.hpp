@@ -0,0 +1,54 @@
+#pragma once
+
+#include "storage_types.hpp"
+#include <cstdint>
+#include <span>
+#include <string_view>
+#include <vector>
+
+namespace loggen {
+
+// Builds uncompressed record batches in Kafka's v2 log format (magic 2), CRC-32C included.
+// finish() appends the batch to a caller's buffer and starts the next one, so a single builder
+// and buffer are enough for any number of batches.
+class RecordBatchBuilder {
+public:
+  explicit RecordBatchBuilder(int64_t base_timestamp = 0) : base_timestamp_(base_timestamp) {}
+
+  // Add a record with a null key
+  void add(std::span<const uint8_t> value, int64_t timestamp_delta = 0);
+  void add(std::span<const uint8_t> key, std::span<const uint8_t> value,
+           int64_t timestamp_delta = 0);
+
+  [[nodiscard]] int32_t count() const { return count_; }
+  [[nodiscard]] bool empty() const { return count_ == 0; }
+
+  // Timestamp the next batch's deltas are relative to
+  void setBaseTimestamp(int64_t timestamp) { base_timestamp_ = timestamp; }
+
+  // Append the batch, numbered from `base_offset`, to `out` and return its size in bytes
+  size_t finish(int64_t base_offset, std::vector<uint8_t> &out);
+
+private:
+  void addRecord(const uint8_t *key, int64_t key_length, std::span<const uint8_t> value,
+                 int64_t timestamp_delta);
+
+  std::vector<uint8_t> records_;
+  int64_t base_timestamp_;
+  int64_t max_timestamp_delta_ {0};
+  int32_t count_ {0};
+};
+
+// Values of __cluster_metadata records, encoded the way a KRaft controller writes them
+
+// FeatureLevelRecord v0, e.g. ("metadata.version", 20)
+std::vector<uint8_t> featureLevelRecord(std::string_view name, int16_t level);
+
+// TopicRecord v0
+std::vector<uint8_t> topicRecord(std::string_view name, storage::TopicId id);
+
+// PartitionRecord v1: replicas, ISR, leader and epochs from `partition`, no reassignment in
+// progress, and one log directory per replica
+std::vector<uint8_t> partitionRecord(const storage::PartitionInfo &partition);
+
+} // namespace loggen
@@ -0,0 +1,96 @@
+// Writes a synthetic KRaft log directory that the broker can serve: a __cluster_metadata log
+// describing the topics and a segmented log for every partition.
+//
+//   kafka_loggen --dir DIR [--topics 1] [--partitions 1] [--replication-factor 1]
+//                [--records 0] [--batch-records 10] [--key-bytes 0] [--value-bytes 100]
+//                [--segment-bytes 1073741824] [--topic-prefix topic-] [--seed 1]
+//
+// --records is per partition. The same options always produce the same files.
+#include "log_generator.hpp"
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+namespace {
+
+struct Options {
+  std::string directory;
+  loggen::LogDirSpec spec;
+};
+
+Options parseOptions(int argc, char **argv) {
+  Options options;
+  auto &spec = options.spec;
+  for (int i = 1; i < argc; i += 2) {
+    std::string flag = argv[i];
+    if (i + 1 >= argc) {
+      throw std::invalid_argument("missing value for " + flag);
+    }
+    std::string value = argv[i + 1];
+    if (flag == "--dir") {
+      options.directory = value;
+    } else if (flag == "--topics") {
+      spec.topics = std::stoul(value);
+    } else if (flag == "--partitions") {
+      spec.partitions = std::stoi(value);
+    } else if (flag == "--replication-factor") {
+      spec.replication_factor = std::stoi(value);
+    } else if (flag == "--records") {
+      spec.records_per_partition = std::stoull(value);
+    } else if (flag == "--batch-records") {
+      spec.records_per_batch = std::stoul(value);
+    } else if (flag == "--key-bytes") {
+      spec.key_bytes = std::stoul(value);
+    } else if (flag == "--value-bytes") {
+      spec.value_bytes = std::stoul(value);
+    } else if (flag == "--segment-bytes") {
+      spec.segment_bytes = std::stoull(value);
+    } else if (flag == "--topic-prefix") {
+      spec.topic_prefix = value;
+    } else if (flag == "--seed") {
+      spec.seed = std::stoull(value);
+    } else {
+      throw std::invalid_argument("unknown option: " + flag);
+    }
+  }
+  if (options.directory.empty()) {
+    throw std::invalid_argument("--dir is required");
+  }
+  if (spec.partitions <= 0 || spec.replication_factor <= 0 || spec.records_per_batch == 0) {
+    throw std::invalid_argument("partitions, replication factor and batch records must be "
+                                "positive");
+  }
+  return options;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  Options options;
+  try {
+    options = parseOptions(argc, argv);
+  } catch (const std::exception &e) {
+    std::cerr << "kafka_loggen: " << e.what() << std::endl;
+    return 2;
+  }
+
+  auto started = std::chrono::steady_clock::now();
+  auto summary = loggen::generateLogDir(options.directory, options.spec);
+  if (!summary) {
+    std::cerr << "kafka_loggen: " << summary.error().what() << std::endl;
+    return 1;
+  }
+  double seconds =
+      std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+
+  std::printf("%zu topics, %zu partitions: %llu records in %llu batches, %llu segments, "
+              "%.1f MiB in %.2f s\n",
+              summary->topics, summary->partitions,
+              static_cast<unsigned long long>(summary->records),
+              static_cast<unsigned long long>(summary->batches),
+              static_cast<unsigned long long>(summary->segments),
+              static_cast<double>(summary->bytes) / (1 << 20), seconds);
+  return 0;
+}
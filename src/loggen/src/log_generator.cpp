@@ -0,0 +1,247 @@
+#include "log_generator.hpp"
+#include "io/file_handle.hpp"
+#include "io/path_resolver.hpp"
+#include "records.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <span>
+
+namespace loggen {
+
+namespace {
+
+using storage::ErrorCode;
+using storage::StorageError;
+
+constexpr int16_t METADATA_VERSION = 20; // 3.8-IV0
+constexpr size_t WRITE_BUFFER_BYTES = 1 << 20;
+constexpr size_t PAYLOAD_POOL_BYTES = 64 * 1024;
+
+uint64_t splitmix64(uint64_t &state) {
+  uint64_t z = (state += 0x9e3779b97f4a7c15ULL);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  return z ^ (z >> 31);
+}
+
+// A random (version 4) UUID, drawn from `state`
+storage::TopicId randomUuid(uint64_t &state) {
+  uint64_t high = (splitmix64(state) & ~0xf000ULL) | 0x4000ULL;
+  uint64_t low = (splitmix64(state) & ~(3ULL << 62)) | (2ULL << 62);
+  return storage::TopicId {(static_cast<uint128_t>(high) << 64) | low};
+}
+
+// Random bytes that keys and values are sliced from, so records differ without generating
+// fresh bytes for each one
+std::vector<uint8_t> payloadPool(uint64_t seed, size_t record_bytes) {
+  std::vector<uint8_t> pool(PAYLOAD_POOL_BYTES + record_bytes);
+  uint64_t state = seed ^ 0x5eedULL;
+  for (size_t i = 0; i < pool.size(); i += 8) {
+    uint64_t word = splitmix64(state);
+    std::memcpy(pool.data() + i, &word, std::min<size_t>(8, pool.size() - i));
+  }
+  return pool;
+}
+
+std::expected<void, StorageError> createDirectories(const std::filesystem::path &path) {
+  std::error_code ec;
+  std::filesystem::create_directories(path, ec);
+  if (ec) {
+    return std::unexpected(StorageError(ErrorCode::IoError,
+                                        "Failed to create " + path.string() + ": " + ec.message()));
+  }
+  return {};
+}
+
+// Appends to a new file through a buffer, so each write(2) carries about a megabyte
+class BufferedFile {
+public:
+  static std::expected<std::unique_ptr<BufferedFile>, StorageError>
+  create(const std::string &path) {
+    if (auto created = createDirectories(std::filesystem::path(path).parent_path()); !created) {
+      return std::unexpected(created.error());
+    }
+    auto file = std::unique_ptr<BufferedFile>(new BufferedFile(path));
+    if (!file->file_.valid()) {
+      return std::unexpected(StorageError(ErrorCode::IoError, "Failed to create " + path + ": " +
+                                                                  std::strerror(errno)));
+    }
+    return file;
+  }
+
+  std::vector<uint8_t> &buffer() { return buffer_; }
+  [[nodiscard]] uint64_t size() const { return written_ + buffer_.size(); }
+
+  // Write the buffer out once it is full, or whatever it holds when `force` is set
+  std::expected<void, StorageError> flush(bool force = false) {
+    if (buffer_.empty() || (!force && buffer_.size() < WRITE_BUFFER_BYTES)) {
+      return {};
+    }
+    size_t done = 0;
+    while (done < buffer_.size()) {
+      ssize_t n = ::write(file_.get(), buffer_.data() + done, buffer_.size() - done);
+      if (n < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        return std::unexpected(StorageError(ErrorCode::IoError, "Failed to write " + path_ +
+                                                                    ": " + std::strerror(errno)));
+      }
+      done += static_cast<size_t>(n);
+    }
+    written_ += buffer_.size();
+    buffer_.clear();
+    return {};
+  }
+
+private:
+  explicit BufferedFile(std::string path)
+      : path_(std::move(path)), file_(path_, O_WRONLY | O_CREAT | O_TRUNC) {
+    buffer_.reserve(WRITE_BUFFER_BYTES + WRITE_BUFFER_BYTES / 4);
+  }
+
+  std::string path_;
+  storage::io::FileHandle file_;
+  std::vector<uint8_t> buffer_;
+  uint64_t written_ {0};
+};
+
+// Write one partition's records, starting a new segment whenever the next batch would take the
+// current one past `segment_bytes`
+std::expected<void, StorageError> writePartition(const storage::io::PathResolver &resolver,
+                                                 const std::string &topic, int32_t partition,
+                                                 const LogDirSpec &spec,
+                                                 std::span<const uint8_t> pool,
+                                                 LogDirSummary &summary) {
+  auto file = BufferedFile::create(resolver.segmentLogPath(topic, partition, 0));
+  if (!file) {
+    return std::unexpected(file.error());
+  }
+  summary.segments++;
+
+  RecordBatchBuilder builder;
+  std::vector<uint8_t> batch;
+  size_t per_batch = std::max<size_t>(spec.records_per_batch, 1);
+  uint64_t offset = 0;
+  while (offset < spec.records_per_partition) {
+    size_t count = static_cast<size_t>(
+        std::min<uint64_t>(per_batch, spec.records_per_partition - offset));
+    builder.setBaseTimestamp(spec.base_timestamp + static_cast<int64_t>(offset));
+    for (size_t i = 0; i < count; i++) {
+      size_t slice = ((offset + i) * 131) % PAYLOAD_POOL_BYTES;
+      auto value = pool.subspan(slice, spec.value_bytes);
+      if (spec.key_bytes > 0) {
+        builder.add(pool.subspan(PAYLOAD_POOL_BYTES - slice, spec.key_bytes), value,
+                    static_cast<int64_t>(i));
+      } else {
+        builder.add(value, static_cast<int64_t>(i));
+      }
+    }
+    batch.clear();
+    builder.finish(static_cast<int64_t>(offset), batch);
+
+    if ((*file)->size() > 0 && (*file)->size() + batch.size() > spec.segment_bytes) {
+      if (auto flushed = (*file)->flush(true); !flushed) {
+        return flushed;
+      }
+      file = BufferedFile::create(
+          resolver.segmentLogPath(topic, partition, static_cast<int64_t>(offset)));
+      if (!file) {
+        return std::unexpected(file.error());
+      }
+      summary.segments++;
+    }
+
+    auto &buffer = (*file)->buffer();
+    buffer.insert(buffer.end(), batch.begin(), batch.end());
+    if (auto flushed = (*file)->flush(); !flushed) {
+      return flushed;
+    }
+    summary.batches++;
+    summary.records += count;
+    summary.bytes += batch.size();
+    offset += count;
+  }
+  return (*file)->flush(true);
+}
+
+} // namespace
+
+std::vector<storage::TopicInfo> topicsFor(const LogDirSpec &spec) {
+  uint64_t state = spec.seed;
+  int32_t brokers = std::max(spec.replication_factor, 1);
+  std::vector<storage::TopicInfo> topics(spec.topics);
+  int32_t assigned = 0;
+  for (size_t t = 0; t < spec.topics; t++) {
+    auto &topic = topics[t];
+    topic.name = spec.topic_prefix + std::to_string(t);
+    topic.topic_id = randomUuid(state);
+    for (int32_t p = 0; p < spec.partitions; p++, assigned++) {
+      storage::PartitionInfo partition;
+      partition.partition_id = p;
+      partition.topic_id = topic.topic_id;
+      for (int32_t r = 0; r < brokers; r++) {
+        partition.replicas.push_back((assigned + r) % brokers + 1);
+      }
+      partition.isr = partition.replicas;
+      partition.leader_id = partition.replicas.front();
+      topic.partitions.push_back(std::move(partition));
+    }
+  }
+  return topics;
+}
+
+std::vector<uint8_t> metadataLog(const std::vector<storage::TopicInfo> &topics) {
+  std::vector<uint8_t> log;
+  RecordBatchBuilder builder;
+  int64_t offset = 0;
+  builder.add(featureLevelRecord("metadata.version", METADATA_VERSION));
+  offset += builder.count();
+  builder.finish(0, log);
+
+  for (const auto &topic : topics) {
+    int64_t base = offset;
+    builder.add(topicRecord(topic.name, topic.topic_id));
+    for (const auto &partition : topic.partitions) {
+      builder.add(partitionRecord(partition));
+    }
+    offset += builder.count();
+    builder.finish(base, log);
+  }
+  return log;
+}
+
+std::expected<LogDirSummary, storage::StorageError> generateLogDir(const std::string &directory,
+                                                                    const LogDirSpec &spec) {
+  storage::io::PathResolver resolver(directory);
+  auto topics = topicsFor(spec);
+
+  auto metadata = BufferedFile::create(resolver.clusterMetadataPath());
+  if (!metadata) {
+    return std::unexpected(metadata.error());
+  }
+  (*metadata)->buffer() = metadataLog(topics);
+  if (auto flushed = (*metadata)->flush(true); !flushed) {
+    return std::unexpected(flushed.error());
+  }
+
+  LogDirSummary summary;
+  summary.topics = topics.size();
+  auto pool = payloadPool(spec.seed, std::max(spec.key_bytes, spec.value_bytes));
+  for (const auto &topic : topics) {
+    for (const auto &partition : topic.partitions) {
+      if (auto written = writePartition(resolver, topic.name, partition.partition_id, spec, pool,
+                                        summary);
+          !written) {
+        return std::unexpected(written.error());
+      }
+      summary.partitions++;
+    }
+  }
+  return summary;
+}
+
+} // namespace loggen
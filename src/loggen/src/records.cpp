@@ -0,0 +1,171 @@
+#include "records.hpp"
+#include "crc32c.hpp"
+#include <algorithm>
+
+namespace loggen {
+
+namespace {
+
+// Fixed fields of a v2 batch: base_offset through records count
+constexpr size_t BATCH_HEADER_SIZE = 61;
+constexpr size_t CRC_OFFSET = 17;
+constexpr size_t CRC_START = 21; // attributes onwards
+
+// Metadata record frame: version, type, record version
+constexpr uint8_t FRAME_VERSION = 1;
+constexpr uint8_t TOPIC_RECORD = 2;
+constexpr uint8_t PARTITION_RECORD = 3;
+constexpr uint8_t FEATURE_LEVEL_RECORD = 12;
+
+void putBigEndian(std::vector<uint8_t> &out, uint64_t value, int bytes) {
+  for (int shift = 8 * (bytes - 1); shift >= 0; shift -= 8) {
+    out.push_back(static_cast<uint8_t>(value >> shift));
+  }
+}
+
+void putUnsignedVarint(std::vector<uint8_t> &out, uint64_t value) {
+  while (value >= 0x80) {
+    out.push_back(static_cast<uint8_t>(value | 0x80));
+    value >>= 7;
+  }
+  out.push_back(static_cast<uint8_t>(value));
+}
+
+void putVarint(std::vector<uint8_t> &out, int64_t value) {
+  putUnsignedVarint(out, (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63));
+}
+
+size_t varintSize(int64_t value) {
+  uint64_t n = (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+  size_t size = 1;
+  while (n >= 0x80) {
+    n >>= 7;
+    size++;
+  }
+  return size;
+}
+
+void putUuid(std::vector<uint8_t> &out, uint128_t id) {
+  putBigEndian(out, static_cast<uint64_t>(id >> 64), 8);
+  putBigEndian(out, static_cast<uint64_t>(id), 8);
+}
+
+void putCompactString(std::vector<uint8_t> &out, std::string_view value) {
+  putUnsignedVarint(out, value.size() + 1);
+  out.insert(out.end(), value.begin(), value.end());
+}
+
+void putCompactInt32Array(std::vector<uint8_t> &out, const std::vector<int32_t> &values) {
+  putUnsignedVarint(out, values.size() + 1);
+  for (int32_t value : values) {
+    putBigEndian(out, static_cast<uint32_t>(value), 4);
+  }
+}
+
+std::vector<uint8_t> frame(uint8_t type, uint8_t version) {
+  return {FRAME_VERSION, type, version};
+}
+
+} // namespace
+
+void RecordBatchBuilder::add(std::span<const uint8_t> value, int64_t timestamp_delta) {
+  addRecord(nullptr, -1, value, timestamp_delta);
+}
+
+void RecordBatchBuilder::add(std::span<const uint8_t> key, std::span<const uint8_t> value,
+                             int64_t timestamp_delta) {
+  addRecord(key.data(), static_cast<int64_t>(key.size()), value, timestamp_delta);
+}
+
+void RecordBatchBuilder::addRecord(const uint8_t *key, int64_t key_length,
+                                   std::span<const uint8_t> value, int64_t timestamp_delta) {
+  auto value_length = static_cast<int64_t>(value.size());
+  // Body size is known up front, so the record goes straight into the buffer
+  size_t body = 1 + varintSize(timestamp_delta) + varintSize(count_) + varintSize(key_length) +
+                static_cast<size_t>(std::max<int64_t>(key_length, 0)) + varintSize(value_length) +
+                value.size() + 1;
+
+  putVarint(records_, static_cast<int64_t>(body));
+  records_.push_back(0); // attributes
+  putVarint(records_, timestamp_delta);
+  putVarint(records_, count_);
+  putVarint(records_, key_length);
+  if (key_length > 0) {
+    records_.insert(records_.end(), key, key + key_length);
+  }
+  putVarint(records_, value_length);
+  records_.insert(records_.end(), value.begin(), value.end());
+  putVarint(records_, 0); // headers
+
+  max_timestamp_delta_ = std::max(max_timestamp_delta_, timestamp_delta);
+  count_++;
+}
+
+size_t RecordBatchBuilder::finish(int64_t base_offset, std::vector<uint8_t> &out) {
+  size_t start = out.size();
+  size_t size = BATCH_HEADER_SIZE + records_.size();
+  out.reserve(start + size);
+
+  putBigEndian(out, static_cast<uint64_t>(base_offset), 8);
+  putBigEndian(out, static_cast<uint32_t>(size - 12), 4); // batch length, after this field
+  putBigEndian(out, 0, 4);                                // partition leader epoch
+  out.push_back(2);                                       // magic
+  putBigEndian(out, 0, 4);                                // crc, filled in below
+  putBigEndian(out, 0, 2);                                // attributes: no compression
+  putBigEndian(out, static_cast<uint32_t>(count_ - 1), 4);
+  putBigEndian(out, static_cast<uint64_t>(base_timestamp_), 8);
+  putBigEndian(out, static_cast<uint64_t>(base_timestamp_ + max_timestamp_delta_), 8);
+  putBigEndian(out, static_cast<uint64_t>(-1), 8); // producer id
+  putBigEndian(out, static_cast<uint16_t>(-1), 2); // producer epoch
+  putBigEndian(out, static_cast<uint32_t>(-1), 4); // base sequence
+  putBigEndian(out, static_cast<uint32_t>(count_), 4);
+  out.insert(out.end(), records_.begin(), records_.end());
+
+  uint32_t crc = common::crc32c(out.data() + start + CRC_START, size - CRC_START);
+  for (int i = 0; i < 4; i++) {
+    out[start + CRC_OFFSET + static_cast<size_t>(i)] = static_cast<uint8_t>(crc >> (24 - 8 * i));
+  }
+
+  records_.clear();
+  max_timestamp_delta_ = 0;
+  count_ = 0;
+  return size;
+}
+
+std::vector<uint8_t> featureLevelRecord(std::string_view name, int16_t level) {
+  auto value = frame(FEATURE_LEVEL_RECORD, 0);
+  putCompactString(value, name);
+  putBigEndian(value, static_cast<uint16_t>(level), 2);
+  value.push_back(0); // tagged fields
+  return value;
+}
+
+std::vector<uint8_t> topicRecord(std::string_view name, storage::TopicId id) {
+  auto value = frame(TOPIC_RECORD, 0);
+  putCompactString(value, name);
+  putUuid(value, id.value);
+  value.push_back(0);
+  return value;
+}
+
+std::vector<uint8_t> partitionRecord(const storage::PartitionInfo &partition) {
+  auto value = frame(PARTITION_RECORD, 1);
+  putBigEndian(value, static_cast<uint32_t>(partition.partition_id), 4);
+  putUuid(value, partition.topic_id.value);
+  putCompactInt32Array(value, partition.replicas);
+  putCompactInt32Array(value, partition.isr);
+  putCompactInt32Array(value, {}); // removing replicas
+  putCompactInt32Array(value, {}); // adding replicas
+  putBigEndian(value, static_cast<uint32_t>(partition.leader_id), 4);
+  putBigEndian(value, static_cast<uint32_t>(partition.leader_epoch), 4);
+  putBigEndian(value, static_cast<uint32_t>(partition.partition_epoch), 4);
+  // Directories: unassigned, as a controller writes them before brokers report their disks
+  putUnsignedVarint(value, partition.replicas.size() + 1);
+  for (size_t i = 0; i < partition.replicas.size(); i++) {
+    putUuid(value, 0);
+  }
+  value.push_back(0);
+  return value;
+}
+
+} // namespace loggen
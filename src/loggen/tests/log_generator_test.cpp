@@ -0,0 +1,147 @@
+#include "io/path_resolver.hpp"
+#include "log/batch_header.hpp"
+#include "log/log_store.hpp"
+#include "log_generator.hpp"
+#include "metadata/metadata_store.hpp"
+#include <filesystem>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <iterator>
+#include <unistd.h>
+
+using namespace loggen;
+
+namespace {
+
+std::vector<uint8_t> readFile(const std::filesystem::path &path) {
+  std::ifstream in(path, std::ios::binary);
+  return {std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+}
+
+class LogGeneratorTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    base_ = std::filesystem::temp_directory_path() /
+            ("log_generator_test_" + std::to_string(::getpid()));
+    std::filesystem::remove_all(base_);
+  }
+
+  void TearDown() override { std::filesystem::remove_all(base_); }
+
+  [[nodiscard]] std::string dir() const { return base_.string(); }
+
+  std::filesystem::path base_;
+};
+
+} // namespace
+
+TEST_F(LogGeneratorTest, MetadataLogLoadsIntoSnapshot) {
+  LogDirSpec spec;
+  spec.topics = 3;
+  spec.partitions = 4;
+  spec.replication_factor = 3;
+  ASSERT_TRUE(generateLogDir(dir(), spec).has_value());
+
+  storage::metadata::MetadataStore store {storage::io::PathResolver(dir())};
+  auto snapshot = store.loadClusterSnapshot();
+  ASSERT_TRUE(snapshot.has_value()) << snapshot.error().what();
+
+  auto expected = topicsFor(spec);
+  ASSERT_EQ((*snapshot)->topics().size(), 3u);
+  for (const auto &topic : expected) {
+    const auto *loaded = (*snapshot)->findByName(topic.name);
+    ASSERT_NE(loaded, nullptr) << topic.name;
+    EXPECT_EQ(loaded->topic_id, topic.topic_id);
+    ASSERT_EQ(loaded->partitions.size(), 4u);
+    for (size_t p = 0; p < loaded->partitions.size(); p++) {
+      EXPECT_EQ(loaded->partitions[p].replicas, topic.partitions[p].replicas);
+      EXPECT_EQ(loaded->partitions[p].leader_id, topic.partitions[p].replicas.front());
+    }
+  }
+  // Leaders rotate over the brokers
+  EXPECT_NE(expected[0].partitions[0].leader_id, expected[0].partitions[1].leader_id);
+}
+
+TEST_F(LogGeneratorTest, PartitionsHoldEveryRecord) {
+  LogDirSpec spec;
+  spec.topics = 2;
+  spec.partitions = 2;
+  spec.records_per_partition = 95;
+  spec.records_per_batch = 10;
+  auto summary = generateLogDir(dir(), spec);
+  ASSERT_TRUE(summary.has_value()) << summary.error().what();
+  EXPECT_EQ(summary->partitions, 4u);
+  EXPECT_EQ(summary->records, 4u * 95);
+  EXPECT_EQ(summary->batches, 4u * 10); // the last batch of each partition holds 5
+
+  storage::log::LogStore store {storage::io::PathResolver(dir())};
+  auto range = store.readPartitionRange("topic-1", 1, 0, 1 << 20);
+  ASSERT_TRUE(range.has_value()) << range.error().what();
+  EXPECT_EQ(range->high_watermark, 95);
+  ASSERT_EQ(range->regions.size(), 1u);
+  EXPECT_EQ(range->regions[0].length * 4, summary->bytes);
+}
+
+TEST_F(LogGeneratorTest, SegmentsRollAtSegmentBytes) {
+  LogDirSpec spec;
+  spec.records_per_partition = 200;
+  spec.records_per_batch = 10;
+  spec.key_bytes = 16;
+  spec.value_bytes = 50;
+  spec.segment_bytes = 4096;
+  auto summary = generateLogDir(dir(), spec);
+  ASSERT_TRUE(summary.has_value());
+  EXPECT_GT(summary->segments, 1u);
+
+  std::vector<std::filesystem::path> segments;
+  for (const auto &entry : std::filesystem::directory_iterator(base_ / "topic-0-0")) {
+    segments.push_back(entry.path());
+  }
+  ASSERT_EQ(segments.size(), summary->segments);
+  for (const auto &path : segments) {
+    auto bytes = readFile(path);
+    EXPECT_LE(bytes.size(), spec.segment_bytes);
+    auto batches = storage::log::validateBatches(bytes);
+    ASSERT_TRUE(batches.has_value()) << path << ": " << batches.error().what();
+    // Each segment is named after the first offset in it
+    auto base = storage::io::PathResolver::parseSegmentFileName(path.filename().string());
+    EXPECT_EQ(base, storage::log::readBatchHeader(bytes, 0)->base_offset);
+  }
+
+  storage::log::LogStore store {storage::io::PathResolver(dir())};
+  auto range = store.readPartitionRange("topic-0", 0, 150, 1 << 20);
+  ASSERT_TRUE(range.has_value());
+  EXPECT_EQ(range->high_watermark, 200);
+}
+
+TEST_F(LogGeneratorTest, OutputDependsOnlyOnTheSpec) {
+  LogDirSpec spec;
+  spec.records_per_partition = 30;
+  spec.key_bytes = 8;
+  ASSERT_TRUE(generateLogDir(dir() + "/a", spec).has_value());
+  ASSERT_TRUE(generateLogDir(dir() + "/b", spec).has_value());
+
+  for (const char *file : {"__cluster_metadata-0/00000000000000000000.log",
+                           "topic-0-0/00000000000000000000.log"}) {
+    EXPECT_EQ(readFile(base_ / "a" / file), readFile(base_ / "b" / file)) << file;
+  }
+
+  auto reseeded = spec;
+  reseeded.seed = 2;
+  EXPECT_NE(topicsFor(spec)[0].topic_id, topicsFor(reseeded)[0].topic_id);
+}
+
+TEST_F(LogGeneratorTest, EmptyPartitionsGetAnEmptySegment) {
+  ASSERT_TRUE(generateLogDir(dir(), LogDirSpec {}).has_value());
+  auto segment = base_ / "topic-0-0" / "00000000000000000000.log";
+  ASSERT_TRUE(std::filesystem::exists(segment));
+  EXPECT_EQ(std::filesystem::file_size(segment), 0u);
+}
+
+TEST_F(LogGeneratorTest, UnwritableDirectoryIsAnIoError) {
+  std::filesystem::create_directories(base_);
+  std::ofstream(base_ / "file") << "not a directory";
+  auto summary = generateLogDir((base_ / "file").string(), LogDirSpec {});
+  ASSERT_FALSE(summary.has_value());
+  EXPECT_EQ(summary.error().code(), storage::ErrorCode::IoError);
+}
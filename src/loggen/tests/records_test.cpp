@@ -0,0 +1,108 @@
+#include "log/batch_header.hpp"
+#include "metadata/metadata_decoder.hpp"
+#include "metadata/record_extractor.hpp"
+#include "records.hpp"
+#include <gtest/gtest.h>
+#include <string>
+
+using namespace loggen;
+
+namespace {
+
+std::vector<uint8_t> bytes(const std::string &text) { return {text.begin(), text.end()}; }
+
+int64_t readInt64(const std::vector<uint8_t> &data, size_t pos) {
+  int64_t value = 0;
+  for (size_t i = 0; i < 8; i++) {
+    value = (value << 8) | data[pos + i];
+  }
+  return value;
+}
+
+} // namespace
+
+TEST(RecordBatchBuilderTest, BatchesPassProduceValidation) {
+  RecordBatchBuilder builder;
+  std::vector<uint8_t> log;
+  for (int64_t base : {0, 3}) {
+    for (int i = 0; i < 3; i++) {
+      builder.add(bytes("value-" + std::to_string(i)));
+    }
+    builder.finish(base, log);
+  }
+
+  auto batches = storage::log::validateBatches(log);
+  ASSERT_TRUE(batches.has_value()) << batches.error().what();
+  ASSERT_EQ(batches->size(), 2u);
+  EXPECT_EQ((*batches)[0].size + (*batches)[1].size, log.size());
+
+  auto second = storage::log::readBatchHeader(log, (*batches)[0].size);
+  ASSERT_TRUE(second.has_value());
+  EXPECT_EQ(second->base_offset, 3);
+  EXPECT_EQ(second->last_offset, 5);
+}
+
+TEST(RecordBatchBuilderTest, ValuesComeBackInOrder) {
+  RecordBatchBuilder builder;
+  builder.add(bytes("key"), bytes("first"));
+  builder.add(bytes("second"));
+  builder.add(std::vector<uint8_t>(300, 'x')); // two-byte length varints
+  EXPECT_EQ(builder.count(), 3);
+
+  std::vector<uint8_t> batch;
+  size_t size = builder.finish(0, batch);
+  EXPECT_EQ(size, batch.size());
+  EXPECT_TRUE(builder.empty());
+
+  auto values = storage::metadata::extractRecordValues(batch);
+  ASSERT_EQ(values.size(), 3u);
+  EXPECT_EQ(values[0], bytes("first"));
+  EXPECT_EQ(values[1], bytes("second"));
+  EXPECT_EQ(values[2], std::vector<uint8_t>(300, 'x'));
+}
+
+TEST(RecordBatchBuilderTest, TimestampsSpanTheRecords) {
+  RecordBatchBuilder builder(1'000);
+  builder.add(bytes("a"), 0);
+  builder.add(bytes("b"), 250);
+  builder.add(bytes("c"), 100);
+  std::vector<uint8_t> batch;
+  builder.finish(0, batch);
+
+  EXPECT_EQ(readInt64(batch, 27), 1'000); // base timestamp
+  EXPECT_EQ(readInt64(batch, 35), 1'250); // max timestamp
+}
+
+TEST(MetadataRecordsTest, TopicRecordDecodes) {
+  storage::TopicId id {(static_cast<uint128_t>(0x0123456789abcdefULL) << 64) | 42};
+  auto topic = storage::metadata::decodeTopicRecord(topicRecord("orders", id));
+  EXPECT_EQ(topic.name, "orders");
+  EXPECT_EQ(topic.topic_id, id);
+}
+
+TEST(MetadataRecordsTest, PartitionRecordDecodes) {
+  storage::PartitionInfo partition;
+  partition.partition_id = 7;
+  partition.topic_id = storage::TopicId {99};
+  partition.replicas = {2, 3, 1};
+  partition.isr = {2, 3};
+  partition.leader_id = 2;
+  partition.leader_epoch = 4;
+  partition.partition_epoch = 9;
+
+  auto value = partitionRecord(partition);
+  EXPECT_EQ(value[2], 1); // record version with directories
+  auto decoded = storage::metadata::decodePartitionRecord(value);
+  EXPECT_EQ(decoded.partition_id, 7);
+  EXPECT_EQ(decoded.topic_id, partition.topic_id);
+  EXPECT_EQ(decoded.replicas, partition.replicas);
+  EXPECT_EQ(decoded.isr, partition.isr);
+  EXPECT_EQ(decoded.leader_id, 2);
+  EXPECT_EQ(decoded.leader_epoch, 4);
+  EXPECT_EQ(decoded.partition_epoch, 9);
+}
+
+TEST(MetadataRecordsTest, FeatureLevelRecordLayout) {
+  std::vector<uint8_t> expected {1, 12, 0, 4, 'a', 'b', 'c', 0, 20, 0};
+  EXPECT_EQ(featureLevelRecord("abc", 20), expected);
+}
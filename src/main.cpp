@@ -1,9 +1,59 @@
 #include "server/include/kafka_server.hpp"
+#include "trace.hpp"
+#include <chrono>
+#include <cstring>
 #include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <string>
 
-int main() {
+namespace {
+
+storage::FsyncPolicy::Mode parseFsyncMode(const std::string &name) {
+  using Mode = storage::FsyncPolicy::Mode;
+  if (name == "every-batch") {
+    return Mode::EveryBatch;
+  }
+  if (name == "interval") {
+    return Mode::Interval;
+  }
+  if (name == "bytes") {
+    return Mode::Bytes;
+  }
+  if (name == "os") {
+    return Mode::Os;
+  }
+  throw std::invalid_argument("unknown --fsync-policy: " + name);
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
   try {
-    KafkaServer server;
+    // --metrics-port N serves Prometheus metrics over HTTP, and with --trace request spans at
+    // /trace as well. --fsync-policy every-batch|interval|bytes|os picks when produced records
+    // are synced, tuned by --fsync-interval-ms and --fsync-bytes. Other arguments are ignored.
+    std::optional<uint16_t> metrics_port;
+    storage::FsyncPolicy fsync_policy;
+    for (int i = 1; i < argc; i++) {
+      bool has_value = i + 1 < argc;
+      if (std::strcmp(argv[i], "--metrics-port") == 0 && has_value) {
+        metrics_port = static_cast<uint16_t>(std::stoul(argv[++i]));
+      } else if (std::strcmp(argv[i], "--trace") == 0) {
+        common::trace::enable();
+      } else if (std::strcmp(argv[i], "--fsync-policy") == 0 && has_value) {
+        fsync_policy.mode = parseFsyncMode(argv[++i]);
+      } else if (std::strcmp(argv[i], "--fsync-interval-ms") == 0 && has_value) {
+        fsync_policy.interval = std::chrono::milliseconds(std::stoul(argv[++i]));
+      } else if (std::strcmp(argv[i], "--fsync-bytes") == 0 && has_value) {
+        fsync_policy.bytes = std::stoull(argv[++i]);
+      }
+    }
+
+    KafkaServer server(9092, fsync_policy);
+    if (metrics_port) {
+      server.serveMetrics(*metrics_port);
+    }
     server.start();
   } catch (const std::exception &e) {
     std::cerr << "Error: " << e.what() << std::endl;
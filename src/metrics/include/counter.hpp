@@ -0,0 +1,42 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace metrics {
+
+// Each thread adds to one of SHARDS cache lines, picked the first time it records anything, so
+// threads on a hot path do not bounce a shared line between cores. Reads sum every shard.
+inline constexpr size_t SHARDS = 16;
+
+inline size_t threadShard() {
+  static std::atomic<size_t> next {0};
+  thread_local size_t shard = next.fetch_add(1, std::memory_order_relaxed) % SHARDS;
+  return shard;
+}
+
+// Monotonic count, e.g. requests or bytes
+class Counter {
+public:
+  void add(uint64_t n = 1) {
+    slots_[threadShard()].value.fetch_add(n, std::memory_order_relaxed);
+  }
+
+  [[nodiscard]] uint64_t value() const {
+    uint64_t total = 0;
+    for (const auto &slot : slots_) {
+      total += slot.value.load(std::memory_order_relaxed);
+    }
+    return total;
+  }
+
+private:
+  struct alignas(64) Slot {
+    std::atomic<uint64_t> value {0};
+  };
+  std::array<Slot, SHARDS> slots_ {};
+};
+
+} // namespace metrics
@@ -0,0 +1,111 @@
+#pragma once
+
+#include "hdr_buckets.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <vector>
+
+namespace metrics {
+
+// Durations in nanoseconds, bucketed like HdrHistogram: exact below 128 ns, then 64 buckets per
+// power of two, so every value is kept to within 1.6%. Recording is a few shifts and relaxed
+// atomic adds, safe from any number of threads without a lock; readers see a consistent count
+// per bucket but may catch a record half done across buckets and the sum.
+class LatencyHistogram {
+public:
+  static constexpr int SIGNIFICANT_BITS = 7;
+  static constexpr int64_t HIGHEST = int64_t {1} << 37; // about 137 s; longer is clamped
+
+  LatencyHistogram() : counts_(std::make_unique<std::atomic<uint64_t>[]>(BUCKET_COUNT)) {}
+
+  void record(int64_t nanos) {
+    auto value = static_cast<uint64_t>(std::clamp<int64_t>(nanos, 0, HIGHEST - 1));
+    counts_[indexOf(value)].fetch_add(1, std::memory_order_relaxed);
+    sum_.fetch_add(value, std::memory_order_relaxed);
+  }
+
+  void record(std::chrono::nanoseconds duration) { record(duration.count()); }
+
+  [[nodiscard]] uint64_t count() const {
+    uint64_t total = 0;
+    for (size_t i = 0; i < BUCKET_COUNT; i++) {
+      total += counts_[i].load(std::memory_order_relaxed);
+    }
+    return total;
+  }
+
+  // Sum of every recorded value, in nanoseconds
+  [[nodiscard]] uint64_t sum() const { return sum_.load(std::memory_order_relaxed); }
+
+  // Recorded values no larger than each of `bounds`, which must be ascending, give or take the
+  // width of the bucket holding the bound. One pass over the buckets serves every bound.
+  [[nodiscard]] std::vector<uint64_t> countsAtOrBelow(std::span<const int64_t> bounds) const {
+    std::vector<uint64_t> counts(bounds.size(), 0);
+    uint64_t total = 0;
+    size_t next = 0;
+    for (size_t i = 0; i < BUCKET_COUNT && next < bounds.size(); i++) {
+      while (next < bounds.size() && highestEquivalent(i) > bounds[next]) {
+        counts[next++] = total;
+      }
+      total += counts_[i].load(std::memory_order_relaxed);
+    }
+    while (next < bounds.size()) {
+      counts[next++] = total;
+    }
+    return counts;
+  }
+
+  [[nodiscard]] uint64_t countAtOrBelow(int64_t nanos) const {
+    return countsAtOrBelow(std::span(&nanos, 1)).front();
+  }
+
+  // Value that `percentile` percent of recorded values are at or below, as the top of its bucket
+  [[nodiscard]] int64_t valueAt(double percentile) const {
+    uint64_t total = count();
+    if (total == 0) {
+      return 0;
+    }
+    auto wanted = static_cast<uint64_t>(percentile / 100.0 * static_cast<double>(total) + 0.5);
+    wanted = std::clamp<uint64_t>(wanted, 1, total);
+    uint64_t seen = 0;
+    for (size_t i = 0; i < BUCKET_COUNT; i++) {
+      seen += counts_[i].load(std::memory_order_relaxed);
+      if (seen >= wanted) {
+        return highestEquivalent(i);
+      }
+    }
+    return HIGHEST;
+  }
+
+private:
+  using Buckets = common::HdrBuckets<SIGNIFICANT_BITS>;
+  static constexpr size_t BUCKET_COUNT = Buckets::countFor(HIGHEST - 1);
+
+  static size_t indexOf(uint64_t value) { return Buckets::indexOf(value); }
+  static int64_t highestEquivalent(size_t index) { return Buckets::highestEquivalent(index); }
+
+  std::unique_ptr<std::atomic<uint64_t>[]> counts_;
+  std::atomic<uint64_t> sum_ {0};
+};
+
+// Records the time from construction to destruction
+class ScopedTimer {
+public:
+  explicit ScopedTimer(LatencyHistogram &histogram)
+      : histogram_(histogram), started_(std::chrono::steady_clock::now()) {}
+  ~ScopedTimer() { histogram_.record(std::chrono::steady_clock::now() - started_); }
+
+  ScopedTimer(const ScopedTimer &) = delete;
+  ScopedTimer &operator=(const ScopedTimer &) = delete;
+
+private:
+  LatencyHistogram &histogram_;
+  std::chrono::steady_clock::time_point started_;
+};
+
+} // namespace metrics
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "counter.hpp"
+#include "latency_histogram.hpp"
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace metrics {
+
+using Labels = std::vector<std::pair<std::string, std::string>>;
+
+// Named metrics, each a family of series told apart by labels. Metrics are registered up front
+// and the references handed out stay valid for the registry's lifetime, so recording never
+// touches the registry itself.
+class Registry {
+public:
+  // The series `name{labels}`, created on first use. Counter names should end in _total.
+  Counter &counter(const std::string &name, const std::string &help, const Labels &labels = {});
+  LatencyHistogram &histogram(const std::string &name, const std::string &help,
+                              const Labels &labels = {});
+
+  // Every series in Prometheus' text exposition format (version 0.0.4). Latencies are exported
+  // as histograms in seconds, with buckets from 1 us to 10 s.
+  [[nodiscard]] std::string exposition() const;
+
+private:
+  enum class Type { Counter, Histogram };
+
+  struct Series {
+    Labels labels;
+    std::unique_ptr<Counter> counter;
+    std::unique_ptr<LatencyHistogram> histogram;
+  };
+
+  struct Family {
+    std::string name;
+    std::string help;
+    Type type;
+    std::deque<Series> series;
+  };
+
+  Series &series(const std::string &name, const std::string &help, Type type,
+                 const Labels &labels);
+
+  mutable std::mutex mutex_;
+  std::deque<Family> families_;
+};
+
+} // namespace metrics
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "registry.hpp"
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace metrics {
+
+// Minimal HTTP/1.1 server for Prometheus: GET /metrics answers with the registry's exposition,
+// added routes with what their handler returns, anything else with 404. One thread serves one
+// scrape at a time and closes every connection after its response, which is all a scraper needs.
+class ScrapeEndpoint {
+public:
+  // Listen on `port` on all interfaces, or on an ephemeral port when it is 0. Throws
+  // std::system_error if the port cannot be bound.
+  ScrapeEndpoint(const Registry &registry, uint16_t port);
+
+  // Stops serving; a scrape in progress is finished first
+  ~ScrapeEndpoint();
+
+  ScrapeEndpoint(const ScrapeEndpoint &) = delete;
+  ScrapeEndpoint &operator=(const ScrapeEndpoint &) = delete;
+
+  [[nodiscard]] uint16_t port() const { return port_; }
+
+  // Also answer GET `path` with the body `handler` returns, which runs on the endpoint's thread
+  void route(std::string path, std::string content_type, std::function<std::string()> handler);
+
+private:
+  struct Route {
+    std::string path;
+    std::string content_type;
+    std::function<std::string()> handler;
+  };
+
+  void run();
+  void serve(int client) const;
+
+  const Registry &registry_;
+  mutable std::mutex routes_mutex_;
+  std::vector<Route> routes_;
+  int listen_fd_ {-1};
+  int wake_[2] {-1, -1}; // written to on shutdown, to end the poll in run()
+  uint16_t port_ {0};
+  std::thread thread_;
+};
+
+} // namespace metrics
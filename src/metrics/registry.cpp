@@ -0,0 +1,142 @@
+#include "include/registry.hpp"
+#include <array>
+#include <cstdio>
+#include <stdexcept>
+
+namespace metrics {
+
+namespace {
+
+// Histogram bucket bounds: 1, 2.5 and 5 of every decade from 1 us to 10 s
+constexpr std::array<int64_t, 22> BUCKET_BOUNDS_NS {
+    1'000,         2'500,         5'000,         10'000,         25'000,        50'000,
+    100'000,       250'000,       500'000,       1'000'000,      2'500'000,     5'000'000,
+    10'000'000,    25'000'000,    50'000'000,    100'000'000,    250'000'000,   500'000'000,
+    1'000'000'000, 2'500'000'000, 5'000'000'000, 10'000'000'000};
+
+void appendEscaped(std::string &out, const std::string &value) {
+  for (char c : value) {
+    if (c == '\\' || c == '"') {
+      out += '\\';
+      out += c;
+    } else if (c == '\n') {
+      out += "\\n";
+    } else {
+      out += c;
+    }
+  }
+}
+
+// `{a="1",b="2"}`, with `extra` (the le of a histogram bucket) last; nothing for no labels
+void appendLabels(std::string &out, const Labels &labels, const char *extra = nullptr) {
+  if (labels.empty() && !extra) {
+    return;
+  }
+  out += '{';
+  for (size_t i = 0; i < labels.size(); i++) {
+    if (i > 0) {
+      out += ',';
+    }
+    out += labels[i].first;
+    out += "=\"";
+    appendEscaped(out, labels[i].second);
+    out += '"';
+  }
+  if (extra) {
+    out += labels.empty() ? "" : ",";
+    out += extra;
+  }
+  out += '}';
+}
+
+std::string seconds(double nanos) {
+  char text[32];
+  std::snprintf(text, sizeof(text), "%.9g", nanos / 1e9);
+  return text;
+}
+
+void appendHistogram(std::string &out, const std::string &name, const Labels &labels,
+                     const LatencyHistogram &histogram) {
+  // Buckets are cumulative; count comes last so it is never below the +Inf bucket
+  auto counts = histogram.countsAtOrBelow(BUCKET_BOUNDS_NS);
+  for (size_t i = 0; i < BUCKET_BOUNDS_NS.size(); i++) {
+    std::string le = "le=\"" + seconds(static_cast<double>(BUCKET_BOUNDS_NS[i])) + "\"";
+    out += name + "_bucket";
+    appendLabels(out, labels, le.c_str());
+    out += ' ' + std::to_string(counts[i]) + '\n';
+  }
+  uint64_t count = histogram.count();
+  out += name + "_bucket";
+  appendLabels(out, labels, "le=\"+Inf\"");
+  out += ' ' + std::to_string(count) + '\n';
+  out += name + "_sum";
+  appendLabels(out, labels);
+  out += ' ' + seconds(static_cast<double>(histogram.sum())) + '\n';
+  out += name + "_count";
+  appendLabels(out, labels);
+  out += ' ' + std::to_string(count) + '\n';
+}
+
+} // namespace
+
+Counter &Registry::counter(const std::string &name, const std::string &help,
+                           const Labels &labels) {
+  return *series(name, help, Type::Counter, labels).counter;
+}
+
+LatencyHistogram &Registry::histogram(const std::string &name, const std::string &help,
+                                      const Labels &labels) {
+  return *series(name, help, Type::Histogram, labels).histogram;
+}
+
+Registry::Series &Registry::series(const std::string &name, const std::string &help, Type type,
+                                   const Labels &labels) {
+  std::lock_guard lock(mutex_);
+  Family *family = nullptr;
+  for (auto &existing : families_) {
+    if (existing.name == name) {
+      family = &existing;
+      break;
+    }
+  }
+  if (!family) {
+    family = &families_.emplace_back(Family {name, help, type, {}});
+  } else if (family->type != type) {
+    throw std::invalid_argument("Metric " + name + " registered with another type");
+  }
+
+  for (auto &existing : family->series) {
+    if (existing.labels == labels) {
+      return existing;
+    }
+  }
+  auto &created = family->series.emplace_back();
+  created.labels = labels;
+  if (type == Type::Counter) {
+    created.counter = std::make_unique<Counter>();
+  } else {
+    created.histogram = std::make_unique<LatencyHistogram>();
+  }
+  return created;
+}
+
+std::string Registry::exposition() const {
+  std::lock_guard lock(mutex_);
+  std::string out;
+  for (const auto &family : families_) {
+    out += "# HELP " + family.name + ' ' + family.help + '\n';
+    out += "# TYPE " + family.name + (family.type == Type::Counter ? " counter\n" : " histogram\n");
+    for (const auto &series : family.series) {
+      if (family.type == Type::Counter) {
+        out += family.name;
+        appendLabels(out, series.labels);
+        out += ' ' + std::to_string(series.counter->value()) + '\n';
+      } else {
+        appendHistogram(out, family.name, series.labels, *series.histogram);
+      }
+    }
+  }
+  return out;
+}
+
+} // namespace metrics
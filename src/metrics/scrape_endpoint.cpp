@@ -0,0 +1,159 @@
+#include "include/scrape_endpoint.hpp"
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstring>
+#include <netinet/in.h>
+#include <poll.h>
+#include <string>
+#include <sys/socket.h>
+#include <system_error>
+#include <unistd.h>
+
+namespace metrics {
+
+namespace {
+
+#if defined(MSG_NOSIGNAL)
+constexpr int SEND_FLAGS = MSG_NOSIGNAL;
+#else
+constexpr int SEND_FLAGS = 0;
+#endif
+
+constexpr size_t MAX_REQUEST_BYTES = 8192;
+constexpr int READ_TIMEOUT_SECONDS = 5;
+
+void closeFd(int &fd) {
+  if (fd >= 0) {
+    ::close(fd);
+    fd = -1;
+  }
+}
+
+bool sendAll(int fd, const std::string &data) {
+  size_t sent = 0;
+  while (sent < data.size()) {
+    ssize_t n = ::send(fd, data.data() + sent, data.size() - sent, SEND_FLAGS);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n <= 0) {
+      return false;
+    }
+    sent += static_cast<size_t>(n);
+  }
+  return true;
+}
+
+std::string response(const char *status, const char *content_type, const std::string &body) {
+  return std::string("HTTP/1.1 ") + status + "\r\nContent-Type: " + content_type +
+         "\r\nContent-Length: " + std::to_string(body.size()) + "\r\nConnection: close\r\n\r\n" +
+         body;
+}
+
+} // namespace
+
+ScrapeEndpoint::ScrapeEndpoint(const Registry &registry, uint16_t port) : registry_(registry) {
+  listen_fd_ = ::socket(AF_INET, SOCK_STREAM, 0);
+  if (listen_fd_ < 0) {
+    throw std::system_error(errno, std::generic_category(), "Failed to create metrics socket");
+  }
+  int reuse = 1;
+  setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+  sockaddr_in addr {};
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = INADDR_ANY;
+  addr.sin_port = htons(port);
+  socklen_t length = sizeof(addr);
+  if (::bind(listen_fd_, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0 ||
+      ::listen(listen_fd_, 16) != 0 || ::pipe(wake_) != 0 ||
+      ::getsockname(listen_fd_, reinterpret_cast<sockaddr *>(&addr), &length) != 0) {
+    int error = errno;
+    closeFd(listen_fd_);
+    closeFd(wake_[0]);
+    closeFd(wake_[1]);
+    throw std::system_error(error, std::generic_category(), "Failed to listen for metrics");
+  }
+  port_ = ntohs(addr.sin_port);
+  thread_ = std::thread([this] { run(); });
+}
+
+ScrapeEndpoint::~ScrapeEndpoint() {
+  char byte = 0;
+  while (::write(wake_[1], &byte, 1) < 0 && errno == EINTR) {
+  }
+  thread_.join();
+  closeFd(listen_fd_);
+  closeFd(wake_[0]);
+  closeFd(wake_[1]);
+}
+
+void ScrapeEndpoint::route(std::string path, std::string content_type,
+                           std::function<std::string()> handler) {
+  std::lock_guard lock(routes_mutex_);
+  routes_.push_back({std::move(path), std::move(content_type), std::move(handler)});
+}
+
+void ScrapeEndpoint::run() {
+  while (true) {
+    pollfd fds[2] = {{listen_fd_, POLLIN, 0}, {wake_[0], POLLIN, 0}};
+    if (::poll(fds, 2, -1) < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return;
+    }
+    if (fds[1].revents != 0) {
+      return;
+    }
+    int client = ::accept(listen_fd_, nullptr, nullptr);
+    if (client < 0) {
+      continue;
+    }
+    serve(client);
+    ::close(client);
+  }
+}
+
+void ScrapeEndpoint::serve(int client) const {
+  timeval timeout {READ_TIMEOUT_SECONDS, 0};
+  setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+  // Only the request line matters; read until the end of the headers
+  std::string request;
+  char buffer[1024];
+  while (request.find("\r\n\r\n") == std::string::npos && request.size() < MAX_REQUEST_BYTES) {
+    ssize_t n = ::recv(client, buffer, sizeof(buffer), 0);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n <= 0) {
+      return;
+    }
+    request.append(buffer, static_cast<size_t>(n));
+  }
+
+  std::string line = request.substr(0, request.find("\r\n"));
+  auto requests = [&line](const std::string &path) {
+    return line.starts_with("GET " + path + " ") || line.starts_with("GET " + path + "?");
+  };
+  if (requests("/metrics")) {
+    sendAll(client, response("200 OK", "text/plain; version=0.0.4; charset=utf-8",
+                             registry_.exposition()));
+    return;
+  }
+  std::unique_lock lock(routes_mutex_);
+  for (const auto &route : routes_) {
+    if (requests(route.path)) {
+      auto handler = route.handler;
+      auto content_type = route.content_type;
+      lock.unlock();
+      sendAll(client, response("200 OK", content_type.c_str(), handler()));
+      return;
+    }
+  }
+  lock.unlock();
+  sendAll(client, response("404 Not Found", "text/plain", "Not found\n"));
+}
+
+} // namespace metrics
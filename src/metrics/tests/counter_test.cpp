@@ -0,0 +1,36 @@
+#include "counter.hpp"
+#include <gtest/gtest.h>
+#include <thread>
+#include <vector>
+
+using metrics::Counter;
+
+TEST(CounterTest, StartsAtZero) {
+  Counter counter;
+  EXPECT_EQ(counter.value(), 0u);
+}
+
+TEST(CounterTest, AddsAmounts) {
+  Counter counter;
+  counter.add();
+  counter.add(41);
+  EXPECT_EQ(counter.value(), 42u);
+}
+
+TEST(CounterTest, SumsEveryThreadsShard) {
+  Counter counter;
+  constexpr int THREADS = 24; // more than there are shards, so some threads share one
+  constexpr int ADDS = 10000;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < THREADS; t++) {
+    threads.emplace_back([&counter] {
+      for (int i = 0; i < ADDS; i++) {
+        counter.add();
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(counter.value(), static_cast<uint64_t>(THREADS) * ADDS);
+}
@@ -0,0 +1,79 @@
+#include "latency_histogram.hpp"
+#include <gtest/gtest.h>
+#include <thread>
+#include <vector>
+
+using metrics::LatencyHistogram;
+
+TEST(LatencyHistogramTest, EmptyHistogram) {
+  LatencyHistogram histogram;
+  EXPECT_EQ(histogram.count(), 0u);
+  EXPECT_EQ(histogram.sum(), 0u);
+  EXPECT_EQ(histogram.valueAt(99), 0);
+}
+
+TEST(LatencyHistogramTest, SmallValuesAreExact) {
+  LatencyHistogram histogram;
+  for (int64_t value = 1; value <= 100; value++) {
+    histogram.record(value);
+  }
+  EXPECT_EQ(histogram.count(), 100u);
+  EXPECT_EQ(histogram.sum(), 5050u);
+  EXPECT_EQ(histogram.valueAt(50), 50);
+  EXPECT_EQ(histogram.valueAt(100), 100);
+  EXPECT_EQ(histogram.countAtOrBelow(10), 10u);
+}
+
+TEST(LatencyHistogramTest, LargeValuesKeepTwoPercentPrecision) {
+  LatencyHistogram histogram;
+  for (int64_t value : {1'234'567LL, 987'654'321LL, 5'000'000'000LL}) {
+    histogram.record(value);
+    int64_t reported = histogram.valueAt(100);
+    EXPECT_GE(reported, value);
+    EXPECT_LE(reported, value + value / 64);
+  }
+}
+
+TEST(LatencyHistogramTest, CountsAtOrBelowBounds) {
+  LatencyHistogram histogram;
+  histogram.record(std::chrono::microseconds(1));
+  histogram.record(std::chrono::milliseconds(1));
+  histogram.record(std::chrono::seconds(1));
+  EXPECT_EQ(histogram.countAtOrBelow(999), 0u);
+  EXPECT_EQ(histogram.countAtOrBelow(2'000), 1u);
+  EXPECT_EQ(histogram.countAtOrBelow(2'000'000), 2u);
+  EXPECT_EQ(histogram.countAtOrBelow(2'000'000'000), 3u);
+}
+
+TEST(LatencyHistogramTest, OutOfRangeValuesAreClamped) {
+  LatencyHistogram histogram;
+  histogram.record(-5);
+  histogram.record(LatencyHistogram::HIGHEST * 2);
+  EXPECT_EQ(histogram.count(), 2u);
+  EXPECT_EQ(histogram.valueAt(0), 0);
+  EXPECT_GE(histogram.valueAt(100), LatencyHistogram::HIGHEST - 1);
+}
+
+TEST(LatencyHistogramTest, RecordsFromManyThreads) {
+  LatencyHistogram histogram;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 8; t++) {
+    threads.emplace_back([&histogram] {
+      for (int i = 0; i < 10000; i++) {
+        histogram.record(1000 + i);
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(histogram.count(), 80000u);
+}
+
+TEST(LatencyHistogramTest, ScopedTimerRecordsOnce) {
+  LatencyHistogram histogram;
+  {
+    metrics::ScopedTimer timer(histogram);
+  }
+  EXPECT_EQ(histogram.count(), 1u);
+}
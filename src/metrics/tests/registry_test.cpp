@@ -0,0 +1,59 @@
+#include "registry.hpp"
+#include <gtest/gtest.h>
+#include <stdexcept>
+
+using metrics::Registry;
+
+TEST(RegistryTest, SameSeriesIsReturnedTwice) {
+  Registry registry;
+  auto &first = registry.counter("requests_total", "Requests", {{"api", "Fetch"}});
+  auto &second = registry.counter("requests_total", "Requests", {{"api", "Fetch"}});
+  auto &other = registry.counter("requests_total", "Requests", {{"api", "Produce"}});
+  EXPECT_EQ(&first, &second);
+  EXPECT_NE(&first, &other);
+}
+
+TEST(RegistryTest, NameCannotChangeType) {
+  Registry registry;
+  registry.counter("calls_total", "Calls");
+  EXPECT_THROW(registry.histogram("calls_total", "Calls"), std::invalid_argument);
+}
+
+TEST(RegistryTest, CountersInExposition) {
+  Registry registry;
+  registry.counter("requests_total", "Requests handled", {{"api", "Fetch"}}).add(3);
+  registry.counter("requests_total", "Requests handled", {{"api", "Produce"}}).add(1);
+  registry.counter("errors_total", "Errors").add(2);
+
+  EXPECT_EQ(registry.exposition(), "# HELP requests_total Requests handled\n"
+                                   "# TYPE requests_total counter\n"
+                                   "requests_total{api=\"Fetch\"} 3\n"
+                                   "requests_total{api=\"Produce\"} 1\n"
+                                   "# HELP errors_total Errors\n"
+                                   "# TYPE errors_total counter\n"
+                                   "errors_total 2\n");
+}
+
+TEST(RegistryTest, LabelValuesAreEscaped) {
+  Registry registry;
+  registry.counter("odd_total", "Odd", {{"path", "a\"b\\c\nd"}}).add();
+  EXPECT_NE(registry.exposition().find("odd_total{path=\"a\\\"b\\\\c\\nd\"} 1\n"),
+            std::string::npos);
+}
+
+TEST(RegistryTest, HistogramsInSeconds) {
+  Registry registry;
+  auto &latency = registry.histogram("call_seconds", "Call time", {{"call", "load"}});
+  latency.record(std::chrono::microseconds(3));   // in the 5 us bucket
+  latency.record(std::chrono::milliseconds(200)); // in the 250 ms bucket
+  auto text = registry.exposition();
+
+  EXPECT_NE(text.find("# TYPE call_seconds histogram\n"), std::string::npos);
+  EXPECT_NE(text.find("call_seconds_bucket{call=\"load\",le=\"1e-06\"} 0\n"), std::string::npos);
+  EXPECT_NE(text.find("call_seconds_bucket{call=\"load\",le=\"5e-06\"} 1\n"), std::string::npos);
+  EXPECT_NE(text.find("call_seconds_bucket{call=\"load\",le=\"0.1\"} 1\n"), std::string::npos);
+  EXPECT_NE(text.find("call_seconds_bucket{call=\"load\",le=\"0.25\"} 2\n"), std::string::npos);
+  EXPECT_NE(text.find("call_seconds_bucket{call=\"load\",le=\"+Inf\"} 2\n"), std::string::npos);
+  EXPECT_NE(text.find("call_seconds_sum{call=\"load\"} 0.200003\n"), std::string::npos);
+  EXPECT_NE(text.find("call_seconds_count{call=\"load\"} 2\n"), std::string::npos);
+}
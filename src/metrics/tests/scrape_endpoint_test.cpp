@@ -0,0 +1,86 @@
+#include "scrape_endpoint.hpp"
+#include <arpa/inet.h>
+#include <gtest/gtest.h>
+#include <netinet/in.h>
+#include <string>
+#include <sys/socket.h>
+#include <unistd.h>
+
+using metrics::Registry;
+using metrics::ScrapeEndpoint;
+
+namespace {
+
+// Send `request` to the endpoint and read until it closes the connection
+std::string exchange(uint16_t port, const std::string &request) {
+  int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+  sockaddr_in addr {};
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  addr.sin_port = htons(port);
+  if (::connect(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0) {
+    ::close(fd);
+    return {};
+  }
+  ::send(fd, request.data(), request.size(), 0);
+  std::string response;
+  char buffer[4096];
+  ssize_t n;
+  while ((n = ::recv(fd, buffer, sizeof(buffer), 0)) > 0) {
+    response.append(buffer, static_cast<size_t>(n));
+  }
+  ::close(fd);
+  return response;
+}
+
+} // namespace
+
+TEST(ScrapeEndpointTest, ServesExposition) {
+  Registry registry;
+  registry.counter("requests_total", "Requests").add(7);
+  ScrapeEndpoint endpoint(registry, 0);
+  ASSERT_NE(endpoint.port(), 0);
+
+  auto response = exchange(endpoint.port(), "GET /metrics HTTP/1.1\r\nHost: x\r\n\r\n");
+  EXPECT_EQ(response.rfind("HTTP/1.1 200 OK\r\n", 0), 0u) << response;
+  EXPECT_NE(response.find("Content-Type: text/plain; version=0.0.4"), std::string::npos);
+  EXPECT_NE(response.find("\r\n\r\n# HELP requests_total Requests\n"), std::string::npos);
+  EXPECT_NE(response.find("requests_total 7\n"), std::string::npos);
+
+  // Every scrape sees current values
+  registry.counter("requests_total", "Requests").add();
+  response = exchange(endpoint.port(), "GET /metrics HTTP/1.0\r\n\r\n");
+  EXPECT_NE(response.find("requests_total 8\n"), std::string::npos);
+}
+
+TEST(ScrapeEndpointTest, OtherPathsAreNotFound) {
+  Registry registry;
+  ScrapeEndpoint endpoint(registry, 0);
+  auto response = exchange(endpoint.port(), "GET / HTTP/1.1\r\n\r\n");
+  EXPECT_EQ(response.rfind("HTTP/1.1 404 Not Found\r\n", 0), 0u) << response;
+}
+
+TEST(ScrapeEndpointTest, ServesRoutes) {
+  Registry registry;
+  ScrapeEndpoint endpoint(registry, 0);
+  int calls = 0;
+  endpoint.route("/trace", "application/json", [&calls] {
+    calls++;
+    return std::string("{}");
+  });
+
+  auto response = exchange(endpoint.port(), "GET /trace HTTP/1.1\r\n\r\n");
+  EXPECT_EQ(response.rfind("HTTP/1.1 200 OK\r\n", 0), 0u) << response;
+  EXPECT_NE(response.find("Content-Type: application/json\r\n"), std::string::npos);
+  EXPECT_NE(response.find("\r\n\r\n{}"), std::string::npos);
+  EXPECT_EQ(calls, 1);
+
+  response = exchange(endpoint.port(), "GET /traces HTTP/1.1\r\n\r\n");
+  EXPECT_EQ(response.rfind("HTTP/1.1 404 Not Found\r\n", 0), 0u) << response;
+}
+
+TEST(ScrapeEndpointTest, PortInUseThrows) {
+  Registry registry;
+  ScrapeEndpoint first(registry, 0);
+  EXPECT_THROW(ScrapeEndpoint(registry, first.port()), std::system_error);
+}
@@ -2,8 +2,10 @@
 
 #include "../../base/include/api_keys.hpp"
 #include "../../base/include/kafka_request.hpp"
+#include "messages/api_versions_request_data.hpp"
 
-class ApiVersionRequest : public KafkaRequest {
+class ApiVersionRequest : public KafkaRequest,
+                          public KafkaProtocol::Messages::ApiVersionsRequestData {
 public:
   static constexpr int16_t KEY = KafkaProtocol::API_VERSIONS;
 };
@@ -4,16 +4,39 @@
 
 namespace KafkaProtocol {
 
+constexpr int16_t PRODUCE = 0;
 constexpr int16_t FETCH = 1;
 constexpr int16_t API_VERSIONS = 18;
 constexpr int16_t DESCRIBE_TOPIC_PARTITIONS = 75;
 
+// Name Kafka gives the API, as in its request metrics; nullptr for keys not listed above
+constexpr const char *apiName(int16_t api_key) {
+  switch (api_key) {
+  case PRODUCE:
+    return "Produce";
+  case FETCH:
+    return "Fetch";
+  case API_VERSIONS:
+    return "ApiVersions";
+  case DESCRIBE_TOPIC_PARTITIONS:
+    return "DescribeTopicPartitions";
+  default:
+    return nullptr;
+  }
+}
+
 namespace ApiVersions {
 inline constexpr int16_t MIN_VERSION = 0;
 inline constexpr int16_t MAX_VERSION = 4;
 inline constexpr int16_t UNSUPPORTED_VERSION = 35;
 } // namespace ApiVersions
 
+namespace Produce {
+// Flexible versions only; v13 switches from topic names to topic ids
+inline constexpr int16_t MIN_VERSION = 9;
+inline constexpr int16_t MAX_VERSION = 11;
+} // namespace Produce
+
 namespace Fetch {
 inline constexpr int16_t MIN_VERSION = 0;
 inline constexpr int16_t MAX_VERSION = 16;
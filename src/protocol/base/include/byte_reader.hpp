@@ -8,6 +8,7 @@
 #include <endian.h>
 #endif
 
+#include "varint.hpp"
 #include <cstdint>
 #include <fstream>
 #include <iostream>
@@ -79,22 +80,23 @@ protected:
     return *static_cast<Derived *>(this);
   }
 
-  Derived &readVarint(int32_t &value) {
-    value = 0;
-    int shift = 0;
-    uint8_t byte;
+  // Reads up to the 5 bytes a 32-bit varint may take; a longer one sets failbit on the stream
+  Derived &readVarint(uint32_t &value) {
+    uint8_t bytes[5];
+    size_t count = 0;
     do {
-      readRaw(byte);
-      value |= (byte & 0x7f) << shift;
-      shift += 7;
-    } while (byte & 0x80);
+      readRaw(bytes[count]);
+    } while (file && (bytes[count++] & 0x80) && count < sizeof(bytes));
+    if (!file || common::decodeVarint32(bytes, count, value) == 0) {
+      file.setstate(std::ios::failbit);
+    }
     return *static_cast<Derived *>(this);
   }
 
   Derived &readZigZagVarint(int32_t &value) {
-    int32_t n;
+    uint32_t n = 0;
     readVarint(n);
-    value = (n >> 1) ^ -(n & 1);
+    value = static_cast<int32_t>(common::zigzagDecode(n));
     return *static_cast<Derived *>(this);
   }
 
@@ -108,12 +110,14 @@ protected:
   }
 
   template <typename T> Derived &readCompactArray(std::vector<T> &values) {
-    uint8_t count;
-    readRaw(count);
-    count--; // Compact format
+    uint32_t count = 0;
+    readVarint(count);
     values.clear();
-    values.reserve(count);
-    for (int i = 0; i < count; i++) {
+    if (count == 0) {
+      return *static_cast<Derived *>(this); // null
+    }
+    count--; // Compact format
+    for (uint32_t i = 0; i < count && file; i++) {
       T value;
       readRaw(value);
       values.push_back(value);
@@ -0,0 +1,293 @@
+#pragma once
+
+#include "kafka_types.hpp"
+#include "message_writer.hpp"
+#include "response_buffer.hpp"
+#include "varint.hpp"
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <variant>
+#include <vector>
+
+class ParseError : public std::runtime_error {
+  using std::runtime_error::runtime_error;
+};
+
+// Primitives the generated message codecs (build/.../generated/messages/*_data.hpp) are made of.
+// Each read or write that differs between the classic and the compact (flexible version) wire
+// format takes the format as a template argument, so a codec instantiated for one version
+// compiles down to the encoding that version uses.
+namespace KafkaProtocol::Codec {
+
+// Record data in a response: a byte range of a log file, or bytes already in memory
+using RecordSegment = std::variant<ResponseBuffer::FileSegment, common::SharedBytes>;
+using Records = std::vector<RecordSegment>;
+
+// Bounds-checked big-endian reads over one request. Running past the end throws ParseError.
+// Arrays read with resizeArray() take their storage from `resource`, and string views point into
+// `data`, so a message decoded that way is only valid while both are.
+class Reader {
+public:
+  Reader(const uint8_t *data, size_t length,
+         std::pmr::memory_resource *resource = std::pmr::get_default_resource())
+      : data_(data), length_(length), resource_(resource) {}
+
+  int8_t readInt8() { return static_cast<int8_t>(readBigEndian<uint8_t>()); }
+  int16_t readInt16() { return static_cast<int16_t>(readBigEndian<uint16_t>()); }
+  uint16_t readUInt16() { return readBigEndian<uint16_t>(); }
+  int32_t readInt32() { return static_cast<int32_t>(readBigEndian<uint32_t>()); }
+  int64_t readInt64() { return static_cast<int64_t>(readBigEndian<uint64_t>()); }
+  bool readBool() { return readInt8() != 0; }
+  double readFloat64() { return std::bit_cast<double>(readBigEndian<uint64_t>()); }
+  uint128_t readUuid() { return readBigEndian<uint128_t>(); }
+
+  uint32_t readUnsignedVarint() {
+    uint32_t value;
+    size_t used = common::decodeVarint32(data_ + offset_, remaining(), value);
+    if (used == 0) {
+      throw ParseError(remaining() < 5 ? "Buffer underflow" : "Varint too long");
+    }
+    offset_ += used;
+    return value;
+  }
+
+  template <bool Compact> std::string readString() {
+    auto string = readNullableString<Compact>();
+    if (!string) {
+      throw ParseError("Null string");
+    }
+    return std::move(*string);
+  }
+
+  template <bool Compact> std::optional<std::string> readNullableString() {
+    int64_t length = readLength<Compact, int16_t>();
+    if (length < 0) {
+      return std::nullopt;
+    }
+    const auto *bytes = reinterpret_cast<const char *>(take(static_cast<size_t>(length)));
+    return std::string(bytes, static_cast<size_t>(length));
+  }
+
+  // Strings as views of the buffer, copying nothing
+  template <bool Compact> std::string_view readStringView() {
+    auto string = readNullableStringView<Compact>();
+    if (!string) {
+      throw ParseError("Null string");
+    }
+    return *string;
+  }
+
+  template <bool Compact> std::optional<std::string_view> readNullableStringView() {
+    int64_t length = readLength<Compact, int16_t>();
+    if (length < 0) {
+      return std::nullopt;
+    }
+    const auto *bytes = reinterpret_cast<const char *>(take(static_cast<size_t>(length)));
+    return std::string_view(bytes, static_cast<size_t>(length));
+  }
+
+  // Bytes and records; null reads as empty
+  template <bool Compact> std::vector<uint8_t> readBytes() {
+    int64_t length = readLength<Compact, int32_t>();
+    if (length <= 0) {
+      return {};
+    }
+    const uint8_t *bytes = take(static_cast<size_t>(length));
+    return {bytes, bytes + length};
+  }
+
+  // Records in a response, copied out of the request buffer
+  template <bool Compact> Records readRecords() {
+    auto bytes = readBytes<Compact>();
+    if (bytes.empty()) {
+      return {};
+    }
+    return {common::SharedBytes::from(std::move(bytes))};
+  }
+
+  // Element count of an array; null reads as empty. Every element takes at least a byte, so a
+  // count larger than what is left is rejected before anything is allocated for it.
+  template <bool Compact> size_t readArrayLength() {
+    int64_t length = readLength<Compact, int32_t>();
+    if (length < 0) {
+      return 0;
+    }
+    if (static_cast<size_t>(length) > remaining()) {
+      throw ParseError("Invalid array length");
+    }
+    return static_cast<size_t>(length);
+  }
+
+  // Make `items` `count` default elements allocated from the reader's resource. A vector on
+  // another resource, like the default-constructed members of a new element, is recreated on
+  // this one first; pmr vectors never change resource once constructed.
+  template <typename T> void resizeArray(std::pmr::vector<T> &items, size_t count) {
+    if (items.get_allocator().resource() != resource_) {
+      std::destroy_at(&items);
+      std::construct_at(&items, resource_);
+    }
+    items.clear();
+    items.resize(count);
+  }
+
+  [[nodiscard]] std::pmr::memory_resource *resource() const { return resource_; }
+
+  // Hand each tagged field to `handler(tag, field_reader)`, where `field_reader` covers just
+  // that field's bytes. Fields the handler does not read are skipped.
+  template <typename Handler> void readTaggedFields(Handler &&handler) {
+    uint32_t count = readUnsignedVarint();
+    for (uint32_t i = 0; i < count; i++) {
+      uint32_t tag = readUnsignedVarint();
+      uint32_t size = readUnsignedVarint();
+      Reader field(take(size), size, resource_);
+      handler(tag, field);
+    }
+  }
+
+  void skipTaggedFields() {
+    readTaggedFields([](uint32_t, Reader &) {});
+  }
+
+  void skip(size_t n) { take(n); }
+  [[nodiscard]] size_t remaining() const { return length_ - offset_; }
+  [[nodiscard]] size_t offset() const { return offset_; }
+
+private:
+  const uint8_t *take(size_t n) {
+    if (n > remaining()) {
+      throw ParseError("Buffer underflow");
+    }
+    const uint8_t *at = data_ + offset_;
+    offset_ += n;
+    return at;
+  }
+
+  template <typename T> T readBigEndian() {
+    const uint8_t *bytes = take(sizeof(T));
+    T value = 0;
+    for (size_t i = 0; i < sizeof(T); i++) {
+      value = static_cast<T>((value << 8) | bytes[i]);
+    }
+    return value;
+  }
+
+  // Length prefix of a string, bytes or array: an unsigned varint holding length + 1 in the
+  // compact format, a signed `Classic` otherwise. -1 is null.
+  template <bool Compact, typename Classic> int64_t readLength() {
+    if constexpr (Compact) {
+      return static_cast<int64_t>(readUnsignedVarint()) - 1;
+    } else {
+      return static_cast<Classic>(readBigEndian<std::make_unsigned_t<Classic>>());
+    }
+  }
+
+  const uint8_t *data_;
+  size_t length_;
+  size_t offset_ {0};
+  std::pmr::memory_resource *resource_;
+};
+
+// Appends message fields to a ResponseBuffer
+class Writer : public MessageWriter<Writer> {
+public:
+  explicit Writer(ResponseBuffer &buffer) : MessageWriter(buffer) {}
+
+  Writer &writeBool(bool value) { return writeInt8(value ? 1 : 0); }
+  Writer &writeUInt16(uint16_t value) { return writeInt16(static_cast<int16_t>(value)); }
+  Writer &writeFloat64(double value) { return writeInt64(std::bit_cast<int64_t>(value)); }
+
+  Writer &writeUnsignedVarint(uint32_t value) {
+    while (value >= 0x80) {
+      writeUInt8(static_cast<uint8_t>(value | 0x80));
+      value >>= 7;
+    }
+    return writeUInt8(static_cast<uint8_t>(value));
+  }
+
+  template <bool Compact> Writer &writeString(std::string_view value) {
+    writeLength<Compact, int16_t>(static_cast<int64_t>(value.size()));
+    return writeBytes(value.data(), value.size());
+  }
+
+  template <bool Compact>
+  Writer &writeNullableString(const std::optional<std::string_view> &value) {
+    if (!value) {
+      return writeLength<Compact, int16_t>(-1);
+    }
+    return writeString<Compact>(*value);
+  }
+
+  template <bool Compact> Writer &writeByteArray(std::span<const uint8_t> value) {
+    writeLength<Compact, int32_t>(static_cast<int64_t>(value.size()));
+    return writeBytes(value.data(), value.size());
+  }
+
+  template <bool Compact> Writer &writeArrayLength(size_t count) {
+    return writeLength<Compact, int32_t>(static_cast<int64_t>(count));
+  }
+
+  // Records are spliced into the response where they are, not copied
+  template <bool Compact> Writer &writeRecords(const Records &records) {
+    uint64_t total = 0;
+    for (const auto &segment : records) {
+      total += std::visit([](const auto &s) -> uint64_t { return segmentLength(s); }, segment);
+    }
+    writeLength<Compact, int32_t>(static_cast<int64_t>(total));
+    for (const auto &segment : records) {
+      if (const auto *file = std::get_if<ResponseBuffer::FileSegment>(&segment)) {
+        buffer.appendFile(*file);
+      } else {
+        buffer.appendShared(std::get<common::SharedBytes>(segment));
+      }
+    }
+    return *this;
+  }
+
+  // One tagged field: its tag, its size, then what `body(field_writer)` writes
+  template <typename Body> Writer &writeTaggedField(uint32_t tag, Body &&body) {
+    ResponseBuffer scratch;
+    Writer field(scratch);
+    body(field);
+    auto bytes = scratch.toVector();
+    writeUnsignedVarint(tag).writeUnsignedVarint(static_cast<uint32_t>(bytes.size()));
+    return writeBytes(bytes.data(), bytes.size());
+  }
+
+private:
+  static uint64_t segmentLength(const ResponseBuffer::FileSegment &file) { return file.length; }
+  static uint64_t segmentLength(const common::SharedBytes &bytes) { return bytes.size(); }
+
+  template <bool Compact, typename Classic> Writer &writeLength(int64_t length) {
+    if constexpr (Compact) {
+      return writeUnsignedVarint(static_cast<uint32_t>(length + 1));
+    } else if constexpr (sizeof(Classic) == 2) {
+      return writeInt16(static_cast<int16_t>(length));
+    } else {
+      return writeInt32(static_cast<int32_t>(length));
+    }
+  }
+};
+
+// Write a complete response frame for `message` at `version`: size, header, body
+template <typename Message>
+void encodeResponse(ResponseBuffer &buffer, int32_t correlation_id, int16_t version,
+                    const Message &message) {
+  Writer writer(buffer);
+  writer.skipBytes(4) // Message size placeholder
+      .writeInt32(correlation_id);
+  if (Message::headerVersion(version) >= 1) {
+    writer.writeUnsignedVarint(0); // TAG_BUFFER
+  }
+  message.write(writer, version);
+  writer.updateMessageSize();
+}
+
+} // namespace KafkaProtocol::Codec
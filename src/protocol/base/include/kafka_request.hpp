@@ -1,13 +1,13 @@
 #pragma once
 
 #include <cstdint>
-#include <string>
+#include <string_view>
 
 struct RequestHeader {
   int16_t api_key;
   int16_t api_version;
   int32_t correlation_id;
-  std::string client_id;
+  std::string_view client_id; // into the request frame
 };
 
 class KafkaRequest {
@@ -1,6 +1,4 @@
 #pragma once
 #include <cstdint>
-#include <vector>
 
 using uint128_t = __uint128_t;
-using RecordBatches = std::vector<std::vector<uint8_t>>;
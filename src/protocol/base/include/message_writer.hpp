@@ -1,52 +1,54 @@
 #pragma once
 #include "kafka_types.hpp"
+#include "response_buffer.hpp"
 #include <arpa/inet.h>
 #include <cstring>
 #include <netinet/in.h>
 #include <string>
 
+// Writes one size-prefixed message at the end of a ResponseBuffer. Several messages can be
+// written back to back into the same buffer.
 template <typename Derived> class MessageWriter {
 protected:
-  char *buffer;
-  int offset;
+  ResponseBuffer &buffer;
+  size_t start;
+
+  template <typename T> Derived &writeRaw(const T &value) {
+    memcpy(buffer.append(sizeof(T)), &value, sizeof(T));
+    return *static_cast<Derived *>(this);
+  }
 
 public:
-  MessageWriter(char *buf) : buffer(buf), offset(0) {}
+  MessageWriter(ResponseBuffer &buf) : buffer(buf), start(buf.size()) {}
+
+  // Pre-acquire space for the rest of the message
+  Derived &reserve(size_t bytes) {
+    buffer.reserve(bytes);
+    return *static_cast<Derived *>(this);
+  }
 
   Derived &writeInt32(int32_t value) {
     value = htonl(value);
-    memcpy(buffer + offset, &value, sizeof(value));
-    offset += sizeof(value);
-    return *static_cast<Derived *>(this);
+    return writeRaw(value);
   }
 
   Derived &writeUInt32(uint32_t value) {
     uint32_t network_value = htonl(value);
-    memcpy(buffer + offset, &network_value, sizeof(network_value));
-    offset += sizeof(network_value);
-    return *static_cast<Derived *>(this);
+    return writeRaw(network_value);
   }
 
   Derived &writeInt64(int64_t value) {
     // For 64-bit values we need to handle endianness manually
     uint64_t network_value = ((uint64_t)htonl(value & 0xFFFFFFFF) << 32) | htonl(value >> 32);
-    memcpy(buffer + offset, &network_value, sizeof(network_value));
-    offset += sizeof(network_value);
-    return *static_cast<Derived *>(this);
+    return writeRaw(network_value);
   }
 
   Derived &writeInt16(int16_t value) {
     value = htons(value);
-    memcpy(buffer + offset, &value, sizeof(value));
-    offset += sizeof(value);
-    return *static_cast<Derived *>(this);
+    return writeRaw(value);
   }
 
-  Derived &writeUInt8(uint8_t value) {
-    memcpy(buffer + offset, &value, sizeof(value));
-    offset += sizeof(value);
-    return *static_cast<Derived *>(this);
-  }
+  Derived &writeUInt8(uint8_t value) { return writeRaw(value); }
 
   Derived &writeUint128(uint128_t value) {
 
@@ -59,27 +61,15 @@ public:
     return *static_cast<Derived *>(this);
   }
 
-  Derived &writeInt8(int8_t value) {
-    memcpy(buffer + offset, &value, sizeof(value));
-    offset += sizeof(value);
-    return *static_cast<Derived *>(this);
-  }
+  Derived &writeInt8(int8_t value) { return writeRaw(value); }
 
   Derived &skipBytes(int count) {
-    offset += count;
+    buffer.write(nullptr, static_cast<size_t>(count));
     return *static_cast<Derived *>(this);
   }
 
   Derived &writeBytes(const void *bytes, size_t length) {
-
-    if (bytes) {
-      memcpy(buffer + offset, bytes, length);
-    } else {
-      memset(buffer + offset, 0, length);
-    }
-
-    offset += length;
-
+    buffer.write(bytes, length);
     return *static_cast<Derived *>(this);
   }
 
@@ -97,17 +87,14 @@ public:
   }
 
   Derived &writeCompactString(const std::string &str) {
-    int16_t length = static_cast<int16_t>(str.length());
-    memcpy(buffer + offset, str.c_str(), length);
-    offset += length;
-
+    buffer.write(str.data(), str.length());
     return *static_cast<Derived *>(this);
   }
 
   void updateMessageSize() {
-    int32_t message_size = htonl(offset - 4);
-    memcpy(buffer, &message_size, 4);
+    int32_t message_size = htonl(static_cast<uint32_t>(getOffset() - 4));
+    buffer.overwrite(start, &message_size, 4);
   }
 
-  int getOffset() const { return offset; }
+  int getOffset() const { return static_cast<int>(buffer.size() - start); }
 };
@@ -0,0 +1,281 @@
+#pragma once
+
+#include "shared_bytes.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <unistd.h>
+#include <variant>
+#include <vector>
+
+// Process-wide free list of fixed-size response chunks. Chunks are taken on worker threads and
+// returned on I/O threads once sent, so the list is shared rather than thread-local.
+class ChunkPool {
+public:
+  static constexpr size_t CHUNK_SIZE = 16 * 1024;
+  static constexpr size_t MAX_POOLED = 1024;
+
+  static ChunkPool &instance() {
+    static ChunkPool pool;
+    return pool;
+  }
+
+  char *acquire() {
+    {
+      std::lock_guard lock(mutex_);
+      if (!free_.empty()) {
+        char *chunk = free_.back();
+        free_.pop_back();
+        return chunk;
+      }
+    }
+    return new char[CHUNK_SIZE];
+  }
+
+  void release(char *chunk) {
+    {
+      std::lock_guard lock(mutex_);
+      if (free_.size() < MAX_POOLED) {
+        free_.push_back(chunk);
+        return;
+      }
+    }
+    delete[] chunk;
+  }
+
+  ~ChunkPool() {
+    for (char *chunk : free_) {
+      delete[] chunk;
+    }
+  }
+
+private:
+  ChunkPool() = default;
+
+  std::mutex mutex_;
+  std::vector<char *> free_;
+};
+
+// Growable response storage built from pooled chunks. Fixed-size fields are always written
+// contiguously inside one chunk; byte payloads may span chunk boundaries. File segments let a
+// response refer to bytes of an open file that the connection sends with sendfile(2) instead of
+// copying them through user space. Shared segments do the same for bytes already in memory, such
+// as record batches in a mapped log segment.
+class ResponseBuffer {
+public:
+  struct Chunk {
+    char *data;
+    size_t size;
+  };
+
+  struct FileSegment {
+    int fd;
+    uint64_t offset;
+    uint64_t length;
+    std::shared_ptr<const void> owner; // keeps `fd` open until the segment is sent
+  };
+
+  using Segment = std::variant<Chunk, FileSegment, common::SharedBytes>;
+
+  ResponseBuffer() = default;
+  ~ResponseBuffer() { releaseChunks(); }
+
+  ResponseBuffer(const ResponseBuffer &) = delete;
+  ResponseBuffer &operator=(const ResponseBuffer &) = delete;
+
+  ResponseBuffer(ResponseBuffer &&other) noexcept
+      : segments_(std::move(other.segments_)), current_(other.current_), size_(other.size_) {
+    other.segments_.clear();
+    other.current_ = 0;
+    other.size_ = 0;
+  }
+
+  ResponseBuffer &operator=(ResponseBuffer &&other) noexcept {
+    if (this != &other) {
+      releaseChunks();
+      segments_ = std::move(other.segments_);
+      current_ = other.current_;
+      size_ = other.size_;
+      other.segments_.clear();
+      other.current_ = 0;
+      other.size_ = 0;
+    }
+    return *this;
+  }
+
+  // Acquire enough chunks up front for `bytes` more bytes of output
+  void reserve(size_t bytes) {
+    size_t available = 0;
+    for (size_t i = current_; i < segments_.size(); i++) {
+      available += ChunkPool::CHUNK_SIZE - chunkAt(i).size;
+    }
+    while (available < bytes) {
+      segments_.emplace_back(Chunk {ChunkPool::instance().acquire(), 0});
+      available += ChunkPool::CHUNK_SIZE;
+    }
+  }
+
+  // Contiguous space for a fixed-size field
+  char *append(size_t length) {
+    if (length > ChunkPool::CHUNK_SIZE) {
+      throw std::length_error("Field larger than a response chunk");
+    }
+    while (current_ < segments_.size() && ChunkPool::CHUNK_SIZE - chunkAt(current_).size < length) {
+      current_++;
+    }
+    if (current_ == segments_.size()) {
+      segments_.emplace_back(Chunk {ChunkPool::instance().acquire(), 0});
+    }
+
+    Chunk &chunk = chunkAt(current_);
+    char *out = chunk.data + chunk.size;
+    chunk.size += length;
+    size_ += length;
+    return out;
+  }
+
+  // Copy a payload, zero-filled when `bytes` is null
+  void write(const void *bytes, size_t length) {
+    const char *src = static_cast<const char *>(bytes);
+    while (length > 0) {
+      if (current_ == segments_.size()) {
+        segments_.emplace_back(Chunk {ChunkPool::instance().acquire(), 0});
+      }
+      Chunk &chunk = chunkAt(current_);
+      size_t room = ChunkPool::CHUNK_SIZE - chunk.size;
+      if (room == 0) {
+        current_++;
+        continue;
+      }
+
+      size_t n = std::min(room, length);
+      if (src) {
+        std::memcpy(chunk.data + chunk.size, src, n);
+        src += n;
+      } else {
+        std::memset(chunk.data + chunk.size, 0, n);
+      }
+      chunk.size += n;
+      size_ += n;
+      length -= n;
+    }
+  }
+
+  // Splice a file byte range into the output after everything written so far
+  void appendFile(FileSegment file) {
+    uint64_t length = file.length;
+    splice(std::move(file), length);
+  }
+
+  // Splice bytes owned elsewhere into the output without copying them
+  void appendShared(common::SharedBytes bytes) {
+    size_t length = bytes.size();
+    splice(std::move(bytes), length);
+  }
+
+  // Patch bytes already written, e.g. a size placeholder. Must not overlap spliced segments.
+  void overwrite(size_t position, const void *bytes, size_t length) {
+    const char *src = static_cast<const char *>(bytes);
+    for (auto &segment : segments_) {
+      if (length == 0) {
+        break;
+      }
+      size_t segment_size = segmentSize(segment);
+      if (position >= segment_size) {
+        position -= segment_size;
+        continue;
+      }
+      Chunk &chunk = std::get<Chunk>(segment);
+      size_t n = std::min(chunk.size - position, length);
+      std::memcpy(chunk.data + position, src, n);
+      src += n;
+      length -= n;
+      position = 0;
+    }
+  }
+
+  [[nodiscard]] size_t size() const { return size_; }
+  [[nodiscard]] bool empty() const { return size_ == 0; }
+  [[nodiscard]] const std::vector<Segment> &segments() const { return segments_; }
+
+  static size_t segmentSize(const Segment &segment) {
+    if (const auto *chunk = std::get_if<Chunk>(&segment)) {
+      return chunk->size;
+    }
+    if (const auto *shared = std::get_if<common::SharedBytes>(&segment)) {
+      return shared->size();
+    }
+    return std::get<FileSegment>(segment).length;
+  }
+
+  // Start of an in-memory segment's bytes; null for file segments
+  static const char *segmentData(const Segment &segment) {
+    if (const auto *chunk = std::get_if<Chunk>(&segment)) {
+      return chunk->data;
+    }
+    if (const auto *shared = std::get_if<common::SharedBytes>(&segment)) {
+      return reinterpret_cast<const char *>(shared->data());
+    }
+    return nullptr;
+  }
+
+  // Flatten into one vector, reading file segments back with pread
+  [[nodiscard]] std::vector<char> toVector() const {
+    std::vector<char> out;
+    out.reserve(size_);
+    for (const auto &segment : segments_) {
+      if (const char *data = segmentData(segment)) {
+        out.insert(out.end(), data, data + segmentSize(segment));
+        continue;
+      }
+      const auto &file = std::get<FileSegment>(segment);
+      size_t old_size = out.size();
+      out.resize(old_size + file.length);
+      size_t done = 0;
+      while (done < file.length) {
+        ssize_t n = pread(file.fd, out.data() + old_size + done, file.length - done,
+                          static_cast<off_t>(file.offset + done));
+        if (n <= 0) {
+          throw std::runtime_error("Failed to read file segment");
+        }
+        done += static_cast<size_t>(n);
+      }
+    }
+    return out;
+  }
+
+private:
+  Chunk &chunkAt(size_t index) { return std::get<Chunk>(segments_[index]); }
+
+  // Insert a non-chunk segment after the bytes written so far; later writes go to chunks after it
+  void splice(Segment segment, size_t length) {
+    if (length == 0) {
+      return;
+    }
+    size_t pos = current_;
+    if (pos < segments_.size() && chunkAt(pos).size > 0) {
+      pos++;
+    }
+    size_ += length;
+    segments_.insert(segments_.begin() + static_cast<std::ptrdiff_t>(pos), std::move(segment));
+    current_ = pos + 1;
+  }
+
+  void releaseChunks() {
+    for (auto &segment : segments_) {
+      if (auto *chunk = std::get_if<Chunk>(&segment)) {
+        ChunkPool::instance().release(chunk->data);
+      }
+    }
+    segments_.clear();
+  }
+
+  // Segments from current_ on are always (possibly reserved, empty) chunks
+  std::vector<Segment> segments_;
+  size_t current_ {0};
+  size_t size_ {0};
+};
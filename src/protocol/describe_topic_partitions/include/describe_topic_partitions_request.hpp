@@ -2,18 +2,10 @@
 
 #include "../../base/include/api_keys.hpp"
 #include "../../base/include/kafka_request.hpp"
-#include <optional>
-#include <string>
-#include <vector>
+#include "messages/describe_topic_partitions_request_data.hpp"
 
-class DescribeTopicsRequest : public KafkaRequest {
+class DescribeTopicsRequest : public KafkaRequest,
+                              public KafkaProtocol::Messages::DescribeTopicPartitionsRequestData {
 public:
   static constexpr int16_t KEY = KafkaProtocol::DESCRIBE_TOPIC_PARTITIONS;
-  std::vector<std::string> topic_names;
-  int32_t response_partition_limit;
-  struct Cursor {
-    std::string topic_name;
-    int32_t partition_index;
-  };
-  std::optional<Cursor> cursor;
 };
@@ -2,39 +2,13 @@
 
 #include "../../base/include/api_keys.hpp"
 #include "../../base/include/kafka_request.hpp"
-#include "../../base/include/kafka_types.hpp"
-#include <vector>
+#include "messages/fetch_request_data.hpp"
 
-struct FetchPartition {
-  int32_t partition;
-  int32_t current_leader_epoch;
-  int64_t fetch_offset;
-  int32_t last_fetched_epoch;
-  int64_t log_start_offset;
-  int32_t partition_max_bytes;
-};
-
-struct FetchTopic {
-  uint128_t topic_id; // UUID
-  std::vector<FetchPartition> partitions;
-};
+using FetchTopic = KafkaProtocol::Messages::FetchRequestData::FetchTopic;
+using FetchPartition = KafkaProtocol::Messages::FetchRequestData::FetchPartition;
+using ForgottenTopic = KafkaProtocol::Messages::FetchRequestData::ForgottenTopic;
 
-struct ForgottenTopic {
-  uint128_t topic_id; // UUID
-  std::vector<int32_t> partitions;
-};
-
-class FetchRequest : public KafkaRequest {
+class FetchRequest : public KafkaRequest, public KafkaProtocol::Messages::FetchRequestData {
 public:
   static constexpr int16_t KEY = KafkaProtocol::FETCH;
-
-  int32_t max_wait_ms;
-  int32_t min_bytes;
-  int32_t max_bytes;
-  int8_t isolation_level;
-  int32_t session_id;
-  int32_t session_epoch;
-  std::vector<FetchTopic> topics;
-  std::vector<ForgottenTopic> forgotten_topics_data;
-  std::string rack_id;
 };
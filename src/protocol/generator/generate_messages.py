@@ -0,0 +1,585 @@
+#!/usr/bin/env python3
+"""Generate a C++ codec for one Kafka message from its JSON schema.
+
+Usage: generate_messages.py SCHEMA.json OUTPUT.hpp
+
+The schemas are the ones Apache Kafka ships in clients/src/main/resources/common/message. Each
+message becomes a struct in KafkaProtocol::Messages with read<V>() and write<V>() templates, one
+instantiation per valid version: which fields exist, whether they are tagged, and whether
+strings, bytes and arrays use the compact encoding are all settled at compile time with
+`if constexpr`, so a decoded version runs straight-line code with no per-field version checks.
+
+Requests are decoded without copying: their strings are string_views into the request buffer
+and their arrays std::pmr::vectors allocated from the Codec::Reader's memory resource.
+"""
+
+import json
+import re
+import sys
+from pathlib import Path
+
+PRIMITIVES = {
+    "bool": ("bool", "Bool", "false"),
+    "int8": ("int8_t", "Int8", "0"),
+    "int16": ("int16_t", "Int16", "0"),
+    "uint16": ("uint16_t", "UInt16", "0"),
+    "int32": ("int32_t", "Int32", "0"),
+    "int64": ("int64_t", "Int64", "0"),
+    "float64": ("double", "Float64", "0"),
+    "uuid": ("uint128_t", "Uuid", "0"),
+}
+
+INTEGER_LIMITS = {
+    "int8": (-(2**7), 2**7 - 1),
+    "int16": (-(2**15), 2**15 - 1),
+    "uint16": (0, 2**16 - 1),
+    "int32": (-(2**31), 2**31 - 1),
+    "int64": (-(2**63), 2**63 - 1),
+}
+
+
+class SchemaError(Exception):
+    pass
+
+
+class Versions:
+    """An inclusive version range; `high` is None for open ranges like "3+"."""
+
+    def __init__(self, low, high):
+        self.low = low
+        self.high = high
+
+    @staticmethod
+    def parse(text):
+        text = text.strip()
+        if text == "none":
+            return Versions(1, 0)
+        if text.endswith("+"):
+            return Versions(int(text[:-1]), None)
+        if "-" in text:
+            low, high = text.split("-")
+            return Versions(int(low), int(high))
+        return Versions(int(text), int(text))
+
+    def intersect(self, other):
+        high = self.high if other.high is None else (
+            other.high if self.high is None else min(self.high, other.high))
+        return Versions(max(self.low, other.low), high)
+
+    def empty(self):
+        return self.high is not None and self.low > self.high
+
+    def covers(self, other):
+        """True if every version in `other` is also in this range."""
+        if other.empty():
+            return True
+        if self.empty() or self.low > other.low:
+            return False
+        return self.high is None or (other.high is not None and other.high <= self.high)
+
+    def __eq__(self, other):
+        if self.empty() and other.empty():
+            return True
+        return self.low == other.low and self.high == other.high
+
+
+def condition(present, scope):
+    """C++ test on V for `present`, simplified to what can differ between versions in `scope`."""
+    present = present.intersect(scope)
+    if present.empty():
+        return "false"
+    parts = []
+    if present.low > scope.low:
+        parts.append(f"V >= {present.low}")
+    if present.high is not None and (scope.high is None or present.high < scope.high):
+        parts.append(f"V <= {present.high}")
+    return " && ".join(parts) if parts else "true"
+
+
+def snake_case(name):
+    name = re.sub(r"(.)([A-Z][a-z]+)", r"\1_\2", name)
+    return re.sub(r"([a-z0-9])([A-Z])", r"\1_\2", name).lower()
+
+
+def load_schema(path):
+    # The schemas carry the Apache license and version notes as // line comments
+    text = "\n".join(line for line in Path(path).read_text().splitlines()
+                     if not line.lstrip().startswith("//"))
+    return json.loads(text)
+
+
+class Field:
+    def __init__(self, spec, scope, message):
+        self.name = spec["name"]
+        self.member = snake_case(self.name)
+        self.type = spec["type"]
+        self.versions = Versions.parse(spec["versions"]).intersect(scope)
+        self.nullable = Versions.parse(spec.get("nullableVersions", "none")).intersect(
+            self.versions)
+        self.default = spec.get("default")
+        self.tag = spec.get("tag")
+        self.flexible = (Versions.parse(spec["flexibleVersions"]).intersect(self.versions)
+                         if "flexibleVersions" in spec else None)
+
+        if self.tag is not None:
+            tagged = Versions.parse(spec.get("taggedVersions", spec["versions"]))
+            if tagged.intersect(self.versions) != self.versions:
+                raise SchemaError(f"{self.name}: tagged in only some of its versions")
+            if not message.flexible.covers(self.versions):
+                raise SchemaError(f"{self.name}: tagged in a version that is not flexible")
+
+        self.is_array = self.type.startswith("[]")
+        self.element = self.type[2:] if self.is_array else self.type
+        self.struct = None
+        if self.element not in PRIMITIVES and self.element not in (
+                "string", "bytes", "records"):
+            self.struct = message.struct(self.element, spec.get("fields"), self.versions)
+        if self.nullable_somewhere() and self.element in PRIMITIVES and not self.is_array:
+            raise SchemaError(f"{self.name}: {self.type} cannot be nullable")
+        if (self.struct is not None and not self.is_array and self.nullable_somewhere()
+                and not self.nullable.covers(self.versions)):
+            raise SchemaError(f"{self.name}: structs must be nullable in all of their versions")
+
+    def nullable_somewhere(self):
+        return not self.nullable.empty()
+
+
+class Struct:
+    def __init__(self, name, versions):
+        self.name = name
+        self.versions = versions
+        self.fields = []
+
+
+class Message:
+    def __init__(self, schema):
+        self.name = schema["name"]
+        self.kind = schema["type"]
+        self.api_key = schema["apiKey"]
+        self.valid = Versions.parse(schema["validVersions"])
+        if self.valid.high is None:
+            raise SchemaError("validVersions must be bounded")
+        self.flexible = Versions.parse(schema.get("flexibleVersions", "none"))
+        self.structs = []  # nested structs, each before the structs that use it
+        self.common = {spec["name"]: spec for spec in schema.get("commonStructs", [])}
+        self.root = Struct(f"{self.name}Data", self.valid)
+        self.root.fields = [Field(spec, self.valid, self) for spec in schema["fields"]]
+
+    def struct(self, name, fields, versions):
+        for existing in self.structs:
+            if existing.name == name:
+                if fields is not None:
+                    raise SchemaError(f"struct {name} is declared twice")
+                return existing
+        if fields is None:
+            if name not in self.common:
+                raise SchemaError(f"unknown type {name}")
+            fields = self.common[name]["fields"]
+            versions = self.valid
+        struct = Struct(name, versions)
+        struct.fields = [Field(spec, versions, self) for spec in fields]
+        self.structs.append(struct)
+        return struct
+
+    def header_version(self):
+        if self.kind == "request":
+            return ("2", "1")
+        # ApiVersionsResponse keeps the v0 header so clients can read it before they know
+        # which versions the broker supports
+        if self.name == "ApiVersionsResponse":
+            return ("0", "0")
+        return ("1", "0")
+
+
+class Writer:
+    """Accumulates C++ lines with indentation."""
+
+    def __init__(self):
+        self.lines = []
+        self.depth = 0
+
+    def line(self, text=""):
+        self.lines.append(("  " * self.depth + text) if text else "")
+
+    def open(self, text):
+        self.line(text + " {")
+        self.depth += 1
+
+    def close(self, text="}"):
+        self.depth -= 1
+        self.line(text)
+
+    def switch(self, text):
+        # Case labels line up with their switch, as clang-format's LLVM style has them
+        self.line(f"switch ({text}) {{")
+
+    def guarded(self, cond):
+        """Context manager body wrapped in `if constexpr (cond)` unless cond always holds."""
+        return _Guard(self, cond)
+
+
+class _Guard:
+    def __init__(self, out, cond):
+        self.out = out
+        self.cond = cond
+
+    def __enter__(self):
+        if self.cond != "true":
+            self.out.open(f"if constexpr ({self.cond})")
+
+    def __exit__(self, *exc):
+        if self.cond != "true":
+            self.out.close()
+
+
+class Generator:
+    def __init__(self, message):
+        self.message = message
+        # Requests only live while their frame is handled, so they can borrow from it
+        self.borrowed = message.kind == "request"
+
+    # Types and defaults
+
+    def element_type(self, field):
+        if field.struct is not None:
+            return field.struct.name
+        if field.element == "string":
+            return "std::string_view" if self.borrowed else "std::string"
+        if field.element in ("bytes", "records"):
+            return self.bytes_type(field)
+        return PRIMITIVES[field.element][0]
+
+    def bytes_type(self, field):
+        if field.element == "records" and self.message.kind == "response":
+            return "Codec::Records"
+        return "std::vector<uint8_t>"
+
+    def member_type(self, field):
+        element = self.element_type(field)
+        if field.is_array:
+            return f"std::{'pmr::' if self.borrowed else ''}vector<{element}>"
+        if field.nullable_somewhere() and (field.struct is not None or field.element == "string"):
+            return f"std::optional<{element}>"
+        return element
+
+    def default_value(self, field):
+        """Initializer for the member, or None when value-initialization is the default."""
+        if field.is_array or field.struct is not None or field.element in ("bytes", "records"):
+            return None
+        default = field.default
+        if field.element == "string":
+            if default == "null":
+                return None
+            if field.nullable_somewhere():
+                return json.dumps(default or "")
+            return json.dumps(default) if default else None
+        if field.element == "bool":
+            return "true" if str(default).lower() == "true" else "false"
+        if default is None:
+            return PRIMITIVES[field.element][2]
+        default = str(default)
+        if field.element in INTEGER_LIMITS:
+            value = int(default, 0)
+            low, _ = INTEGER_LIMITS[field.element]
+            if value == low and low < 0:
+                return f"std::numeric_limits<{PRIMITIVES[field.element][0]}>::min()"
+        return default
+
+    def differs_from_default(self, field):
+        member = field.member
+        if field.is_array or field.element in ("bytes", "records"):
+            return f"!{member}.empty()"
+        if field.struct is not None:
+            if field.nullable_somewhere():
+                return f"{member}.has_value()"
+            return f"{member} != {field.struct.name} {{}}"
+        if field.element == "string":
+            default = self.default_value(field)
+            if field.nullable_somewhere() and default is None:
+                return f"{member}.has_value()"
+            return f"{member} != {default}" if default else f"!{member}.empty()"
+        if field.element == "bool":
+            return member if self.default_value(field) == "false" else f"!{member}"
+        return f"{member} != {self.default_value(field)}"
+
+    # Decoding
+
+    def read_value(self, field, target, reader, compact, scope):
+        """Lines that decode one value of `field` from `reader` into `target`."""
+        element = field.element
+        if field.is_array:
+            length = f"{reader}.readArrayLength<{compact}>()"
+            resize = (f"{reader}.resizeArray({target}, {length});" if self.borrowed
+                      else f"{target}.resize({length});")
+            lines = [resize, f"for (auto &item : {target}) {{"]
+            if field.struct is not None:
+                lines.append(f"  item.read<V>({reader});")
+            else:
+                lines.append(f"  item = {self.read_scalar(field, reader, compact, nullable=False)};")
+            lines.append("}")
+            return lines
+        if field.struct is not None:
+            if not field.nullable_somewhere():
+                return [f"{target}.read<V>({reader});"]
+            return [f"if ({reader}.readInt8() >= 0) {{",
+                    f"  {target}.emplace().read<V>({reader});",
+                    "} else {",
+                    f"  {target}.reset();",
+                    "}"]
+        nullable = field.nullable_somewhere() and element == "string"
+        if nullable and not field.nullable.covers(field.versions):
+            cond = condition(field.nullable, scope)
+            return [f"if constexpr ({cond}) {{",
+                    f"  {target} = {reader}.{self.string_read(True)}<{compact}>();",
+                    "} else {",
+                    f"  {target} = {reader}.{self.string_read(False)}<{compact}>();",
+                    "}"]
+        return [f"{target} = {self.read_scalar(field, reader, compact, nullable)};"]
+
+    def read_scalar(self, field, reader, compact, nullable):
+        element = field.element
+        if element == "string":
+            return f"{reader}.{self.string_read(nullable)}<{compact}>()"
+        if element == "bytes" or (element == "records" and self.message.kind == "request"):
+            return f"{reader}.readBytes<{compact}>()"
+        if element == "records":
+            return f"{reader}.readRecords<{compact}>()"
+        return f"{reader}.read{PRIMITIVES[element][1]}()"
+
+    def string_read(self, nullable):
+        kind = "NullableString" if nullable else "String"
+        return f"read{kind}{'View' if self.borrowed else ''}"
+
+    # Encoding
+
+    def write_value(self, field, source, writer, compact, scope):
+        """Lines that encode one value of `field` held in `source`."""
+        element = field.element
+        if field.is_array:
+            lines = [f"{writer}.writeArrayLength<{compact}>({source}.size());",
+                     f"for (const auto &item : {source}) {{"]
+            if field.struct is not None:
+                lines.append(f"  item.write<V>({writer});")
+            else:
+                lines.append(f"  {self.write_scalar(field, 'item', writer, compact, False)};")
+            lines.append("}")
+            return lines
+        if field.struct is not None:
+            if not field.nullable_somewhere():
+                return [f"{source}.write<V>({writer});"]
+            return [f"if ({source}) {{",
+                    f"  {writer}.writeInt8(1);",
+                    f"  {source}->write<V>({writer});",
+                    "} else {",
+                    f"  {writer}.writeInt8(-1);",
+                    "}"]
+        if element == "string" and field.nullable_somewhere():
+            if field.nullable.covers(field.versions):
+                return [f"{writer}.writeNullableString<{compact}>({source});"]
+            cond = condition(field.nullable, scope)
+            return [f"if constexpr ({cond}) {{",
+                    f"  {writer}.writeNullableString<{compact}>({source});",
+                    "} else {",
+                    f"  {writer}.writeString<{compact}>({source}.value_or(\"\"));",
+                    "}"]
+        return [self.write_scalar(field, source, writer, compact, False) + ";"]
+
+    def write_scalar(self, field, source, writer, compact, nullable):
+        element = field.element
+        if element == "string":
+            return f"{writer}.writeString<{compact}>({source})"
+        if element == "bytes" or (element == "records" and self.message.kind == "request"):
+            return f"{writer}.writeByteArray<{compact}>({source})"
+        if element == "records":
+            return f"{writer}.writeRecords<{compact}>({source})"
+        if element == "uuid":
+            return f"{writer}.writeUint128({source})"
+        return f"{writer}.write{PRIMITIVES[element][1]}({source})"
+
+    # Structs
+
+    def compact(self, field, flexible):
+        """Template argument choosing the compact encoding for `field`."""
+        if field.flexible is None:
+            return flexible
+        cond = condition(field.flexible, field.versions)
+        return cond if cond in ("true", "false") else f"({cond})"
+
+    def emit_struct(self, out, struct, root=False):
+        scope = struct.versions
+        flexible = condition(self.message.flexible, scope)
+        regular = [f for f in struct.fields if f.tag is None and not f.versions.empty()]
+        tagged = sorted((f for f in struct.fields if f.tag is not None and not f.versions.empty()),
+                        key=lambda f: f.tag)
+        flexible_name = "FLEXIBLE" if flexible not in ("true", "false") else flexible
+        # Tagged fields are only read and written inside the flexible branch
+        tagged_scope = scope.intersect(self.message.flexible)
+
+        for field in struct.fields:
+            if field.versions.empty():
+                continue
+            default = self.default_value(field)
+            init = f" {{{default}}}" if default is not None else ""
+            out.line(f"{self.member_type(field)} {field.member}{init};")
+        if struct.fields:
+            out.line()
+        out.line(f"bool operator==(const {struct.name} &) const = default;")
+        out.line()
+
+        empty = not regular and not tagged and flexible == "false"
+        unused = "[[maybe_unused]] " if empty else ""
+
+        # read<V>
+        out.open(f"template <int16_t V> void read({unused}Codec::Reader &reader)")
+        if flexible_name == "FLEXIBLE":
+            out.line(f"constexpr bool FLEXIBLE = {flexible};")
+        for field in regular:
+            with out.guarded(condition(field.versions, scope)):
+                for text in self.read_value(field, field.member, "reader",
+                                            self.compact(field, flexible_name), scope):
+                    out.line(text)
+        if flexible != "false":
+            with out.guarded(flexible_name):
+                if not tagged:
+                    out.line("reader.skipTaggedFields();")
+                else:
+                    out.open("reader.readTaggedFields([&](uint32_t tag, Codec::Reader &field)")
+                    out.switch("tag")
+                    for field in tagged:
+                        out.line(f"case {field.tag}:")
+                        out.depth += 1
+                        with out.guarded(condition(field.versions, tagged_scope)):
+                            for text in self.read_value(field, field.member, "field", "true",
+                                                        tagged_scope):
+                                out.line(text)
+                        out.line("break;")
+                        out.depth -= 1
+                    out.line("default:")
+                    out.line("  break; // unknown tags are skipped")
+                    out.line("}")
+                    out.close("});")
+        out.close()
+        out.line()
+
+        # write<V>
+        out.open(f"template <int16_t V> void write({unused}Codec::Writer &writer) const")
+        if flexible_name == "FLEXIBLE":
+            out.line(f"constexpr bool FLEXIBLE = {flexible};")
+        for field in regular:
+            with out.guarded(condition(field.versions, scope)):
+                for text in self.write_value(field, field.member, "writer",
+                                             self.compact(field, flexible_name), scope):
+                    out.line(text)
+        if flexible != "false":
+            with out.guarded(flexible_name):
+                if not tagged:
+                    out.line("writer.writeUnsignedVarint(0);")
+                else:
+                    # Fields still at their defaults are left out
+                    out.line("uint32_t tagged = 0;")
+                    for field in tagged:
+                        with out.guarded(condition(field.versions, tagged_scope)):
+                            out.line(f"tagged += {self.differs_from_default(field)} ? 1 : 0;")
+                    out.line("writer.writeUnsignedVarint(tagged);")
+                    for field in tagged:
+                        with out.guarded(condition(field.versions, tagged_scope)):
+                            out.open(f"if ({self.differs_from_default(field)})")
+                            out.open(f"writer.writeTaggedField({field.tag}, "
+                                     "[&](Codec::Writer &field)")
+                            for text in self.write_value(field, field.member, "field", "true",
+                                                         tagged_scope):
+                                out.line(text)
+                            out.close("});")
+                            out.close()
+        out.close()
+
+        if root:
+            self.emit_dispatch(out, struct)
+
+    def emit_dispatch(self, out, struct):
+        versions = range(self.message.valid.low, self.message.valid.high + 1)
+        out.line()
+        out.line("// Decode or encode `version`, chosen at run time, through its specialization")
+        out.open("void read(Codec::Reader &reader, int16_t version)")
+        out.switch("version")
+        for v in versions:
+            out.line(f"case {v}:")
+            out.line(f"  return read<{v}>(reader);")
+        out.line("default:")
+        out.line(f"  throw ParseError(\"Unsupported {self.message.name} version \" +")
+        out.line("                   std::to_string(version));")
+        out.line("}")
+        out.close()
+        out.line()
+        out.open("void write(Codec::Writer &writer, int16_t version) const")
+        out.switch("version")
+        for v in versions:
+            out.line(f"case {v}:")
+            out.line(f"  return write<{v}>(writer);")
+        out.line("default:")
+        out.line(f"  throw std::invalid_argument(\"Unsupported {self.message.name} version \" +")
+        out.line("                              std::to_string(version));")
+        out.line("}")
+        out.close()
+
+    def generate(self, source):
+        message = self.message
+        out = Writer()
+        out.line(f"// Generated from {source} by generate_messages.py. Do not edit.")
+        out.line("#pragma once")
+        out.line()
+        out.line('#include "codec.hpp"')
+        for header in ("cstdint", "limits", "memory_resource", "optional", "stdexcept", "string",
+                       "string_view", "vector"):
+            out.line(f"#include <{header}>")
+        out.line()
+        out.line("namespace KafkaProtocol::Messages {")
+        out.line()
+        out.open(f"struct {message.root.name}")
+        out.line(f"static constexpr int16_t API_KEY = {message.api_key};")
+        out.line(f"static constexpr int16_t LOWEST_VERSION = {message.valid.low};")
+        out.line(f"static constexpr int16_t HIGHEST_VERSION = {message.valid.high};")
+        out.line()
+
+        flexible = condition(message.flexible, message.valid).replace("V", "version")
+        param = "int16_t version" if "version" in flexible else "int16_t /*version*/"
+        out.line(f"static constexpr bool isFlexible({param}) {{ return {flexible}; }}")
+        flexible_header, classic_header = message.header_version()
+        if flexible_header == classic_header:
+            out.open("static constexpr int16_t headerVersion(int16_t /*version*/)")
+            out.line(f"return {flexible_header};")
+        else:
+            out.open("static constexpr int16_t headerVersion(int16_t version)")
+            out.line(f"return isFlexible(version) ? {flexible_header} : {classic_header};")
+        out.close()
+
+        for struct in message.structs:
+            out.line()
+            out.open(f"struct {struct.name}")
+            self.emit_struct(out, struct)
+            out.close("};")
+        out.line()
+        self.emit_struct(out, message.root, root=True)
+        out.close("};")
+        out.line()
+        out.line("} // namespace KafkaProtocol::Messages")
+        return "\n".join(out.lines) + "\n"
+
+
+def main():
+    if len(sys.argv) != 3:
+        sys.exit("usage: generate_messages.py SCHEMA.json OUTPUT.hpp")
+    schema_path, output_path = sys.argv[1], sys.argv[2]
+    try:
+        message = Message(load_schema(schema_path))
+        code = Generator(message).generate(Path(schema_path).name)
+    except (SchemaError, KeyError, ValueError) as e:
+        sys.exit(f"{schema_path}: {e}")
+
+    output = Path(output_path)
+    output.parent.mkdir(parents=True, exist_ok=True)
+    output.write_text(code)
+
+
+if __name__ == "__main__":
+    main()
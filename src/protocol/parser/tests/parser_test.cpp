@@ -2,10 +2,13 @@
 #include "../../base/include/kafka_request_variant.hpp"
 #include "../../describe_topic_partitions/include/describe_topic_partitions_request.hpp"
 #include "../../fetch/include/fetch_request.hpp"
+#include "../../produce/include/produce_request.hpp"
 #include "../include/kafka_parser.hpp"
 #include <arpa/inet.h>
+#include <array>
 #include <cstring>
 #include <gtest/gtest.h>
+#include <memory_resource>
 #include <vector>
 
 namespace KP = KafkaProtocol;
@@ -33,7 +36,7 @@ TEST(ParserTest, MessageTooShort) {
 
 TEST(ParserTest, UnknownApiKey) {
   std::vector<uint8_t> buf(20, 0);
-  writeInt32(buf.data() + 0, 6);
+  writeInt32(buf.data() + 0, 10);
   writeInt16(buf.data() + 4, 99);
   writeInt16(buf.data() + 6, 0);
   writeInt32(buf.data() + 8, 1);
@@ -43,7 +46,7 @@ TEST(ParserTest, UnknownApiKey) {
 
 TEST(ParserTest, ApiVersionsRequest) {
   std::vector<uint8_t> buf(20, 0);
-  writeInt32(buf.data() + 0, 6);
+  writeInt32(buf.data() + 0, 10);
   writeInt16(buf.data() + 4, KP::API_VERSIONS);
   writeInt16(buf.data() + 6, 0);
   writeInt32(buf.data() + 8, 42);
@@ -58,7 +61,7 @@ TEST(ParserTest, ApiVersionsRequest) {
 
 TEST(ParserTest, GetApiKey) {
   std::vector<uint8_t> buf(20, 0);
-  writeInt32(buf.data() + 0, 6);
+  writeInt32(buf.data() + 0, 10);
   writeInt16(buf.data() + 4, KP::API_VERSIONS);
   writeInt16(buf.data() + 6, 0);
   writeInt32(buf.data() + 8, 1);
@@ -70,20 +73,21 @@ TEST(ParserTest, GetApiKey) {
 
 TEST(ParserTest, DescribeTopicsRequest) {
   // Header: size(4), api_key(2), api_version(2), correlation_id(4), client_id(2)
-  // Body: TAG(1), topics_len(1)=2, topic "a"(2), TAG(1), limit(4), cursor_tag(1)=0xFF, TAG(1)
+  // Header TAG(1); body: topics_len(1)=2, topic "a"(2), TAG(1), limit(4), cursor_tag(1)=0xFF,
+  // TAG(1)
   std::vector<uint8_t> buf(30, 0);
   size_t off = 0;
   writeInt32(buf.data() + off, 21);
   off += 4;
   writeInt16(buf.data() + off, KP::DESCRIBE_TOPIC_PARTITIONS);
   off += 2;
-  writeInt16(buf.data() + off, 4);
+  writeInt16(buf.data() + off, 0);
   off += 2;
   writeInt32(buf.data() + off, 99);
   off += 4;
   writeInt16(buf.data() + off, 0);
   off += 2;
-  buf[off++] = 0; // TAG_BUFFER
+  buf[off++] = 0; // header TAG_BUFFER
   buf[off++] = 2; // 1 topic (compact: count+1)
   buf[off++] = 2; // "a" (compact: len+1)
   buf[off++] = 'a';
@@ -98,8 +102,8 @@ TEST(ParserTest, DescribeTopicsRequest) {
   const auto &r = std::get<DescribeTopicsRequest>(req);
   EXPECT_EQ(r.header.api_key, KP::DESCRIBE_TOPIC_PARTITIONS);
   EXPECT_EQ(r.header.correlation_id, 99);
-  ASSERT_EQ(r.topic_names.size(), 1u);
-  EXPECT_EQ(r.topic_names[0], "a");
+  ASSERT_EQ(r.topics.size(), 1u);
+  EXPECT_EQ(r.topics[0].name, "a");
   EXPECT_EQ(r.response_partition_limit, 100);
   EXPECT_FALSE(r.cursor.has_value());
 }
@@ -141,7 +145,7 @@ TEST(ParserTest, FetchRequest) {
   append(tmp, 4);
   writeInt32(tmp, 0);
   append(tmp, 4);
-  writeInt64(tmp, 0);
+  writeInt64(tmp, 0x123456789);
   append(tmp, 8);
   writeInt32(tmp, 0);
   append(tmp, 4);
@@ -149,8 +153,16 @@ TEST(ParserTest, FetchRequest) {
   append(tmp, 8);
   writeInt32(tmp, 4096);
   append(tmp, 4);
+  buf.push_back(0); // partition TAG_BUFFER
+  buf.push_back(0); // topic TAG_BUFFER
   buf.push_back(1); // 0 forgotten topics
-  buf.push_back(0); // empty rack_id
+  buf.push_back(1); // empty rack_id
+  buf.push_back(1); // TAG_BUFFER with one tagged field...
+  buf.push_back(7); // ...tag 7, which v16 does not know
+  buf.push_back(2); // ...of 2 bytes
+  buf.push_back(0xaa);
+  buf.push_back(0xbb);
+  writeInt32(buf.data(), static_cast<int32_t>(buf.size() - 4));
 
   auto req = Parser::parse(buf.data(), buf.size());
   ASSERT_TRUE(std::holds_alternative<FetchRequest>(req));
@@ -163,7 +175,199 @@ TEST(ParserTest, FetchRequest) {
   ASSERT_EQ(r.topics.size(), 1u);
   ASSERT_EQ(r.topics[0].partitions.size(), 1u);
   EXPECT_EQ(r.topics[0].partitions[0].partition, 0);
+  EXPECT_EQ(r.topics[0].partitions[0].fetch_offset, 0x123456789);
   EXPECT_EQ(r.topics[0].partitions[0].partition_max_bytes, 4096);
   EXPECT_TRUE(r.forgotten_topics_data.empty());
   EXPECT_TRUE(r.rack_id.empty());
 }
+
+TEST(ParserTest, FetchSessionRequest) {
+  // Incremental fetch: 200 partitions (a two-byte varint count) and one forgotten topic
+  std::vector<uint8_t> buf;
+  auto append = [&buf](const uint8_t *p, size_t n) { buf.insert(buf.end(), p, p + n); };
+  uint8_t tmp[8];
+  writeInt32(tmp, 0);
+  append(tmp, 4);
+  writeInt16(tmp, KP::FETCH);
+  append(tmp, 2);
+  writeInt16(tmp, 16);
+  append(tmp, 2);
+  writeInt32(tmp, 8);
+  append(tmp, 4);
+  writeInt16(tmp, 0);
+  append(tmp, 2);
+  buf.push_back(0); // TAG_BUFFER
+  writeInt32(tmp, 0);
+  append(tmp, 4);
+  writeInt32(tmp, 1);
+  append(tmp, 4);
+  writeInt32(tmp, 1024);
+  append(tmp, 4);
+  buf.push_back(0); // isolation_level
+  writeInt32(tmp, 1234);
+  append(tmp, 4);
+  writeInt32(tmp, 5);
+  append(tmp, 4);
+  buf.push_back(2); // 1 topic
+  for (int i = 0; i < 16; i++)
+    buf.push_back((i == 15) ? 1 : 0);
+  buf.push_back(0xc9); // 201 as an unsigned varint: 200 partitions
+  buf.push_back(0x01);
+  for (int32_t p = 0; p < 200; p++) {
+    writeInt32(tmp, p);
+    append(tmp, 4);
+    writeInt32(tmp, 0);
+    append(tmp, 4);
+    writeInt64(tmp, p * 10);
+    append(tmp, 8);
+    writeInt32(tmp, 0);
+    append(tmp, 4);
+    writeInt64(tmp, 0);
+    append(tmp, 8);
+    writeInt32(tmp, 4096);
+    append(tmp, 4);
+    buf.push_back(0); // partition TAG_BUFFER
+  }
+  buf.push_back(0); // topic TAG_BUFFER
+  buf.push_back(2); // 1 forgotten topic
+  for (int i = 0; i < 16; i++)
+    buf.push_back((i == 15) ? 2 : 0);
+  buf.push_back(3); // 2 partitions
+  writeInt32(tmp, 4);
+  append(tmp, 4);
+  writeInt32(tmp, 9);
+  append(tmp, 4);
+  buf.push_back(0); // forgotten topic TAG_BUFFER
+  buf.push_back(1); // empty rack_id
+  buf.push_back(0); // TAG_BUFFER
+  writeInt32(buf.data(), static_cast<int32_t>(buf.size() - 4));
+
+  auto req = Parser::parse(buf.data(), buf.size());
+  ASSERT_TRUE(std::holds_alternative<FetchRequest>(req));
+  const auto &r = std::get<FetchRequest>(req);
+  EXPECT_EQ(r.session_id, 1234);
+  EXPECT_EQ(r.session_epoch, 5);
+  ASSERT_EQ(r.topics.size(), 1u);
+  ASSERT_EQ(r.topics[0].partitions.size(), 200u);
+  EXPECT_EQ(r.topics[0].partitions[199].partition, 199);
+  EXPECT_EQ(r.topics[0].partitions[199].fetch_offset, 1990);
+  ASSERT_EQ(r.forgotten_topics_data.size(), 1u);
+  EXPECT_EQ(r.forgotten_topics_data[0].topic_id, uint128_t {2});
+  EXPECT_EQ(r.forgotten_topics_data[0].partitions, (std::pmr::vector<int32_t> {4, 9}));
+}
+
+TEST(ParserTest, DecodesIntoArena) {
+  FetchRequest request;
+  request.rack_id = "rack-1";
+  for (int32_t t = 0; t < 3; t++) {
+    auto &topic = request.topics.emplace_back();
+    topic.topic = "orders";
+    for (int32_t p = 0; p < 10; p++) {
+      topic.partitions.emplace_back().partition = p;
+    }
+  }
+  auto &forgotten = request.forgotten_topics_data.emplace_back();
+  forgotten.topic = "payments";
+  forgotten.partitions = {1, 2};
+
+  // Fetch v12: topics still by name, flexible encoding
+  ResponseBuffer out;
+  KP::Codec::Writer writer(out);
+  writer.skipBytes(4).writeInt16(KP::FETCH).writeInt16(12).writeInt32(7);
+  writer.writeString<false>("client").writeUnsignedVarint(0);
+  request.write(writer, 12);
+  writer.updateMessageSize();
+  auto bytes = out.toVector();
+  std::vector<uint8_t> frame(bytes.begin(), bytes.end());
+
+  // Nothing may fall back to the heap: the arena has no upstream
+  std::array<std::byte, 8192> buffer;
+  std::pmr::monotonic_buffer_resource arena(buffer.data(), buffer.size(),
+                                            std::pmr::null_memory_resource());
+  auto parsed = Parser::parse(frame.data(), frame.size(), &arena);
+  const auto &r = std::get<FetchRequest>(parsed);
+  EXPECT_TRUE(static_cast<const KP::Messages::FetchRequestData &>(r) == request);
+
+  auto inFrame = [&frame](std::string_view text) {
+    const auto *at = reinterpret_cast<const uint8_t *>(text.data());
+    return at >= frame.data() && at + text.size() <= frame.data() + frame.size();
+  };
+  EXPECT_EQ(r.header.client_id, "client");
+  EXPECT_TRUE(inFrame(r.header.client_id));
+  EXPECT_TRUE(inFrame(r.rack_id));
+  EXPECT_TRUE(inFrame(r.topics[2].topic));
+  EXPECT_EQ(r.topics.get_allocator().resource(), &arena);
+  EXPECT_EQ(r.topics[2].partitions.get_allocator().resource(), &arena);
+  EXPECT_EQ(r.forgotten_topics_data[0].partitions.get_allocator().resource(), &arena);
+}
+
+TEST(ParserTest, ProduceRequest) {
+  // Produce v9: TAG_BUFFER, transactional_id, acks, timeout_ms, topics[name, partitions[index,
+  // records]]
+  std::vector<uint8_t> buf;
+  auto append = [&buf](const uint8_t *p, size_t n) { buf.insert(buf.end(), p, p + n); };
+  uint8_t tmp[8];
+  writeInt32(tmp, 0);
+  append(tmp, 4);
+  writeInt16(tmp, KP::PRODUCE);
+  append(tmp, 2);
+  writeInt16(tmp, 9);
+  append(tmp, 2);
+  writeInt32(tmp, 11);
+  append(tmp, 4);
+  writeInt16(tmp, 0);
+  append(tmp, 2);
+  buf.push_back(0); // TAG_BUFFER
+  buf.push_back(0); // null transactional_id
+  writeInt16(tmp, -1);
+  append(tmp, 2);
+  writeInt32(tmp, 1500);
+  append(tmp, 4);
+  buf.push_back(2); // 1 topic
+  buf.push_back(4); // name length + 1
+  append(reinterpret_cast<const uint8_t *>("foo"), 3);
+  buf.push_back(2); // 1 partition
+  writeInt32(tmp, 3);
+  append(tmp, 4);
+  buf.push_back(5); // 4 record bytes + 1
+  append(reinterpret_cast<const uint8_t *>("abcd"), 4);
+  buf.push_back(0); // partition TAG_BUFFER
+  buf.push_back(0); // topic TAG_BUFFER
+  buf.push_back(0); // TAG_BUFFER
+  writeInt32(buf.data(), static_cast<int32_t>(buf.size() - 4));
+
+  auto req = Parser::parse(buf.data(), buf.size());
+  ASSERT_TRUE(std::holds_alternative<ProduceRequest>(req));
+  const auto &r = std::get<ProduceRequest>(req);
+  EXPECT_EQ(r.header.correlation_id, 11);
+  EXPECT_FALSE(r.transactional_id.has_value());
+  EXPECT_EQ(r.acks, -1);
+  EXPECT_EQ(r.timeout_ms, 1500);
+  ASSERT_EQ(r.topic_data.size(), 1u);
+  EXPECT_EQ(r.topic_data[0].name, "foo");
+  ASSERT_EQ(r.topic_data[0].partition_data.size(), 1u);
+  EXPECT_EQ(r.topic_data[0].partition_data[0].index, 3);
+  EXPECT_EQ(r.topic_data[0].partition_data[0].records,
+            (std::vector<uint8_t> {'a', 'b', 'c', 'd'}));
+}
+
+TEST(ParserTest, ProduceRecordsOverrunBuffer) {
+  std::vector<uint8_t> buf(14, 0);
+  writeInt16(buf.data() + 4, KP::PRODUCE);
+  writeInt16(buf.data() + 6, 9);
+  writeInt32(buf.data() + 8, 1);
+  uint8_t body[] = {0, 0, 0xff, 0xff, 0, 0, 0, 0, 2, 2, 'x', 2, 0, 0, 0, 0, 0x7f};
+  buf.insert(buf.end(), body, body + sizeof(body));
+  writeInt32(buf.data(), static_cast<int32_t>(buf.size() - 4));
+  EXPECT_THROW(Parser::parse(buf.data(), buf.size()), ParseError);
+}
+
+TEST(ParserTest, TruncatedMessage) {
+  std::vector<uint8_t> buf(20, 0);
+  writeInt32(buf.data() + 0, 64); // declares more bytes than were received
+  writeInt16(buf.data() + 4, KP::API_VERSIONS);
+  writeInt16(buf.data() + 6, 0);
+  writeInt32(buf.data() + 8, 1);
+  writeInt16(buf.data() + 12, 0);
+  EXPECT_THROW(Parser::parse(buf.data(), buf.size()), ParseError);
+}
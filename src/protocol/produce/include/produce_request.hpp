@@ -0,0 +1,13 @@
+#pragma once
+
+#include "../../base/include/api_keys.hpp"
+#include "../../base/include/kafka_request.hpp"
+#include "messages/produce_request_data.hpp"
+
+using ProduceTopic = KafkaProtocol::Messages::ProduceRequestData::TopicProduceData;
+using ProducePartition = KafkaProtocol::Messages::ProduceRequestData::PartitionProduceData;
+
+class ProduceRequest : public KafkaRequest, public KafkaProtocol::Messages::ProduceRequestData {
+public:
+  static constexpr int16_t KEY = KafkaProtocol::PRODUCE;
+};
@@ -0,0 +1,10 @@
+#pragma once
+#include "messages/produce_response_data.hpp"
+
+namespace KafkaProtocol::Produce {
+inline constexpr int16_t ERROR_CORRUPT_MESSAGE = 2;
+inline constexpr int16_t ERROR_UNKNOWN_TOPIC_OR_PARTITION = 3;
+inline constexpr int16_t ERROR_KAFKA_STORAGE_ERROR = 56;
+} // namespace KafkaProtocol::Produce
+
+using ProduceResponse = KafkaProtocol::Messages::ProduceResponseData;
@@ -1,22 +1,41 @@
-#include "../responses/include/api_version_response.hpp"
-#include <cstring>
+#include "../api_versions/include/api_versions_response.hpp"
+#include "../base/include/api_keys.hpp"
 #include <gtest/gtest.h>
+#include <vector>
 
-TEST(ApiVersionsResponseTest, WritesValidResponse) {
-  char buf[256] = {};
-  ApiVersionResponse writer(buf);
-  writer.writeHeader(1, 0)
-      .writeApiVersionSupport()
-      .writeDescribeTopicsSupport()
-      .writeFetchSupport()
-      .writeMetadata()
-      .complete();
-  EXPECT_GT(writer.getOffset(), 0);
+namespace {
+ApiVersionsResponse supported() {
+  ApiVersionsResponse response;
+  response.api_keys = {{KafkaProtocol::API_VERSIONS, 0, 4}, {KafkaProtocol::FETCH, 0, 16}};
+  return response;
+}
+} // namespace
+
+TEST(ApiVersionsResponseTest, WritesFlexibleResponse) {
+  ResponseBuffer buf;
+  KafkaProtocol::Codec::encodeResponse(buf, 1, 4, supported());
+
+  // size, correlation id, error_code, api_keys (compact: count + 1), two entries with a
+  // TAG_BUFFER each, throttle_time_ms, TAG_BUFFER; the header has no tagged fields even here
+  auto bytes = buf.toVector();
+  ASSERT_EQ(bytes.size(), 4u + 4 + 2 + 1 + 2 * 7 + 4 + 1);
+  EXPECT_EQ(bytes[3], 26);
+  EXPECT_EQ(bytes[7], 1);
+  EXPECT_EQ(bytes[10], 3);
+  EXPECT_EQ(std::vector<char>(bytes.begin() + 11, bytes.begin() + 18),
+            (std::vector<char> {0, 18, 0, 0, 0, 4, 0}));
+  EXPECT_EQ(bytes.back(), 0);
 }
 
 TEST(ApiVersionsResponseTest, UnsupportedVersion) {
-  char buf[256] = {};
-  ApiVersionResponse writer(buf);
-  writer.writeHeader(1, 99).writeApiVersionSupport();
-  EXPECT_EQ(writer.getOffset(), 4 + 4 + 2 + 1 + 2 + 2 + 2 + 1);
+  auto response = supported();
+  response.error_code = KafkaProtocol::ApiVersions::UNSUPPORTED_VERSION;
+  ResponseBuffer buf;
+  KafkaProtocol::Codec::encodeResponse(buf, 1, 0, response);
+
+  // v0: classic int32 array length, no throttle time, no tagged fields
+  auto bytes = buf.toVector();
+  ASSERT_EQ(bytes.size(), 4u + 4 + 2 + 4 + 2 * 6);
+  EXPECT_EQ(bytes[9], KafkaProtocol::ApiVersions::UNSUPPORTED_VERSION);
+  EXPECT_EQ(bytes[13], 2);
 }
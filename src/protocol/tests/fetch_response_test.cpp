@@ -1,26 +1,93 @@
-#include "../responses/include/fetch_response.hpp"
+#include "../fetch/include/fetch_response.hpp"
+#include <arpa/inet.h>
+#include <cstdio>
+#include <cstring>
 #include <gtest/gtest.h>
 
+namespace {
+
+// One topic with one partition holding `records`
+FetchResponse responseWith(KafkaProtocol::Codec::Records records) {
+  FetchResponse response;
+  auto &topic = response.responses.emplace_back();
+  topic.topic_id = 1;
+  auto &partition = topic.partitions.emplace_back();
+  partition.records = std::move(records);
+  return response;
+}
+
+int32_t frameSize(const std::vector<char> &bytes) {
+  int32_t size;
+  std::memcpy(&size, bytes.data(), 4);
+  return static_cast<int32_t>(ntohl(static_cast<uint32_t>(size)));
+}
+
+} // namespace
+
 TEST(FetchResponseTest, WritesValidResponse) {
-  char buf[1024] = {};
-  FetchResponse writer(buf);
-  writer.writeHeader(42)
-      .writeResponseData(0, 0, 0, 2) // 1 topic
-      .writeTopicHeader(1, 2)        // 1 partition
-      .writePartitionData(0, 0, 0, 0, 0, std::vector<FetchResponse::AbortedTransaction> {}, 0,
-                          RecordBatches {})
-      .complete();
-  EXPECT_GT(writer.getOffset(), 0);
+  ResponseBuffer buf;
+  KafkaProtocol::Codec::encodeResponse(buf, 42, 16, responseWith({}));
+  auto bytes = buf.toVector();
+  EXPECT_EQ(static_cast<size_t>(frameSize(bytes)), bytes.size() - 4);
 }
 
 TEST(FetchResponseTest, WritesPartitionWithError) {
-  char buf[1024] = {};
-  FetchResponse writer(buf);
-  writer.writeHeader(1)
-      .writeResponseData(0, 0, 0, 2)
-      .writeTopicHeader(0, 2)
-      .writePartitionData(0, -1, 0, 0, 0, // error_code -1 = UNKNOWN_TOPIC
-                          std::vector<FetchResponse::AbortedTransaction> {}, 0, RecordBatches {})
-      .complete();
-  EXPECT_GT(writer.getOffset(), 0);
+  auto response = responseWith({});
+  response.responses[0].partitions[0].error_code =
+      KafkaProtocol::Fetch::ERROR_UNKNOWN_TOPIC_OR_PARTITION;
+
+  ResponseBuffer buf;
+  KafkaProtocol::Codec::encodeResponse(buf, 1, 16, response);
+  auto bytes = buf.toVector();
+  // size, correlation id, TAG, throttle, error, session, topics, topic id, partitions, index,
+  // then the low byte of the partition's error_code
+  EXPECT_EQ(bytes[4 + 4 + 1 + 4 + 2 + 4 + 1 + 16 + 1 + 4 + 1],
+            KafkaProtocol::Fetch::ERROR_UNKNOWN_TOPIC_OR_PARTITION);
+}
+
+TEST(FetchResponseTest, WritesTopicNamesBeforeVersion13) {
+  auto response = responseWith({});
+  response.responses[0].topic = "foo";
+
+  ResponseBuffer buf;
+  KafkaProtocol::Codec::encodeResponse(buf, 1, 12, response);
+  auto bytes = buf.toVector();
+  // size, correlation id, TAG, throttle, error, session, topics, then the compact topic name
+  size_t name = 4 + 4 + 1 + 4 + 2 + 4 + 1;
+  EXPECT_EQ(bytes[name], 4);
+  EXPECT_EQ(std::string(bytes.begin() + name + 1, bytes.begin() + name + 4), "foo");
+}
+
+TEST(FetchResponseTest, RecordBatchesLargerThanOneChunk) {
+  auto batch = common::SharedBytes::from(std::vector<uint8_t>(3 * ChunkPool::CHUNK_SIZE, 0xab));
+  ResponseBuffer buf;
+  KafkaProtocol::Codec::encodeResponse(buf, 7, 16, responseWith({batch}));
+
+  auto bytes = buf.toVector();
+  // The batch is sent from where it is rather than copied into chunks
+  ASSERT_EQ(buf.segments().size(), 3u);
+  EXPECT_EQ(ResponseBuffer::segmentData(buf.segments()[1]),
+            reinterpret_cast<const char *>(batch.data()));
+  EXPECT_EQ(static_cast<size_t>(frameSize(bytes)), bytes.size() - 4);
+}
+
+TEST(FetchResponseTest, RecordFilesAreSplicedNotCopied) {
+  FILE *file = std::tmpfile();
+  ASSERT_NE(file, nullptr);
+  std::fputs("batchbytes", file);
+  std::fflush(file);
+
+  ResponseBuffer buf;
+  KafkaProtocol::Codec::encodeResponse(
+      buf, 9, 16, responseWith({ResponseBuffer::FileSegment {fileno(file), 0, 10, nullptr}}));
+
+  ASSERT_EQ(buf.segments().size(), 3u);
+  EXPECT_TRUE(std::holds_alternative<ResponseBuffer::FileSegment>(buf.segments()[1]));
+
+  auto bytes = buf.toVector();
+  EXPECT_EQ(static_cast<size_t>(frameSize(bytes)), bytes.size() - 4);
+  // records length (10 + 1), records, partition TAG_BUFFER, topic TAG_BUFFER, final TAG_BUFFER
+  std::string tail(bytes.end() - 14, bytes.end());
+  EXPECT_EQ(tail, std::string("\x0b") + "batchbytes" + std::string(3, '\0'));
+  std::fclose(file);
 }
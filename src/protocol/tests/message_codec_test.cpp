@@ -0,0 +1,133 @@
+#include "codec.hpp"
+#include "messages/describe_topic_partitions_request_data.hpp"
+#include "messages/fetch_request_data.hpp"
+#include "messages/produce_request_data.hpp"
+#include <gtest/gtest.h>
+#include <stdexcept>
+#include <vector>
+
+using namespace KafkaProtocol;
+
+namespace {
+
+template <typename Message> std::vector<uint8_t> encode(const Message &message, int16_t version) {
+  ResponseBuffer buf;
+  Codec::Writer writer(buf);
+  message.write(writer, version);
+  auto bytes = buf.toVector();
+  return {bytes.begin(), bytes.end()};
+}
+
+template <typename Message> Message decode(const std::vector<uint8_t> &bytes, int16_t version) {
+  Codec::Reader reader(bytes.data(), bytes.size());
+  Message message;
+  message.read(reader, version);
+  EXPECT_EQ(reader.remaining(), 0u);
+  return message;
+}
+
+Messages::FetchRequestData fetchRequest() {
+  Messages::FetchRequestData request;
+  request.cluster_id = "cluster";
+  request.max_wait_ms = 500;
+  request.min_bytes = 1;
+  request.session_id = 7;
+  request.session_epoch = 2;
+  auto &topic = request.topics.emplace_back();
+  topic.topic = "foo";
+  topic.topic_id = 0x1234;
+  auto &partition = topic.partitions.emplace_back();
+  partition.partition = 3;
+  partition.fetch_offset = 90;
+  partition.partition_max_bytes = 1024;
+  auto &forgotten = request.forgotten_topics_data.emplace_back();
+  forgotten.topic = "bar";
+  forgotten.topic_id = 0x5678;
+  forgotten.partitions = {0, 1};
+  request.rack_id = "rack";
+  return request;
+}
+
+} // namespace
+
+TEST(MessageCodecTest, FetchRoundTripsEveryVersion) {
+  for (int16_t version = Messages::FetchRequestData::LOWEST_VERSION;
+       version <= Messages::FetchRequestData::HIGHEST_VERSION; version++) {
+    SCOPED_TRACE(version);
+    auto bytes = encode(fetchRequest(), version);
+    auto decoded = decode<Messages::FetchRequestData>(bytes, version);
+
+    // Whatever this version carries survives, and encodes back to the same bytes
+    EXPECT_EQ(encode(decoded, version), bytes);
+    EXPECT_EQ(decoded.max_wait_ms, 500);
+    ASSERT_EQ(decoded.topics.size(), 1u);
+    ASSERT_EQ(decoded.topics[0].partitions.size(), 1u);
+    EXPECT_EQ(decoded.topics[0].partitions[0].fetch_offset, 90);
+    if (version >= 13) {
+      EXPECT_EQ(decoded.topics[0].topic_id, 0x1234u);
+      EXPECT_TRUE(decoded.topics[0].topic.empty());
+    } else {
+      EXPECT_EQ(decoded.topics[0].topic, "foo");
+      EXPECT_EQ(decoded.topics[0].topic_id, 0u);
+    }
+    EXPECT_EQ(decoded.session_id, version >= 7 ? 7 : 0);
+    EXPECT_EQ(decoded.forgotten_topics_data.size(), version >= 7 ? 1u : 0u);
+  }
+}
+
+TEST(MessageCodecTest, TaggedFieldsOnlyInFlexibleVersions) {
+  auto request = fetchRequest();
+  EXPECT_EQ(decode<Messages::FetchRequestData>(encode(request, 12), 12).cluster_id, "cluster");
+  EXPECT_EQ(decode<Messages::FetchRequestData>(encode(request, 11), 11).cluster_id, std::nullopt);
+
+  // A tagged field left at its default is not written at all
+  request.cluster_id.reset();
+  EXPECT_EQ(encode(request, 12).size() + 10, encode(fetchRequest(), 12).size());
+}
+
+TEST(MessageCodecTest, NullableStructRoundTrips) {
+  Messages::DescribeTopicPartitionsRequestData request;
+  request.topics.emplace_back().name = "foo";
+  request.response_partition_limit = 10;
+  EXPECT_EQ(decode<Messages::DescribeTopicPartitionsRequestData>(encode(request, 0), 0), request);
+
+  request.cursor.emplace();
+  request.cursor->topic_name = "foo";
+  request.cursor->partition_index = 4;
+  EXPECT_EQ(decode<Messages::DescribeTopicPartitionsRequestData>(encode(request, 0), 0), request);
+}
+
+TEST(MessageCodecTest, ClassicProduceRoundTrips) {
+  Messages::ProduceRequestData request;
+  request.acks = -1;
+  request.timeout_ms = 1500;
+  auto &topic = request.topic_data.emplace_back();
+  topic.name = "foo";
+  auto &partition = topic.partition_data.emplace_back();
+  partition.index = 2;
+  partition.records = {1, 2, 3};
+
+  auto bytes = encode(request, 3);
+  // transactional_id is a classic nullable string: int16 length -1
+  EXPECT_EQ(bytes[0], 0xff);
+  EXPECT_EQ(bytes[1], 0xff);
+  EXPECT_EQ(decode<Messages::ProduceRequestData>(bytes, 3), request);
+}
+
+TEST(MessageCodecTest, TruncatedInputThrows) {
+  auto bytes = encode(fetchRequest(), 16);
+  bytes.resize(bytes.size() - 3);
+  EXPECT_THROW(decode<Messages::FetchRequestData>(bytes, 16), ParseError);
+}
+
+TEST(MessageCodecTest, ArrayLongerThanInputThrows) {
+  // transactional_id null, acks, timeout_ms, then a compact array claiming 1000 topics
+  std::vector<uint8_t> bytes {0, 0, 1, 0, 0, 0, 0, 0xe9, 0x07};
+  EXPECT_THROW(decode<Messages::ProduceRequestData>(bytes, 9), ParseError);
+}
+
+TEST(MessageCodecTest, UnsupportedVersionThrows) {
+  std::vector<uint8_t> bytes(64, 0);
+  EXPECT_THROW(decode<Messages::FetchRequestData>(bytes, 18), ParseError);
+  EXPECT_THROW(encode(fetchRequest(), 18), std::invalid_argument);
+}
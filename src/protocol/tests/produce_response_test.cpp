@@ -0,0 +1,49 @@
+#include "../produce/include/produce_response.hpp"
+#include <arpa/inet.h>
+#include <cstring>
+#include <gtest/gtest.h>
+
+TEST(ProduceResponseTest, WritesPartitionResults) {
+  ProduceResponse response;
+  auto &topic = response.responses.emplace_back();
+  topic.name = "foo";
+  auto &ok = topic.partition_responses.emplace_back();
+  ok.index = 0;
+  ok.base_offset = 42;
+  ok.log_start_offset = 0;
+  auto &failed = topic.partition_responses.emplace_back();
+  failed.index = 1;
+  failed.error_code = KafkaProtocol::Produce::ERROR_UNKNOWN_TOPIC_OR_PARTITION;
+  failed.base_offset = -1;
+
+  ResponseBuffer buf;
+  KafkaProtocol::Codec::encodeResponse(buf, 5, 11, response);
+
+  auto bytes = buf.toVector();
+  // size, correlation id, TAG, topics, name, partitions, 2 * 33-byte partitions, topic TAG,
+  // throttle, TAG
+  ASSERT_EQ(bytes.size(), 4u + 4 + 1 + 1 + 4 + 1 + 2 * 33 + 1 + 4 + 1);
+  int32_t size;
+  std::memcpy(&size, bytes.data(), 4);
+  EXPECT_EQ(static_cast<size_t>(ntohl(static_cast<uint32_t>(size))), bytes.size() - 4);
+
+  int64_t base_offset = 0;
+  for (int i = 0; i < 8; i++) {
+    base_offset = (base_offset << 8) | static_cast<uint8_t>(bytes[15 + 6 + i]);
+  }
+  EXPECT_EQ(base_offset, 42);
+}
+
+TEST(ProduceResponseTest, ClassicVersionsUseFixedWidthLengths) {
+  ProduceResponse response;
+  response.responses.emplace_back().name = "foo";
+
+  ResponseBuffer buf;
+  KafkaProtocol::Codec::encodeResponse(buf, 5, 8, response);
+
+  // size, correlation id, topics (int32), name (int16 length), partitions (int32), throttle
+  auto bytes = buf.toVector();
+  ASSERT_EQ(bytes.size(), 4u + 4 + 4 + 2 + 3 + 4 + 4);
+  EXPECT_EQ(bytes[11], 1);
+  EXPECT_EQ(bytes[13], 3);
+}
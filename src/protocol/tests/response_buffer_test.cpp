@@ -0,0 +1,87 @@
+#include "../base/include/response_buffer.hpp"
+#include <cstdio>
+#include <gtest/gtest.h>
+#include <numeric>
+#include <vector>
+
+TEST(ResponseBufferTest, AppendKeepsFieldsContiguous) {
+  ResponseBuffer buf;
+  buf.write(nullptr, ChunkPool::CHUNK_SIZE - 2);
+  char *field = buf.append(4);
+  std::memcpy(field, "abcd", 4);
+
+  ASSERT_EQ(buf.segments().size(), 2u);
+  EXPECT_EQ(ResponseBuffer::segmentSize(buf.segments()[1]), 4u);
+  EXPECT_EQ(buf.size(), ChunkPool::CHUNK_SIZE + 2);
+}
+
+TEST(ResponseBufferTest, WriteSpansChunks) {
+  std::vector<char> payload(ChunkPool::CHUNK_SIZE * 2 + 100);
+  std::iota(payload.begin(), payload.end(), 0);
+
+  ResponseBuffer buf;
+  buf.write(payload.data(), payload.size());
+  EXPECT_EQ(buf.segments().size(), 3u);
+  EXPECT_EQ(buf.toVector(), payload);
+}
+
+TEST(ResponseBufferTest, OverwriteAcrossChunkBoundary) {
+  ResponseBuffer buf;
+  buf.write(nullptr, ChunkPool::CHUNK_SIZE + 8);
+  buf.overwrite(ChunkPool::CHUNK_SIZE - 2, "wxyz", 4);
+
+  auto bytes = buf.toVector();
+  EXPECT_EQ(std::string(bytes.data() + ChunkPool::CHUNK_SIZE - 2, 4), "wxyz");
+}
+
+TEST(ResponseBufferTest, ReserveAcquiresChunksUpFront) {
+  ResponseBuffer buf;
+  buf.reserve(ChunkPool::CHUNK_SIZE * 2);
+  EXPECT_EQ(buf.segments().size(), 2u);
+  EXPECT_TRUE(buf.empty());
+
+  buf.write(nullptr, ChunkPool::CHUNK_SIZE * 2);
+  EXPECT_EQ(buf.segments().size(), 2u);
+}
+
+TEST(ResponseBufferTest, MoveTransfersChunks) {
+  ResponseBuffer a;
+  a.write("hello", 5);
+  ResponseBuffer b(std::move(a));
+  EXPECT_TRUE(a.empty());
+  EXPECT_EQ(b.size(), 5u);
+}
+
+TEST(ResponseBufferTest, FileSegmentSitsBetweenChunks) {
+  FILE *file = std::tmpfile();
+  ASSERT_NE(file, nullptr);
+  std::fputs("0123456789", file);
+  std::fflush(file);
+
+  ResponseBuffer buf;
+  buf.reserve(ChunkPool::CHUNK_SIZE * 2);
+  buf.write("<", 1);
+  buf.appendFile({fileno(file), 2, 5, nullptr});
+  buf.write(">", 1);
+
+  EXPECT_EQ(buf.size(), 7u);
+  auto bytes = buf.toVector();
+  EXPECT_EQ(std::string(bytes.begin(), bytes.end()), "<23456>");
+  std::fclose(file);
+}
+
+TEST(ResponseBufferTest, SharedSegmentIsReferencedNotCopied) {
+  auto shared = common::SharedBytes::from({'x', 'y', 'z'});
+
+  ResponseBuffer buf;
+  buf.write("<", 1);
+  buf.appendShared(shared);
+  buf.write(">", 1);
+
+  ASSERT_EQ(buf.segments().size(), 3u);
+  EXPECT_EQ(ResponseBuffer::segmentData(buf.segments()[1]),
+            reinterpret_cast<const char *>(shared.data()));
+  EXPECT_EQ(shared.owner().use_count(), 2);
+  auto bytes = buf.toVector();
+  EXPECT_EQ(std::string(bytes.begin(), bytes.end()), "<xyz>");
+}
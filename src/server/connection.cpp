@@ -0,0 +1,237 @@
+#include "include/connection.hpp"
+#include "trace.hpp"
+#include <arpa/inet.h>
+#include <cerrno>
+#include <algorithm>
+#include <cstring>
+#include <sys/socket.h>
+
+#if defined(__linux__)
+#include <sys/sendfile.h>
+#else
+#include <sys/types.h>
+#include <sys/uio.h>
+#endif
+
+#if defined(MSG_NOSIGNAL)
+static constexpr int SEND_FLAGS = MSG_NOSIGNAL;
+#else
+static constexpr int SEND_FLAGS = 0;
+#endif
+
+#if defined(MSG_MORE)
+static constexpr int MORE_FLAG = MSG_MORE;
+#else
+static constexpr int MORE_FLAG = 0;
+#endif
+
+// Copy file bytes straight from the page cache to the socket. Returns bytes sent or -1.
+static ssize_t sendFileRange(int socket, const ResponseBuffer::FileSegment &file, uint64_t offset,
+                             uint64_t length) {
+#if defined(__linux__)
+  auto pos = static_cast<off_t>(file.offset + offset);
+  ssize_t n = sendfile(socket, file.fd, &pos, length);
+  if (n == 0) {
+    // The file shrank underneath us; there is nothing sensible left to send
+    errno = EIO;
+    return -1;
+  }
+  return n;
+#else
+  auto sent = static_cast<off_t>(length);
+  int rc = sendfile(file.fd, socket, static_cast<off_t>(file.offset + offset), &sent, nullptr, 0);
+  if (rc != 0 && !(errno == EAGAIN && sent > 0)) {
+    return -1;
+  }
+  if (sent == 0) {
+    errno = EIO;
+    return -1;
+  }
+  return static_cast<ssize_t>(sent);
+#endif
+}
+
+bool Connection::readAvailable() {
+  while (true) {
+    // Stop pulling from the socket while plenty of pipelined requests are waiting; the server
+    // resumes reading once they have been handled.
+    read_paused_ = inputFull();
+    if (read_paused_) {
+      return true;
+    }
+
+    size_t old_size = input_.size();
+    input_.resize(old_size + READ_CHUNK);
+    ssize_t n = recv(socket_.get(), input_.data() + old_size, READ_CHUNK, 0);
+    if (n > 0) {
+      input_.resize(old_size + static_cast<size_t>(n));
+      scanFrames();
+      continue;
+    }
+
+    input_.resize(old_size);
+    if (n == 0) {
+      return false;
+    }
+    if (errno == EINTR) {
+      continue;
+    }
+    return errno == EAGAIN || errno == EWOULDBLOCK;
+  }
+}
+
+bool Connection::flush() {
+  while (hasOutput()) {
+    iovec iov[MAX_GATHER];
+    size_t count = gatherOutput(iov, MAX_GATHER);
+    ssize_t n;
+    if (count > 0) {
+      // Everything in memory up to the next file segment goes out in one call. Hold back a
+      // partial packet when more output follows it.
+      size_t gathered = 0;
+      for (size_t i = 0; i < count; i++) {
+        gathered += iov[i].iov_len;
+      }
+      msghdr message {};
+      message.msg_iov = iov;
+      message.msg_iovlen = count;
+      bool more = gathered < output_bytes_;
+      n = sendmsg(socket_.get(), &message, SEND_FLAGS | (more ? MORE_FLAG : 0));
+      if (n > 0) {
+        consumeOutput(static_cast<size_t>(n));
+      }
+    } else {
+      n = sendFile();
+    }
+    if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return errno == EAGAIN || errno == EWOULDBLOCK;
+    }
+  }
+  return true;
+}
+
+size_t Connection::gatherOutput(iovec *iov, size_t max) const {
+  size_t count = 0;
+  for (size_t r = 0; r < output_.size() && count < max; r++) {
+    const auto &segments = output_[r].segments();
+    for (size_t s = r == 0 ? output_segment_ : 0; s < segments.size() && count < max; s++) {
+      size_t sent = r == 0 && s == output_segment_ ? output_offset_ : 0;
+      size_t size = ResponseBuffer::segmentSize(segments[s]);
+      if (sent == size) {
+        continue;
+      }
+      const char *data = ResponseBuffer::segmentData(segments[s]);
+      if (!data) {
+        return count;
+      }
+      iov[count++] = {const_cast<char *>(data) + sent, size - sent};
+    }
+  }
+  return count;
+}
+
+ssize_t Connection::sendFile() {
+  common::trace::Span span("Connection::sendFile");
+  skipSent();
+  if (output_.empty()) {
+    return 0;
+  }
+  const auto &segment = output_.front().segments()[output_segment_];
+  const auto *file = std::get_if<ResponseBuffer::FileSegment>(&segment);
+  if (!file) {
+    errno = EINVAL;
+    return -1;
+  }
+  ssize_t n = sendFileRange(socket_.get(), *file, output_offset_, file->length - output_offset_);
+  if (n > 0) {
+    output_offset_ += static_cast<size_t>(n);
+    output_bytes_ -= static_cast<size_t>(n);
+    skipSent();
+  }
+  return n;
+}
+
+void Connection::consumeOutput(size_t length) {
+  while (length > 0) {
+    skipSent();
+    if (output_.empty()) {
+      return;
+    }
+    size_t segment_size =
+        ResponseBuffer::segmentSize(output_.front().segments()[output_segment_]);
+    size_t step = std::min(length, segment_size - output_offset_);
+    output_offset_ += step;
+    output_bytes_ -= step;
+    length -= step;
+  }
+  skipSent();
+}
+
+void Connection::skipSent() {
+  while (!output_.empty()) {
+    const auto &segments = output_.front().segments();
+    if (output_segment_ == segments.size()) {
+      output_.pop_front();
+      output_segment_ = 0;
+      output_offset_ = 0;
+      continue;
+    }
+    if (output_offset_ == ResponseBuffer::segmentSize(segments[output_segment_])) {
+      output_segment_++;
+      output_offset_ = 0;
+      continue;
+    }
+    return;
+  }
+}
+
+void Connection::scanFrames() {
+  size_t pos = complete_length_;
+  while (!invalid_frame_ && input_.size() - pos >= sizeof(int32_t)) {
+    int32_t size;
+    std::memcpy(&size, input_.data() + pos, sizeof(size));
+    size = static_cast<int32_t>(ntohl(static_cast<uint32_t>(size)));
+    if (size < 0 || size > MAX_REQUEST_SIZE) {
+      invalid_frame_ = true;
+      break;
+    }
+
+    size_t frame_length = sizeof(int32_t) + static_cast<size_t>(size);
+    if (input_.size() - pos < frame_length) {
+      break;
+    }
+    pos += frame_length;
+  }
+  complete_length_ = pos;
+}
+
+std::vector<uint8_t> Connection::takeRequests() {
+  size_t length = complete_length_;
+  complete_length_ = 0;
+  std::vector<uint8_t> requests;
+  if (length == input_.size()) {
+    requests.swap(input_);
+    return requests;
+  }
+
+  requests.assign(input_.begin(), input_.begin() + static_cast<std::ptrdiff_t>(length));
+  input_.erase(input_.begin(), input_.begin() + static_cast<std::ptrdiff_t>(length));
+  // What is left is at most the start of one frame, so this reads a single size prefix
+  scanFrames();
+  return requests;
+}
+
+void Connection::appendInput(const uint8_t *data, size_t length) {
+  input_.insert(input_.end(), data, data + length);
+  scanFrames();
+}
+
+void Connection::queueResponse(ResponseBuffer response) {
+  if (!response.empty()) {
+    output_bytes_ += response.size();
+    output_.push_back(std::move(response));
+  }
+}
@@ -0,0 +1,215 @@
+#include "include/event_loop.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <fcntl.h>
+#include <system_error>
+#include <unistd.h>
+
+#if defined(__linux__)
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#else
+#include <sys/event.h>
+#include <sys/time.h>
+#endif
+
+EventLoop::EventLoop() {
+#if defined(__linux__)
+  poll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+  if (poll_fd_ < 0) {
+    throw std::system_error(errno, std::generic_category(), "Failed to create epoll instance");
+  }
+  wakeup_read_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (wakeup_read_fd_ < 0) {
+    ::close(poll_fd_);
+    throw std::system_error(errno, std::generic_category(), "Failed to create eventfd");
+  }
+  wakeup_write_fd_ = wakeup_read_fd_;
+
+  epoll_event ev {};
+  ev.events = EPOLLIN;
+  ev.data.fd = wakeup_read_fd_;
+  epoll_ctl(poll_fd_, EPOLL_CTL_ADD, wakeup_read_fd_, &ev);
+#else
+  poll_fd_ = kqueue();
+  if (poll_fd_ < 0) {
+    throw std::system_error(errno, std::generic_category(), "Failed to create kqueue");
+  }
+  int fds[2];
+  if (pipe(fds) != 0) {
+    ::close(poll_fd_);
+    throw std::system_error(errno, std::generic_category(), "Failed to create wakeup pipe");
+  }
+  for (int fd : fds) {
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+    fcntl(fd, F_SETFD, FD_CLOEXEC);
+  }
+  wakeup_read_fd_ = fds[0];
+  wakeup_write_fd_ = fds[1];
+
+  struct kevent change;
+  EV_SET(&change, wakeup_read_fd_, EVFILT_READ, EV_ADD, 0, 0, nullptr);
+  kevent(poll_fd_, &change, 1, nullptr, 0, nullptr);
+#endif
+}
+
+EventLoop::~EventLoop() {
+  if (wakeup_write_fd_ != wakeup_read_fd_) {
+    ::close(wakeup_write_fd_);
+  }
+  ::close(wakeup_read_fd_);
+  ::close(poll_fd_);
+}
+
+void EventLoop::add(int fd, Callback callback) {
+#if defined(__linux__)
+  epoll_event ev {};
+  ev.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+  ev.data.fd = fd;
+  if (epoll_ctl(poll_fd_, EPOLL_CTL_ADD, fd, &ev) != 0) {
+    throw std::system_error(errno, std::generic_category(), "Failed to register fd with epoll");
+  }
+#else
+  struct kevent changes[2];
+  EV_SET(&changes[0], fd, EVFILT_READ, EV_ADD | EV_CLEAR, 0, 0, nullptr);
+  EV_SET(&changes[1], fd, EVFILT_WRITE, EV_ADD | EV_CLEAR, 0, 0, nullptr);
+  if (kevent(poll_fd_, changes, 2, nullptr, 0, nullptr) != 0) {
+    throw std::system_error(errno, std::generic_category(), "Failed to register fd with kqueue");
+  }
+#endif
+  callbacks_[fd] = std::make_shared<Callback>(std::move(callback));
+}
+
+void EventLoop::remove(int fd) {
+#if defined(__linux__)
+  epoll_ctl(poll_fd_, EPOLL_CTL_DEL, fd, nullptr);
+#else
+  struct kevent changes[2];
+  EV_SET(&changes[0], fd, EVFILT_READ, EV_DELETE, 0, 0, nullptr);
+  EV_SET(&changes[1], fd, EVFILT_WRITE, EV_DELETE, 0, 0, nullptr);
+  kevent(poll_fd_, changes, 2, nullptr, 0, nullptr);
+#endif
+  callbacks_.erase(fd);
+}
+
+void EventLoop::post(InlineFunction task) {
+  {
+    std::lock_guard lock(posted_mutex_);
+    posted_.push_back(std::move(task));
+  }
+  wakeup();
+}
+
+void EventLoop::runAfter(std::chrono::milliseconds delay, InlineFunction task) {
+  timers_.emplace(std::chrono::steady_clock::now() + delay, std::move(task));
+}
+
+void EventLoop::run() {
+  while (!stopped_.load(std::memory_order_acquire)) {
+    int wait = waitMillis();
+#if defined(__linux__)
+    epoll_event events[MAX_EVENTS];
+    int n = epoll_wait(poll_fd_, events, MAX_EVENTS, wait);
+#else
+    struct kevent events[MAX_EVENTS];
+    timespec timeout {wait / 1000, (wait % 1000) * 1000000L};
+    int n = kevent(poll_fd_, nullptr, 0, events, MAX_EVENTS, wait < 0 ? nullptr : &timeout);
+#endif
+    if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      throw std::system_error(errno, std::generic_category(), "Event loop wait failed");
+    }
+
+    for (int i = 0; i < n; i++) {
+#if defined(__linux__)
+      int fd = events[i].data.fd;
+      uint32_t flags = 0;
+      if (events[i].events & (EPOLLIN | EPOLLERR)) {
+        flags |= READABLE;
+      }
+      if (events[i].events & EPOLLOUT) {
+        flags |= WRITABLE;
+      }
+      if (events[i].events & (EPOLLHUP | EPOLLRDHUP)) {
+        flags |= HANGUP;
+      }
+#else
+      int fd = static_cast<int>(events[i].ident);
+      uint32_t flags = events[i].filter == EVFILT_WRITE ? WRITABLE : READABLE;
+      if (events[i].flags & (EV_EOF | EV_ERROR)) {
+        flags |= HANGUP;
+      }
+#endif
+      if (fd == wakeup_read_fd_) {
+        drainWakeup();
+        continue;
+      }
+      dispatch(fd, flags);
+    }
+
+    runPosted();
+    runTimers();
+  }
+}
+
+void EventLoop::stop() {
+  stopped_.store(true, std::memory_order_release);
+  wakeup();
+}
+
+void EventLoop::wakeup() {
+#if defined(__linux__)
+  uint64_t one = 1;
+  [[maybe_unused]] auto n = ::write(wakeup_write_fd_, &one, sizeof(one));
+#else
+  char byte = 1;
+  [[maybe_unused]] auto n = ::write(wakeup_write_fd_, &byte, 1);
+#endif
+}
+
+void EventLoop::drainWakeup() {
+  uint64_t buf[16];
+  while (::read(wakeup_read_fd_, buf, sizeof(buf)) > 0) {
+  }
+}
+
+void EventLoop::runPosted() {
+  std::vector<InlineFunction> tasks;
+  {
+    std::lock_guard lock(posted_mutex_);
+    tasks.swap(posted_);
+  }
+  for (auto &task : tasks) {
+    task();
+  }
+}
+
+void EventLoop::runTimers() {
+  auto now = std::chrono::steady_clock::now();
+  // A task may add timers of its own, so take each one out before running it
+  while (!timers_.empty() && timers_.begin()->first <= now) {
+    auto node = timers_.extract(timers_.begin());
+    node.mapped()();
+  }
+}
+
+int EventLoop::waitMillis() const {
+  if (timers_.empty()) {
+    return -1;
+  }
+  auto wait = std::chrono::ceil<std::chrono::milliseconds>(timers_.begin()->first -
+                                                           std::chrono::steady_clock::now());
+  return static_cast<int>(std::max<std::chrono::milliseconds::rep>(wait.count(), 0));
+}
+
+void EventLoop::dispatch(int fd, uint32_t events) {
+  auto it = callbacks_.find(fd);
+  if (it == callbacks_.end()) {
+    return;
+  }
+  // Keep the callback alive in case it removes its own registration
+  auto callback = it->second;
+  (*callback)(events);
+}
@@ -0,0 +1,218 @@
+#include "include/fetch_session.hpp"
+#include "../protocol/fetch/include/fetch_response.hpp"
+#include <algorithm>
+#include <limits>
+#include <unordered_set>
+
+namespace KPF = KafkaProtocol::Fetch;
+
+FetchSessionCache::FetchSessionCache(size_t max_sessions, size_t max_partitions)
+    : max_sessions_(max_sessions), max_partitions_(max_partitions) {}
+
+FetchPlan FetchSessionCache::resolve(const FetchRequest &request) {
+  std::lock_guard lock(mutex_);
+
+  if (request.session_epoch == FINAL_EPOCH || request.session_epoch == INITIAL_EPOCH) {
+    // A full fetch replaces whatever session the client had
+    if (auto it = by_id_.find(request.session_id); it != by_id_.end()) {
+      remove(it->second);
+    }
+    return request.session_epoch == INITIAL_EPOCH ? createSession(request) : sessionless(request);
+  }
+
+  if (request.session_id == 0) {
+    FetchPlan plan;
+    plan.error_code = KPF::ERROR_INVALID_FETCH_SESSION_EPOCH;
+    return plan;
+  }
+  return continueSession(request);
+}
+
+std::vector<bool> FetchSessionCache::recordSent(int32_t session_id, bool incremental,
+                                                std::span<const SentPartition> partitions) {
+  std::vector<bool> include(partitions.size(), true);
+  if (session_id == 0) {
+    return include;
+  }
+
+  std::lock_guard lock(mutex_);
+  auto it = by_id_.find(session_id);
+  if (it == by_id_.end()) {
+    return include; // evicted since the request was resolved; the next fetch starts over
+  }
+
+  auto &session = *it->second;
+  for (size_t i = 0; i < partitions.size(); i++) {
+    const auto &sent = partitions[i];
+    auto found = session.index.find(sent.key);
+    if (found == session.index.end()) {
+      continue;
+    }
+    auto &cached = session.partitions[found->second];
+    bool changed = sent.high_watermark != cached.high_watermark ||
+                   sent.last_stable_offset != cached.last_stable_offset ||
+                   sent.log_start_offset != cached.log_start_offset;
+    cached.high_watermark = sent.high_watermark;
+    cached.last_stable_offset = sent.last_stable_offset;
+    cached.log_start_offset = sent.log_start_offset;
+    if (incremental) {
+      include[i] = changed || sent.has_records || sent.error_code != 0;
+    }
+  }
+  return include;
+}
+
+size_t FetchSessionCache::sessions() const {
+  std::lock_guard lock(mutex_);
+  return sessions_.size();
+}
+
+size_t FetchSessionCache::partitions() const {
+  std::lock_guard lock(mutex_);
+  return cached_partitions_;
+}
+
+FetchPlan FetchSessionCache::createSession(const FetchRequest &request) {
+  Session session;
+  for (const auto &topic : request.topics) {
+    for (const auto &partition : topic.partitions) {
+      TopicPartition key {storage::TopicId {topic.topic_id}, partition.partition};
+      auto [found, added] = session.index.try_emplace(key, session.partitions.size());
+      if (added) {
+        session.partitions.push_back({key, partition});
+      } else {
+        session.partitions[found->second].request = partition;
+      }
+    }
+  }
+
+  // A session that cannot fit is not an error: the client just fetches without one
+  if (max_sessions_ == 0 || !makeRoom(session.partitions.size(), nullptr)) {
+    return sessionless(request);
+  }
+  while (sessions_.size() >= max_sessions_) {
+    remove(std::prev(sessions_.end()));
+  }
+
+  session.id = newSessionId();
+  cached_partitions_ += session.partitions.size();
+  sessions_.push_front(std::move(session));
+  by_id_[sessions_.front().id] = sessions_.begin();
+
+  FetchPlan plan;
+  plan.session_id = sessions_.front().id;
+  planTopics(sessions_.front(), plan);
+  return plan;
+}
+
+FetchPlan FetchSessionCache::continueSession(const FetchRequest &request) {
+  FetchPlan plan;
+  auto it = by_id_.find(request.session_id);
+  if (it == by_id_.end()) {
+    plan.error_code = KPF::ERROR_FETCH_SESSION_ID_NOT_FOUND;
+    return plan;
+  }
+  auto &session = *it->second;
+  if (request.session_epoch != session.next_epoch) {
+    plan.error_code = KPF::ERROR_INVALID_FETCH_SESSION_EPOCH;
+    return plan;
+  }
+
+  std::unordered_set<TopicPartition, TopicPartitionHash> forgotten;
+  for (const auto &topic : request.forgotten_topics_data) {
+    for (int32_t partition : topic.partitions) {
+      forgotten.insert({storage::TopicId {topic.topic_id}, partition});
+    }
+  }
+  if (!forgotten.empty()) {
+    size_t before = session.partitions.size();
+    std::erase_if(session.partitions,
+                  [&](const CachedPartition &cached) { return forgotten.contains(cached.key); });
+    cached_partitions_ -= before - session.partitions.size();
+    session.index.clear();
+    for (size_t i = 0; i < session.partitions.size(); i++) {
+      session.index.emplace(session.partitions[i].key, i);
+    }
+  }
+
+  size_t added = 0;
+  for (const auto &topic : request.topics) {
+    for (const auto &partition : topic.partitions) {
+      TopicPartition key {storage::TopicId {topic.topic_id}, partition.partition};
+      auto [found, inserted] = session.index.try_emplace(key, session.partitions.size());
+      if (inserted) {
+        session.partitions.push_back({key, partition});
+        added++;
+      } else {
+        session.partitions[found->second].request = partition;
+      }
+    }
+  }
+  cached_partitions_ += added;
+
+  // A session that outgrows the cache on its own is dropped; the client falls back to a full
+  // fetch, which runs without a session if it still does not fit
+  if (cached_partitions_ > max_partitions_ && !makeRoom(0, &session)) {
+    remove(it->second);
+    plan.error_code = KPF::ERROR_FETCH_SESSION_ID_NOT_FOUND;
+    return plan;
+  }
+
+  session.next_epoch = session.next_epoch == std::numeric_limits<int32_t>::max()
+                           ? 1
+                           : session.next_epoch + 1;
+  sessions_.splice(sessions_.begin(), sessions_, it->second);
+
+  plan.session_id = session.id;
+  plan.incremental = true;
+  planTopics(session, plan);
+  return plan;
+}
+
+bool FetchSessionCache::makeRoom(size_t needed, const Session *keep) {
+  if (needed > max_partitions_) {
+    return false;
+  }
+  auto victim = sessions_.end();
+  while (cached_partitions_ + needed > max_partitions_ && victim != sessions_.begin()) {
+    --victim;
+    if (&*victim == keep) {
+      continue;
+    }
+    remove(victim++);
+  }
+  return cached_partitions_ + needed <= max_partitions_;
+}
+
+void FetchSessionCache::remove(SessionList::iterator session) {
+  cached_partitions_ -= session->partitions.size();
+  by_id_.erase(session->id);
+  sessions_.erase(session);
+}
+
+int32_t FetchSessionCache::newSessionId() {
+  std::uniform_int_distribution<int32_t> distribution(1, std::numeric_limits<int32_t>::max());
+  int32_t id;
+  do {
+    id = distribution(random_);
+  } while (by_id_.contains(id));
+  return id;
+}
+
+FetchPlan FetchSessionCache::sessionless(const FetchRequest &request) {
+  FetchPlan plan;
+  plan.topics = request.topics;
+  return plan;
+}
+
+void FetchSessionCache::planTopics(const Session &session, FetchPlan &plan) {
+  // Partitions of a topic go out together even when they joined the session at different times
+  std::unordered_map<storage::TopicId, size_t, storage::TopicIdHash> topic_index;
+  for (const auto &cached : session.partitions) {
+    auto [found, added] = topic_index.try_emplace(cached.key.topic_id, plan.topics.size());
+    if (added) {
+      plan.topics.emplace_back().topic_id = cached.key.topic_id.value;
+    }
+    plan.topics[found->second].partitions.push_back(cached.request);
+  }
+}
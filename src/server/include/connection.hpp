@@ -0,0 +1,87 @@
+#pragma once
+
+#include "../../protocol/base/include/response_buffer.hpp"
+#include "socket_fd.hpp"
+#include <cstdint>
+#include <deque>
+#include <sys/types.h>
+#include <sys/uio.h>
+#include <vector>
+
+// Per-client state owned by one I/O backend. Only touched from that backend's thread.
+class Connection {
+public:
+  explicit Connection(SocketFd socket) : socket_(std::move(socket)) {}
+
+  [[nodiscard]] int fd() const { return socket_.get(); }
+  [[nodiscard]] bool closed() const { return !socket_.valid(); }
+
+  // Read until the socket would block, or pause once enough complete requests are buffered.
+  // Returns false once the peer is gone.
+  bool readAvailable();
+
+  // Write queued responses until done or the socket would block. Returns false on error.
+  // In-memory segments of all queued responses are gathered into one sendmsg(2); file segments
+  // go out with sendfile(2) so log bytes never pass through user space.
+  bool flush();
+
+  // Requests are framed by a big-endian int32 size prefix. Partial frames stay buffered until
+  // the rest arrives; several pipelined frames can be taken at once.
+  [[nodiscard]] bool hasRequest() const { return complete_length_ > 0; }
+  [[nodiscard]] bool invalidFrame() const { return invalid_frame_; }
+  [[nodiscard]] bool readPaused() const { return read_paused_; }
+  [[nodiscard]] size_t buffered() const { return input_.size(); }
+
+  // Enough complete requests are buffered that reading more can wait until they are handled
+  [[nodiscard]] bool inputFull() const {
+    return input_.size() >= MAX_BUFFERED_INPUT && hasRequest();
+  }
+
+  // Input received by means other than readAvailable(), e.g. an io_uring completion
+  void appendInput(const uint8_t *data, size_t length);
+
+  // Remove every complete frame from the input buffer, size prefixes included
+  std::vector<uint8_t> takeRequests();
+
+  void queueResponse(ResponseBuffer response);
+
+  [[nodiscard]] bool hasOutput() const { return !output_.empty(); }
+  [[nodiscard]] size_t pendingOutput() const { return output_bytes_; }
+
+  // For writers that send output themselves: up to `max` iovecs over the unsent bytes of the
+  // in-memory segments that come next. Returns 0 when a file segment is next.
+  size_t gatherOutput(iovec *iov, size_t max) const;
+
+  // Send the file segment that comes next with sendfile(2). Returns bytes sent or -1.
+  ssize_t sendFile();
+
+  // Mark `length` bytes of queued output as sent
+  void consumeOutput(size_t length);
+
+  void close() { socket_.close(); }
+
+  static constexpr int32_t MAX_REQUEST_SIZE = 100 * 1024 * 1024;
+  // iovecs handed to one vectored send
+  static constexpr size_t MAX_GATHER = 64;
+
+private:
+  // Extend the run of complete frames over input received since the last scan, so each byte
+  // of a pipelined batch is looked at once however often the checks above run
+  void scanFrames();
+
+  // Move past fully sent segments and responses
+  void skipSent();
+
+  static constexpr size_t READ_CHUNK = 16 * 1024;
+  static constexpr size_t MAX_BUFFERED_INPUT = 1024 * 1024;
+
+  SocketFd socket_;
+  std::vector<uint8_t> input_;
+  size_t complete_length_ {0}; // bytes of input_ holding complete frames
+  bool invalid_frame_ {false}; // the frame after them has an impossible size
+  bool read_paused_ {false};
+  std::deque<ResponseBuffer> output_;
+  size_t output_segment_ {0};
+  size_t output_offset_ {0};
+  size_t output_bytes_ {0}; // queued and not yet sent
+};
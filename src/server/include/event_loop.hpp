@@ -0,0 +1,64 @@
+#pragma once
+
+#include "inline_function.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+// Edge-triggered readiness loop: epoll on Linux, kqueue on macOS/BSD. Registered fds are watched
+// for read and write readiness at once, so callbacks must drain the socket until EAGAIN.
+// add()/remove()/runAfter()/run() belong to the loop thread; post() and stop() may be called from
+// any thread.
+class EventLoop {
+public:
+  enum Events : uint32_t {
+    READABLE = 1u << 0,
+    WRITABLE = 1u << 1,
+    HANGUP = 1u << 2,
+  };
+
+  using Callback = std::function<void(uint32_t events)>;
+
+  EventLoop();
+  ~EventLoop();
+
+  EventLoop(const EventLoop &) = delete;
+  EventLoop &operator=(const EventLoop &) = delete;
+
+  void add(int fd, Callback callback);
+  void remove(int fd);
+
+  // Queue a task for the loop thread and wake it up
+  void post(InlineFunction task);
+
+  // Run a task on the loop thread once `delay` has passed
+  void runAfter(std::chrono::milliseconds delay, InlineFunction task);
+
+  void run();
+  void stop();
+
+private:
+  void wakeup();
+  void drainWakeup();
+  void runPosted();
+  void runTimers();
+  [[nodiscard]] int waitMillis() const;
+  void dispatch(int fd, uint32_t events);
+
+  static constexpr int MAX_EVENTS = 256;
+
+  int poll_fd_ {-1};
+  int wakeup_read_fd_ {-1};
+  int wakeup_write_fd_ {-1};
+  std::unordered_map<int, std::shared_ptr<Callback>> callbacks_;
+  std::mutex posted_mutex_;
+  std::vector<InlineFunction> posted_;
+  std::multimap<std::chrono::steady_clock::time_point, InlineFunction> timers_;
+  std::atomic<bool> stopped_ {false};
+};
@@ -0,0 +1,94 @@
+#pragma once
+
+#include "../../protocol/fetch/include/fetch_request.hpp"
+#include "topic_partition.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory_resource>
+#include <mutex>
+#include <random>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+// What a fetch request asks for once its session is taken into account
+struct FetchPlan {
+  int16_t error_code {0};   // a session error fails the whole request
+  int32_t session_id {0};   // returned to the client; 0 when the fetch has no session
+  bool incremental {false}; // the response leaves out partitions with nothing new
+  std::pmr::vector<FetchTopic> topics;
+};
+
+// Broker side of KIP-227 incremental fetch sessions. A full fetch (epoch 0) creates a session
+// that remembers its partitions; later fetches send only the partitions whose fetch position
+// changed plus the ones to forget, and get back only partitions with new records, new offsets
+// or an error. Sessions and the partitions they hold are bounded; the least recently used
+// sessions are evicted to make room. Thread-safe.
+class FetchSessionCache {
+public:
+  static constexpr int32_t INITIAL_EPOCH = 0;
+  static constexpr int32_t FINAL_EPOCH = -1;
+
+  // What a response said about one partition, compared against what the session last sent
+  struct SentPartition {
+    TopicPartition key;
+    int16_t error_code {0};
+    int64_t high_watermark {0};
+    int64_t last_stable_offset {0};
+    int64_t log_start_offset {0};
+    bool has_records {false};
+  };
+
+  explicit FetchSessionCache(size_t max_sessions = 1000, size_t max_partitions = 100000);
+
+  // Apply the request's session fields: create, continue or close a session and work out
+  // which partitions to read. Advances the session epoch, so call it once per request.
+  FetchPlan resolve(const FetchRequest &request);
+
+  // Remember what the response for `session_id` tells the client and say which partitions it
+  // should include. A full response includes them all.
+  std::vector<bool> recordSent(int32_t session_id, bool incremental,
+                               std::span<const SentPartition> partitions);
+
+  [[nodiscard]] size_t sessions() const;
+  [[nodiscard]] size_t partitions() const;
+
+private:
+  struct CachedPartition {
+    TopicPartition key;
+    FetchPartition request;
+    int64_t high_watermark {-1};
+    int64_t last_stable_offset {-1};
+    int64_t log_start_offset {-1};
+  };
+
+  struct Session {
+    int32_t id {0};
+    int32_t next_epoch {1};
+    std::vector<CachedPartition> partitions; // in the order they were added
+    std::unordered_map<TopicPartition, size_t, TopicPartitionHash> index;
+  };
+
+  using SessionList = std::list<Session>; // most recently used first
+
+  FetchPlan createSession(const FetchRequest &request);
+  FetchPlan continueSession(const FetchRequest &request);
+
+  // Evict least recently used sessions other than `keep` until `needed` more partitions fit
+  bool makeRoom(size_t needed, const Session *keep);
+  void remove(SessionList::iterator session);
+  int32_t newSessionId();
+
+  static FetchPlan sessionless(const FetchRequest &request);
+  static void planTopics(const Session &session, FetchPlan &plan);
+
+  const size_t max_sessions_;
+  const size_t max_partitions_;
+
+  mutable std::mutex mutex_;
+  SessionList sessions_;
+  std::unordered_map<int32_t, SessionList::iterator> by_id_;
+  size_t cached_partitions_ {0};
+  std::mt19937 random_ {std::random_device {}()};
+};
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+// Move-only `void()` callable. Callables up to INLINE_SIZE bytes that move without throwing are
+// stored in place, so wrapping a typical request lambda does not allocate; larger ones go to
+// the heap. Unlike std::function it accepts move-only captures such as promises.
+class InlineFunction {
+public:
+  static constexpr size_t INLINE_SIZE = 48;
+
+  InlineFunction() noexcept = default;
+
+  template <typename F>
+    requires(!std::is_same_v<std::remove_cvref_t<F>, InlineFunction> &&
+             std::is_invocable_v<std::remove_cvref_t<F> &>)
+  InlineFunction(F &&f) { // implicit, like std::function
+    using Callable = std::remove_cvref_t<F>;
+    if constexpr (fitsInline<Callable>()) {
+      ::new (static_cast<void *>(storage_)) Callable(std::forward<F>(f));
+      ops_ = &INLINE_OPS<Callable>;
+    } else {
+      ::new (static_cast<void *>(storage_)) Callable *(new Callable(std::forward<F>(f)));
+      ops_ = &HEAP_OPS<Callable>;
+    }
+  }
+
+  InlineFunction(InlineFunction &&other) noexcept : ops_(other.ops_) {
+    if (ops_) {
+      ops_->move(other.storage_, storage_);
+      other.ops_ = nullptr;
+    }
+  }
+
+  InlineFunction &operator=(InlineFunction &&other) noexcept {
+    if (this != &other) {
+      reset();
+      ops_ = other.ops_;
+      if (ops_) {
+        ops_->move(other.storage_, storage_);
+        other.ops_ = nullptr;
+      }
+    }
+    return *this;
+  }
+
+  InlineFunction(const InlineFunction &) = delete;
+  InlineFunction &operator=(const InlineFunction &) = delete;
+
+  ~InlineFunction() { reset(); }
+
+  void operator()() { ops_->invoke(storage_); }
+
+  explicit operator bool() const noexcept { return ops_ != nullptr; }
+
+  void reset() noexcept {
+    if (ops_) {
+      ops_->destroy(storage_);
+      ops_ = nullptr;
+    }
+  }
+
+  // Whether F would be stored without allocating
+  template <typename F> static constexpr bool fitsInline() {
+    return sizeof(F) <= INLINE_SIZE && alignof(F) <= alignof(std::max_align_t) &&
+           std::is_nothrow_move_constructible_v<F>;
+  }
+
+private:
+  struct Ops {
+    void (*invoke)(void *);
+    void (*move)(void *from, void *to) noexcept;
+    void (*destroy)(void *) noexcept;
+  };
+
+  template <typename F>
+  static constexpr Ops INLINE_OPS {
+      [](void *self) { (*static_cast<F *>(self))(); },
+      [](void *from, void *to) noexcept {
+        ::new (to) F(std::move(*static_cast<F *>(from)));
+        static_cast<F *>(from)->~F();
+      },
+      [](void *self) noexcept { static_cast<F *>(self)->~F(); },
+  };
+
+  template <typename F>
+  static constexpr Ops HEAP_OPS {
+      [](void *self) { (**static_cast<F **>(self))(); },
+      [](void *from, void *to) noexcept { ::new (to) F *(*static_cast<F **>(from)); },
+      [](void *self) noexcept { delete *static_cast<F **>(self); },
+  };
+
+  alignas(std::max_align_t) std::byte storage_[INLINE_SIZE];
+  const Ops *ops_ {nullptr};
+};
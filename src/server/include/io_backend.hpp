@@ -0,0 +1,97 @@
+#pragma once
+
+#include "connection.hpp"
+#include "inline_function.hpp"
+#include "socket_fd.hpp"
+#include "task.hpp"
+#include <cerrno>
+#include <chrono>
+#include <coroutine>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <unordered_map>
+
+// One I/O thread. Each connection is served by a coroutine that co_awaits read() and write() on
+// its backend; the backend resumes it on the loop thread once the socket was ready (epoll,
+// kqueue) or the operation completed (io_uring). run() and everything but post(), stop() and
+// schedule() belong to the loop thread.
+class IoBackend {
+public:
+  enum class Kind {
+    Auto,      // io_uring where the kernel allows it, readiness otherwise
+    Readiness, // epoll on Linux, kqueue on macOS/BSD
+    IoUring,
+  };
+
+  static std::unique_ptr<IoBackend> create(Kind kind = Kind::Auto);
+
+  IoBackend() = default;
+  virtual ~IoBackend();
+
+  IoBackend(const IoBackend &) = delete;
+  IoBackend &operator=(const IoBackend &) = delete;
+
+  virtual void run() = 0;
+  virtual void stop() = 0;
+
+  // Queue a task for the loop thread and wake it up
+  virtual void post(InlineFunction task) = 0;
+
+  [[nodiscard]] virtual const char *name() const = 0;
+
+  // Call `on_accept` with every connection accepted on the listening socket
+  virtual void listen(SocketFd &socket, std::function<void(SocketFd)> on_accept) = 0;
+
+  // A connection is attached while a coroutine serves it
+  virtual void attach(Connection &connection) = 0;
+  virtual void detach(Connection &connection) = 0;
+
+  // Resolves to true once more input is buffered, false once the peer is gone
+  virtual Task<bool> read(Connection &connection) = 0;
+
+  // Resolves once every queued response is written, false on error
+  virtual Task<bool> write(Connection &connection) = 0;
+
+  // Run `task` on the loop thread. Tasks still suspended when the backend is destroyed are
+  // destroyed with it.
+  void spawn(Task<> task);
+
+  // co_await schedule() to continue on the loop thread
+  auto schedule() {
+    struct Awaiter {
+      IoBackend &backend;
+      bool await_ready() const noexcept { return false; }
+      void await_suspend(std::coroutine_handle<> handle) {
+        backend.post([handle] { handle.resume(); });
+      }
+      void await_resume() const noexcept {}
+    };
+    return Awaiter {*this};
+  }
+
+protected:
+  // Parks the awaiting coroutine in `slot` for the backend to resume later
+  struct WaitFor {
+    std::coroutine_handle<> &slot;
+    bool await_ready() const noexcept { return false; }
+    void await_suspend(std::coroutine_handle<> handle) noexcept { slot = handle; }
+    void await_resume() const noexcept {}
+  };
+
+  // Accepting again right after running out of descriptors or memory fails the same way at
+  // once, so backends stop accepting for a while instead
+  static constexpr std::chrono::milliseconds ACCEPT_BACKOFF {100};
+  static bool acceptExhausted(int error) {
+    return error == EMFILE || error == ENFILE || error == ENOBUFS || error == ENOMEM;
+  }
+
+  // Derived destructors call this before tearing down what suspended tasks refer to
+  void destroyTasks();
+
+private:
+  static DetachedTask runDetached(Task<> task, IoBackend *backend, uint64_t id);
+
+  std::unordered_map<uint64_t, std::coroutine_handle<>> tasks_;
+  uint64_t next_task_id_ {0};
+};
@@ -0,0 +1,84 @@
+#pragma once
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#endif
+
+// Multishot recv and provided buffer rings arrived in Linux 6.0; older headers build the
+// readiness backend only
+#if defined(IORING_RECV_MULTISHOT)
+#define KAFKA_HAVE_IO_URING 1
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+
+// Submission and completion rings of one io_uring instance, driven through the raw system calls.
+// Not thread-safe: one thread submits and reaps.
+class IoUring {
+public:
+  explicit IoUring(unsigned entries);
+  ~IoUring();
+
+  IoUring(const IoUring &) = delete;
+  IoUring &operator=(const IoUring &) = delete;
+
+  // A zeroed submission entry, handing queued entries to the kernel first if the ring is full.
+  // While the kernel takes no more (completions must be reaped first), the entry is parked and
+  // moves into the ring on a later submit(). Valid until the next sqe() or submit().
+  io_uring_sqe *sqe();
+
+  // Submit queued entries and wait until at least `wait` completions are ready
+  void submit(unsigned wait = 0);
+
+  // Entries parked because the submission ring was full
+  [[nodiscard]] size_t parked() const { return parked_.size(); }
+
+  // Call `f(const io_uring_cqe &)` for every ready completion and mark them consumed
+  template <typename F> unsigned forEachCompletion(F &&f) {
+    unsigned head = *cq_head_;
+    unsigned tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+    unsigned seen = 0;
+    for (; head != tail; head++, seen++) {
+      f(cqes_[head & *cq_mask_]);
+    }
+    __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+    return seen;
+  }
+
+  // Register `entries` buffer descriptors at `ring` as provided buffer group `group`
+  void registerBufferRing(io_uring_buf_ring *ring, unsigned entries, uint16_t group);
+
+  [[nodiscard]] int fd() const { return fd_; }
+
+private:
+  void release();
+  int enter(unsigned submit, unsigned wait, unsigned flags);
+  [[nodiscard]] bool full() const;
+  // Move parked entries into the ring, oldest first, while it has room
+  void unpark();
+
+  int fd_ {-1};
+  void *sq_ring_ {nullptr};
+  size_t sq_ring_size_ {0};
+  void *cq_ring_ {nullptr};
+  size_t cq_ring_size_ {0};
+  io_uring_sqe *sqes_ {nullptr};
+  size_t sqes_size_ {0};
+
+  unsigned *sq_head_ {nullptr};
+  unsigned *sq_tail_ {nullptr};
+  unsigned sq_mask_ {0};
+  unsigned sq_entries_ {0};
+  unsigned sq_local_tail_ {0};
+  unsigned sq_submitted_ {0};
+
+  unsigned *cq_head_ {nullptr};
+  unsigned *cq_tail_ {nullptr};
+  unsigned *cq_mask_ {nullptr};
+  io_uring_cqe *cqes_ {nullptr};
+
+  std::deque<io_uring_sqe> parked_;
+};
+
+#endif
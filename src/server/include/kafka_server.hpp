@@ -2,44 +2,155 @@
 
 #include "../../protocol/api_versions/include/api_versions_request.hpp"
 #include "../../protocol/base/include/api_keys.hpp"
+#include "../../protocol/base/include/codec.hpp"
 #include "../../protocol/base/include/kafka_request_variant.hpp"
+#include "../../protocol/base/include/response_buffer.hpp"
 #include "../../protocol/describe_topic_partitions/include/describe_topic_partitions_request.hpp"
 #include "../../protocol/fetch/include/fetch_request.hpp"
 #include "../../protocol/fetch/include/fetch_response.hpp"
+#include "../../protocol/produce/include/produce_request.hpp"
+#include "../../metrics/include/registry.hpp"
+#include "../../metrics/include/scrape_endpoint.hpp"
 #include "../../storage/include/storage_service.hpp"
+#include "connection.hpp"
+#include "fetch_session.hpp"
+#include "io_backend.hpp"
+#include "purgatory.hpp"
+#include "server_metrics.hpp"
 #include "socket_fd.hpp"
+#include "task.hpp"
 #include "thread_pool.hpp"
+#include <atomic>
+#include <chrono>
+#include <coroutine>
 #include <cstdint>
+#include <expected>
 #include <functional>
 #include <map>
 #include <memory>
 #include <netinet/in.h>
+#include <span>
+#include <string>
+#include <thread>
+#include <vector>
 
 class KafkaServer {
 public:
-  explicit KafkaServer(uint16_t port = 9092);
-  KafkaServer(uint16_t port, std::unique_ptr<storage::IStorageService> storage);
-  ~KafkaServer() = default;
+  // Serves the logs under /tmp/kraft-combined-logs, syncing appends as `fsync_policy` says
+  explicit KafkaServer(uint16_t port = 9092, storage::FsyncPolicy fsync_policy = {});
+  KafkaServer(uint16_t port, std::unique_ptr<storage::IStorageService> storage,
+              IoBackend::Kind io = IoBackend::Kind::Auto);
+  ~KafkaServer();
 
+  // Accept and serve connections until stop() is called
   void start();
+  void stop();
+
+  // Serve the server's metrics in Prometheus' text format over HTTP on `port`, or on a free
+  // port when it is 0, and the spans traced so far as Chrome trace JSON at /trace. Returns the
+  // port; throws std::system_error if it cannot be bound.
+  uint16_t serveMetrics(uint16_t port);
+
+  [[nodiscard]] const metrics::Registry &metrics() const { return metrics_registry_; }
 
 private:
-  static constexpr size_t BUFFER_SIZE = 4096;
+  using ConnectionPtr = std::shared_ptr<Connection>;
+
+  // Writes one request's response. A handler that has to wait, like a fetch short of min_bytes,
+  // suspends instead of holding a thread; requests behind it wait, so responses stay in order.
+  using RequestHandler =
+      std::function<Task<>(const KafkaRequestVariant &, ResponseBuffer &response)>;
+
+  // What a fetch found for one requested partition
+  struct FetchedPartition {
+    int32_t index {0};
+    int16_t error_code {0};
+    int64_t high_watermark {0};
+    int64_t last_stable_offset {0};
+    int64_t log_start_offset {0};
+    KafkaProtocol::Codec::Records records;
+  };
+
+  struct FetchResult {
+    std::vector<std::vector<FetchedPartition>> topics; // in request order
+    std::vector<std::string> topic_names;              // empty for unknown topics
+    uint64_t bytes {0};
+    bool has_error {false};
+  };
+
+  // Suspends until a watched partition is appended to or the deadline passes, then continues
+  // on the thread pool
+  struct FetchWait {
+    KafkaServer &server;
+    std::span<const TopicPartition> keys;
+    std::span<const uint64_t> seen;
+    Purgatory::Clock::time_point deadline;
+    bool await_ready() const noexcept { return false; }
+    void await_suspend(std::coroutine_handle<> handle);
+    void await_resume() const noexcept {}
+  };
+
+  // Acknowledgements of the appends one produce request submitted, which arrive in any order
+  // on the storage's writer thread
+  struct ProduceAcks {
+    explicit ProduceAcks(size_t appends) : results(appends) {}
+    std::vector<std::expected<storage::AppendResult, storage::StorageError>> results;
+    std::atomic<size_t> outstanding {1}; // one per append, plus the handler's until it waits
+    std::coroutine_handle<> handle;
+  };
+
+  // Suspends until every append of `acks` is acknowledged, then continues on the thread pool
+  struct ProduceWait {
+    ProduceAcks &acks;
+    bool await_ready() const noexcept { return false; }
+    bool await_suspend(std::coroutine_handle<> handle) noexcept;
+    void await_resume() const noexcept {}
+  };
+
+  // Record that one append of `acks` was acknowledged; the last one resumes the handler
+  void acknowledge(ProduceAcks &acks);
 
-  using RequestHandler = std::function<void(const KafkaRequestVariant &, char *, int &)>;
+  // The life of one connection: read requests, handle them on the thread pool, write the
+  // responses back on the connection's I/O thread, until the peer goes away
+  Task<> serveConnection(IoBackend &io, ConnectionPtr connection);
 
-  void handleClient(int client_fd);
+  // Handle every frame in `requests` in order, adding the metrics of each request handled to
+  // `handled`. Requests are decoded into an arena in the batch's frame, released after each
+  // one. Resolves to false at the first invalid request.
+  Task<bool> handleRequests(std::vector<uint8_t> requests, ResponseBuffer &responses,
+                            std::vector<ApiMetrics *> &handled);
   void registerHandlers();
 
-  void handleApiVersions(const ApiVersionRequest &request, char *response, int &offset);
-  void handleDescribeTopicPartitions(const DescribeTopicsRequest &request, char *response,
-                                     int &offset);
-  void handleFetch(const FetchRequest &request, char *response, int &offset);
+  void handleApiVersions(const ApiVersionRequest &request, ResponseBuffer &response);
+  void handleDescribeTopicPartitions(const DescribeTopicsRequest &request,
+                                     ResponseBuffer &response);
+  Task<> handleFetch(const FetchRequest &request, ResponseBuffer &response);
+  // Fill in the topic ids of a pre-v13 fetch, which names its topics instead
+  void resolveTopicIds(FetchRequest &request);
+  FetchResult readFetch(std::span<const FetchTopic> topics, int32_t max_bytes);
+  Task<> handleProduce(const ProduceRequest &request, ResponseBuffer &response);
+
+  // Declared first: storage calls and request handlers record into these until the end
+  metrics::Registry metrics_registry_;
+  std::unique_ptr<ServerMetrics> metrics_;
+  std::unique_ptr<metrics::ScrapeEndpoint> scrape_endpoint_;
 
   uint16_t port = 9092;
+  std::unique_ptr<storage::IStorageService> storage_;
+  std::map<int16_t, RequestHandler> apiHandlers;
   SocketFd server_socket_;
   struct sockaddr_in server_addr;
+
+  FetchSessionCache fetch_sessions_;
+
+  // Fetches waiting for min_bytes, woken by produce appends or their max_wait_ms
+  Purgatory fetch_purgatory_;
+
+  // Connections are spread round-robin over the I/O backends; request handling runs on the
+  // thread pool, which is declared last so it drains before the backends it posts to go away.
+  std::unique_ptr<IoBackend> accept_io_;
+  std::vector<std::unique_ptr<IoBackend>> io_loops_;
+  std::vector<std::thread> io_threads_;
+  size_t next_loop_ {0};
   ThreadPool thread_pool;
-  std::map<int16_t, RequestHandler> apiHandlers;
-  std::unique_ptr<storage::IStorageService> storage_;
 };
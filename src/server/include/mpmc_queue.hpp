@@ -0,0 +1,80 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+
+// Bounded multi-producer multi-consumer FIFO (Vyukov). Each slot has a sequence number saying
+// whose turn it is, so producers and consumers only contend on their own end's counter and
+// never take a lock. push() fails when the queue is full.
+template <typename T> class MpmcQueue {
+public:
+  explicit MpmcQueue(size_t capacity = 4096)
+      : mask_(std::bit_ceil(std::max<size_t>(capacity, 2)) - 1),
+        slots_(std::make_unique<Slot[]>(mask_ + 1)) {
+    for (size_t i = 0; i <= mask_; i++) {
+      slots_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  MpmcQueue(const MpmcQueue &) = delete;
+  MpmcQueue &operator=(const MpmcQueue &) = delete;
+
+  bool push(T &value) {
+    size_t position = tail_.load(std::memory_order_relaxed);
+    while (true) {
+      auto &slot = slots_[position & mask_];
+      size_t sequence = slot.sequence.load(std::memory_order_acquire);
+      auto lag = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+      if (lag == 0) {
+        if (tail_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+          slot.value = std::move(value);
+          slot.sequence.store(position + 1, std::memory_order_release);
+          return true;
+        }
+      } else if (lag < 0) {
+        return false; // the consumer a lap behind has not emptied this slot
+      } else {
+        position = tail_.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  std::optional<T> pop() {
+    size_t position = head_.load(std::memory_order_relaxed);
+    while (true) {
+      auto &slot = slots_[position & mask_];
+      size_t sequence = slot.sequence.load(std::memory_order_acquire);
+      auto lag = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position + 1);
+      if (lag == 0) {
+        if (head_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+          T value = std::move(slot.value);
+          slot.value = T {};
+          slot.sequence.store(position + mask_ + 1, std::memory_order_release);
+          return value;
+        }
+      } else if (lag < 0) {
+        return std::nullopt;
+      } else {
+        position = head_.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  [[nodiscard]] size_t capacity() const { return mask_ + 1; }
+
+private:
+  struct Slot {
+    std::atomic<size_t> sequence {0};
+    T value {};
+  };
+
+  alignas(64) std::atomic<size_t> head_ {0};
+  alignas(64) std::atomic<size_t> tail_ {0};
+  const size_t mask_;
+  std::unique_ptr<Slot[]> slots_;
+};
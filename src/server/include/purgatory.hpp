@@ -0,0 +1,71 @@
+#pragma once
+
+#include "timing_wheel.hpp"
+#include "topic_partition.hpp"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// Delayed operations waiting on partitions, e.g. fetches that want more bytes than are there.
+// An operation completes exactly once: when one of its partitions is triggered, or when its
+// deadline passes, whichever comes first. Nothing blocks while operations wait; deadlines are
+// kept in a timing wheel driven by one expiration thread.
+class Purgatory {
+public:
+  using Clock = std::chrono::steady_clock;
+
+  explicit Purgatory(Clock::duration tick = std::chrono::milliseconds(1));
+  ~Purgatory();
+
+  Purgatory(const Purgatory &) = delete;
+  Purgatory &operator=(const Purgatory &) = delete;
+
+  // How often each key has been triggered. Read before checking whether an operation can
+  // complete and hand the result to watch(), so a trigger in between is not missed.
+  std::vector<uint64_t> generations(std::span<const TopicPartition> keys);
+
+  // Park `on_complete` until a key is triggered past `seen` or `deadline` passes. It runs on the
+  // triggering thread or the expiration thread, or right away if a key has already moved on.
+  void watch(std::span<const TopicPartition> keys, std::span<const uint64_t> seen,
+             Clock::time_point deadline, std::function<void()> on_complete);
+
+  // Complete every operation waiting on `key`
+  void trigger(const TopicPartition &key);
+
+  // Stop the expiration thread. Operations still parked are dropped without completing.
+  void stop();
+
+  [[nodiscard]] size_t parked() const { return parked_.load(std::memory_order_relaxed); }
+
+private:
+  struct Operation {
+    std::atomic<bool> claimed {false};
+    std::function<void()> complete;
+  };
+
+  struct Watchers {
+    uint64_t generation {0};
+    std::vector<std::weak_ptr<Operation>> operations;
+  };
+
+  // Run `operation` unless it already completed
+  void complete(const std::shared_ptr<Operation> &operation);
+
+  void expireOperations();
+
+  std::mutex mutex_;
+  std::condition_variable wake_;
+  std::unordered_map<TopicPartition, Watchers, TopicPartitionHash> watchers_;
+  TimingWheel<std::shared_ptr<Operation>> wheel_;
+  bool stopped_ {false};
+  std::atomic<size_t> parked_ {0};
+  std::thread reaper_;
+};
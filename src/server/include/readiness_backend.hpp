@@ -0,0 +1,40 @@
+#pragma once
+
+#include "event_loop.hpp"
+#include "io_backend.hpp"
+#include <coroutine>
+#include <functional>
+#include <memory>
+#include <unordered_map>
+
+// IoBackend over the edge-triggered EventLoop. read() and write() try the socket first and only
+// suspend when it would block; the next readiness edge resumes them.
+class ReadinessBackend : public IoBackend {
+public:
+  ReadinessBackend() = default;
+  ~ReadinessBackend() override;
+
+  void run() override { loop_.run(); }
+  void stop() override { loop_.stop(); }
+  void post(InlineFunction task) override;
+  [[nodiscard]] const char *name() const override;
+
+  void listen(SocketFd &socket, std::function<void(SocketFd)> on_accept) override;
+  void attach(Connection &connection) override;
+  void detach(Connection &connection) override;
+  Task<bool> read(Connection &connection) override;
+  Task<bool> write(Connection &connection) override;
+
+private:
+  // Coroutines waiting for the next readiness edge on one socket
+  struct Waiters {
+    std::coroutine_handle<> reader;
+    std::coroutine_handle<> writer;
+  };
+
+  // Accept on `socket` until it runs dry, or pause for ACCEPT_BACKOFF once out of resources
+  void watchListener(SocketFd &socket, std::shared_ptr<std::function<void(SocketFd)>> on_accept);
+
+  EventLoop loop_;
+  std::unordered_map<int, std::shared_ptr<Waiters>> waiters_;
+};
@@ -0,0 +1,99 @@
+#pragma once
+
+#include "../../metrics/include/registry.hpp"
+#include "../../storage/include/storage_service.hpp"
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <span>
+#include <string>
+
+// What the server records for each API it serves. Send time is the write of the whole batch of
+// responses the request's response went out in, so pipelined requests share it.
+struct ApiMetrics {
+  metrics::Counter &requests;
+  metrics::Counter &request_bytes;
+  metrics::Counter &response_bytes;
+  metrics::LatencyHistogram &parse;
+  metrics::LatencyHistogram &handle;
+  metrics::LatencyHistogram &send;
+};
+
+// The server's series in `registry`, created once so the request path only looks them up
+class ServerMetrics {
+public:
+  ServerMetrics(metrics::Registry &registry, std::span<const int16_t> api_keys);
+
+  // Series for `api_key`, or nullptr for an API the server does not serve
+  ApiMetrics *api(int16_t api_key) {
+    auto found = apis_.find(api_key);
+    return found == apis_.end() ? nullptr : &found->second;
+  }
+
+  // Frames that failed to parse, which never reach an API
+  metrics::Counter &parseErrors() { return parse_errors_; }
+
+private:
+  std::map<int16_t, ApiMetrics> apis_;
+  metrics::Counter &parse_errors_;
+};
+
+// Storage service that times every call into the one it wraps, by call name, and counts the
+// calls that failed
+class InstrumentedStorageService : public storage::IStorageService {
+public:
+  InstrumentedStorageService(std::unique_ptr<storage::IStorageService> inner,
+                             metrics::Registry &registry);
+
+  std::expected<std::shared_ptr<const storage::ClusterSnapshot>, storage::StorageError>
+  loadClusterSnapshot() override;
+
+  const storage::TopicInfo *findTopicByName(const storage::ClusterSnapshot &snapshot,
+                                            std::string_view name) const override {
+    return inner_->findTopicByName(snapshot, name);
+  }
+
+  const storage::TopicInfo *findTopicById(const storage::ClusterSnapshot &snapshot,
+                                          storage::TopicId id) const override {
+    return inner_->findTopicById(snapshot, id);
+  }
+
+  std::expected<storage::PartitionData, storage::StorageError>
+  readPartitionData(const std::string &topic_name, int32_t partition_id) override;
+
+  // Timed until the records are acknowledged
+  void appendRecords(const std::string &topic_name, int32_t partition_id,
+                     std::vector<uint8_t> records, AppendCallback done) override;
+
+  void stop() override { inner_->stop(); }
+
+  std::expected<storage::PartitionRange, storage::StorageError>
+  readPartitionRange(const std::string &topic_name, int32_t partition_id, int64_t fetch_offset,
+                     uint64_t max_bytes) override;
+
+private:
+  struct Call {
+    metrics::LatencyHistogram &latency;
+    metrics::Counter &errors;
+  };
+
+  static Call call(metrics::Registry &registry, const std::string &name);
+
+  // Time `f`, counting an error when its result holds one
+  template <typename F> auto timed(Call &call, F &&f) {
+    auto result = [&] {
+      metrics::ScopedTimer timer(call.latency);
+      return f();
+    }();
+    if (!result) {
+      call.errors.add();
+    }
+    return result;
+  }
+
+  std::unique_ptr<storage::IStorageService> inner_;
+  Call load_cluster_snapshot_;
+  Call read_partition_data_;
+  Call append_records_;
+  Call read_partition_range_;
+};
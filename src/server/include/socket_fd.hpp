@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cerrno>
+#include <fcntl.h>
 #include <netinet/in.h>
 #include <sys/socket.h>
 #include <system_error>
@@ -80,6 +81,34 @@ public:
     return SocketFd(client_fd);
   }
 
+  // Accept with the returned socket already non-blocking and close-on-exec. An invalid SocketFd
+  // with errno == EAGAIN/EWOULDBLOCK means the accept queue is drained.
+  SocketFd acceptNonBlocking(struct sockaddr_in &client_addr, socklen_t &len) {
+#if defined(__linux__)
+    int client_fd = ::accept4(fd_, reinterpret_cast<struct sockaddr *>(&client_addr), &len,
+                              SOCK_NONBLOCK | SOCK_CLOEXEC);
+    if (client_fd < 0) {
+      return SocketFd {};
+    }
+    return SocketFd(client_fd);
+#else
+    SocketFd client = accept(client_addr, len);
+    if (client.valid()) {
+      client.setNonBlocking();
+      fcntl(client.get(), F_SETFD, FD_CLOEXEC);
+    }
+    return client;
+#endif
+  }
+
+  void setNonBlocking() {
+    int flags = fcntl(fd_, F_GETFL, 0);
+    if (flags < 0 || fcntl(fd_, F_SETFL, flags | O_NONBLOCK) < 0) {
+      close();
+      throw std::system_error(errno, std::generic_category(), "Failed to set non-blocking mode");
+    }
+  }
+
   void setSendTimeout(int seconds) {
     struct timeval tv;
     tv.tv_sec = seconds;
@@ -0,0 +1,133 @@
+#pragma once
+
+#include <coroutine>
+#include <exception>
+#include <utility>
+#include <variant>
+
+template <typename T = void> class Task;
+
+namespace detail {
+
+template <typename T> struct TaskPromiseBase {
+  std::coroutine_handle<> continuation;
+  std::exception_ptr exception;
+
+  std::suspend_always initial_suspend() noexcept { return {}; }
+
+  // Hand control straight to whoever awaited us, so chains of tasks do not grow the stack
+  struct FinalAwaiter {
+    bool await_ready() noexcept { return false; }
+    template <typename Promise>
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> self) noexcept {
+      auto continuation = self.promise().continuation;
+      return continuation ? continuation : std::noop_coroutine();
+    }
+    void await_resume() noexcept {}
+  };
+  FinalAwaiter final_suspend() noexcept { return {}; }
+
+  void unhandled_exception() { exception = std::current_exception(); }
+};
+
+template <typename T> struct TaskPromise : TaskPromiseBase<T> {
+  std::variant<std::monostate, T> value;
+
+  Task<T> get_return_object();
+  template <typename U> void return_value(U &&result) {
+    value.template emplace<1>(std::forward<U>(result));
+  }
+
+  T result() {
+    if (this->exception) {
+      std::rethrow_exception(this->exception);
+    }
+    return std::move(std::get<1>(value));
+  }
+};
+
+template <> struct TaskPromise<void> : TaskPromiseBase<void> {
+  Task<void> get_return_object();
+  void return_void() {}
+
+  void result() {
+    if (exception) {
+      std::rethrow_exception(exception);
+    }
+  }
+};
+
+} // namespace detail
+
+// Lazily started coroutine. Nothing runs until the task is awaited; the awaiting coroutine is
+// resumed when it finishes, on whatever thread it finished on. Exceptions propagate to the
+// awaiter. A task that is destroyed unfinished destroys its suspended frame.
+template <typename T> class [[nodiscard]] Task {
+public:
+  using promise_type = detail::TaskPromise<T>;
+  using Handle = std::coroutine_handle<promise_type>;
+
+  Task() noexcept = default;
+  explicit Task(Handle handle) noexcept : handle_(handle) {}
+  Task(Task &&other) noexcept : handle_(std::exchange(other.handle_, {})) {}
+  Task &operator=(Task &&other) noexcept {
+    if (this != &other) {
+      if (handle_) {
+        handle_.destroy();
+      }
+      handle_ = std::exchange(other.handle_, {});
+    }
+    return *this;
+  }
+  Task(const Task &) = delete;
+  Task &operator=(const Task &) = delete;
+
+  ~Task() {
+    if (handle_) {
+      handle_.destroy();
+    }
+  }
+
+  auto operator co_await() && noexcept {
+    struct Awaiter {
+      Handle handle;
+      bool await_ready() const noexcept { return !handle || handle.done(); }
+      std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+        handle.promise().continuation = awaiting;
+        return handle;
+      }
+      T await_resume() { return handle.promise().result(); }
+    };
+    return Awaiter {handle_};
+  }
+
+  [[nodiscard]] bool done() const { return handle_ && handle_.done(); }
+
+private:
+  Handle handle_;
+};
+
+namespace detail {
+template <typename T> Task<T> TaskPromise<T>::get_return_object() {
+  return Task<T> {std::coroutine_handle<TaskPromise<T>>::from_promise(*this)};
+}
+inline Task<void> TaskPromise<void>::get_return_object() {
+  return Task<void> {std::coroutine_handle<TaskPromise<void>>::from_promise(*this)};
+}
+} // namespace detail
+
+// Coroutine that starts when resumed and frees itself when it finishes; the building block for
+// running a Task without awaiting it
+struct DetachedTask {
+  struct promise_type {
+    DetachedTask get_return_object() {
+      return {std::coroutine_handle<promise_type>::from_promise(*this)};
+    }
+    std::suspend_always initial_suspend() noexcept { return {}; }
+    std::suspend_never final_suspend() noexcept { return {}; }
+    void return_void() {}
+    void unhandled_exception() { std::terminate(); }
+  };
+
+  std::coroutine_handle<promise_type> handle;
+};
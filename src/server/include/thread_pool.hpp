@@ -1,21 +1,94 @@
 #pragma once
-#include <condition_variable>
-#include <functional>
+#include "inline_function.hpp"
+#include "mpmc_queue.hpp"
+#include "work_stealing_deque.hpp"
+#include <atomic>
+#include <coroutine>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <future>
+#include <memory>
 #include <mutex>
-#include <queue>
+#include <optional>
 #include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
+// Work-stealing pool. Tasks enqueued from a worker go on that worker's own deque; tasks from
+// other threads go through a shared lock-free queue. Idle workers steal from each other before
+// parking on a futex (std::atomic::wait), and enqueue only wakes a worker when one is parked.
 class ThreadPool {
 public:
   explicit ThreadPool(size_t threads);
+
+  // Runs everything still queued, then joins the workers
   ~ThreadPool();
 
-  void enqueue(std::function<void()> task);
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+
+  void enqueue(InlineFunction task);
+
+  // Run `f` on the pool; the future holds its result or exception
+  template <typename F> auto submit(F &&f) -> std::future<std::invoke_result_t<std::decay_t<F> &>> {
+    using Result = std::invoke_result_t<std::decay_t<F> &>;
+    std::promise<Result> promise;
+    auto result = promise.get_future();
+    enqueue([promise = std::move(promise), f = std::forward<F>(f)]() mutable {
+      try {
+        if constexpr (std::is_void_v<Result>) {
+          f();
+          promise.set_value();
+        } else {
+          promise.set_value(f());
+        }
+      } catch (...) {
+        promise.set_exception(std::current_exception());
+      }
+    });
+    return result;
+  }
+
+  // co_await schedule() to continue on a worker
+  auto schedule() {
+    struct Awaiter {
+      ThreadPool &pool;
+      bool await_ready() const noexcept { return false; }
+      void await_suspend(std::coroutine_handle<> handle) {
+        pool.enqueue([handle] { handle.resume(); });
+      }
+      void await_resume() const noexcept {}
+    };
+    return Awaiter {*this};
+  }
+
+  [[nodiscard]] size_t size() const { return workers.size(); }
 
 private:
-  std::vector<std::thread> workers;
-  std::queue<std::function<void()>> tasks;
-  std::mutex queue_mutex;
-  std::condition_variable condition;
-  bool stop;
+  struct Worker {
+    WorkStealingDeque<InlineFunction> tasks;
+    std::thread thread;
+  };
+
+  void run(size_t index);
+
+  // Own deque first (newest first), then the shared queue, then the other workers' deques
+  std::optional<InlineFunction> next(size_t index);
+
+  void park();
+
+  std::vector<std::unique_ptr<Worker>> workers;
+  MpmcQueue<InlineFunction> injected;
+
+  // Tasks that found the shared queue full
+  std::mutex overflow_mutex;
+  std::deque<InlineFunction> overflow;
+  std::atomic<size_t> overflowed {0};
+
+  std::atomic<size_t> queued {0}; // enqueued and not yet taken by a worker
+  std::atomic<uint32_t> sleepers {0};
+  std::atomic<uint32_t> wake_epoch {0};
+  std::atomic<bool> stop {false};
 };
@@ -0,0 +1,133 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <utility>
+#include <vector>
+
+// Hierarchical timing wheel: LEVELS wheels of SLOTS buckets, each level's bucket spanning a full
+// turn of the level below. Scheduling and expiring are O(1) per entry; an entry moves down at
+// most LEVELS - 1 times on its way to level 0. Deadlines are rounded up to whole ticks.
+// Not thread-safe.
+template <typename T> class TimingWheel {
+public:
+  using Clock = std::chrono::steady_clock;
+
+  static constexpr unsigned SLOT_BITS = 6;
+  static constexpr uint64_t SLOTS = uint64_t {1} << SLOT_BITS;
+  static constexpr unsigned LEVELS = 4;
+  static constexpr uint64_t SPAN = uint64_t {1} << (SLOT_BITS * LEVELS); // ticks covered
+
+  explicit TimingWheel(Clock::duration tick, Clock::time_point start = Clock::now())
+      : tick_(tick), start_(start) {}
+
+  void schedule(Clock::time_point deadline, T value) {
+    size_++;
+    uint64_t expiry = tickOf(deadline);
+    if (expiry <= current_) {
+      due_.push_back(std::move(value));
+      return;
+    }
+    place({expiry, std::move(value)});
+  }
+
+  // Everything whose deadline is at or before `now`
+  std::vector<T> advance(Clock::time_point now) {
+    std::vector<T> expired = std::move(due_);
+    due_.clear();
+    size_ -= expired.size();
+
+    uint64_t target = now > start_ ? static_cast<uint64_t>((now - start_) / tick_) : 0;
+    while (current_ < target) {
+      if (size_ == 0) {
+        current_ = target;
+        break;
+      }
+      current_++;
+
+      // Bring down the buckets whose span starts at this tick, highest level first
+      unsigned top = 0;
+      while (top + 1 < LEVELS && (current_ & (levelSpan(top + 1) - 1)) == 0) {
+        top++;
+      }
+      for (unsigned level = top; level > 0; level--) {
+        auto entries = std::move(slots_[level][slotOf(current_, level)]);
+        slots_[level][slotOf(current_, level)].clear();
+        for (auto &entry : entries) {
+          place(std::move(entry));
+        }
+      }
+
+      auto &bucket = slots_[0][slotOf(current_, 0)];
+      for (auto &entry : bucket) {
+        expired.push_back(std::move(entry.value));
+      }
+      size_ -= bucket.size();
+      bucket.clear();
+    }
+    return expired;
+  }
+
+  // When advance() next has something to do: the first occupied level-0 bucket, or the next
+  // point where a higher level moves entries down
+  [[nodiscard]] std::optional<Clock::time_point> nextExpiry() const {
+    if (!due_.empty()) {
+      return start_ + static_cast<Clock::duration>(tick_ * current_);
+    }
+    if (size_ == 0) {
+      return std::nullopt;
+    }
+    uint64_t next = current_ + 1;
+    while (slots_[0][slotOf(next, 0)].empty() && (next & (SLOTS - 1)) != 0) {
+      next++;
+    }
+    return start_ + static_cast<Clock::duration>(tick_ * next);
+  }
+
+  [[nodiscard]] size_t size() const { return size_; }
+  [[nodiscard]] bool empty() const { return size_ == 0; }
+
+private:
+  struct Entry {
+    uint64_t expiry;
+    T value;
+  };
+
+  static constexpr uint64_t levelSpan(unsigned level) {
+    return uint64_t {1} << (SLOT_BITS * level);
+  }
+
+  static constexpr size_t slotOf(uint64_t tick, unsigned level) {
+    return static_cast<size_t>((tick >> (SLOT_BITS * level)) & (SLOTS - 1));
+  }
+
+  uint64_t tickOf(Clock::time_point deadline) const {
+    if (deadline <= start_) {
+      return 0;
+    }
+    auto elapsed = deadline - start_;
+    return static_cast<uint64_t>((elapsed + tick_ - Clock::duration {1}) / tick_);
+  }
+
+  // Put an entry on the lowest level whose turn still reaches it. Entries beyond the top
+  // level's reach wait in its farthest bucket and are placed again when that comes round.
+  void place(Entry entry) {
+    uint64_t position = std::min(entry.expiry, current_ + SPAN - 1);
+    uint64_t delta = position - current_;
+    unsigned level = 0;
+    while (level + 1 < LEVELS && delta >= levelSpan(level + 1)) {
+      level++;
+    }
+    slots_[level][slotOf(position, level)].push_back(std::move(entry));
+  }
+
+  Clock::duration tick_;
+  Clock::time_point start_;
+  uint64_t current_ {0};
+  size_t size_ {0};
+  std::vector<T> due_;
+  std::array<std::array<std::vector<Entry>, SLOTS>, LEVELS> slots_;
+};
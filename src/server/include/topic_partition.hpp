@@ -0,0 +1,18 @@
+#pragma once
+
+#include "../../storage/include/storage_types.hpp"
+#include <cstddef>
+#include <cstdint>
+
+struct TopicPartition {
+  storage::TopicId topic_id;
+  int32_t partition {0};
+
+  bool operator==(const TopicPartition &) const = default;
+};
+
+struct TopicPartitionHash {
+  size_t operator()(const TopicPartition &key) const {
+    return storage::TopicIdHash {}(key.topic_id) ^ static_cast<uint32_t>(key.partition);
+  }
+};
@@ -0,0 +1,113 @@
+#pragma once
+
+#include "io_backend.hpp"
+#include "io_uring.hpp"
+
+#if defined(KAFKA_HAVE_IO_URING)
+#include <atomic>
+#include <coroutine>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+// IoBackend on io_uring. Listening sockets use multishot accept. Every attached connection
+// keeps one multishot recv armed that lands in buffers the kernel picks from a registered
+// buffer ring, so input keeps arriving while requests are handled and an idle connection costs
+// no syscall of its own. Responses go out with sendmsg; log file ranges with sendfile(2), waiting
+// for POLLOUT through the ring when the socket is full. Everything queued in one loop iteration
+// is submitted with the same io_uring_enter that waits for the next completions.
+class UringBackend : public IoBackend {
+public:
+  static constexpr unsigned RING_ENTRIES = 1024;
+  static constexpr unsigned BUFFER_COUNT = 64; // power of two
+  static constexpr size_t BUFFER_SIZE = 16 * 1024;
+
+  UringBackend();
+  ~UringBackend() override;
+
+  void run() override;
+  void stop() override;
+  void post(InlineFunction task) override;
+  [[nodiscard]] const char *name() const override { return "io_uring"; }
+
+  void listen(SocketFd &socket, std::function<void(SocketFd)> on_accept) override;
+  void attach(Connection &connection) override;
+  void detach(Connection &connection) override;
+  Task<bool> read(Connection &connection) override;
+  Task<bool> write(Connection &connection) override;
+
+private:
+  // Something waiting for completions; each submission's user_data points at one
+  struct Operation {
+    virtual ~Operation() = default;
+    virtual void complete(int32_t result, uint32_t flags) = 0;
+  };
+
+  struct Acceptor;
+  struct Receiver;
+  struct Wakeup;
+
+  // One-shot operation that resumes the awaiting coroutine with its result
+  struct Completion : Operation {
+    std::coroutine_handle<> handle;
+    int32_t result {0};
+    void complete(int32_t res, uint32_t) override {
+      result = res;
+      handle.resume();
+    }
+  };
+
+  template <typename Prepare> struct Submit {
+    UringBackend &backend;
+    Prepare prepare;
+    Completion operation {};
+    bool await_ready() const noexcept { return false; }
+    void await_suspend(std::coroutine_handle<> handle) {
+      operation.handle = handle;
+      auto *sqe = backend.ring_.sqe();
+      prepare(sqe);
+      sqe->user_data = reinterpret_cast<uint64_t>(&operation);
+    }
+    int32_t await_resume() const noexcept { return operation.result; }
+  };
+
+  template <typename Prepare> Submit<Prepare> submit(Prepare prepare) {
+    return {*this, std::move(prepare)};
+  }
+
+  struct Mapping {
+    void *data {nullptr};
+    size_t size {0};
+    ~Mapping();
+  };
+
+  void armAccept(Acceptor &acceptor);
+  void armBackoff(Acceptor &acceptor); // armAccept() once ACCEPT_BACKOFF has passed
+  void armReceive(Receiver &receiver);
+  void armWakeup();
+  void cancel(Operation &operation);
+  void recycle(uint16_t buffer);
+  [[nodiscard]] const uint8_t *buffer(uint16_t id) const;
+  void runPosted();
+
+  // Declared before the ring so the kernel is done with them when they go
+  std::unique_ptr<uint8_t[]> buffers_;
+  Mapping buffer_ring_;
+  uint16_t buffer_tail_ {0};
+
+  IoUring ring_;
+
+  int wakeup_fd_ {-1};
+  std::unique_ptr<Wakeup> wakeup_;
+  std::mutex posted_mutex_;
+  std::vector<InlineFunction> posted_;
+  std::atomic<bool> stopped_ {false};
+
+  std::vector<std::unique_ptr<Acceptor>> acceptors_;
+  std::unordered_map<int, std::unique_ptr<Receiver>> receivers_;
+  std::vector<std::unique_ptr<Receiver>> retired_; // detached, waiting for their recv to end
+};
+
+#endif
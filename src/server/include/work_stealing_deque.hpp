@@ -0,0 +1,97 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <thread>
+
+// Bounded Chase-Lev deque. The owning thread pushes and pops at the bottom; any thread may steal
+// from the top. Values are moved out only after the index is claimed, so T need not be
+// trivially copyable; each slot carries a flag that keeps the owner from reusing it while a
+// thief is still moving out of it. The deque never grows: push() fails when it is full.
+template <typename T> class WorkStealingDeque {
+public:
+  explicit WorkStealingDeque(size_t capacity = 1024)
+      : mask_(std::bit_ceil(std::max<size_t>(capacity, 2)) - 1),
+        slots_(std::make_unique<Slot[]>(mask_ + 1)) {}
+
+  WorkStealingDeque(const WorkStealingDeque &) = delete;
+  WorkStealingDeque &operator=(const WorkStealingDeque &) = delete;
+
+  // Owner only
+  bool push(T &value) {
+    int64_t bottom = bottom_.load(std::memory_order_relaxed);
+    int64_t top = top_.load(std::memory_order_acquire);
+    if (bottom - top > static_cast<int64_t>(mask_)) {
+      return false;
+    }
+    auto &slot = slots_[static_cast<size_t>(bottom) & mask_];
+    while (slot.full.load(std::memory_order_acquire)) {
+      std::this_thread::yield(); // a thief that took this slot a lap ago is still moving out
+    }
+    slot.value = std::move(value);
+    slot.full.store(true, std::memory_order_release);
+    bottom_.store(bottom + 1, std::memory_order_seq_cst);
+    return true;
+  }
+
+  // Owner only: the most recently pushed value
+  std::optional<T> pop() {
+    int64_t bottom = bottom_.load(std::memory_order_relaxed) - 1;
+    bottom_.store(bottom, std::memory_order_seq_cst);
+    int64_t top = top_.load(std::memory_order_seq_cst);
+    if (top > bottom) {
+      bottom_.store(bottom + 1, std::memory_order_relaxed);
+      return std::nullopt;
+    }
+    if (top == bottom) {
+      // Last value: race the thieves for it
+      bool won = top_.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst);
+      bottom_.store(bottom + 1, std::memory_order_relaxed);
+      if (!won) {
+        return std::nullopt;
+      }
+    }
+    return take(slots_[static_cast<size_t>(bottom) & mask_]);
+  }
+
+  // Any thread: the oldest value
+  std::optional<T> steal() {
+    int64_t top = top_.load(std::memory_order_seq_cst);
+    int64_t bottom = bottom_.load(std::memory_order_seq_cst);
+    if (top >= bottom ||
+        !top_.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst)) {
+      return std::nullopt;
+    }
+    return take(slots_[static_cast<size_t>(top) & mask_]);
+  }
+
+  [[nodiscard]] bool empty() const {
+    return top_.load(std::memory_order_seq_cst) >= bottom_.load(std::memory_order_seq_cst);
+  }
+
+  [[nodiscard]] size_t capacity() const { return mask_ + 1; }
+
+private:
+  struct Slot {
+    T value {};
+    std::atomic<bool> full {false};
+  };
+
+  static T take(Slot &slot) {
+    T value = std::move(slot.value);
+    slot.value = T {};
+    slot.full.store(false, std::memory_order_release);
+    return value;
+  }
+
+  // Indexes grow without wrapping; a slot is index & mask_
+  alignas(64) std::atomic<int64_t> top_ {0};
+  alignas(64) std::atomic<int64_t> bottom_ {0};
+  const size_t mask_;
+  std::unique_ptr<Slot[]> slots_;
+};
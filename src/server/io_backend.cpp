@@ -0,0 +1,51 @@
+#include "include/io_backend.hpp"
+#include "include/io_uring.hpp"
+#include "include/readiness_backend.hpp"
+#include "include/uring_backend.hpp"
+#include <cerrno>
+#include <iostream>
+#include <system_error>
+#include <utility>
+
+std::unique_ptr<IoBackend> IoBackend::create(Kind kind) {
+#if defined(KAFKA_HAVE_IO_URING)
+  if (kind != Kind::Readiness) {
+    try {
+      return std::make_unique<UringBackend>();
+    } catch (const std::system_error &e) {
+      if (kind == Kind::IoUring) {
+        throw;
+      }
+      // Commonly a seccomp profile or an old kernel; serve with readiness instead
+      std::cerr << "io_uring unavailable (" << e.what() << "), using epoll" << std::endl;
+    }
+  }
+#else
+  if (kind == Kind::IoUring) {
+    throw std::system_error(ENOSYS, std::generic_category(), "Built without io_uring support");
+  }
+#endif
+  return std::make_unique<ReadinessBackend>();
+}
+
+IoBackend::~IoBackend() { destroyTasks(); }
+
+void IoBackend::spawn(Task<> task) {
+  uint64_t id = next_task_id_++;
+  auto detached = runDetached(std::move(task), this, id);
+  tasks_.emplace(id, detached.handle);
+  detached.handle.resume();
+}
+
+void IoBackend::destroyTasks() {
+  // A destroyed frame never reaches the erase at the end of runDetached
+  auto tasks = std::exchange(tasks_, {});
+  for (auto &[id, handle] : tasks) {
+    handle.destroy();
+  }
+}
+
+DetachedTask IoBackend::runDetached(Task<> task, IoBackend *backend, uint64_t id) {
+  co_await std::move(task);
+  backend->tasks_.erase(id);
+}
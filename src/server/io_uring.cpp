@@ -0,0 +1,160 @@
+#include "include/io_uring.hpp"
+
+#if defined(KAFKA_HAVE_IO_URING)
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <system_error>
+#include <unistd.h>
+
+namespace {
+int setup(unsigned entries, io_uring_params &params) {
+  return static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+}
+
+void *mapRing(int fd, size_t size, uint64_t offset) {
+  void *ring = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd,
+                    static_cast<off_t>(offset));
+  return ring == MAP_FAILED ? nullptr : ring;
+}
+} // namespace
+
+IoUring::IoUring(unsigned entries) {
+  io_uring_params params {};
+  // Completion work runs when we next enter the kernel instead of interrupting us
+  params.flags = IORING_SETUP_CLAMP | IORING_SETUP_SUBMIT_ALL | IORING_SETUP_COOP_TASKRUN;
+  fd_ = setup(entries, params);
+  if (fd_ < 0 && errno == EINVAL) {
+    params = {};
+    params.flags = IORING_SETUP_CLAMP;
+    fd_ = setup(entries, params);
+  }
+  if (fd_ < 0) {
+    throw std::system_error(errno, std::generic_category(), "Failed to set up io_uring");
+  }
+  if (!(params.features & IORING_FEAT_SINGLE_MMAP) || !(params.features & IORING_FEAT_NODROP)) {
+    ::close(fd_);
+    throw std::system_error(ENOSYS, std::generic_category(), "io_uring is too old");
+  }
+
+  sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+  cq_ring_size_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+  sq_ring_size_ = cq_ring_size_ = std::max(sq_ring_size_, cq_ring_size_);
+  sq_ring_ = cq_ring_ = mapRing(fd_, sq_ring_size_, IORING_OFF_SQ_RING);
+  sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+  sqes_ = static_cast<io_uring_sqe *>(mapRing(fd_, sqes_size_, IORING_OFF_SQES));
+  if (!sq_ring_ || !sqes_) {
+    int error = errno;
+    release();
+    throw std::system_error(error, std::generic_category(), "Failed to map io_uring");
+  }
+
+  auto *sq = static_cast<uint8_t *>(sq_ring_);
+  sq_head_ = reinterpret_cast<unsigned *>(sq + params.sq_off.head);
+  sq_tail_ = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+  sq_mask_ = *reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+  sq_entries_ = params.sq_entries;
+  sq_local_tail_ = sq_submitted_ = *sq_tail_;
+
+  // Entry i always sits in slot i, so the indirection array is filled once
+  auto *array = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+  for (unsigned i = 0; i < sq_entries_; i++) {
+    array[i] = i;
+  }
+
+  auto *cq = static_cast<uint8_t *>(cq_ring_);
+  cq_head_ = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+  cq_tail_ = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+  cq_mask_ = reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+  cqes_ = reinterpret_cast<io_uring_cqe *>(cq + params.cq_off.cqes);
+}
+
+IoUring::~IoUring() { release(); }
+
+void IoUring::release() {
+  if (sqes_) {
+    munmap(sqes_, sqes_size_);
+    sqes_ = nullptr;
+  }
+  if (sq_ring_) {
+    munmap(sq_ring_, sq_ring_size_);
+    sq_ring_ = cq_ring_ = nullptr;
+  }
+  if (fd_ >= 0) {
+    ::close(fd_);
+    fd_ = -1;
+  }
+}
+
+io_uring_sqe *IoUring::sqe() {
+  // Parked entries go first, so entries reach the kernel in the order they were taken
+  if (parked_.empty() && full()) {
+    submit();
+  }
+  if (!parked_.empty() || full()) {
+    auto &entry = parked_.emplace_back();
+    std::memset(&entry, 0, sizeof(entry));
+    return &entry;
+  }
+  auto *entry = &sqes_[sq_local_tail_ & sq_mask_];
+  std::memset(entry, 0, sizeof(*entry));
+  sq_local_tail_++;
+  return entry;
+}
+
+bool IoUring::full() const {
+  return sq_local_tail_ - __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE) >= sq_entries_;
+}
+
+void IoUring::unpark() {
+  while (!parked_.empty() && !full()) {
+    sqes_[sq_local_tail_ & sq_mask_] = parked_.front();
+    parked_.pop_front();
+    sq_local_tail_++;
+  }
+}
+
+void IoUring::submit(unsigned wait) {
+  while (true) {
+    unpark();
+    __atomic_store_n(sq_tail_, sq_local_tail_, __ATOMIC_RELEASE);
+    unsigned pending = sq_local_tail_ - sq_submitted_;
+    int rc = enter(pending, wait, wait > 0 ? IORING_ENTER_GETEVENTS : 0);
+    if (rc >= 0) {
+      sq_submitted_ += static_cast<unsigned>(rc);
+      if ((sq_submitted_ == sq_local_tail_ && parked_.empty()) || wait > 0) {
+        return;
+      }
+      continue;
+    }
+    if (errno == EINTR) {
+      if (wait > 0) {
+        return; // the caller reaps whatever is there and comes back
+      }
+      continue;
+    }
+    if (errno == EBUSY || errno == EAGAIN) {
+      return; // completions must be reaped before more can be submitted
+    }
+    throw std::system_error(errno, std::generic_category(), "io_uring_enter failed");
+  }
+}
+
+void IoUring::registerBufferRing(io_uring_buf_ring *ring, unsigned entries, uint16_t group) {
+  io_uring_buf_reg reg {};
+  reg.ring_addr = reinterpret_cast<uint64_t>(ring);
+  reg.ring_entries = entries;
+  reg.bgid = group;
+  if (syscall(__NR_io_uring_register, fd_, IORING_REGISTER_PBUF_RING, &reg, 1) != 0) {
+    throw std::system_error(errno, std::generic_category(), "Failed to register buffer ring");
+  }
+}
+
+int IoUring::enter(unsigned submit, unsigned wait, unsigned flags) {
+  return static_cast<int>(
+      syscall(__NR_io_uring_enter, fd_, submit, wait, flags, nullptr, size_t {0}));
+}
+
+#endif
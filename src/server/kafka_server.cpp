@@ -1,11 +1,20 @@
 #include "include/kafka_server.hpp"
 #include "../../protocol/api_versions/include/api_versions_response.hpp"
+#include "../../protocol/base/include/api_keys.hpp"
 #include "../../protocol/describe_topic_partitions/include/describe_topic_partitions_response.hpp"
 #include "../../protocol/fetch/include/fetch_response.hpp"
 #include "../../protocol/parser/include/kafka_parser.hpp"
+#include "../../protocol/produce/include/produce_response.hpp"
+#include "../../storage/include/io/file_handle.hpp"
 #include "../../storage/include/storage_service.hpp"
+#include "trace.hpp"
+#include <algorithm>
+#include <arpa/inet.h>
+#include <array>
+#include <cerrno>
 #include <cstring>
 #include <iostream>
+#include <memory_resource>
 #include <ostream>
 #include <string>
 #include <sys/socket.h>
@@ -15,22 +24,18 @@ std::ostream &operator<<(std::ostream &os, const uint128_t &value) {
             << static_cast<uint64_t>(value);
 }
 
-KafkaServer::KafkaServer(uint16_t port)
-    : port(port), thread_pool(std::thread::hardware_concurrency()),
-      storage_(storage::createStorageService("/tmp/kraft-combined-logs")) {
-  server_socket_ = SocketFd::create();
-  server_socket_.setReuseAddr();
-
-  server_addr = {};
-  server_addr.sin_family = AF_INET;
-  server_addr.sin_addr.s_addr = INADDR_ANY;
-  server_addr.sin_port = htons(port);
+namespace {
+size_t defaultThreadCount() { return std::max(1u, std::thread::hardware_concurrency()); }
+} // namespace
 
-  registerHandlers();
-}
+KafkaServer::KafkaServer(uint16_t port, storage::FsyncPolicy fsync_policy)
+    : KafkaServer(port, storage::createStorageService("/tmp/kraft-combined-logs", fsync_policy)) {}
 
-KafkaServer::KafkaServer(uint16_t port, std::unique_ptr<storage::IStorageService> storage)
-    : port(port), thread_pool(std::thread::hardware_concurrency()), storage_(std::move(storage)) {
+KafkaServer::KafkaServer(uint16_t port, std::unique_ptr<storage::IStorageService> storage,
+                         IoBackend::Kind io)
+    : port(port), storage_(std::make_unique<InstrumentedStorageService>(std::move(storage),
+                                                                        metrics_registry_)),
+      thread_pool(defaultThreadCount()) {
   server_socket_ = SocketFd::create();
   server_socket_.setReuseAddr();
 
@@ -39,160 +44,502 @@ KafkaServer::KafkaServer(uint16_t port, std::unique_ptr<storage::IStorageService
   server_addr.sin_addr.s_addr = INADDR_ANY;
   server_addr.sin_port = htons(port);
 
+  accept_io_ = IoBackend::create(io);
+  for (size_t i = 0; i < defaultThreadCount(); i++) {
+    io_loops_.push_back(IoBackend::create(io));
+  }
+
   registerHandlers();
 }
 
+KafkaServer::~KafkaServer() {
+  stop();
+  for (auto &t : io_threads_) {
+    if (t.joinable())
+      t.join();
+  }
+  // Parked fetches and acknowledged produces resume on the thread pool; stop both before it
+  // goes away. Storage outlives the pool, so its writer is drained here, not in its destructor.
+  fetch_purgatory_.stop();
+  storage_->stop();
+}
+
 void KafkaServer::registerHandlers() {
   namespace KP = KafkaProtocol;
-  apiHandlers[KP::API_VERSIONS] = [this](const KafkaRequestVariant &v, char *response,
-                                         int &offset) {
-    handleApiVersions(std::get<ApiVersionRequest>(v), response, offset);
+  apiHandlers[KP::API_VERSIONS] = [this](const KafkaRequestVariant &v,
+                                         ResponseBuffer &response) -> Task<> {
+    handleApiVersions(std::get<ApiVersionRequest>(v), response);
+    co_return;
   };
 
-  apiHandlers[KP::DESCRIBE_TOPIC_PARTITIONS] = [this](const KafkaRequestVariant &v, char *response,
-                                                      int &offset) {
-    handleDescribeTopicPartitions(std::get<DescribeTopicsRequest>(v), response, offset);
+  apiHandlers[KP::DESCRIBE_TOPIC_PARTITIONS] = [this](const KafkaRequestVariant &v,
+                                                      ResponseBuffer &response) -> Task<> {
+    handleDescribeTopicPartitions(std::get<DescribeTopicsRequest>(v), response);
+    co_return;
   };
 
-  apiHandlers[KP::FETCH] = [this](const KafkaRequestVariant &v, char *response, int &offset) {
-    handleFetch(std::get<FetchRequest>(v), response, offset);
+  apiHandlers[KP::FETCH] = [this](const KafkaRequestVariant &v, ResponseBuffer &response) {
+    return handleFetch(std::get<FetchRequest>(v), response);
   };
+
+  apiHandlers[KP::PRODUCE] = [this](const KafkaRequestVariant &v, ResponseBuffer &response) {
+    return handleProduce(std::get<ProduceRequest>(v), response);
+  };
+
+  std::vector<int16_t> keys;
+  for (const auto &[key, handler] : apiHandlers) {
+    keys.push_back(key);
+  }
+  metrics_ = std::make_unique<ServerMetrics>(metrics_registry_, keys);
 }
 
 void KafkaServer::start() {
   server_socket_.bind(server_addr);
-  server_socket_.listen(5);
+  server_socket_.listen(SOMAXCONN);
+  server_socket_.setNonBlocking();
 
-  while (true) {
-    struct sockaddr_in client_addr {};
-    socklen_t client_addr_len = sizeof(client_addr);
+  std::cerr << "Serving connections with " << accept_io_->name() << std::endl;
+  for (auto &loop : io_loops_) {
+    io_threads_.emplace_back([&loop] { loop->run(); });
+  }
 
-    SocketFd client = server_socket_.accept(client_addr, client_addr_len);
+  accept_io_->listen(server_socket_, [this](SocketFd client) {
+    IoBackend &io = *io_loops_[next_loop_++ % io_loops_.size()];
+    auto connection = std::make_shared<Connection>(std::move(client));
+    io.post([this, &io, connection] { io.spawn(serveConnection(io, connection)); });
+  });
+  accept_io_->run();
+}
 
-    if (!client.valid()) {
-      std::cerr << "Accept failed" << std::endl;
-      continue;
-    }
+uint16_t KafkaServer::serveMetrics(uint16_t port) {
+  scrape_endpoint_ = std::make_unique<metrics::ScrapeEndpoint>(metrics_registry_, port);
+  scrape_endpoint_->route("/trace", "application/json", common::trace::chromeTraceJson);
+  std::cerr << "Serving metrics on port " << scrape_endpoint_->port() << std::endl;
+  return scrape_endpoint_->port();
+}
 
-    int client_fd = client.release();
-    thread_pool.enqueue([this, client_fd] { handleClient(client_fd); });
+void KafkaServer::stop() {
+  accept_io_->stop();
+  for (auto &loop : io_loops_) {
+    loop->stop();
   }
 }
 
-void KafkaServer::handleClient(int client_fd) {
-  SocketFd client(client_fd);
-  std::vector<uint8_t> buffer(BUFFER_SIZE);
-  char response[BUFFER_SIZE];
-
-  client.setSendTimeout(5);
-
+Task<> KafkaServer::serveConnection(IoBackend &io, ConnectionPtr connection) {
+  io.attach(*connection);
   while (true) {
-    ssize_t bytes_received = recv(client.get(), buffer.data(), buffer.size(), 0);
-    if (bytes_received <= 0) {
-      break;
+    if (!connection->hasRequest()) {
+      if (connection->invalidFrame()) {
+        std::cerr << "Invalid request size, closing connection" << std::endl;
+        break;
+      }
+      if (!co_await io.read(*connection)) {
+        break;
+      }
+      continue;
     }
 
+    // Every complete frame buffered so far is handled as one batch, in order
+    auto requests = connection->takeRequests();
+    ResponseBuffer responses;
+    std::vector<ApiMetrics *> handled;
+    bool valid = false;
+    co_await thread_pool.schedule();
     try {
-      int offset = 0;
-      auto request = Parser::parse(buffer.data(), bytes_received);
-      auto handler = apiHandlers.find(getApiKey(request));
-
-      if (handler != apiHandlers.end()) {
-        handler->second(request, response, offset);
+      valid = co_await handleRequests(std::move(requests), responses, handled);
+    } catch (const std::exception &e) {
+      std::cerr << "Request failed: " << e.what() << std::endl;
+    }
+    co_await io.schedule();
+
+    connection->queueResponse(std::move(responses));
+    auto send_started = std::chrono::steady_clock::now();
+    bool written;
+    {
+      common::trace::Span span("send");
+      written = co_await io.write(*connection);
+    }
+    auto send_time = std::chrono::steady_clock::now() - send_started;
+    for (auto *api : handled) {
+      api->send.record(send_time);
+    }
+    if (!written || !valid) {
+      break;
+    }
+  }
+  io.detach(*connection);
+  connection->close();
+}
 
-        if (send(client.get(), response, offset, 0) < 0) {
-          break;
-        }
-      }
+Task<bool> KafkaServer::handleRequests(std::vector<uint8_t> requests, ResponseBuffer &responses,
+                                       std::vector<ApiMetrics *> &handled) {
+  using Clock = std::chrono::steady_clock;
+  // Requests decode into this frame, which only exists while a batch is handled, so a request
+  // that fits allocates nothing while it is parsed and idle connections hold no arena
+  std::array<std::byte, 8192> arena_buffer;
+  std::pmr::monotonic_buffer_resource arena(arena_buffer.data(), arena_buffer.size());
+  size_t position = 0;
+  while (position < requests.size()) {
+    arena.release(); // the previous request is gone
+    const uint8_t *frame = requests.data() + position;
+    int32_t size;
+    std::memcpy(&size, frame, sizeof(size));
+    size_t frame_length = sizeof(int32_t) + ntohl(static_cast<uint32_t>(size));
+
+    auto parse_started = Clock::now();
+    KafkaRequestVariant parsed;
+    try {
+      common::trace::Span span("Parser::parse");
+      parsed = Parser::parse(frame, frame_length, &arena);
     } catch (const ParseError &e) {
       std::cerr << "Parse error: " << e.what() << std::endl;
-      break;
+      metrics_->parseErrors().add();
+      co_return false;
+    }
+    auto handler_started = Clock::now();
+
+    int16_t api_key = getApiKey(parsed);
+    auto handler = apiHandlers.find(api_key);
+    if (handler != apiHandlers.end()) {
+      size_t response_start = responses.size();
+      {
+        common::trace::Span span(KafkaProtocol::apiName(api_key));
+        co_await handler->second(parsed, responses);
+      }
+
+      ApiMetrics *api = metrics_->api(api_key);
+      api->requests.add();
+      api->request_bytes.add(frame_length);
+      api->response_bytes.add(responses.size() - response_start);
+      api->parse.record(handler_started - parse_started);
+      api->handle.record(Clock::now() - handler_started);
+      handled.push_back(api);
     }
+    position += frame_length;
   }
+  co_return true;
 }
 
-void KafkaServer::handleApiVersions(const ApiVersionRequest &request, char *response, int &offset) {
+void KafkaServer::FetchWait::await_suspend(std::coroutine_handle<> handle) {
+  // The callback may run before watch() returns, so nothing here is touched after it
+  auto &pool = server.thread_pool;
+  server.fetch_purgatory_.watch(keys, seen, deadline,
+                                [&pool, handle] { pool.enqueue([handle] { handle.resume(); }); });
+}
+
+void KafkaServer::acknowledge(ProduceAcks &acks) {
+  // Only the last one in touches `acks` afterwards: the handler may free it once that has run
+  if (acks.outstanding.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+    thread_pool.enqueue([handle = acks.handle] { handle.resume(); });
+  }
+}
+
+bool KafkaServer::ProduceWait::await_suspend(std::coroutine_handle<> handle) noexcept {
+  acks.handle = handle;
+  // Carry on without suspending if every acknowledgement is already in
+  return acks.outstanding.fetch_sub(1, std::memory_order_acq_rel) > 1;
+}
+
+void KafkaServer::handleApiVersions(const ApiVersionRequest &request, ResponseBuffer &response) {
+  namespace KPA = KafkaProtocol::ApiVersions;
   const auto &header = request.header;
 
-  ApiVersionsResponse writer(response);
-  writer.writeHeader(header.correlation_id, header.api_version)
-      .writeApiVersionSupport()
-      .writeDescribeTopicsSupport()
-      .writeFetchSupport()
-      .writeMetadata()
-      .complete();
+  ApiVersionsResponse body;
+  body.api_keys = {
+      {KafkaProtocol::API_VERSIONS, KPA::MIN_VERSION, KPA::MAX_VERSION},
+      {KafkaProtocol::DESCRIBE_TOPIC_PARTITIONS, KafkaProtocol::DescribeTopicPartitions::MIN_VERSION,
+       KafkaProtocol::DescribeTopicPartitions::MAX_VERSION},
+      {KafkaProtocol::FETCH, KafkaProtocol::Fetch::MIN_VERSION, KafkaProtocol::Fetch::MAX_VERSION},
+      {KafkaProtocol::PRODUCE, KafkaProtocol::Produce::MIN_VERSION,
+       KafkaProtocol::Produce::MAX_VERSION},
+  };
+
+  // A client that asked for a version we do not speak gets the error in a v0 response, which
+  // every client can read
+  int16_t version = header.api_version;
+  if (version < KPA::MIN_VERSION || version > KPA::MAX_VERSION) {
+    body.error_code = KPA::UNSUPPORTED_VERSION;
+    version = 0;
+  }
 
-  offset = writer.getOffset();
+  response.reserve(64);
+  KafkaProtocol::Codec::encodeResponse(response, header.correlation_id, version, body);
 }
 
 void KafkaServer::handleDescribeTopicPartitions(const DescribeTopicsRequest &request,
-                                                char *response, int &offset) {
+                                                ResponseBuffer &response) {
+  namespace KPD = KafkaProtocol::DescribeTopicPartitions;
   const auto &header = request.header;
 
   auto snapshot = storage_->loadClusterSnapshot();
   if (!snapshot) {
-    offset = 0;
     return;
   }
 
-  DescribeTopicPartitionsResponse writer(response);
-  writer.writeHeader(header.correlation_id, static_cast<int8_t>(request.topic_names.size()));
+  DescribeTopicPartitionsResponse body;
+  size_t estimate = 32; // About 32 bytes per topic before partitions
+  for (const auto &requested : request.topics) {
+    estimate += requested.name.size() + 32;
+    auto &topic = body.topics.emplace_back();
+    topic.name = requested.name;
+
+    auto topic_info = storage_->findTopicByName(**snapshot, requested.name);
+    if (!topic_info) {
+      topic.error_code = KPD::ERROR_UNKNOWN_TOPIC_OR_PARTITION;
+      topic.topic_authorized_operations = 0;
+      continue;
+    }
 
-  for (const auto &topic_name : request.topic_names) {
-    auto topic_info = storage_->findTopicByName(*snapshot, topic_name);
-    writer.writeTopic(topic_name, topic_info);
+    topic.topic_id = topic_info->topic_id.value;
+    topic.topic_authorized_operations = 0xdf8;
+    for (const auto &partition_info : topic_info->partitions) {
+      auto &partition = topic.partitions.emplace_back();
+      partition.partition_index = partition_info.partition_id;
+      partition.leader_id = 1;
+      partition.leader_epoch = 0;
+      partition.replica_nodes = {1};
+      partition.isr_nodes = {1};
+    }
   }
 
-  writer.complete();
-  offset = writer.getOffset();
+  response.reserve(estimate);
+  KafkaProtocol::Codec::encodeResponse(response, header.correlation_id, header.api_version, body);
 }
 
-void KafkaServer::handleFetch(const FetchRequest &request, char *response, int &offset) {
-  const auto &header = request.header;
-  int8_t topics_size = static_cast<int8_t>(request.topics.size());
+Task<> KafkaServer::handleFetch(const FetchRequest &request, ResponseBuffer &response) {
+  // Before v13 topics are named; sessions and reads work on topic ids, so look those up first
+  FetchRequest named;
+  const FetchRequest *fetch = &request;
+  if (request.header.api_version < 13) {
+    named = request;
+    resolveTopicIds(named);
+    fetch = &named;
+  }
+  auto plan = fetch_sessions_.resolve(*fetch);
+
+  std::vector<TopicPartition> watched;
+  for (const auto &topic : plan.topics) {
+    for (const auto &partition : topic.partitions) {
+      watched.push_back({storage::TopicId {topic.topic_id}, partition.partition});
+    }
+  }
 
-  FetchResponse writer(response);
-  writer.writeHeader(header.correlation_id).writeResponseData(0, 0, 0, topics_size + 1);
+  // Wait for min_bytes unless there is an error to report or the wait is over. Trigger counts
+  // are read before the logs so an append landing in between still wakes us.
+  auto deadline = Purgatory::Clock::now() + std::chrono::milliseconds(request.max_wait_ms);
+  FetchResult result;
+  while (true) {
+    auto seen = fetch_purgatory_.generations(watched);
+    result = readFetch(plan.topics, request.max_bytes);
+    if (request.max_wait_ms <= 0 || Purgatory::Clock::now() >= deadline ||
+        plan.error_code != 0 || result.has_error ||
+        result.bytes >= static_cast<uint64_t>(std::max(request.min_bytes, 0))) {
+      break;
+    }
+    co_await FetchWait {*this, watched, seen, deadline};
+  }
 
+  FetchResponse body;
+  if (plan.error_code != 0) {
+    body.error_code = plan.error_code;
+    KafkaProtocol::Codec::encodeResponse(response, request.header.correlation_id,
+                                         request.header.api_version, body);
+    co_return;
+  }
+
+  // An incremental session only hears about partitions that changed since its last response
+  std::vector<FetchSessionCache::SentPartition> sent;
+  for (size_t t = 0; t < result.topics.size(); t++) {
+    for (const auto &partition : result.topics[t]) {
+      sent.push_back({{storage::TopicId {plan.topics[t].topic_id}, partition.index},
+                      partition.error_code,
+                      partition.high_watermark,
+                      partition.last_stable_offset,
+                      partition.log_start_offset,
+                      !partition.records.empty()});
+    }
+  }
+  auto include = fetch_sessions_.recordSent(plan.session_id, plan.incremental, sent);
+
+  body.session_id = plan.session_id;
+  size_t next = 0;
+  for (size_t t = 0; t < result.topics.size(); t++) {
+    FetchResponse::FetchableTopicResponse topic;
+    topic.topic = result.topic_names[t].empty() ? plan.topics[t].topic : result.topic_names[t];
+    topic.topic_id = plan.topics[t].topic_id;
+    for (auto &partition : result.topics[t]) {
+      if (!include[next++]) {
+        continue;
+      }
+      auto &out = topic.partitions.emplace_back();
+      out.partition_index = partition.index;
+      out.error_code = partition.error_code;
+      out.high_watermark = partition.high_watermark;
+      out.last_stable_offset = partition.last_stable_offset;
+      out.log_start_offset = partition.log_start_offset;
+      out.records = std::move(partition.records);
+    }
+    if (!topic.partitions.empty()) {
+      body.responses.push_back(std::move(topic));
+    }
+  }
+
+  KafkaProtocol::Codec::encodeResponse(response, request.header.correlation_id,
+                                       request.header.api_version, body);
+}
+
+void KafkaServer::resolveTopicIds(FetchRequest &request) {
   auto snapshot = storage_->loadClusterSnapshot();
-  if (!snapshot) {
-    writer.complete();
-    offset = writer.getOffset();
-    return;
+  auto idOf = [&](std::string_view name) -> uint128_t {
+    const storage::TopicInfo *topic_info =
+        snapshot ? storage_->findTopicByName(**snapshot, name) : nullptr;
+    return topic_info ? topic_info->topic_id.value : 0;
+  };
+  for (auto &topic : request.topics) {
+    topic.topic_id = idOf(topic.topic);
   }
+  for (auto &topic : request.forgotten_topics_data) {
+    topic.topic_id = idOf(topic.topic);
+  }
+}
 
-  for (const auto &topic : request.topics) {
-    writer.writeTopicHeader(topic.topic_id, static_cast<int64_t>(topic.partitions.size()) + 1);
+KafkaServer::FetchResult KafkaServer::readFetch(std::span<const FetchTopic> topics,
+                                                int32_t max_bytes) {
+  namespace KPF = KafkaProtocol::Fetch;
+  FetchResult result;
+
+  auto snapshot = storage_->loadClusterSnapshot();
+  if (!snapshot) {
+    return result;
+  }
 
-    auto topic_info = storage_->findTopicById(*snapshot, storage::TopicId {topic.topic_id});
+  uint64_t remaining_bytes = static_cast<uint64_t>(std::max(max_bytes, 0));
+  bool sent_records = false;
+  for (const auto &topic : topics) {
+    auto &fetched = result.topics.emplace_back();
+    auto topic_info = storage_->findTopicById(**snapshot, storage::TopicId {topic.topic_id});
+    result.topic_names.push_back(topic_info ? topic_info->name : std::string());
 
     for (const auto &partition : topic.partitions) {
-      if (!topic_info) {
-        writer.writePartitionData(
-            partition.partition, KafkaProtocol::Fetch::ERROR_UNKNOWN_TOPIC_OR_PARTITION, 0, 0, 0,
-            std::vector<FetchResponse::AbortedTransaction> {}, 0, RecordBatches {});
+      auto &out = fetched.emplace_back();
+      out.index = partition.partition;
+      if (!topic_info || partition.partition < 0 ||
+          static_cast<size_t>(partition.partition) >= topic_info->partitions.size()) {
+        out.error_code = KPF::ERROR_UNKNOWN_TOPIC_OR_PARTITION;
+        result.has_error = true;
         continue;
       }
 
-      const auto &partitions = topic_info->partitions;
-      if (partition.partition < 0 ||
-          static_cast<size_t>(partition.partition) >= partitions.size()) {
-        writer.writePartitionData(
-            partition.partition, KafkaProtocol::Fetch::ERROR_UNKNOWN_TOPIC_OR_PARTITION, 0, 0, 0,
-            std::vector<FetchResponse::AbortedTransaction> {}, 0, RecordBatches {});
+      // Partitions share the request's max_bytes in request order
+      const auto &partition_info = topic_info->partitions[static_cast<size_t>(partition.partition)];
+      uint64_t limit = std::min<uint64_t>(
+          static_cast<uint64_t>(std::max(partition.partition_max_bytes, 0)), remaining_bytes);
+      auto range = storage_->readPartitionRange(topic_info->name, partition_info.partition_id,
+                                                partition.fetch_offset, limit);
+      if (!range) {
+        out.error_code = KPF::ERROR_OFFSET_OUT_OF_RANGE;
+        out.high_watermark = out.last_stable_offset = out.log_start_offset = -1;
+        result.has_error = true;
         continue;
       }
+      out.high_watermark = out.last_stable_offset = range->high_watermark;
+      out.log_start_offset = range->log_start_offset;
+
+      // Only the first partition with data may go over its limit, so the consumer can make
+      // progress past a batch larger than max_bytes
+      uint64_t range_bytes = 0;
+      for (const auto &region : range->regions) {
+        range_bytes += region.length;
+      }
+      if (limit > 0 && (range_bytes <= limit || !sent_records)) {
+        for (auto &region : range->regions) {
+          int fd = region.file->get();
+          out.records.emplace_back(ResponseBuffer::FileSegment {fd, region.offset, region.length,
+                                                                std::move(region.file)});
+        }
+        remaining_bytes -= std::min(range_bytes, remaining_bytes);
+        result.bytes += range_bytes;
+        sent_records = sent_records || range_bytes > 0;
+      }
+    }
+  }
+  return result;
+}
 
-      const auto &partition_info = partitions[static_cast<size_t>(partition.partition)];
-      auto partition_data =
-          storage_->readPartitionData(topic_info->name, partition_info.partition_id);
-      RecordBatches batches = partition_data ? std::move(*partition_data) : RecordBatches {};
+Task<> KafkaServer::handleProduce(const ProduceRequest &request, ResponseBuffer &response) {
+  namespace KPP = KafkaProtocol::Produce;
+  const auto &header = request.header;
+
+  // Where in the response each submitted append reports back to
+  struct Submitted {
+    size_t topic;
+    size_t partition;
+    TopicPartition key;
+  };
 
-      writer.writePartitionData(partition.partition, 0, 0, 0, 0,
-                                std::vector<FetchResponse::AbortedTransaction> {}, 0, batches);
+  ProduceResponse body;
+  size_t partitions = 0;
+  for (const auto &topic : request.topic_data) {
+    partitions += topic.partition_data.size();
+  }
+  ProduceAcks acks(partitions);
+  std::vector<Submitted> submitted;
+  submitted.reserve(partitions);
+
+  // Submit every partition before waiting, so the writer can group them into one round
+  auto snapshot = storage_->loadClusterSnapshot();
+  for (const auto &topic : request.topic_data) {
+    auto &topic_response = body.responses.emplace_back();
+    topic_response.name = topic.name;
+
+    const storage::TopicInfo *topic_info =
+        snapshot ? storage_->findTopicByName(**snapshot, topic.name) : nullptr;
+
+    for (const auto &partition : topic.partition_data) {
+      // base_offset and log_start_offset stay -1 when the append fails
+      auto &out = topic_response.partition_responses.emplace_back();
+      out.index = partition.index;
+      out.base_offset = -1;
+
+      if (!topic_info || partition.index < 0 ||
+          static_cast<size_t>(partition.index) >= topic_info->partitions.size()) {
+        out.error_code = KPP::ERROR_UNKNOWN_TOPIC_OR_PARTITION;
+        continue;
+      }
+
+      const auto &partition_info = topic_info->partitions[static_cast<size_t>(partition.index)];
+      size_t slot = submitted.size();
+      submitted.push_back({body.responses.size() - 1,
+                           topic_response.partition_responses.size() - 1,
+                           {topic_info->topic_id, partition.index}});
+      acks.outstanding.fetch_add(1, std::memory_order_relaxed);
+      storage_->appendRecords(topic_info->name, partition_info.partition_id, partition.records,
+                              [this, &acks, slot](auto result) {
+                                acks.results[slot] = std::move(result);
+                                acknowledge(acks);
+                              });
+    }
+  }
+  co_await ProduceWait {acks};
+
+  for (size_t slot = 0; slot < submitted.size(); slot++) {
+    auto &out =
+        body.responses[submitted[slot].topic].partition_responses[submitted[slot].partition];
+    const auto &result = acks.results[slot];
+    if (!result) {
+      out.error_code = result.error().code() == storage::ErrorCode::CorruptMessage
+                           ? KPP::ERROR_CORRUPT_MESSAGE
+                           : KPP::ERROR_KAFKA_STORAGE_ERROR;
+      continue;
     }
+    out.base_offset = result->base_offset;
+    out.log_start_offset = result->log_start_offset;
+    fetch_purgatory_.trigger(submitted[slot].key);
   }
 
-  writer.complete();
-  offset = writer.getOffset();
+  // acks=0 producers expect no response at all; the records are still appended
+  if (request.acks != 0) {
+    KafkaProtocol::Codec::encodeResponse(response, header.correlation_id, header.api_version,
+                                         body);
+  }
 }
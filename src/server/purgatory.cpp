@@ -0,0 +1,112 @@
+#include "include/purgatory.hpp"
+
+Purgatory::Purgatory(Clock::duration tick)
+    : wheel_(tick), reaper_([this] { expireOperations(); }) {}
+
+Purgatory::~Purgatory() { stop(); }
+
+std::vector<uint64_t> Purgatory::generations(std::span<const TopicPartition> keys) {
+  std::vector<uint64_t> seen;
+  seen.reserve(keys.size());
+  std::lock_guard lock(mutex_);
+  for (const auto &key : keys) {
+    auto it = watchers_.find(key);
+    seen.push_back(it == watchers_.end() ? 0 : it->second.generation);
+  }
+  return seen;
+}
+
+void Purgatory::watch(std::span<const TopicPartition> keys, std::span<const uint64_t> seen,
+                      Clock::time_point deadline, std::function<void()> on_complete) {
+  auto operation = std::make_shared<Operation>();
+  operation->complete = std::move(on_complete);
+
+  bool triggered = false;
+  {
+    std::lock_guard lock(mutex_);
+    if (stopped_) {
+      return;
+    }
+    for (size_t i = 0; i < keys.size() && !triggered; i++) {
+      triggered = watchers_[keys[i]].generation != seen[i];
+    }
+    if (!triggered) {
+      for (const auto &key : keys) {
+        // Operations completed through another key linger until this one triggers; sweep them
+        // whenever the list doubles so it stays proportional to what is really waiting
+        auto &operations = watchers_[key].operations;
+        operations.push_back(operation);
+        size_t count = operations.size();
+        if (count >= 64 && (count & (count - 1)) == 0) {
+          std::erase_if(operations, [](const std::weak_ptr<Operation> &waiting) {
+            auto op = waiting.lock();
+            return !op || op->claimed.load(std::memory_order_relaxed);
+          });
+        }
+      }
+      wheel_.schedule(deadline, operation);
+      parked_.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+
+  if (triggered) {
+    parked_.fetch_add(1, std::memory_order_relaxed);
+    complete(operation);
+    return;
+  }
+  wake_.notify_one();
+}
+
+void Purgatory::trigger(const TopicPartition &key) {
+  std::vector<std::weak_ptr<Operation>> waiting;
+  {
+    std::lock_guard lock(mutex_);
+    auto &watchers = watchers_[key];
+    watchers.generation++;
+    waiting.swap(watchers.operations);
+  }
+  for (const auto &operation : waiting) {
+    if (auto op = operation.lock()) {
+      complete(op);
+    }
+  }
+}
+
+void Purgatory::stop() {
+  {
+    std::lock_guard lock(mutex_);
+    stopped_ = true;
+  }
+  wake_.notify_one();
+  if (reaper_.joinable()) {
+    reaper_.join();
+  }
+}
+
+void Purgatory::complete(const std::shared_ptr<Operation> &operation) {
+  if (operation->claimed.exchange(true)) {
+    return;
+  }
+  parked_.fetch_sub(1, std::memory_order_relaxed);
+  auto complete = std::move(operation->complete);
+  operation->complete = nullptr;
+  complete();
+}
+
+void Purgatory::expireOperations() {
+  std::unique_lock lock(mutex_);
+  while (!stopped_) {
+    if (auto next = wheel_.nextExpiry()) {
+      wake_.wait_until(lock, *next);
+    } else {
+      wake_.wait(lock);
+    }
+
+    auto expired = wheel_.advance(Clock::now());
+    lock.unlock();
+    for (const auto &operation : expired) {
+      complete(operation);
+    }
+    lock.lock();
+  }
+}
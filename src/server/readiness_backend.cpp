@@ -0,0 +1,93 @@
+#include "include/readiness_backend.hpp"
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+
+ReadinessBackend::~ReadinessBackend() { destroyTasks(); }
+
+void ReadinessBackend::post(InlineFunction task) { loop_.post(std::move(task)); }
+
+const char *ReadinessBackend::name() const {
+#if defined(__linux__)
+  return "epoll";
+#else
+  return "kqueue";
+#endif
+}
+
+void ReadinessBackend::listen(SocketFd &socket, std::function<void(SocketFd)> on_accept) {
+  watchListener(socket, std::make_shared<std::function<void(SocketFd)>>(std::move(on_accept)));
+}
+
+void ReadinessBackend::watchListener(SocketFd &socket,
+                                     std::shared_ptr<std::function<void(SocketFd)>> on_accept) {
+  loop_.add(socket.get(), [this, &socket, on_accept](uint32_t) {
+    while (true) {
+      struct sockaddr_in client_addr {};
+      socklen_t client_addr_len = sizeof(client_addr);
+      SocketFd client = socket.acceptNonBlocking(client_addr, client_addr_len);
+      if (!client.valid()) {
+        if (errno == EINTR || errno == ECONNABORTED) {
+          continue;
+        }
+        if (errno != EAGAIN && errno != EWOULDBLOCK) {
+          std::cerr << "Accept failed: " << std::strerror(errno) << std::endl;
+        }
+        if (acceptExhausted(errno)) {
+          // Watching again reports the connections still pending as a fresh edge
+          loop_.remove(socket.get());
+          loop_.runAfter(ACCEPT_BACKOFF,
+                         [this, &socket, on_accept] { watchListener(socket, on_accept); });
+        }
+        return;
+      }
+      (*on_accept)(std::move(client));
+    }
+  });
+}
+
+void ReadinessBackend::attach(Connection &connection) {
+  auto waiters = std::make_shared<Waiters>();
+  waiters_[connection.fd()] = waiters;
+  loop_.add(connection.fd(), [waiters](uint32_t events) {
+    // Resuming may detach the connection; `waiters` stays alive through this callback
+    if ((events & (EventLoop::READABLE | EventLoop::HANGUP)) && waiters->reader) {
+      std::exchange(waiters->reader, {}).resume();
+    }
+    if ((events & (EventLoop::WRITABLE | EventLoop::HANGUP)) && waiters->writer) {
+      std::exchange(waiters->writer, {}).resume();
+    }
+  });
+}
+
+void ReadinessBackend::detach(Connection &connection) {
+  loop_.remove(connection.fd());
+  waiters_.erase(connection.fd());
+}
+
+Task<bool> ReadinessBackend::read(Connection &connection) {
+  auto waiters = waiters_.at(connection.fd());
+  while (true) {
+    size_t buffered = connection.buffered();
+    if (!connection.readAvailable()) {
+      co_return false;
+    }
+    if (connection.buffered() > buffered || connection.readPaused()) {
+      co_return true;
+    }
+    co_await WaitFor {waiters->reader};
+  }
+}
+
+Task<bool> ReadinessBackend::write(Connection &connection) {
+  auto waiters = waiters_.at(connection.fd());
+  while (true) {
+    if (!connection.flush()) {
+      co_return false;
+    }
+    if (!connection.hasOutput()) {
+      co_return true;
+    }
+    co_await WaitFor {waiters->writer};
+  }
+}
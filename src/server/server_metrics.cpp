@@ -0,0 +1,76 @@
+#include "include/server_metrics.hpp"
+#include "../../protocol/base/include/api_keys.hpp"
+
+ServerMetrics::ServerMetrics(metrics::Registry &registry, std::span<const int16_t> api_keys)
+    : parse_errors_(registry.counter("kafka_request_parse_errors_total",
+                                     "Request frames that could not be parsed")) {
+  for (int16_t key : api_keys) {
+    const char *name = KafkaProtocol::apiName(key);
+    metrics::Labels labels {{"api", name ? name : std::to_string(key)}};
+    apis_.emplace(
+        key,
+        ApiMetrics {
+            registry.counter("kafka_requests_total", "Requests handled", labels),
+            registry.counter("kafka_request_bytes_total",
+                             "Request bytes received, framing included", labels),
+            registry.counter("kafka_response_bytes_total", "Response bytes sent, framing included",
+                             labels),
+            registry.histogram("kafka_request_parse_seconds", "Time to decode a request", labels),
+            registry.histogram("kafka_request_handler_seconds",
+                               "Time in the API handler, waiting for min_bytes included", labels),
+            registry.histogram("kafka_response_send_seconds",
+                               "Time to write the batch of responses holding the response",
+                               labels)});
+  }
+}
+
+InstrumentedStorageService::InstrumentedStorageService(
+    std::unique_ptr<storage::IStorageService> inner, metrics::Registry &registry)
+    : inner_(std::move(inner)), load_cluster_snapshot_(call(registry, "load_cluster_snapshot")),
+      read_partition_data_(call(registry, "read_partition_data")),
+      append_records_(call(registry, "append_records")),
+      read_partition_range_(call(registry, "read_partition_range")) {}
+
+InstrumentedStorageService::Call InstrumentedStorageService::call(metrics::Registry &registry,
+                                                                  const std::string &name) {
+  metrics::Labels labels {{"call", name}};
+  return {registry.histogram("kafka_storage_call_seconds", "Time spent in storage calls", labels),
+          registry.counter("kafka_storage_call_errors_total", "Storage calls that failed",
+                           labels)};
+}
+
+std::expected<std::shared_ptr<const storage::ClusterSnapshot>, storage::StorageError>
+InstrumentedStorageService::loadClusterSnapshot() {
+  return timed(load_cluster_snapshot_, [&] { return inner_->loadClusterSnapshot(); });
+}
+
+std::expected<storage::PartitionData, storage::StorageError>
+InstrumentedStorageService::readPartitionData(const std::string &topic_name,
+                                              int32_t partition_id) {
+  return timed(read_partition_data_,
+               [&] { return inner_->readPartitionData(topic_name, partition_id); });
+}
+
+void InstrumentedStorageService::appendRecords(const std::string &topic_name,
+                                               int32_t partition_id, std::vector<uint8_t> records,
+                                               AppendCallback done) {
+  auto started = std::chrono::steady_clock::now();
+  inner_->appendRecords(
+      topic_name, partition_id, std::move(records),
+      [&call = append_records_, started, done = std::move(done)](auto result) {
+        call.latency.record(std::chrono::steady_clock::now() - started);
+        if (!result) {
+          call.errors.add();
+        }
+        done(std::move(result));
+      });
+}
+
+std::expected<storage::PartitionRange, storage::StorageError>
+InstrumentedStorageService::readPartitionRange(const std::string &topic_name,
+                                               int32_t partition_id, int64_t fetch_offset,
+                                               uint64_t max_bytes) {
+  return timed(read_partition_range_, [&] {
+    return inner_->readPartitionRange(topic_name, partition_id, fetch_offset, max_bytes);
+  });
+}
@@ -0,0 +1,209 @@
+#include "../include/connection.hpp"
+#include <arpa/inet.h>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <gtest/gtest.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+std::vector<uint8_t> frame(const std::string &payload) {
+  std::vector<uint8_t> bytes(4);
+  uint32_t size = htonl(static_cast<uint32_t>(payload.size()));
+  std::memcpy(bytes.data(), &size, 4);
+  bytes.insert(bytes.end(), payload.begin(), payload.end());
+  return bytes;
+}
+
+class ConnectionTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    int fds[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+    fcntl(fds[0], F_SETFL, fcntl(fds[0], F_GETFL, 0) | O_NONBLOCK);
+    connection = std::make_unique<Connection>(SocketFd(fds[0]));
+    peer = SocketFd(fds[1]);
+  }
+
+  void send(const std::vector<uint8_t> &bytes) {
+    ASSERT_EQ(::write(peer.get(), bytes.data(), bytes.size()),
+              static_cast<ssize_t>(bytes.size()));
+  }
+
+  std::unique_ptr<Connection> connection;
+  SocketFd peer;
+};
+} // namespace
+
+TEST_F(ConnectionTest, WaitsForCompleteFrame) {
+  auto bytes = frame("hello");
+  send({bytes.begin(), bytes.begin() + 6});
+  ASSERT_TRUE(connection->readAvailable());
+  EXPECT_FALSE(connection->hasRequest());
+
+  send({bytes.begin() + 6, bytes.end()});
+  ASSERT_TRUE(connection->readAvailable());
+  ASSERT_TRUE(connection->hasRequest());
+  EXPECT_EQ(connection->takeRequests(), bytes);
+  EXPECT_FALSE(connection->hasRequest());
+}
+
+TEST_F(ConnectionTest, TakesPipelinedFramesAndKeepsPartialTail) {
+  auto first = frame("one");
+  auto second = frame("two");
+  auto third = frame("three");
+  std::vector<uint8_t> bytes = first;
+  bytes.insert(bytes.end(), second.begin(), second.end());
+  bytes.insert(bytes.end(), third.begin(), third.begin() + 5);
+  send(bytes);
+
+  ASSERT_TRUE(connection->readAvailable());
+  auto requests = connection->takeRequests();
+  EXPECT_EQ(requests.size(), first.size() + second.size());
+  EXPECT_FALSE(connection->hasRequest());
+
+  send({third.begin() + 5, third.end()});
+  ASSERT_TRUE(connection->readAvailable());
+  EXPECT_EQ(connection->takeRequests(), third);
+}
+
+TEST_F(ConnectionTest, RejectsNegativeSize) {
+  send({0xff, 0xff, 0xff, 0xff});
+  ASSERT_TRUE(connection->readAvailable());
+  EXPECT_TRUE(connection->invalidFrame());
+  EXPECT_FALSE(connection->hasRequest());
+}
+
+TEST_F(ConnectionTest, FramesInputAppendedAByteAtATime) {
+  auto first = frame("one");
+  auto second = frame("two");
+  std::vector<uint8_t> bytes = first;
+  bytes.insert(bytes.end(), second.begin(), second.end());
+  bytes.insert(bytes.end(), {0xff, 0xff, 0xff, 0xff});
+
+  for (size_t i = 0; i < bytes.size(); i++) {
+    connection->appendInput(&bytes[i], 1);
+    EXPECT_EQ(connection->hasRequest(), i + 1 >= first.size()) << i;
+  }
+  EXPECT_TRUE(connection->invalidFrame());
+  EXPECT_EQ(connection->takeRequests().size(), first.size() + second.size());
+  EXPECT_FALSE(connection->hasRequest());
+  // The invalid size prefix is what is left
+  EXPECT_TRUE(connection->invalidFrame());
+}
+
+TEST_F(ConnectionTest, ReportsPeerClose) {
+  peer.close();
+  EXPECT_FALSE(connection->readAvailable());
+}
+
+TEST_F(ConnectionTest, FlushWritesQueuedResponses) {
+  ResponseBuffer response;
+  response.write("abc", 3);
+  connection->queueResponse(std::move(response));
+  ASSERT_TRUE(connection->flush());
+  char buf[3];
+  ASSERT_EQ(::read(peer.get(), buf, sizeof(buf)), 3);
+  EXPECT_EQ(std::string(buf, 3), "abc");
+}
+
+TEST_F(ConnectionTest, FlushSendsFileSegmentsInPlace) {
+  FILE *file = std::tmpfile();
+  ASSERT_NE(file, nullptr);
+  std::fputs("0123456789", file);
+  std::fflush(file);
+
+  ResponseBuffer response;
+  response.write("[", 1);
+  response.appendFile({fileno(file), 3, 4, nullptr});
+  response.write("]", 1);
+  connection->queueResponse(std::move(response));
+  ASSERT_TRUE(connection->flush());
+
+  char buf[6];
+  ASSERT_EQ(::recv(peer.get(), buf, sizeof(buf), MSG_WAITALL), 6);
+  EXPECT_EQ(std::string(buf, 6), "[3456]");
+  std::fclose(file);
+}
+
+TEST_F(ConnectionTest, GathersOutputUpToFileSegment) {
+  FILE *file = std::tmpfile();
+  ASSERT_NE(file, nullptr);
+  std::fputs("0123456789", file);
+  std::fflush(file);
+
+  ResponseBuffer response;
+  response.write("ab", 2);
+  response.appendFile({fileno(file), 3, 4, nullptr});
+  response.write("]", 1);
+  connection->queueResponse(std::move(response));
+
+  iovec iov[4];
+  ASSERT_EQ(connection->gatherOutput(iov, 4), 1u);
+  EXPECT_EQ(std::string(static_cast<char *>(iov[0].iov_base), iov[0].iov_len), "ab");
+
+  // A partial send leaves the rest of the segment next
+  connection->consumeOutput(1);
+  ASSERT_EQ(connection->gatherOutput(iov, 4), 1u);
+  EXPECT_EQ(std::string(static_cast<char *>(iov[0].iov_base), iov[0].iov_len), "b");
+  connection->consumeOutput(1);
+
+  EXPECT_EQ(connection->gatherOutput(iov, 4), 0u);
+  EXPECT_EQ(connection->sendFile(), 4);
+  ASSERT_EQ(connection->gatherOutput(iov, 4), 1u);
+  connection->consumeOutput(iov[0].iov_len);
+  EXPECT_FALSE(connection->hasOutput());
+
+  char buf[4];
+  ASSERT_EQ(::recv(peer.get(), buf, sizeof(buf), MSG_WAITALL), 4);
+  EXPECT_EQ(std::string(buf, 4), "3456");
+  std::fclose(file);
+}
+
+TEST_F(ConnectionTest, SendsSharedSegmentsAlongsideChunks) {
+  ResponseBuffer response;
+  response.write("[", 1);
+  response.appendShared(common::SharedBytes::from({'a', 'b', 'c'}));
+  response.write("]", 1);
+  connection->queueResponse(std::move(response));
+
+  iovec iov[4];
+  ASSERT_EQ(connection->gatherOutput(iov, 4), 3u);
+  EXPECT_EQ(std::string(static_cast<char *>(iov[1].iov_base), iov[1].iov_len), "abc");
+
+  ASSERT_TRUE(connection->flush());
+  char buf[5];
+  ASSERT_EQ(::recv(peer.get(), buf, sizeof(buf), MSG_WAITALL), 5);
+  EXPECT_EQ(std::string(buf, 5), "[abc]");
+}
+
+TEST_F(ConnectionTest, FlushResumesAfterShortWrite) {
+  // Several responses, together larger than the socket buffer
+  std::string expected;
+  for (char fill = 'a'; fill < 'e'; fill++) {
+    std::string payload(512 * 1024, fill);
+    ResponseBuffer response;
+    response.write(payload.data(), payload.size());
+    connection->queueResponse(std::move(response));
+    expected += payload;
+  }
+  EXPECT_EQ(connection->pendingOutput(), expected.size());
+
+  std::string received;
+  std::vector<char> buf(64 * 1024);
+  while (connection->hasOutput()) {
+    ASSERT_TRUE(connection->flush());
+    ssize_t n;
+    while ((n = ::recv(peer.get(), buf.data(), buf.size(), MSG_DONTWAIT)) > 0) {
+      received.append(buf.data(), static_cast<size_t>(n));
+    }
+  }
+  EXPECT_EQ(connection->pendingOutput(), 0u);
+  ssize_t n;
+  while ((n = ::recv(peer.get(), buf.data(), buf.size(), MSG_DONTWAIT)) > 0) {
+    received.append(buf.data(), static_cast<size_t>(n));
+  }
+  EXPECT_EQ(received, expected);
+}
@@ -0,0 +1,87 @@
+#include "../include/event_loop.hpp"
+#include <atomic>
+#include <chrono>
+#include <gtest/gtest.h>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+
+TEST(EventLoopTest, RunsPostedTasksOnLoopThread) {
+  EventLoop loop;
+  std::thread runner([&loop] { loop.run(); });
+  auto runner_id = runner.get_id();
+
+  std::atomic<bool> ran {false};
+  std::thread::id task_thread;
+  loop.post([&] {
+    task_thread = std::this_thread::get_id();
+    ran = true;
+  });
+
+  for (int i = 0; i < 100 && !ran; i++) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  }
+  loop.stop();
+  runner.join();
+
+  EXPECT_TRUE(ran.load());
+  EXPECT_EQ(task_thread, runner_id);
+}
+
+TEST(EventLoopTest, ReportsReadableSocket) {
+  int fds[2];
+  ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+
+  EventLoop loop;
+  std::atomic<bool> readable {false};
+  loop.add(fds[0], [&](uint32_t events) {
+    if (events & EventLoop::READABLE) {
+      readable = true;
+    }
+  });
+  std::thread runner([&loop] { loop.run(); });
+
+  ASSERT_EQ(write(fds[1], "x", 1), 1);
+  for (int i = 0; i < 100 && !readable; i++) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  }
+  loop.stop();
+  runner.join();
+
+  EXPECT_TRUE(readable.load());
+  close(fds[0]);
+  close(fds[1]);
+}
+
+TEST(EventLoopTest, StopBeforeRunReturnsImmediately) {
+  EventLoop loop;
+  loop.stop();
+  loop.run();
+  SUCCEED();
+}
+
+TEST(EventLoopTest, RunsTimersOnceTheirDelayHasPassed) {
+  EventLoop loop;
+  std::atomic<int> fired {0};
+  auto start = std::chrono::steady_clock::now();
+  std::chrono::steady_clock::duration waited {};
+  loop.post([&] {
+    // Scheduled out of order; a timer may schedule another
+    loop.runAfter(std::chrono::milliseconds(40), [&] {
+      waited = std::chrono::steady_clock::now() - start;
+      fired = fired * 10 + 2;
+      loop.runAfter(std::chrono::milliseconds(0), [&] { fired = fired * 10 + 3; });
+    });
+    loop.runAfter(std::chrono::milliseconds(20), [&] { fired = fired * 10 + 1; });
+  });
+  std::thread runner([&loop] { loop.run(); });
+
+  for (int i = 0; i < 200 && fired < 123; i++) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  }
+  loop.stop();
+  runner.join();
+
+  EXPECT_EQ(fired.load(), 123);
+  EXPECT_GE(waited, std::chrono::milliseconds(40));
+}
@@ -0,0 +1,173 @@
+#include "../../protocol/fetch/include/fetch_response.hpp"
+#include "../include/fetch_session.hpp"
+#include <gtest/gtest.h>
+
+namespace KPF = KafkaProtocol::Fetch;
+
+namespace {
+FetchPartition partition(int32_t index, int64_t offset) { return {index, 0, offset, -1, -1, 4096}; }
+
+FetchTopic topic(uint128_t id, std::pmr::vector<FetchPartition> partitions) {
+  FetchTopic topic;
+  topic.topic_id = id;
+  topic.partitions = std::move(partitions);
+  return topic;
+}
+
+ForgottenTopic forget(uint128_t id, std::pmr::vector<int32_t> partitions) {
+  ForgottenTopic topic;
+  topic.topic_id = id;
+  topic.partitions = std::move(partitions);
+  return topic;
+}
+
+FetchRequest fetch(int32_t session_id, int32_t epoch, std::pmr::vector<FetchTopic> topics,
+                   std::pmr::vector<ForgottenTopic> forgotten = {}) {
+  FetchRequest request;
+  request.session_id = session_id;
+  request.session_epoch = epoch;
+  request.topics = std::move(topics);
+  request.forgotten_topics_data = std::move(forgotten);
+  return request;
+}
+
+FetchSessionCache::SentPartition sent(uint128_t topic, int32_t index, int64_t high_watermark,
+                                      bool has_records = false) {
+  return {{storage::TopicId {topic}, index}, 0, high_watermark, high_watermark, 0, has_records};
+}
+
+size_t partitionCount(const FetchPlan &plan) {
+  size_t count = 0;
+  for (const auto &topic : plan.topics) {
+    count += topic.partitions.size();
+  }
+  return count;
+}
+} // namespace
+
+TEST(FetchSessionTest, SessionlessFetchIsNotCached) {
+  FetchSessionCache cache;
+  auto plan =
+      cache.resolve(fetch(0, FetchSessionCache::FINAL_EPOCH, {topic(1, {partition(0, 5)})}));
+  EXPECT_EQ(plan.error_code, 0);
+  EXPECT_EQ(plan.session_id, 0);
+  EXPECT_FALSE(plan.incremental);
+  EXPECT_EQ(partitionCount(plan), 1u);
+  EXPECT_EQ(cache.sessions(), 0u);
+}
+
+TEST(FetchSessionTest, IncrementalFetchKeepsSessionPartitions) {
+  FetchSessionCache cache;
+  auto full =
+      cache.resolve(fetch(0, 0, {topic(1, {partition(0, 0), partition(1, 0)}), topic(2, {})}));
+  ASSERT_GT(full.session_id, 0);
+  EXPECT_FALSE(full.incremental);
+  EXPECT_EQ(cache.partitions(), 2u);
+
+  // Only partition 1 moved on; partition 0 is still fetched from where the session left it
+  auto next = cache.resolve(fetch(full.session_id, 1, {topic(1, {partition(1, 7)})}));
+  EXPECT_EQ(next.error_code, 0);
+  EXPECT_EQ(next.session_id, full.session_id);
+  EXPECT_TRUE(next.incremental);
+  ASSERT_EQ(next.topics.size(), 1u);
+  ASSERT_EQ(next.topics[0].partitions.size(), 2u);
+  EXPECT_EQ(next.topics[0].partitions[0].fetch_offset, 0);
+  EXPECT_EQ(next.topics[0].partitions[1].fetch_offset, 7);
+
+  // New partitions join, forgotten ones leave, and topics stay grouped
+  auto grown = cache.resolve(fetch(full.session_id, 2,
+                                   {topic(2, {partition(0, 0)}), topic(1, {partition(2, 0)})},
+                                   {forget(1, {0})}));
+  ASSERT_EQ(grown.topics.size(), 2u);
+  EXPECT_EQ(grown.topics[0].topic_id, uint128_t {1});
+  ASSERT_EQ(grown.topics[0].partitions.size(), 2u);
+  EXPECT_EQ(grown.topics[0].partitions[0].partition, 1);
+  EXPECT_EQ(grown.topics[0].partitions[1].partition, 2);
+  EXPECT_EQ(grown.topics[1].topic_id, uint128_t {2});
+  EXPECT_EQ(cache.partitions(), 3u);
+}
+
+TEST(FetchSessionTest, RejectsBadSessionAndEpoch) {
+  FetchSessionCache cache;
+  auto full = cache.resolve(fetch(0, 0, {topic(1, {partition(0, 0)})}));
+
+  EXPECT_EQ(cache.resolve(fetch(full.session_id, 2, {})).error_code,
+            KPF::ERROR_INVALID_FETCH_SESSION_EPOCH);
+  EXPECT_EQ(cache.resolve(fetch(full.session_id + 1, 1, {})).error_code,
+            KPF::ERROR_FETCH_SESSION_ID_NOT_FOUND);
+  EXPECT_EQ(cache.resolve(fetch(0, 3, {})).error_code, KPF::ERROR_INVALID_FETCH_SESSION_EPOCH);
+
+  // The rejected requests did not move the epoch on
+  EXPECT_EQ(cache.resolve(fetch(full.session_id, 1, {})).error_code, 0);
+}
+
+TEST(FetchSessionTest, FinalEpochClosesSession) {
+  FetchSessionCache cache;
+  auto full = cache.resolve(fetch(0, 0, {topic(1, {partition(0, 0)})}));
+  auto closed = cache.resolve(fetch(full.session_id, FetchSessionCache::FINAL_EPOCH, {}));
+  EXPECT_EQ(closed.session_id, 0);
+  EXPECT_EQ(cache.sessions(), 0u);
+  EXPECT_EQ(cache.partitions(), 0u);
+  EXPECT_EQ(cache.resolve(fetch(full.session_id, 1, {})).error_code,
+            KPF::ERROR_FETCH_SESSION_ID_NOT_FOUND);
+}
+
+TEST(FetchSessionTest, EvictsLeastRecentlyUsedSession) {
+  FetchSessionCache cache(2, 100);
+  auto first = cache.resolve(fetch(0, 0, {topic(1, {partition(0, 0)})}));
+  auto second = cache.resolve(fetch(0, 0, {topic(1, {partition(1, 0)})}));
+
+  // Using the first session makes the second the oldest
+  EXPECT_EQ(cache.resolve(fetch(first.session_id, 1, {})).error_code, 0);
+  auto third = cache.resolve(fetch(0, 0, {topic(1, {partition(2, 0)})}));
+  EXPECT_GT(third.session_id, 0);
+  EXPECT_EQ(cache.sessions(), 2u);
+
+  EXPECT_EQ(cache.resolve(fetch(first.session_id, 2, {})).error_code, 0);
+  EXPECT_EQ(cache.resolve(fetch(second.session_id, 1, {})).error_code,
+            KPF::ERROR_FETCH_SESSION_ID_NOT_FOUND);
+}
+
+TEST(FetchSessionTest, PartitionBudgetBoundsTheCache) {
+  FetchSessionCache cache(10, 3);
+  auto small = cache.resolve(fetch(0, 0, {topic(1, {partition(0, 0), partition(1, 0)})}));
+  EXPECT_GT(small.session_id, 0);
+
+  // Too big to cache at all: served without a session
+  auto huge = cache.resolve(fetch(
+      0, 0, {topic(2, {partition(0, 0), partition(1, 0), partition(2, 0), partition(3, 0)})}));
+  EXPECT_EQ(huge.session_id, 0);
+  EXPECT_EQ(partitionCount(huge), 4u);
+
+  // Fits once the older session is evicted
+  auto other = cache.resolve(fetch(0, 0, {topic(2, {partition(0, 0), partition(1, 0)})}));
+  EXPECT_GT(other.session_id, 0);
+  EXPECT_EQ(cache.sessions(), 1u);
+  EXPECT_EQ(cache.partitions(), 2u);
+
+  // Growing past the budget on its own drops the session
+  auto grown =
+      cache.resolve(fetch(other.session_id, 1, {topic(3, {partition(0, 0), partition(1, 0)})}));
+  EXPECT_EQ(grown.error_code, KPF::ERROR_FETCH_SESSION_ID_NOT_FOUND);
+  EXPECT_EQ(cache.sessions(), 0u);
+  EXPECT_EQ(cache.partitions(), 0u);
+}
+
+TEST(FetchSessionTest, IncrementalResponseOmitsUnchangedPartitions) {
+  FetchSessionCache cache;
+  auto full = cache.resolve(fetch(0, 0, {topic(1, {partition(0, 0), partition(1, 0)})}));
+  std::vector<FetchSessionCache::SentPartition> first {sent(1, 0, 3, true), sent(1, 1, 0)};
+  EXPECT_EQ(cache.recordSent(full.session_id, false, first), (std::vector<bool> {true, true}));
+
+  auto next = cache.resolve(fetch(full.session_id, 1, {topic(1, {partition(0, 3)})}));
+  std::vector<FetchSessionCache::SentPartition> idle {sent(1, 0, 3), sent(1, 1, 0)};
+  EXPECT_EQ(cache.recordSent(next.session_id, true, idle), (std::vector<bool> {false, false}));
+
+  // New records, a moved high watermark and errors all go out
+  std::vector<FetchSessionCache::SentPartition> busy {sent(1, 0, 5, true), sent(1, 1, 2)};
+  EXPECT_EQ(cache.recordSent(next.session_id, true, busy), (std::vector<bool> {true, true}));
+  auto failed = sent(1, 1, 2);
+  failed.error_code = KPF::ERROR_OFFSET_OUT_OF_RANGE;
+  std::vector<FetchSessionCache::SentPartition> errors {sent(1, 0, 5), failed};
+  EXPECT_EQ(cache.recordSent(next.session_id, true, errors), (std::vector<bool> {false, true}));
+}
@@ -0,0 +1,58 @@
+#include "../include/inline_function.hpp"
+#include <array>
+#include <gtest/gtest.h>
+#include <memory>
+#include <utility>
+
+TEST(InlineFunctionTest, SmallCallablesAreStoredInline) {
+  auto owner = std::make_shared<int>(0);
+  auto lambda = [owner, self = static_cast<void *>(nullptr)] { (void)self; };
+  EXPECT_TRUE(InlineFunction::fitsInline<decltype(lambda)>());
+
+  std::array<char, InlineFunction::INLINE_SIZE + 1> big {};
+  auto large = [big] { (void)big; };
+  EXPECT_FALSE(InlineFunction::fitsInline<decltype(large)>());
+}
+
+TEST(InlineFunctionTest, InvokesAndMoves) {
+  int calls = 0;
+  InlineFunction f([&calls] { calls++; });
+  f();
+  InlineFunction g(std::move(f));
+  EXPECT_FALSE(f);
+  ASSERT_TRUE(g);
+  g();
+  EXPECT_EQ(calls, 2);
+}
+
+TEST(InlineFunctionTest, AcceptsMoveOnlyCaptures) {
+  auto value = std::make_unique<int>(7);
+  int seen = 0;
+  InlineFunction f([value = std::move(value), &seen] { seen = *value; });
+  InlineFunction g;
+  g = std::move(f);
+  g();
+  EXPECT_EQ(seen, 7);
+}
+
+TEST(InlineFunctionTest, LargeCallablesGoToTheHeap) {
+  std::array<int, 64> values {};
+  values[63] = 5;
+  int seen = 0;
+  InlineFunction f([values, &seen] { seen = values[63]; });
+  InlineFunction g(std::move(f));
+  g();
+  EXPECT_EQ(seen, 5);
+}
+
+TEST(InlineFunctionTest, DestroysCapturesOnce) {
+  auto tracker = std::make_shared<int>(0);
+  {
+    InlineFunction f([tracker] {});
+    InlineFunction g(std::move(f));
+    EXPECT_EQ(tracker.use_count(), 2);
+    g.reset();
+    EXPECT_EQ(tracker.use_count(), 1);
+  }
+  EXPECT_EQ(tracker.use_count(), 1);
+}
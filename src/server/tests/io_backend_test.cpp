@@ -0,0 +1,218 @@
+#include "../include/io_backend.hpp"
+#include "../include/io_uring.hpp"
+#include <arpa/inet.h>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <fcntl.h>
+#include <gtest/gtest.h>
+#include <memory>
+#include <set>
+#include <string>
+#include <sys/socket.h>
+#include <system_error>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+std::vector<uint8_t> frame(const std::string &payload) {
+  std::vector<uint8_t> bytes(4);
+  uint32_t size = htonl(static_cast<uint32_t>(payload.size()));
+  std::memcpy(bytes.data(), &size, 4);
+  bytes.insert(bytes.end(), payload.begin(), payload.end());
+  return bytes;
+}
+
+template <typename Predicate> bool waitUntil(Predicate predicate) {
+  for (int i = 0; i < 400 && !predicate(); i++) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  }
+  return predicate();
+}
+
+// Writes every complete frame back to the peer until it goes away
+Task<> echo(IoBackend &io, Connection &connection, std::atomic<bool> &finished) {
+  io.attach(connection);
+  while (true) {
+    if (!connection.hasRequest()) {
+      if (!co_await io.read(connection)) {
+        break;
+      }
+      continue;
+    }
+    auto requests = connection.takeRequests();
+    ResponseBuffer response;
+    response.write(requests.data(), requests.size());
+    connection.queueResponse(std::move(response));
+    if (!co_await io.write(connection)) {
+      break;
+    }
+  }
+  io.detach(connection);
+  finished = true;
+}
+
+class IoBackendTest : public ::testing::TestWithParam<IoBackend::Kind> {
+protected:
+  void SetUp() override {
+    try {
+      io = IoBackend::create(GetParam());
+    } catch (const std::system_error &e) {
+      GTEST_SKIP() << e.what();
+    }
+    runner = std::thread([this] { io->run(); });
+  }
+
+  void TearDown() override {
+    if (runner.joinable()) {
+      io->stop();
+      runner.join();
+    }
+  }
+
+  // A connected pair: the first end is served by the backend, the second is the test's peer
+  std::pair<std::unique_ptr<Connection>, SocketFd> connect() {
+    int fds[2];
+    EXPECT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+    fcntl(fds[0], F_SETFL, fcntl(fds[0], F_GETFL, 0) | O_NONBLOCK);
+    return {std::make_unique<Connection>(SocketFd(fds[0])), SocketFd(fds[1])};
+  }
+
+  std::unique_ptr<IoBackend> io;
+  std::thread runner;
+};
+} // namespace
+
+TEST_P(IoBackendTest, RunsPostedTasksOnLoopThread) {
+  std::atomic<bool> ran {false};
+  std::thread::id task_thread;
+  io->post([&] {
+    task_thread = std::this_thread::get_id();
+    ran = true;
+  });
+  ASSERT_TRUE(waitUntil([&] { return ran.load(); }));
+  EXPECT_EQ(task_thread, runner.get_id());
+}
+
+TEST_P(IoBackendTest, EchoesPipelinedFrames) {
+  auto [connection, peer] = connect();
+  std::atomic<bool> finished {false};
+  io->post([&] { io->spawn(echo(*io, *connection, finished)); });
+
+  auto first = frame("hello");
+  auto second = frame("world!");
+  std::vector<uint8_t> both = first;
+  both.insert(both.end(), second.begin(), second.end());
+  ASSERT_EQ(::write(peer.get(), both.data(), both.size()), static_cast<ssize_t>(both.size()));
+
+  std::vector<uint8_t> echoed(both.size());
+  ASSERT_EQ(::recv(peer.get(), echoed.data(), echoed.size(), MSG_WAITALL),
+            static_cast<ssize_t>(echoed.size()));
+  EXPECT_EQ(echoed, both);
+
+  peer.close();
+  EXPECT_TRUE(waitUntil([&] { return finished.load(); }));
+}
+
+TEST_P(IoBackendTest, WritesResponsesLargerThanTheSocketBuffer) {
+  auto [connection, peer] = connect();
+  std::atomic<bool> finished {false};
+  io->post([&] { io->spawn(echo(*io, *connection, finished)); });
+
+  // Sent in one go so the echo has to wait for the peer to drain it
+  auto request = frame(std::string(4 * 1024 * 1024, 'x'));
+  std::thread sender([&] {
+    size_t sent = 0;
+    while (sent < request.size()) {
+      ssize_t n = ::send(peer.get(), request.data() + sent, request.size() - sent, 0);
+      ASSERT_GT(n, 0);
+      sent += static_cast<size_t>(n);
+    }
+  });
+  std::vector<uint8_t> echoed(request.size());
+  ASSERT_EQ(::recv(peer.get(), echoed.data(), echoed.size(), MSG_WAITALL),
+            static_cast<ssize_t>(echoed.size()));
+  sender.join();
+  EXPECT_EQ(echoed, request);
+
+  peer.close();
+  EXPECT_TRUE(waitUntil([&] { return finished.load(); }));
+}
+
+TEST_P(IoBackendTest, AcceptsConnections) {
+  SocketFd listener = SocketFd::create();
+  sockaddr_in addr {};
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  listener.bind(addr);
+  listener.listen();
+  listener.setNonBlocking();
+  socklen_t length = sizeof(addr);
+  ASSERT_EQ(getsockname(listener.get(), reinterpret_cast<sockaddr *>(&addr), &length), 0);
+
+  std::atomic<int> accepted {0};
+  io->post([&] { io->listen(listener, [&](SocketFd) { accepted++; }); });
+
+  std::vector<SocketFd> clients;
+  for (int i = 0; i < 3; i++) {
+    clients.push_back(SocketFd::create());
+    ASSERT_EQ(::connect(clients.back().get(), reinterpret_cast<sockaddr *>(&addr), sizeof(addr)),
+              0);
+  }
+  EXPECT_TRUE(waitUntil([&] { return accepted.load() == 3; }));
+
+  // The listener goes away with this scope
+  io->stop();
+  runner.join();
+}
+
+TEST_P(IoBackendTest, DestroysSuspendedTasks) {
+  auto [connection, peer] = connect();
+  std::atomic<bool> finished {false};
+  io->post([&] { io->spawn(echo(*io, *connection, finished)); });
+  std::atomic<bool> spawned {false};
+  io->post([&] { spawned = true; });
+  ASSERT_TRUE(waitUntil([&] { return spawned.load(); }));
+
+  // The echo is parked in read(); tearing the backend down must free it without resuming it
+  io->stop();
+  runner.join();
+  io.reset();
+  EXPECT_FALSE(finished.load());
+}
+
+INSTANTIATE_TEST_SUITE_P(Backends, IoBackendTest,
+                         ::testing::Values(IoBackend::Kind::Readiness, IoBackend::Kind::IoUring),
+                         [](const auto &info) {
+                           return info.param == IoBackend::Kind::IoUring ? "IoUring"
+                                                                         : "Readiness";
+                         });
+
+#if defined(KAFKA_HAVE_IO_URING)
+TEST(IoUringTest, TakesEntriesWhileCompletionsPileUp) {
+  std::unique_ptr<IoUring> ring;
+  try {
+    ring = std::make_unique<IoUring>(4);
+  } catch (const std::system_error &e) {
+    GTEST_SKIP() << e.what();
+  }
+
+  // Far more entries than the rings hold, taken without reaping any completion. Kernels that
+  // refuse to submit while completions overflow get theirs parked instead of a throw.
+  constexpr uint64_t ENTRIES = 256;
+  for (uint64_t i = 1; i <= ENTRIES; i++) {
+    auto *sqe = ring->sqe();
+    sqe->opcode = IORING_OP_NOP;
+    sqe->user_data = i;
+  }
+
+  std::set<uint64_t> completed;
+  for (int round = 0; round < 1000 && completed.size() < ENTRIES; round++) {
+    ring->submit(1);
+    ring->forEachCompletion([&](const io_uring_cqe &cqe) { completed.insert(cqe.user_data); });
+  }
+  EXPECT_EQ(completed.size(), ENTRIES);
+  EXPECT_EQ(ring->parked(), 0u);
+}
+#endif
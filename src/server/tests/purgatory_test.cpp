@@ -0,0 +1,91 @@
+#include "../include/purgatory.hpp"
+#include <atomic>
+#include <chrono>
+#include <gtest/gtest.h>
+#include <thread>
+
+using namespace std::chrono_literals;
+
+namespace {
+const TopicPartition FOO_0 {storage::TopicId {1}, 0};
+const TopicPartition FOO_1 {storage::TopicId {1}, 1};
+
+void waitFor(const std::atomic<int> &value, int expected) {
+  for (int i = 0; i < 200 && value.load() != expected; i++) {
+    std::this_thread::sleep_for(5ms);
+  }
+}
+} // namespace
+
+TEST(PurgatoryTest, TriggerCompletesWatchers) {
+  Purgatory purgatory;
+  std::atomic<int> completed {0};
+  std::vector<TopicPartition> keys {FOO_0, FOO_1};
+  auto seen = purgatory.generations(keys);
+  purgatory.watch(keys, seen, Purgatory::Clock::now() + 10s, [&] { completed++; });
+  EXPECT_EQ(purgatory.parked(), 1u);
+
+  purgatory.trigger(FOO_1);
+  EXPECT_EQ(completed.load(), 1);
+  EXPECT_EQ(purgatory.parked(), 0u);
+
+  // Completing once takes it off the other partition's watch list too
+  purgatory.trigger(FOO_0);
+  EXPECT_EQ(completed.load(), 1);
+}
+
+TEST(PurgatoryTest, DeadlineCompletesOnExpirationThread) {
+  Purgatory purgatory;
+  std::atomic<int> completed {0};
+  std::vector<TopicPartition> keys {FOO_0};
+  auto seen = purgatory.generations(keys);
+  auto start = Purgatory::Clock::now();
+  purgatory.watch(keys, seen, start + 30ms, [&] { completed++; });
+
+  waitFor(completed, 1);
+  EXPECT_EQ(completed.load(), 1);
+  EXPECT_GE(Purgatory::Clock::now() - start, 30ms);
+  purgatory.trigger(FOO_0);
+  EXPECT_EQ(completed.load(), 1);
+}
+
+TEST(PurgatoryTest, TriggerBeforeWatchIsNotMissed) {
+  Purgatory purgatory;
+  std::atomic<int> completed {0};
+  std::vector<TopicPartition> keys {FOO_0};
+  auto seen = purgatory.generations(keys);
+  purgatory.trigger(FOO_0);
+
+  purgatory.watch(keys, seen, Purgatory::Clock::now() + 10s, [&] { completed++; });
+  EXPECT_EQ(completed.load(), 1);
+  EXPECT_EQ(purgatory.parked(), 0u);
+}
+
+TEST(PurgatoryTest, ManyParkedOperationsExpire) {
+  Purgatory purgatory;
+  std::atomic<int> completed {0};
+  std::vector<TopicPartition> keys {FOO_0};
+  auto now = Purgatory::Clock::now();
+  for (int i = 0; i < 20000; i++) {
+    purgatory.watch(keys, purgatory.generations(keys), now + std::chrono::milliseconds(i % 50),
+                    [&] { completed++; });
+  }
+
+  waitFor(completed, 20000);
+  EXPECT_EQ(completed.load(), 20000);
+  EXPECT_EQ(purgatory.parked(), 0u);
+}
+
+TEST(PurgatoryTest, StopDropsParkedOperations) {
+  std::atomic<int> completed {0};
+  {
+    Purgatory purgatory;
+    std::vector<TopicPartition> keys {FOO_0};
+    purgatory.watch(keys, purgatory.generations(keys), Purgatory::Clock::now() + 10s,
+                    [&] { completed++; });
+    purgatory.stop();
+    purgatory.watch(keys, purgatory.generations(keys), Purgatory::Clock::now(),
+                    [&] { completed++; });
+  }
+  EXPECT_EQ(completed.load(), 0);
+}
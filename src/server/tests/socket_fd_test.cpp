@@ -27,3 +27,20 @@ TEST(SocketFdTest, Release) {
     close(raw);
   }
 }
+
+TEST(SocketFdTest, AcceptNonBlockingWithNoPendingConnection) {
+  auto listener = SocketFd::create();
+  struct sockaddr_in addr {};
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  addr.sin_port = 0;
+  listener.bind(addr);
+  listener.listen();
+  listener.setNonBlocking();
+
+  struct sockaddr_in client_addr {};
+  socklen_t len = sizeof(client_addr);
+  auto client = listener.acceptNonBlocking(client_addr, len);
+  EXPECT_FALSE(client.valid());
+  EXPECT_TRUE(errno == EAGAIN || errno == EWOULDBLOCK);
+}
@@ -2,7 +2,9 @@
 #include <atomic>
 #include <chrono>
 #include <gtest/gtest.h>
+#include <stdexcept>
 #include <thread>
+#include <vector>
 
 TEST(ThreadPoolTest, ExecutesTask) {
   std::atomic<int> counter {0};
@@ -31,3 +33,70 @@ TEST(ThreadPoolTest, DestructorJoinsWorkers) {
   }
   EXPECT_EQ(done.load(), 1);
 }
+
+TEST(ThreadPoolTest, DestructorRunsQueuedTasks) {
+  std::atomic<int> done {0};
+  {
+    ThreadPool pool(2);
+    for (int i = 0; i < 10000; i++) {
+      pool.enqueue([&done] { done++; });
+    }
+  }
+  EXPECT_EQ(done.load(), 10000);
+}
+
+TEST(ThreadPoolTest, SubmitReturnsResult) {
+  ThreadPool pool(2);
+  auto answer = pool.submit([] { return 42; });
+  EXPECT_EQ(answer.get(), 42);
+
+  auto failed = pool.submit([]() -> int { throw std::runtime_error("boom"); });
+  EXPECT_THROW(failed.get(), std::runtime_error);
+}
+
+TEST(ThreadPoolTest, TasksSpawnedByWorkersAreStolen) {
+  // One task fans out onto its worker's own deque; the other workers have to steal to help
+  std::atomic<int> done {0};
+  std::atomic<int> workers_seen {0};
+  {
+    ThreadPool pool(4);
+    pool.enqueue([&] {
+      for (int i = 0; i < 4000; i++) {
+        pool.enqueue([&] {
+          thread_local bool counted = false;
+          if (!counted) {
+            counted = true;
+            workers_seen++;
+          }
+          std::this_thread::sleep_for(std::chrono::microseconds(10));
+          done++;
+        });
+      }
+    });
+    // Stopping now would let idle workers exit before the fan-out is queued
+    while (done.load() < 4000) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+  }
+  EXPECT_EQ(done.load(), 4000);
+  EXPECT_GT(workers_seen.load(), 1);
+}
+
+TEST(ThreadPoolTest, ManyProducers) {
+  std::atomic<int> done {0};
+  {
+    ThreadPool pool(3);
+    std::vector<std::thread> producers;
+    for (int p = 0; p < 4; p++) {
+      producers.emplace_back([&] {
+        for (int i = 0; i < 5000; i++) {
+          pool.enqueue([&done] { done++; });
+        }
+      });
+    }
+    for (auto &producer : producers) {
+      producer.join();
+    }
+  }
+  EXPECT_EQ(done.load(), 20000);
+}
@@ -0,0 +1,83 @@
+#include "../include/timing_wheel.hpp"
+#include <algorithm>
+#include <chrono>
+#include <gtest/gtest.h>
+
+using namespace std::chrono_literals;
+using Clock = std::chrono::steady_clock;
+
+TEST(TimingWheelTest, ExpiresEntriesAtTheirTick) {
+  auto start = Clock::now();
+  TimingWheel<int> wheel(1ms, start);
+  wheel.schedule(start + 5ms, 5);
+  wheel.schedule(start + 2ms, 2);
+  EXPECT_EQ(wheel.size(), 2u);
+
+  EXPECT_TRUE(wheel.advance(start + 1ms).empty());
+  EXPECT_EQ(wheel.advance(start + 4ms), std::vector<int> {2});
+  EXPECT_EQ(wheel.advance(start + 5ms), std::vector<int> {5});
+  EXPECT_TRUE(wheel.empty());
+}
+
+TEST(TimingWheelTest, PastDeadlinesExpireOnNextAdvance) {
+  auto start = Clock::now();
+  TimingWheel<int> wheel(1ms, start);
+  wheel.advance(start + 10ms);
+  wheel.schedule(start + 3ms, 1);
+  EXPECT_EQ(wheel.advance(start + 10ms), std::vector<int> {1});
+}
+
+TEST(TimingWheelTest, CascadesFromHigherLevels) {
+  auto start = Clock::now();
+  TimingWheel<int> wheel(1ms, start);
+  // One entry per level, plus one past the top level's reach
+  std::vector<int> deadlines {3, 100, 5000, 300000, 20000000};
+  for (int deadline : deadlines) {
+    wheel.schedule(start + std::chrono::milliseconds(deadline), deadline);
+  }
+
+  for (int deadline : deadlines) {
+    EXPECT_TRUE(wheel.advance(start + std::chrono::milliseconds(deadline - 1)).empty());
+    EXPECT_EQ(wheel.advance(start + std::chrono::milliseconds(deadline)),
+              std::vector<int> {deadline});
+  }
+  EXPECT_TRUE(wheel.empty());
+}
+
+TEST(TimingWheelTest, NextExpiryPointsAtFirstOccupiedTick) {
+  auto start = Clock::now();
+  TimingWheel<int> wheel(1ms, start);
+  EXPECT_FALSE(wheel.nextExpiry().has_value());
+
+  wheel.schedule(start + 7ms, 7);
+  EXPECT_EQ(wheel.nextExpiry(), start + 7ms);
+
+  // Beyond level 0 the wheel only needs waking where entries move down
+  wheel.advance(start + 7ms);
+  wheel.schedule(start + 1000ms, 1000);
+  EXPECT_EQ(wheel.nextExpiry(), start + 64ms);
+}
+
+TEST(TimingWheelTest, ManyRandomDeadlinesExpireInOrder) {
+  auto start = Clock::now();
+  TimingWheel<int> wheel(1ms, start);
+  std::vector<int> deadlines;
+  for (int i = 0; i < 10000; i++) {
+    deadlines.push_back((i * 7919) % 100000 + 1);
+    wheel.schedule(start + std::chrono::milliseconds(deadlines.back()), deadlines.back());
+  }
+
+  std::vector<int> expired;
+  for (int now = 0; now <= 100000; now += 37) {
+    for (int deadline : wheel.advance(start + std::chrono::milliseconds(now))) {
+      EXPECT_LE(deadline, now);
+      EXPECT_GT(deadline, now - 37);
+      expired.push_back(deadline);
+    }
+  }
+  for (int deadline : wheel.advance(start + 100001ms)) {
+    expired.push_back(deadline);
+  }
+  EXPECT_EQ(expired.size(), deadlines.size());
+  EXPECT_TRUE(wheel.empty());
+}
@@ -0,0 +1,126 @@
+#include "../include/mpmc_queue.hpp"
+#include "../include/work_stealing_deque.hpp"
+#include <atomic>
+#include <gtest/gtest.h>
+#include <thread>
+#include <vector>
+
+TEST(WorkStealingDequeTest, OwnerPopsNewestThievesStealOldest) {
+  WorkStealingDeque<int> deque(8);
+  for (int i = 1; i <= 3; i++) {
+    ASSERT_TRUE(deque.push(i));
+  }
+  EXPECT_EQ(deque.steal(), 1);
+  EXPECT_EQ(deque.pop(), 3);
+  EXPECT_EQ(deque.pop(), 2);
+  EXPECT_FALSE(deque.pop().has_value());
+  EXPECT_FALSE(deque.steal().has_value());
+  EXPECT_TRUE(deque.empty());
+}
+
+TEST(WorkStealingDequeTest, PushFailsWhenFull) {
+  WorkStealingDeque<int> deque(4);
+  for (int i = 0; i < 4; i++) {
+    ASSERT_TRUE(deque.push(i));
+  }
+  int extra = 4;
+  EXPECT_FALSE(deque.push(extra));
+  EXPECT_EQ(deque.steal(), 0);
+  EXPECT_TRUE(deque.push(extra));
+}
+
+TEST(WorkStealingDequeTest, EveryValueIsTakenOnce) {
+  constexpr int COUNT = 200000;
+  WorkStealingDeque<int> deque(256);
+  std::vector<std::atomic<int>> taken(COUNT);
+  std::atomic<bool> done {false};
+
+  std::vector<std::thread> thieves;
+  for (int t = 0; t < 3; t++) {
+    thieves.emplace_back([&] {
+      while (!done.load() || !deque.empty()) {
+        if (auto value = deque.steal()) {
+          taken[static_cast<size_t>(*value)]++;
+        } else {
+          std::this_thread::yield();
+        }
+      }
+    });
+  }
+
+  for (int i = 0; i < COUNT;) {
+    int value = i;
+    if (deque.push(value)) {
+      i++;
+    } else if (auto popped = deque.pop()) {
+      taken[static_cast<size_t>(*popped)]++;
+    }
+  }
+  while (auto popped = deque.pop()) {
+    taken[static_cast<size_t>(*popped)]++;
+  }
+  done = true;
+  for (auto &thief : thieves) {
+    thief.join();
+  }
+
+  for (int i = 0; i < COUNT; i++) {
+    ASSERT_EQ(taken[static_cast<size_t>(i)].load(), 1) << i;
+  }
+}
+
+TEST(MpmcQueueTest, FifoAndBounded) {
+  MpmcQueue<int> queue(4);
+  for (int i = 0; i < 4; i++) {
+    ASSERT_TRUE(queue.push(i));
+  }
+  int extra = 4;
+  EXPECT_FALSE(queue.push(extra));
+  EXPECT_EQ(queue.pop(), 0);
+  EXPECT_TRUE(queue.push(extra));
+  for (int i = 1; i <= 4; i++) {
+    EXPECT_EQ(queue.pop(), i);
+  }
+  EXPECT_FALSE(queue.pop().has_value());
+}
+
+TEST(MpmcQueueTest, EveryValueIsTakenOnce) {
+  constexpr int PER_PRODUCER = 50000;
+  constexpr int PRODUCERS = 3;
+  MpmcQueue<int> queue(128);
+  std::vector<std::atomic<int>> taken(PER_PRODUCER * PRODUCERS);
+  std::atomic<int> consumed {0};
+
+  std::vector<std::thread> threads;
+  for (int p = 0; p < PRODUCERS; p++) {
+    threads.emplace_back([&, p] {
+      for (int i = 0; i < PER_PRODUCER;) {
+        int value = p * PER_PRODUCER + i;
+        if (queue.push(value)) {
+          i++;
+        } else {
+          std::this_thread::yield();
+        }
+      }
+    });
+  }
+  for (int c = 0; c < 2; c++) {
+    threads.emplace_back([&] {
+      while (consumed.load() < PER_PRODUCER * PRODUCERS) {
+        if (auto value = queue.pop()) {
+          taken[static_cast<size_t>(*value)]++;
+          consumed++;
+        } else {
+          std::this_thread::yield();
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  for (size_t i = 0; i < taken.size(); i++) {
+    ASSERT_EQ(taken[i].load(), 1) << i;
+  }
+}
@@ -1,40 +1,97 @@
 #include "include/thread_pool.hpp"
 
-ThreadPool::ThreadPool(size_t threads) : stop(false) {
+namespace {
+// The pool and worker index of the calling thread, if it is a worker
+struct CurrentWorker {
+  const ThreadPool *pool {nullptr};
+  size_t index {0};
+};
+thread_local CurrentWorker current_worker;
+} // namespace
+
+ThreadPool::ThreadPool(size_t threads) {
+  for (size_t i = 0; i < threads; ++i) {
+    workers.push_back(std::make_unique<Worker>());
+  }
   for (size_t i = 0; i < threads; ++i) {
-    workers.emplace_back([this] {
-      while (true) {
-        std::function<void()> task;
-        {
-          std::unique_lock lock(queue_mutex);
-          condition.wait(lock, [this] { return stop || !tasks.empty(); });
-          if (stop && tasks.empty())
-            return;
-          task = std::move(tasks.front());
-          tasks.pop();
-        }
-        task();
-      }
-    });
+    workers[i]->thread = std::thread([this, i] { run(i); });
   }
 }
 
 ThreadPool::~ThreadPool() {
-  {
-    std::unique_lock lock(queue_mutex);
-    stop = true;
+  stop.store(true);
+  wake_epoch.fetch_add(1);
+  wake_epoch.notify_all();
+  for (auto &worker : workers) {
+    if (worker->thread.joinable())
+      worker->thread.join();
+  }
+}
+
+void ThreadPool::enqueue(InlineFunction task) {
+  bool local = current_worker.pool == this && workers[current_worker.index]->tasks.push(task);
+  if (!local && !injected.push(task)) {
+    std::lock_guard lock(overflow_mutex);
+    overflow.push_back(std::move(task));
+    overflowed.fetch_add(1);
+  }
+
+  // Pairs with park(): either the worker sees the task or we see the worker asleep
+  queued.fetch_add(1);
+  if (sleepers.load() > 0) {
+    wake_epoch.fetch_add(1);
+    wake_epoch.notify_one();
+  }
+}
+
+void ThreadPool::run(size_t index) {
+  current_worker = {this, index};
+  while (true) {
+    if (auto task = next(index)) {
+      queued.fetch_sub(1);
+      (*task)();
+      continue;
+    }
+    if (stop.load() && queued.load() == 0) {
+      return;
+    }
+    park();
+  }
+}
+
+std::optional<InlineFunction> ThreadPool::next(size_t index) {
+  if (auto task = workers[index]->tasks.pop()) {
+    return task;
+  }
+  if (auto task = injected.pop()) {
+    return task;
+  }
+  for (size_t i = 1; i < workers.size(); i++) {
+    if (auto task = workers[(index + i) % workers.size()]->tasks.steal()) {
+      return task;
+    }
   }
-  condition.notify_all();
-  for (auto &w : workers) {
-    if (w.joinable())
-      w.join();
+  if (overflowed.load(std::memory_order_relaxed) > 0) {
+    std::lock_guard lock(overflow_mutex);
+    if (!overflow.empty()) {
+      auto task = std::move(overflow.front());
+      overflow.pop_front();
+      overflowed.fetch_sub(1);
+      return task;
+    }
   }
+  return std::nullopt;
 }
 
-void ThreadPool::enqueue(std::function<void()> task) {
-  {
-    std::unique_lock lock(queue_mutex);
-    tasks.push(std::move(task));
+void ThreadPool::park() {
+  sleepers.fetch_add(1);
+  uint32_t epoch = wake_epoch.load();
+  if (queued.load() > 0 || stop.load()) {
+    // Something is queued but was mid-push or mid-steal when we looked; look again
+    sleepers.fetch_sub(1);
+    std::this_thread::yield();
+    return;
   }
-  condition.notify_one();
+  wake_epoch.wait(epoch);
+  sleepers.fetch_sub(1);
 }
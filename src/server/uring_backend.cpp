@@ -0,0 +1,346 @@
+#include "include/uring_backend.hpp"
+
+#if defined(KAFKA_HAVE_IO_URING)
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <system_error>
+#include <unistd.h>
+
+namespace {
+constexpr uint16_t BUFFER_GROUP = 0;
+} // namespace
+
+// Multishot accept; re-armed whenever the kernel ends it, after a pause if it ran out of
+// descriptors or memory
+struct UringBackend::Acceptor : Operation {
+  // Timeout that re-arms the accept once the pause is over
+  struct Backoff : Operation {
+    Acceptor &acceptor;
+    __kernel_timespec delay {};
+
+    explicit Backoff(Acceptor &acceptor) : acceptor(acceptor) {}
+
+    void complete(int32_t, uint32_t) override { acceptor.backend.armAccept(acceptor); }
+  };
+
+  UringBackend &backend;
+  SocketFd &socket;
+  std::function<void(SocketFd)> on_accept;
+  Backoff backoff {*this};
+
+  Acceptor(UringBackend &backend, SocketFd &socket, std::function<void(SocketFd)> on_accept)
+      : backend(backend), socket(socket), on_accept(std::move(on_accept)) {}
+
+  void complete(int32_t result, uint32_t flags) override {
+    if (result >= 0) {
+      on_accept(SocketFd(result));
+    } else if (result != -EINTR && result != -ECONNABORTED && result != -EAGAIN) {
+      std::cerr << "Accept failed: " << std::strerror(-result) << std::endl;
+    }
+    if (flags & IORING_CQE_F_MORE) {
+      return;
+    }
+    if (result < 0 && acceptExhausted(-result)) {
+      backend.armBackoff(*this);
+    } else {
+      backend.armAccept(*this);
+    }
+  }
+};
+
+// The multishot recv of one attached connection and the coroutine waiting on it
+struct UringBackend::Receiver : Operation {
+  UringBackend &backend;
+  Connection *connection;
+  std::coroutine_handle<> reader;
+  uint64_t received {0};
+  uint64_t seen {0};
+  bool armed {false};
+  bool closed {false};
+  bool detached {false};
+
+  Receiver(UringBackend &backend, Connection &connection)
+      : backend(backend), connection(&connection) {}
+
+  void complete(int32_t result, uint32_t flags) override {
+    if (flags & IORING_CQE_F_BUFFER) {
+      auto id = static_cast<uint16_t>(flags >> IORING_CQE_BUFFER_SHIFT);
+      if (result > 0 && !detached) {
+        connection->appendInput(backend.buffer(id), static_cast<size_t>(result));
+        received += static_cast<uint64_t>(result);
+      }
+      backend.recycle(id);
+    }
+    if (!(flags & IORING_CQE_F_MORE)) {
+      armed = false;
+    }
+    if (detached) {
+      return; // freed by run() once `armed` is clear
+    }
+
+    // -ENOBUFS: every buffer was in use; -ECANCELED: stopped because input was full
+    if (result == 0 || (result < 0 && result != -ENOBUFS && result != -ECANCELED)) {
+      closed = true;
+    } else if (armed && connection->inputFull()) {
+      backend.cancel(*this);
+    } else if (!armed && result == -ENOBUFS) {
+      backend.armReceive(*this);
+    }
+
+    if (reader && (received > seen || closed)) {
+      std::exchange(reader, {}).resume();
+    }
+  }
+};
+
+// Completion of the eventfd read that post() and stop() wake the loop through
+struct UringBackend::Wakeup : Operation {
+  UringBackend &backend;
+  uint64_t value {0};
+
+  explicit Wakeup(UringBackend &backend) : backend(backend) {}
+
+  void complete(int32_t, uint32_t) override { backend.armWakeup(); }
+};
+
+UringBackend::Mapping::~Mapping() {
+  if (data) {
+    munmap(data, size);
+  }
+}
+
+UringBackend::UringBackend()
+    : buffers_(std::make_unique<uint8_t[]>(BUFFER_COUNT * BUFFER_SIZE)), ring_(RING_ENTRIES) {
+  buffer_ring_.size = BUFFER_COUNT * sizeof(io_uring_buf);
+  void *mapped = mmap(nullptr, buffer_ring_.size, PROT_READ | PROT_WRITE,
+                      MAP_ANONYMOUS | MAP_PRIVATE, -1, 0);
+  if (mapped == MAP_FAILED) {
+    throw std::system_error(errno, std::generic_category(), "Failed to map buffer ring");
+  }
+  buffer_ring_.data = mapped;
+  ring_.registerBufferRing(static_cast<io_uring_buf_ring *>(mapped), BUFFER_COUNT,
+                           BUFFER_GROUP);
+  for (unsigned id = 0; id < BUFFER_COUNT; id++) {
+    recycle(static_cast<uint16_t>(id));
+  }
+
+  wakeup_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (wakeup_fd_ < 0) {
+    throw std::system_error(errno, std::generic_category(), "Failed to create eventfd");
+  }
+  wakeup_ = std::make_unique<Wakeup>(*this);
+  armWakeup();
+}
+
+UringBackend::~UringBackend() {
+  destroyTasks();
+  if (wakeup_fd_ >= 0) {
+    ::close(wakeup_fd_);
+  }
+}
+
+void UringBackend::run() {
+  while (!stopped_.load(std::memory_order_acquire)) {
+    ring_.submit(1);
+    ring_.forEachCompletion([](const io_uring_cqe &cqe) {
+      if (cqe.user_data != 0) {
+        reinterpret_cast<Operation *>(cqe.user_data)->complete(cqe.res, cqe.flags);
+      }
+    });
+    runPosted();
+    std::erase_if(retired_, [](const auto &receiver) { return !receiver->armed; });
+  }
+}
+
+void UringBackend::stop() {
+  stopped_.store(true, std::memory_order_release);
+  uint64_t one = 1;
+  [[maybe_unused]] auto n = ::write(wakeup_fd_, &one, sizeof(one));
+}
+
+void UringBackend::post(InlineFunction task) {
+  {
+    std::lock_guard lock(posted_mutex_);
+    posted_.push_back(std::move(task));
+  }
+  uint64_t one = 1;
+  [[maybe_unused]] auto n = ::write(wakeup_fd_, &one, sizeof(one));
+}
+
+void UringBackend::runPosted() {
+  std::vector<InlineFunction> tasks;
+  {
+    std::lock_guard lock(posted_mutex_);
+    tasks.swap(posted_);
+  }
+  for (auto &task : tasks) {
+    task();
+  }
+}
+
+void UringBackend::listen(SocketFd &socket, std::function<void(SocketFd)> on_accept) {
+  acceptors_.push_back(std::make_unique<Acceptor>(*this, socket, std::move(on_accept)));
+  armAccept(*acceptors_.back());
+}
+
+void UringBackend::attach(Connection &connection) {
+  auto receiver = std::make_unique<Receiver>(*this, connection);
+  armReceive(*receiver);
+  receivers_[connection.fd()] = std::move(receiver);
+}
+
+void UringBackend::detach(Connection &connection) {
+  auto node = receivers_.extract(connection.fd());
+  if (node.empty()) {
+    return;
+  }
+  // The recv may still complete, and detach can run from inside its completion
+  auto &receiver = node.mapped();
+  receiver->detached = true;
+  receiver->reader = {};
+  if (receiver->armed) {
+    cancel(*receiver);
+  }
+  retired_.push_back(std::move(receiver));
+}
+
+Task<bool> UringBackend::read(Connection &connection) {
+  Receiver &receiver = *receivers_.at(connection.fd());
+  while (true) {
+    if (receiver.received > receiver.seen) {
+      receiver.seen = receiver.received;
+      co_return true;
+    }
+    if (receiver.closed) {
+      co_return false;
+    }
+    if (!receiver.armed) {
+      armReceive(receiver);
+    }
+    co_await WaitFor {receiver.reader};
+  }
+}
+
+Task<bool> UringBackend::write(Connection &connection) {
+  int fd = connection.fd();
+  while (connection.hasOutput()) {
+    iovec iov[Connection::MAX_GATHER];
+    size_t count = connection.gatherOutput(iov, Connection::MAX_GATHER);
+    if (count > 0) {
+      size_t gathered = 0;
+      for (size_t i = 0; i < count; i++) {
+        gathered += iov[i].iov_len;
+      }
+      msghdr message {};
+      message.msg_iov = iov;
+      message.msg_iovlen = count;
+      uint32_t flags = MSG_NOSIGNAL | (gathered < connection.pendingOutput() ? MSG_MORE : 0);
+      int32_t sent = co_await submit([fd, &message, flags](io_uring_sqe *sqe) {
+        sqe->opcode = IORING_OP_SENDMSG;
+        sqe->fd = fd;
+        sqe->addr = reinterpret_cast<uint64_t>(&message);
+        sqe->len = 1;
+        sqe->msg_flags = flags;
+      });
+      if (sent < 0) {
+        if (sent == -EINTR || sent == -EAGAIN) {
+          continue;
+        }
+        co_return false;
+      }
+      connection.consumeOutput(static_cast<size_t>(sent));
+      continue;
+    }
+
+    if (connection.sendFile() >= 0) {
+      continue;
+    }
+    if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+      co_return false;
+    }
+    int32_t ready = co_await submit([fd](io_uring_sqe *sqe) {
+      sqe->opcode = IORING_OP_POLL_ADD;
+      sqe->fd = fd;
+      sqe->poll32_events = POLLOUT;
+    });
+    if (ready < 0) {
+      co_return false;
+    }
+  }
+  co_return true;
+}
+
+void UringBackend::armAccept(Acceptor &acceptor) {
+  auto *sqe = ring_.sqe();
+  sqe->opcode = IORING_OP_ACCEPT;
+  sqe->fd = acceptor.socket.get();
+  sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+  sqe->accept_flags = SOCK_NONBLOCK | SOCK_CLOEXEC;
+  sqe->user_data = reinterpret_cast<uint64_t>(&acceptor);
+}
+
+void UringBackend::armBackoff(Acceptor &acceptor) {
+  auto &backoff = acceptor.backoff;
+  auto seconds = std::chrono::floor<std::chrono::seconds>(ACCEPT_BACKOFF);
+  backoff.delay.tv_sec = seconds.count();
+  backoff.delay.tv_nsec = std::chrono::nanoseconds(ACCEPT_BACKOFF - seconds).count();
+  auto *sqe = ring_.sqe();
+  sqe->opcode = IORING_OP_TIMEOUT;
+  sqe->addr = reinterpret_cast<uint64_t>(&backoff.delay);
+  sqe->len = 1;
+  sqe->user_data = reinterpret_cast<uint64_t>(&backoff);
+}
+
+void UringBackend::armReceive(Receiver &receiver) {
+  auto *sqe = ring_.sqe();
+  sqe->opcode = IORING_OP_RECV;
+  sqe->fd = receiver.connection->fd();
+  sqe->flags = IOSQE_BUFFER_SELECT;
+  sqe->buf_group = BUFFER_GROUP;
+  sqe->ioprio = IORING_RECV_MULTISHOT;
+  sqe->user_data = reinterpret_cast<uint64_t>(&receiver);
+  receiver.armed = true;
+}
+
+void UringBackend::armWakeup() {
+  auto *sqe = ring_.sqe();
+  sqe->opcode = IORING_OP_READ;
+  sqe->fd = wakeup_fd_;
+  sqe->addr = reinterpret_cast<uint64_t>(&wakeup_->value);
+  sqe->len = sizeof(wakeup_->value);
+  sqe->user_data = reinterpret_cast<uint64_t>(wakeup_.get());
+}
+
+void UringBackend::cancel(Operation &operation) {
+  auto *sqe = ring_.sqe();
+  sqe->opcode = IORING_OP_ASYNC_CANCEL;
+  sqe->addr = reinterpret_cast<uint64_t>(&operation);
+  sqe->user_data = 0; // nobody waits for the cancellation itself
+}
+
+void UringBackend::recycle(uint16_t id) {
+  // The tail shares memory with the first entry's `resv`, so only the other fields are written.
+  // Entries are indexed from the start of the mapping: compiled as C++, the header's flexible
+  // `bufs` array starts 8 bytes in.
+  auto *ring = static_cast<io_uring_buf_ring *>(buffer_ring_.data);
+  auto *entries = static_cast<io_uring_buf *>(buffer_ring_.data);
+  io_uring_buf &entry = entries[buffer_tail_ & (BUFFER_COUNT - 1)];
+  entry.addr = reinterpret_cast<uint64_t>(buffers_.get() + size_t {id} * BUFFER_SIZE);
+  entry.len = BUFFER_SIZE;
+  entry.bid = id;
+  buffer_tail_++;
+  __atomic_store_n(&ring->tail, buffer_tail_, __ATOMIC_RELEASE);
+}
+
+const uint8_t *UringBackend::buffer(uint16_t id) const {
+  return buffers_.get() + size_t {id} * BUFFER_SIZE;
+}
+
+#endif
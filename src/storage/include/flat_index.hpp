@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <optional>
+#include <vector>
+
+namespace storage {
+
+// Open-addressing hash index from keys to positions in an array the caller owns. Slots hold the
+// full hash next to the position and are probed linearly, so a lookup scans one contiguous block
+// and only looks at the owner's array when hashes match. Copying the index along with the array
+// keeps both valid, since nothing points into the array.
+template <typename Key, typename Hash = std::hash<Key>> class FlatIndex {
+public:
+  // Position of `key`, comparing candidates through `key_at(position)`
+  template <typename KeyAt>
+  [[nodiscard]] std::optional<uint32_t> find(const Key &key, KeyAt &&key_at) const {
+    if (slots_.empty()) {
+      return std::nullopt;
+    }
+    uint64_t hash = Hash {}(key);
+    for (size_t i = hash & mask(); slots_[i].position != EMPTY; i = (i + 1) & mask()) {
+      if (slots_[i].hash == hash && key_at(slots_[i].position) == key) {
+        return slots_[i].position;
+      }
+    }
+    return std::nullopt;
+  }
+
+  // Add a key that is not in the index yet
+  void insert(const Key &key, uint32_t position) {
+    if ((size_ + 1) * 2 > slots_.size()) {
+      grow();
+    }
+    place({Hash {}(key), position});
+    size_++;
+  }
+
+  void clear() {
+    slots_.clear();
+    size_ = 0;
+  }
+
+  [[nodiscard]] size_t size() const { return size_; }
+
+private:
+  struct Slot {
+    uint64_t hash;
+    uint32_t position;
+  };
+
+  static constexpr uint32_t EMPTY = std::numeric_limits<uint32_t>::max();
+  static constexpr size_t MIN_SLOTS = 16;
+
+  [[nodiscard]] size_t mask() const { return slots_.size() - 1; }
+
+  void place(Slot slot) {
+    size_t i = slot.hash & mask();
+    while (slots_[i].position != EMPTY) {
+      i = (i + 1) & mask();
+    }
+    slots_[i] = slot;
+  }
+
+  // Double the table, keeping the load factor at or below one half
+  void grow() {
+    std::vector<Slot> old(std::max(slots_.size() * 2, MIN_SLOTS), Slot {0, EMPTY});
+    old.swap(slots_);
+    for (const auto &slot : old) {
+      if (slot.position != EMPTY) {
+        place(slot);
+      }
+    }
+  }
+
+  std::vector<Slot> slots_;
+  size_t size_ {0};
+};
+
+} // namespace storage
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "log/log_store.hpp"
+#include "log/log_writer.hpp"
 #include "metadata/metadata_store.hpp"
 #include "storage_service.hpp"
 #include "storage_types.hpp"
@@ -10,23 +11,34 @@ namespace storage::internal {
 
 class StorageServiceImpl : public IStorageService {
 public:
-  explicit StorageServiceImpl(std::string base_path);
+  explicit StorageServiceImpl(std::string base_path, FsyncPolicy fsync_policy = {});
 
-  std::expected<ClusterSnapshot, StorageError> loadClusterSnapshot() override;
+  std::expected<std::shared_ptr<const ClusterSnapshot>, StorageError>
+  loadClusterSnapshot() override;
 
-  std::optional<TopicInfo> findTopicByName(const ClusterSnapshot &snapshot,
-                                           const std::string &name) const override;
+  const TopicInfo *findTopicByName(const ClusterSnapshot &snapshot,
+                                   std::string_view name) const override;
 
-  std::optional<TopicInfo> findTopicById(const ClusterSnapshot &snapshot,
-                                         TopicId id) const override;
+  const TopicInfo *findTopicById(const ClusterSnapshot &snapshot, TopicId id) const override;
 
   std::expected<PartitionData, StorageError> readPartitionData(const std::string &topic_name,
                                                                int32_t partition_id) override;
 
+  void appendRecords(const std::string &topic_name, int32_t partition_id,
+                     std::vector<uint8_t> records, AppendCallback done) override;
+
+  void stop() override;
+
+  std::expected<PartitionRange, StorageError> readPartitionRange(const std::string &topic_name,
+                                                                 int32_t partition_id,
+                                                                 int64_t fetch_offset,
+                                                                 uint64_t max_bytes) override;
+
 private:
   io::PathResolver path_resolver_;
   metadata::MetadataStore metadata_store_;
   log::LogStore log_store_;
+  log::LogWriter log_writer_;
 };
 
 } // namespace storage::internal
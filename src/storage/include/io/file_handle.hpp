@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstdint>
+#include <fcntl.h>
+#include <string>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace storage::io {
+
+// File descriptor shared by everything that still refers to bytes of the file. Read-only unless
+// other open flags are given.
+class FileHandle {
+public:
+  explicit FileHandle(const std::string &path) : fd_(::open(path.c_str(), O_RDONLY | O_CLOEXEC)) {}
+  FileHandle(const std::string &path, int flags, mode_t mode = 0644)
+      : fd_(::open(path.c_str(), flags | O_CLOEXEC, mode)) {}
+  ~FileHandle() {
+    if (fd_ >= 0) {
+      ::close(fd_);
+    }
+  }
+
+  FileHandle(const FileHandle &) = delete;
+  FileHandle &operator=(const FileHandle &) = delete;
+
+  [[nodiscard]] int get() const { return fd_; }
+  [[nodiscard]] bool valid() const { return fd_ >= 0; }
+
+  [[nodiscard]] uint64_t size() const {
+    struct stat st {};
+    if (fstat(fd_, &st) != 0) {
+      return 0;
+    }
+    return static_cast<uint64_t>(st.st_size);
+  }
+
+  // False once `path` names a different file than the one open, e.g. after another was renamed
+  // over it. A path that is gone still counts as this file.
+  [[nodiscard]] bool refersTo(const std::string &path) const {
+    struct stat opened {};
+    struct stat named {};
+    if (fstat(fd_, &opened) != 0 || ::stat(path.c_str(), &named) != 0) {
+      return true;
+    }
+    return opened.st_ino == named.st_ino && opened.st_dev == named.st_dev;
+  }
+
+  // Force written data to stable storage
+  bool sync() const {
+#if defined(__linux__)
+    return ::fdatasync(fd_) == 0;
+#else
+    return ::fsync(fd_) == 0;
+#endif
+  }
+
+private:
+  int fd_;
+};
+
+} // namespace storage::io
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "io/file_handle.hpp"
+#include <cstdint>
+#include <span>
+
+namespace storage::io {
+
+// Read-only shared mapping of the first bytes of a file. Logs only grow, so the mapping grows
+// with them through map(); spans handed out earlier are invalid once it has moved.
+class MappedFile {
+public:
+  enum class Access {
+    Normal,
+    Sequential, // read once front to back: read ahead aggressively, drop pages behind
+    WillNeed,   // start reading the range in now
+  };
+
+  MappedFile() = default;
+  ~MappedFile();
+
+  MappedFile(MappedFile &&other) noexcept;
+  MappedFile &operator=(MappedFile &&other) noexcept;
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+
+  // Map the first `size` bytes of `file`, moving the existing mapping if there is one. Returns
+  // false and keeps the old mapping if the new one cannot be made.
+  bool map(const FileHandle &file, uint64_t size);
+
+  [[nodiscard]] std::span<const uint8_t> bytes() const { return {data_, size_}; }
+  [[nodiscard]] uint64_t size() const { return size_; }
+
+  // Hint how `length` bytes from `offset` are about to be read; the whole mapping by default
+  void advise(Access access, uint64_t offset = 0, uint64_t length = UINT64_MAX) const;
+
+private:
+  void unmap();
+
+  const uint8_t *data_ {nullptr};
+  uint64_t size_ {0};
+};
+
+} // namespace storage::io
@@ -1,19 +1,34 @@
 #pragma once
 
+#include <cstdint>
+#include <optional>
 #include <string>
 
 namespace storage::io {
 
+// Maps topics and partitions to files in the log directory. A partition is a directory of
+// segment files, each named after the first offset it holds, zero-padded to 20 digits.
 class PathResolver {
 public:
   explicit PathResolver(std::string base_path) : base_path_(std::move(base_path)) {}
 
   std::string clusterMetadataPath() const;
+  std::string partitionDir(const std::string &topic_name, int32_t partition_id) const;
+  std::string segmentLogPath(const std::string &topic_name, int32_t partition_id,
+                             int64_t base_offset) const;
+
+  // First segment of the partition
   std::string partitionLogPath(const std::string &topic_name, int32_t partition_id) const;
 
+  static std::string segmentFileName(int64_t base_offset);
+
+  // Base offset encoded in a segment file name, or nullopt for any other file
+  static std::optional<int64_t> parseSegmentFileName(const std::string &file_name);
+
 private:
   std::string base_path_;
-  static constexpr const char *LOG_FILE = "00000000000000000000.log";
+  static constexpr const char *LOG_SUFFIX = ".log";
+  static constexpr size_t OFFSET_DIGITS = 20;
 };
 
 } // namespace storage::io
@@ -0,0 +1,31 @@
+#pragma once
+
+#include "storage_error.hpp"
+#include <cstdint>
+#include <expected>
+#include <optional>
+#include <span>
+#include <vector>
+
+namespace storage::log {
+
+// Leading fields of a record batch, enough to place it in the log without reading its records
+struct BatchHeader {
+  static constexpr uint64_t LOG_OVERHEAD = 12; // base_offset + batch_length
+  static constexpr uint64_t SIZE = 27;         // ... through last_offset_delta
+  static constexpr uint64_t MIN_BATCH_SIZE = 61; // header of a v2 batch, before its records
+
+  int64_t base_offset {0};
+  int64_t last_offset {0};
+  uint64_t size {0}; // whole batch, LOG_OVERHEAD included
+};
+
+// Header of the batch at `position`, or nullopt if the batch is not entirely inside `log`
+std::optional<BatchHeader> readBatchHeader(std::span<const uint8_t> log, uint64_t position);
+
+// Split produced records into batches, checking framing, magic and CRC-32C of each one. Offsets in
+// the returned headers are as sent by the client, relative to a base offset the log assigns.
+std::expected<std::vector<BatchHeader>, StorageError>
+validateBatches(std::span<const uint8_t> records);
+
+} // namespace storage::log
@@ -1,22 +1,113 @@
 #pragma once
 
+#include "io/file_handle.hpp"
+#include "io/mapped_file.hpp"
 #include "io/path_resolver.hpp"
+#include "log/batch_header.hpp"
+#include "log/offset_index.hpp"
 #include "storage_error.hpp"
 #include "storage_types.hpp"
 #include <expected>
-#include <fstream>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <vector>
 
 namespace storage::log {
 
+// Record batches that passed validateBatches, ready to be given offsets
+struct ValidatedRecords {
+  std::vector<uint8_t> bytes;
+  std::vector<BatchHeader> batches;
+};
+
 class LogStore {
 public:
-  explicit LogStore(io::PathResolver resolver);
+  static constexpr uint64_t DEFAULT_SEGMENT_BYTES = 1024 * 1024 * 1024;
+
+  explicit LogStore(io::PathResolver resolver, uint64_t segment_bytes = DEFAULT_SEGMENT_BYTES);
+
+  // Validate produced record batches and append them to the partition, assigning offsets from
+  // the log end. Rolls to a new segment first when the active one would pass segment_bytes.
+  std::expected<AppendResult, StorageError> append(const std::string &topic_name,
+                                                   int32_t partition_id,
+                                                   std::vector<uint8_t> records);
+
+  // Outcome of appendGroup: one result per record set written, in order, and the segment files
+  // written. If the group stopped early, `error` says why the record sets after those failed.
+  struct GroupAppend {
+    std::vector<AppendResult> results;
+    std::vector<std::shared_ptr<io::FileHandle>> files;
+    std::optional<StorageError> error;
+  };
+
+  // Append record sets from several producers back to back, with one vectored write per segment
+  // touched. Nothing is synced; callers decide when to sync the returned files.
+  std::expected<GroupAppend, StorageError> appendGroup(const std::string &topic_name,
+                                                       int32_t partition_id,
+                                                       std::span<ValidatedRecords> record_sets);
 
   std::expected<PartitionData, StorageError> readPartition(const std::string &topic_name,
                                                            int32_t partition_id);
 
+  // Whole batches from the one holding `fetch_offset` on, stopping before `max_bytes` would be
+  // exceeded. Reads continue into later segments; a batch still being appended is left out.
+  std::expected<PartitionRange, StorageError> readPartitionRange(const std::string &topic_name,
+                                                                 int32_t partition_id,
+                                                                 int64_t fetch_offset,
+                                                                 uint64_t max_bytes);
+
 private:
+  // One segment file, mapped, and its index; only the last segment of a partition still grows
+  struct Segment {
+    int64_t base_offset {0};
+    std::shared_ptr<io::FileHandle> file;
+    OffsetIndex index;
+    std::shared_ptr<io::FileHandle> writer; // opened on the active segment by the first append
+    io::MappedFile mapped;                  // batch headers are read from here, never copied
+
+    // Map and index what was appended since the last call
+    void refresh();
+    [[nodiscard]] int64_t nextOffset() const {
+      return index.empty() ? base_offset : index.nextOffset();
+    }
+  };
+
+  // Segments ordered by base offset, kept between fetches so each one only indexes new batches.
+  // The directory is listed again only when its mtime changes, i.e. a segment was rolled or
+  // removed by retention.
+  struct PartitionLog {
+    std::mutex mutex;
+    std::vector<Segment> segments;
+    std::filesystem::file_time_type dir_mtime {};
+  };
+
+  PartitionLog &partitionLog(const std::string &dir);
+  static void refreshSegments(PartitionLog &log, const std::string &dir);
+
+  // Start a new, empty segment at `base_offset` and make it the active one
+  static std::expected<void, StorageError> rollSegment(PartitionLog &log, const std::string &dir,
+                                                       int64_t base_offset);
+
+  // Writable handle on the active segment, dropping any partially written batch at its end
+  static std::expected<void, StorageError> openWriter(Segment &segment, const std::string &dir);
+
+  // Segment that holds `offset`: the last one whose base offset is not after it
+  static size_t segmentFor(const PartitionLog &log, int64_t offset);
+
+  // Add batches of `segment` from `fetch_offset` on within `remaining` bytes. Returns false once
+  // the byte limit stopped the read.
+  static bool appendSegmentRange(Segment &segment, int64_t fetch_offset, uint64_t &remaining,
+                                 PartitionRange &range);
+
   io::PathResolver resolver_;
+  uint64_t segment_bytes_;
+  std::mutex partitions_mutex_;
+  std::unordered_map<std::string, std::unique_ptr<PartitionLog>> partitions_;
 };
 
 } // namespace storage::log
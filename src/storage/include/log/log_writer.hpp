@@ -0,0 +1,104 @@
+#pragma once
+
+#include "io/file_handle.hpp"
+#include "log/log_store.hpp"
+#include "storage_error.hpp"
+#include "storage_types.hpp"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <expected>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace storage::log {
+
+// Group commit for produced records. Callers on any thread queue validated batches without
+// waiting; one writer thread takes everything queued for a partition, writes it with a single
+// pwritev(2) and syncs as the FsyncPolicy says. A caller hears back once its records are
+// acknowledged:
+//   EveryBatch  after the fsync that follows the write
+//   Interval    after the next periodic fsync, at most `interval` after the write
+//   Bytes, Os   after the write; Bytes also syncs once `bytes` unsynced bytes have piled up
+class LogWriter {
+public:
+  explicit LogWriter(LogStore &store, FsyncPolicy policy = {});
+
+  // Writes and syncs whatever is still queued, then stops the writer thread
+  ~LogWriter();
+
+  LogWriter(const LogWriter &) = delete;
+  LogWriter &operator=(const LogWriter &) = delete;
+
+  // Receives the outcome of one append on the writer thread, or on the calling thread when the
+  // records are rejected before they are queued. It must not block the writer.
+  using Acknowledge = std::function<void(std::expected<AppendResult, StorageError>)>;
+
+  // Validate `records` on the calling thread and queue them; `done` runs once they are
+  // acknowledged
+  void append(const std::string &topic_name, int32_t partition_id, std::vector<uint8_t> records,
+              Acknowledge done);
+
+  // Same, waiting for the acknowledgement
+  std::expected<AppendResult, StorageError> append(const std::string &topic_name,
+                                                   int32_t partition_id,
+                                                   std::vector<uint8_t> records);
+
+  // Write, sync and acknowledge whatever is still queued, then stop the writer thread. Later
+  // appends fail. Call it from the thread that owns the writer.
+  void stop();
+
+  // Group writes and syncs issued so far
+  [[nodiscard]] uint64_t writeCount() const { return writes_.load(std::memory_order_relaxed); }
+  [[nodiscard]] uint64_t syncCount() const { return syncs_.load(std::memory_order_relaxed); }
+
+private:
+  struct Pending {
+    std::string topic_name;
+    int32_t partition_id;
+    ValidatedRecords records;
+    Acknowledge done;
+  };
+
+  struct Unacked {
+    Acknowledge done;
+    AppendResult result;
+  };
+
+  void run();
+
+  // Write queued appends partition by partition, in arrival order within each partition
+  void writeQueued(std::vector<Pending> queued);
+
+  [[nodiscard]] bool syncDue() const;
+
+  // Sync every file written since the last sync. Returns false if any sync failed.
+  bool sync();
+
+  // Complete every written append, with an error when the sync covering it failed
+  void acknowledge(bool synced);
+
+  LogStore &store_;
+  FsyncPolicy policy_;
+
+  std::mutex mutex_;
+  std::condition_variable wake_;
+  std::vector<Pending> queue_;
+  bool stopping_ {false};
+
+  // Writer thread only
+  std::vector<std::shared_ptr<io::FileHandle>> unsynced_files_;
+  std::vector<Unacked> unacked_;
+  uint64_t unsynced_bytes_ {0};
+  std::chrono::steady_clock::time_point last_sync_ {std::chrono::steady_clock::now()};
+
+  std::atomic<uint64_t> writes_ {0};
+  std::atomic<uint64_t> syncs_ {0};
+  std::thread thread_;
+};
+
+} // namespace storage::log
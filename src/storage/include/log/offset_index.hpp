@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace storage::log {
+
+// Sparse map from batch base offsets to file positions, the in-memory counterpart of Kafka's
+// .index files. One entry is kept per INDEX_INTERVAL_BYTES of log, so a lookup lands at most
+// that many bytes before the wanted batch. Built from batch headers and extended as the log grows.
+class OffsetIndex {
+public:
+  static constexpr uint64_t INDEX_INTERVAL_BYTES = 4096;
+
+  struct Entry {
+    int64_t offset;
+    uint64_t position;
+  };
+
+  // Index batches appended to `segment` since the last call; stops before a partially written
+  // batch
+  void extend(std::span<const uint8_t> segment);
+
+  // Position of the last indexed batch whose base offset is at or before `offset`
+  [[nodiscard]] uint64_t lookup(int64_t offset) const;
+
+  [[nodiscard]] bool empty() const { return entries_.empty(); }
+  [[nodiscard]] int64_t startOffset() const { return start_offset_; }
+  [[nodiscard]] int64_t nextOffset() const { return next_offset_; }
+
+  // End of the last complete batch
+  [[nodiscard]] uint64_t endPosition() const { return end_position_; }
+
+  [[nodiscard]] const std::vector<Entry> &entries() const { return entries_; }
+
+private:
+  std::vector<Entry> entries_;
+  uint64_t end_position_ {0};
+  uint64_t bytes_since_entry_ {0};
+  int64_t start_offset_ {0};
+  int64_t next_offset_ {0};
+};
+
+} // namespace storage::log
@@ -0,0 +1,33 @@
+#pragma once
+
+#include "log/batch_header.hpp"
+#include <cstdint>
+#include <optional>
+#include <span>
+
+namespace storage::log {
+
+// Walks the record batches of a mapped log segment, handing out views of the mapped bytes
+class SegmentReader {
+public:
+  struct Batch {
+    BatchHeader header;
+    uint64_t position {0};
+    std::span<const uint8_t> bytes; // the whole batch, LOG_OVERHEAD included
+  };
+
+  explicit SegmentReader(std::span<const uint8_t> segment, uint64_t position = 0)
+      : segment_(segment), position_(position) {}
+
+  // The next complete batch; nullopt at the end of the segment or at a batch still being written
+  std::optional<Batch> next();
+
+  // Where the next batch starts, i.e. the end of the last one returned
+  [[nodiscard]] uint64_t position() const { return position_; }
+
+private:
+  std::span<const uint8_t> segment_;
+  uint64_t position_;
+};
+
+} // namespace storage::log
@@ -1,21 +1,53 @@
 #pragma once
 
+#include "io/file_handle.hpp"
+#include "io/mapped_file.hpp"
 #include "io/path_resolver.hpp"
 #include "storage_error.hpp"
 #include "storage_types.hpp"
+#include <atomic>
+#include <chrono>
 #include <expected>
-#include <fstream>
+#include <memory>
+#include <mutex>
+#include <span>
 
 namespace storage::metadata {
 
+// Keeps the cluster metadata in memory and follows the metadata log as it grows. New batches are
+// applied to a copy of the current snapshot which is then published, so readers holding the old
+// one are never affected and never wait for a refresh in progress. The log is looked at no more
+// than once per `check_interval`; in between readers get the published snapshot without a
+// system call.
 class MetadataStore {
 public:
-  explicit MetadataStore(io::PathResolver resolver);
+  static constexpr std::chrono::milliseconds DEFAULT_CHECK_INTERVAL {100};
 
-  std::expected<ClusterSnapshot, StorageError> loadClusterSnapshot();
+  explicit MetadataStore(io::PathResolver resolver,
+                         std::chrono::milliseconds check_interval = DEFAULT_CHECK_INTERVAL);
+
+  std::expected<std::shared_ptr<const ClusterSnapshot>, StorageError> loadClusterSnapshot();
 
 private:
+  // Apply batches appended since the last call. Caller holds refresh_mutex_.
+  std::expected<void, StorageError> tail();
+
+  static void applyRecord(ClusterSnapshot &snapshot, std::span<const uint8_t> value);
+
   io::PathResolver resolver_;
+  std::atomic<std::shared_ptr<const ClusterSnapshot>> snapshot_;
+
+  const std::chrono::milliseconds check_interval_;
+  std::atomic<std::chrono::steady_clock::time_point> next_check_ {};
+
+  std::mutex refresh_mutex_;
+  std::unique_ptr<io::FileHandle> file_;
+  io::MappedFile mapped_;
+  uint64_t consumed_ {0}; // end of the last applied batch in the metadata log
+  // The log was replaced or truncated: the next snapshot is built from empty, not on top of the
+  // published one, even when an earlier attempt failed halfway
+  bool rebuild_ {false};
+
   static constexpr uint8_t TOPIC_RECORD = 0x02;
   static constexpr uint8_t PARTITION_RECORD = 0x03;
 };
@@ -10,6 +10,8 @@ enum class ErrorCode {
   DecodeError,
   IoError,
   InvalidPath,
+  OffsetOutOfRange,
+  CorruptMessage,
 };
 
 class StorageError : public std::runtime_error {
@@ -30,6 +32,10 @@ private:
       return "I/O error";
     case ErrorCode::InvalidPath:
       return "Invalid path";
+    case ErrorCode::OffsetOutOfRange:
+      return "Offset out of range";
+    case ErrorCode::CorruptMessage:
+      return "Corrupt message";
     default:
       return "Unknown storage error";
     }
@@ -3,9 +3,12 @@
 #include "storage_error.hpp"
 #include "storage_types.hpp"
 #include <expected>
+#include <functional>
 #include <memory>
 #include <optional>
 #include <string>
+#include <string_view>
+#include <vector>
 
 namespace storage {
 
@@ -13,22 +16,43 @@ class IStorageService {
 public:
   virtual ~IStorageService() = default;
 
-  // Load full cluster metadata snapshot
-  virtual std::expected<ClusterSnapshot, StorageError> loadClusterSnapshot() = 0;
+  // Current cluster metadata. The snapshot is immutable and stays valid for as long as the
+  // caller holds it; metadata changes are published as new snapshots.
+  virtual std::expected<std::shared_ptr<const ClusterSnapshot>, StorageError>
+  loadClusterSnapshot() = 0;
 
-  // Lookup topic by name (from snapshot)
-  virtual std::optional<TopicInfo> findTopicByName(const ClusterSnapshot &snapshot,
-                                                   const std::string &name) const = 0;
+  // Lookup topic by name (from snapshot); the result lives as long as the snapshot
+  virtual const TopicInfo *findTopicByName(const ClusterSnapshot &snapshot,
+                                           std::string_view name) const = 0;
 
-  // Lookup topic by id (from snapshot)
-  virtual std::optional<TopicInfo> findTopicById(const ClusterSnapshot &snapshot,
-                                                 TopicId id) const = 0;
+  // Lookup topic by id (from snapshot); the result lives as long as the snapshot
+  virtual const TopicInfo *findTopicById(const ClusterSnapshot &snapshot, TopicId id) const = 0;
 
   // Read partition log data (raw record batches)
   virtual std::expected<PartitionData, StorageError>
   readPartitionData(const std::string &topic_name, int32_t partition_id) = 0;
+
+  // Outcome of one append. Runs on the storage's writer thread, or on the calling thread when
+  // the records are rejected up front, so it must not block.
+  using AppendCallback = std::function<void(std::expected<AppendResult, StorageError>)>;
+
+  // Append produced record batches (Kafka v2 format) to a partition log without waiting; `done`
+  // runs once the records are acknowledged under the service's FsyncPolicy
+  virtual void appendRecords(const std::string &topic_name, int32_t partition_id,
+                             std::vector<uint8_t> records, AppendCallback done) = 0;
+
+  // Acknowledge every append still in flight, then fail later ones. Owners stop the service
+  // while whatever the callbacks hand work to is still alive.
+  virtual void stop() = 0;
+
+  // Locate the batches from `fetch_offset` on, up to about `max_bytes`, without reading them.
+  // The batch holding `fetch_offset` is always included, even if it alone exceeds `max_bytes`.
+  virtual std::expected<PartitionRange, StorageError>
+  readPartitionRange(const std::string &topic_name, int32_t partition_id, int64_t fetch_offset,
+                     uint64_t max_bytes) = 0;
 };
 
-std::unique_ptr<IStorageService> createStorageService(std::string base_path);
+std::unique_ptr<IStorageService> createStorageService(std::string base_path,
+                                                     FsyncPolicy fsync_policy = {});
 
 } // namespace storage
@@ -1,14 +1,23 @@
 #pragma once
 
+#include "flat_index.hpp"
+#include "shared_bytes.hpp"
+#include <chrono>
 #include <cstdint>
-#include <map>
+#include <memory>
 #include <string>
+#include <string_view>
+#include <utility>
 #include <vector>
 
 using uint128_t = __uint128_t;
 
 namespace storage {
 
+namespace io {
+class FileHandle;
+}
+
 struct TopicId {
   uint128_t value {0};
   bool operator==(const TopicId &o) const { return value == o.value; }
@@ -31,14 +40,101 @@ struct TopicInfo {
   std::vector<PartitionInfo> partitions;
 };
 
-struct ClusterSnapshot {
-  std::map<TopicId, TopicInfo> topics_by_id;
+struct TopicIdHash {
+  uint64_t operator()(TopicId id) const {
+    // Fold the two halves, then mix so every bit of the UUID reaches the low bits
+    uint64_t x = static_cast<uint64_t>(id.value >> 64) ^ static_cast<uint64_t>(id.value);
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+  }
+};
+
+// Topics known to the cluster, with hash indexes by id and by name. Published snapshots are never
+// modified; the metadata store applies changes to a copy.
+class ClusterSnapshot {
+public:
+  [[nodiscard]] const std::vector<TopicInfo> &topics() const { return topics_; }
+
+  [[nodiscard]] const TopicInfo *findById(TopicId id) const {
+    auto pos = by_id_.find(id, [this](uint32_t p) { return topics_[p].topic_id; });
+    return pos ? &topics_[*pos] : nullptr;
+  }
+
+  [[nodiscard]] const TopicInfo *findByName(std::string_view name) const {
+    auto pos =
+        by_name_.find(name, [this](uint32_t p) { return std::string_view(topics_[p].name); });
+    return pos ? &topics_[*pos] : nullptr;
+  }
+
+  TopicInfo *findById(TopicId id) {
+    return const_cast<TopicInfo *>(std::as_const(*this).findById(id));
+  }
+
+  // Add a topic or rename an existing one; its partitions are kept
+  TopicInfo &upsertTopic(TopicId id, std::string name) {
+    if (auto *topic = findById(id)) {
+      if (topic->name != name) {
+        topic->name = std::move(name);
+        reindexNames();
+      }
+      return *topic;
+    }
+
+    auto pos = static_cast<uint32_t>(topics_.size());
+    topics_.push_back(TopicInfo {id, std::move(name), {}});
+    by_id_.insert(id, pos);
+    by_name_.insert(topics_.back().name, pos);
+    return topics_.back();
+  }
+
+private:
+  void reindexNames() {
+    by_name_.clear();
+    for (uint32_t pos = 0; pos < topics_.size(); pos++) {
+      by_name_.insert(topics_[pos].name, pos);
+    }
+  }
+
+  std::vector<TopicInfo> topics_;
+  FlatIndex<TopicId, TopicIdHash> by_id_;
+  FlatIndex<std::string_view> by_name_;
 };
 
-// Raw bytes for one record batch (Kafka log format); used by fetch response
-using RecordBatchBytes = std::vector<uint8_t>;
+// Raw bytes for one record batch (Kafka log format), viewed in place where they were read
+using RecordBatchBytes = common::SharedBytes;
 
 // All record batches for a partition
 using PartitionData = std::vector<RecordBatchBytes>;
 
+// Byte range of whole record batches in a log file, for sending without copying
+struct FileRegion {
+  std::shared_ptr<io::FileHandle> file;
+  uint64_t offset {0};
+  uint64_t length {0};
+};
+
+// Where an append landed in the partition
+struct AppendResult {
+  int64_t base_offset {0};
+  int64_t log_start_offset {0};
+};
+
+// When appended records are forced to disk with fsync(2). Os leaves write-back to the kernel,
+// like Kafka's defaults; see log::LogWriter for when producers are acknowledged under each mode.
+struct FsyncPolicy {
+  enum class Mode { EveryBatch, Interval, Bytes, Os };
+
+  Mode mode {Mode::Os};
+  std::chrono::milliseconds interval {1000}; // Interval: longest time between syncs
+  uint64_t bytes {1024 * 1024};              // Bytes: unsynced bytes that trigger a sync
+};
+
+// Batches a fetch should return, with the partition's offset bounds at the time of the read
+struct PartitionRange {
+  std::vector<FileRegion> regions;
+  int64_t log_start_offset {0};
+  int64_t high_watermark {0};
+};
+
 } // namespace storage
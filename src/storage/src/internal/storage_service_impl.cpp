@@ -1,33 +1,24 @@
 #include "internal/storage_service_impl.hpp"
-#include <algorithm>
 
 namespace storage::internal {
 
-StorageServiceImpl::StorageServiceImpl(std::string base_path)
+StorageServiceImpl::StorageServiceImpl(std::string base_path, FsyncPolicy fsync_policy)
     : path_resolver_(std::move(base_path)), metadata_store_(path_resolver_),
-      log_store_(path_resolver_) {}
+      log_store_(path_resolver_), log_writer_(log_store_, fsync_policy) {}
 
-std::expected<ClusterSnapshot, StorageError> StorageServiceImpl::loadClusterSnapshot() {
+std::expected<std::shared_ptr<const ClusterSnapshot>, StorageError>
+StorageServiceImpl::loadClusterSnapshot() {
   return metadata_store_.loadClusterSnapshot();
 }
 
-std::optional<TopicInfo> StorageServiceImpl::findTopicByName(const ClusterSnapshot &snapshot,
-                                                             const std::string &name) const {
-  auto it = std::find_if(snapshot.topics_by_id.begin(), snapshot.topics_by_id.end(),
-                         [&name](const auto &p) { return p.second.name == name; });
-  if (it != snapshot.topics_by_id.end()) {
-    return it->second;
-  }
-  return std::nullopt;
+const TopicInfo *StorageServiceImpl::findTopicByName(const ClusterSnapshot &snapshot,
+                                                     std::string_view name) const {
+  return snapshot.findByName(name);
 }
 
-std::optional<TopicInfo> StorageServiceImpl::findTopicById(const ClusterSnapshot &snapshot,
-                                                           TopicId id) const {
-  auto it = snapshot.topics_by_id.find(id);
-  if (it != snapshot.topics_by_id.end()) {
-    return it->second;
-  }
-  return std::nullopt;
+const TopicInfo *StorageServiceImpl::findTopicById(const ClusterSnapshot &snapshot,
+                                                   TopicId id) const {
+  return snapshot.findById(id);
 }
 
 std::expected<PartitionData, StorageError>
@@ -35,4 +26,17 @@ StorageServiceImpl::readPartitionData(const std::string &topic_name, int32_t par
   return log_store_.readPartition(topic_name, partition_id);
 }
 
+void StorageServiceImpl::appendRecords(const std::string &topic_name, int32_t partition_id,
+                                       std::vector<uint8_t> records, AppendCallback done) {
+  log_writer_.append(topic_name, partition_id, std::move(records), std::move(done));
+}
+
+void StorageServiceImpl::stop() { log_writer_.stop(); }
+
+std::expected<PartitionRange, StorageError>
+StorageServiceImpl::readPartitionRange(const std::string &topic_name, int32_t partition_id,
+                                       int64_t fetch_offset, uint64_t max_bytes) {
+  return log_store_.readPartitionRange(topic_name, partition_id, fetch_offset, max_bytes);
+}
+
 } // namespace storage::internal
@@ -0,0 +1,77 @@
+#include "io/mapped_file.hpp"
+#include <algorithm>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <utility>
+
+namespace storage::io {
+
+MappedFile::~MappedFile() { unmap(); }
+
+MappedFile::MappedFile(MappedFile &&other) noexcept
+    : data_(std::exchange(other.data_, nullptr)), size_(std::exchange(other.size_, 0)) {}
+
+MappedFile &MappedFile::operator=(MappedFile &&other) noexcept {
+  if (this != &other) {
+    unmap();
+    data_ = std::exchange(other.data_, nullptr);
+    size_ = std::exchange(other.size_, 0);
+  }
+  return *this;
+}
+
+bool MappedFile::map(const FileHandle &file, uint64_t size) {
+  if (size == size_) {
+    return true;
+  }
+  if (size == 0) {
+    unmap();
+    return true;
+  }
+
+  void *mapped = MAP_FAILED;
+#if defined(__linux__)
+  // Grow in place when the address space allows, without touching the pages already mapped
+  if (data_) {
+    mapped = mremap(const_cast<uint8_t *>(data_), size_, size, MREMAP_MAYMOVE);
+  }
+#endif
+  if (mapped == MAP_FAILED) {
+    mapped = mmap(nullptr, size, PROT_READ, MAP_SHARED, file.get(), 0);
+    if (mapped == MAP_FAILED) {
+      return false;
+    }
+    unmap();
+  }
+  data_ = static_cast<const uint8_t *>(mapped);
+  size_ = size;
+  return true;
+}
+
+void MappedFile::advise(Access access, uint64_t offset, uint64_t length) const {
+  if (!data_ || offset >= size_) {
+    return;
+  }
+  // madvise wants a page-aligned start
+  static const uint64_t page = static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+  uint64_t start = offset - offset % page;
+  uint64_t end = offset + std::min(length, size_ - offset);
+
+  int advice = MADV_NORMAL;
+  if (access == Access::Sequential) {
+    advice = MADV_SEQUENTIAL;
+  } else if (access == Access::WillNeed) {
+    advice = MADV_WILLNEED;
+  }
+  madvise(const_cast<uint8_t *>(data_) + start, end - start, advice);
+}
+
+void MappedFile::unmap() {
+  if (data_) {
+    munmap(const_cast<uint8_t *>(data_), size_);
+    data_ = nullptr;
+    size_ = 0;
+  }
+}
+
+} // namespace storage::io
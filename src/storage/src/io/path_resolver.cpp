@@ -1,14 +1,52 @@
 #include "io/path_resolver.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <limits>
 
 namespace storage::io {
 
 std::string PathResolver::clusterMetadataPath() const {
-  return base_path_ + "/__cluster_metadata-0/" + LOG_FILE;
+  return base_path_ + "/__cluster_metadata-0/" + segmentFileName(0);
+}
+
+std::string PathResolver::partitionDir(const std::string &topic_name,
+                                       int32_t partition_id) const {
+  return base_path_ + "/" + topic_name + "-" + std::to_string(partition_id);
+}
+
+std::string PathResolver::segmentLogPath(const std::string &topic_name, int32_t partition_id,
+                                         int64_t base_offset) const {
+  return partitionDir(topic_name, partition_id) + "/" + segmentFileName(base_offset);
 }
 
 std::string PathResolver::partitionLogPath(const std::string &topic_name,
                                            int32_t partition_id) const {
-  return base_path_ + "/" + topic_name + "-" + std::to_string(partition_id) + "/" + LOG_FILE;
+  return segmentLogPath(topic_name, partition_id, 0);
+}
+
+std::string PathResolver::segmentFileName(int64_t base_offset) {
+  std::string digits = std::to_string(base_offset);
+  return std::string(OFFSET_DIGITS - std::min(digits.size(), OFFSET_DIGITS), '0') + digits +
+         LOG_SUFFIX;
+}
+
+std::optional<int64_t> PathResolver::parseSegmentFileName(const std::string &file_name) {
+  size_t suffix_length = std::strlen(LOG_SUFFIX);
+  if (file_name.size() != OFFSET_DIGITS + suffix_length ||
+      file_name.compare(OFFSET_DIGITS, suffix_length, LOG_SUFFIX) != 0) {
+    return std::nullopt;
+  }
+
+  int64_t base_offset = 0;
+  for (size_t i = 0; i < OFFSET_DIGITS; i++) {
+    if (!std::isdigit(static_cast<unsigned char>(file_name[i])) ||
+        base_offset > (std::numeric_limits<int64_t>::max() - 9) / 10) {
+      return std::nullopt;
+    }
+    base_offset = base_offset * 10 + (file_name[i] - '0');
+  }
+  return base_offset;
 }
 
 } // namespace storage::io
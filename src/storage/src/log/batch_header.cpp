@@ -0,0 +1,95 @@
+#include "log/batch_header.hpp"
+#include "crc32c.hpp"
+#include <arpa/inet.h>
+#include <cstring>
+
+#if defined(__APPLE__)
+#include <libkern/OSByteOrder.h>
+#define STORAGE_be64toh(x) OSSwapBigToHostInt64(x)
+#else
+#include <endian.h>
+#define STORAGE_be64toh(x) be64toh(x)
+#endif
+
+namespace storage::log {
+
+std::optional<BatchHeader> readBatchHeader(std::span<const uint8_t> log, uint64_t position) {
+  if (position + BatchHeader::SIZE > log.size()) {
+    return std::nullopt;
+  }
+
+  const uint8_t *raw = log.data() + position;
+  uint64_t base_offset;
+  uint32_t batch_length;
+  uint32_t last_offset_delta;
+  std::memcpy(&base_offset, raw, sizeof(base_offset));
+  std::memcpy(&batch_length, raw + 8, sizeof(batch_length));
+  std::memcpy(&last_offset_delta, raw + 23, sizeof(last_offset_delta));
+
+  auto length = static_cast<int32_t>(ntohl(batch_length));
+  if (length <= 0) {
+    return std::nullopt;
+  }
+
+  BatchHeader header;
+  header.base_offset = static_cast<int64_t>(STORAGE_be64toh(base_offset));
+  header.last_offset = header.base_offset + static_cast<int32_t>(ntohl(last_offset_delta));
+  header.size = BatchHeader::LOG_OVERHEAD + static_cast<uint64_t>(length);
+  if (position + header.size > log.size()) {
+    return std::nullopt;
+  }
+  return header;
+}
+
+std::expected<std::vector<BatchHeader>, StorageError>
+validateBatches(std::span<const uint8_t> records) {
+  constexpr size_t MAGIC_OFFSET = 16;
+  constexpr size_t CRC_OFFSET = 17;
+  constexpr size_t ATTRIBUTES_OFFSET = 21;
+  constexpr uint8_t MAGIC_V2 = 2;
+
+  if (records.empty()) {
+    return std::unexpected(StorageError(ErrorCode::CorruptMessage, "No record batches"));
+  }
+
+  std::vector<BatchHeader> batches;
+  size_t pos = 0;
+  while (pos < records.size()) {
+    auto rest = records.subspan(pos);
+    if (rest.size() < BatchHeader::MIN_BATCH_SIZE) {
+      return std::unexpected(StorageError(ErrorCode::CorruptMessage, "Truncated record batch"));
+    }
+
+    uint32_t batch_length;
+    uint32_t crc;
+    uint32_t last_offset_delta;
+    std::memcpy(&batch_length, rest.data() + 8, sizeof(batch_length));
+    std::memcpy(&crc, rest.data() + CRC_OFFSET, sizeof(crc));
+    std::memcpy(&last_offset_delta, rest.data() + 23, sizeof(last_offset_delta));
+
+    uint64_t size = BatchHeader::LOG_OVERHEAD + ntohl(batch_length);
+    if (size < BatchHeader::MIN_BATCH_SIZE || size > rest.size()) {
+      return std::unexpected(StorageError(ErrorCode::CorruptMessage, "Bad record batch length"));
+    }
+    if (rest[MAGIC_OFFSET] != MAGIC_V2) {
+      return std::unexpected(StorageError(ErrorCode::CorruptMessage, "Unsupported batch magic"));
+    }
+    // The checksum covers everything from the attributes to the end of the batch
+    if (common::crc32c(rest.data() + ATTRIBUTES_OFFSET, size - ATTRIBUTES_OFFSET) != ntohl(crc)) {
+      return std::unexpected(StorageError(ErrorCode::CorruptMessage, "Record batch CRC mismatch"));
+    }
+    auto delta = static_cast<int32_t>(ntohl(last_offset_delta));
+    if (delta < 0) {
+      return std::unexpected(StorageError(ErrorCode::CorruptMessage, "Bad last offset delta"));
+    }
+
+    BatchHeader header;
+    header.last_offset = delta;
+    header.size = size;
+    batches.push_back(header);
+    pos += size;
+  }
+  return batches;
+}
+
+} // namespace storage::log
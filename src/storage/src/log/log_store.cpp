@@ -1,20 +1,362 @@
 #include "log/log_store.hpp"
-#include "log/batch_scanner.hpp"
-#include <fstream>
+#include "io/file_handle.hpp"
+#include "log/batch_header.hpp"
+#include "log/segment_reader.hpp"
+#include "trace.hpp"
+#include <algorithm>
+#include <arpa/inet.h>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <sys/uio.h>
+#include <unistd.h>
 
 namespace storage::log {
 
-LogStore::LogStore(io::PathResolver resolver) : resolver_(std::move(resolver)) {}
+LogStore::LogStore(io::PathResolver resolver, uint64_t segment_bytes)
+    : resolver_(std::move(resolver)), segment_bytes_(segment_bytes) {}
 
 std::expected<PartitionData, StorageError> LogStore::readPartition(const std::string &topic_name,
                                                                    int32_t partition_id) {
-  std::ifstream file(resolver_.partitionLogPath(topic_name, partition_id), std::ios::binary);
-  if (!file.is_open()) {
-    return PartitionData {};
+  common::trace::Span span("LogStore::readPartition");
+  auto dir = resolver_.partitionDir(topic_name, partition_id);
+  auto &log = partitionLog(dir);
+  std::vector<int64_t> base_offsets;
+  {
+    std::lock_guard lock(log.mutex);
+    refreshSegments(log, dir);
+    for (const auto &segment : log.segments) {
+      base_offsets.push_back(segment.base_offset);
+    }
   }
 
-  BatchScanner scanner(file);
-  return scanner.scanAll();
+  PartitionData batches;
+  for (int64_t base_offset : base_offsets) {
+    io::FileHandle file(resolver_.segmentLogPath(topic_name, partition_id, base_offset));
+    auto mapped = std::make_shared<io::MappedFile>();
+    if (!file.valid() || !mapped->map(file, file.size())) {
+      continue;
+    }
+    // The batches point into this mapping, which stays (unmoved) until the last of them is gone
+    mapped->advise(io::MappedFile::Access::Sequential);
+    SegmentReader reader(mapped->bytes());
+    while (auto batch = reader.next()) {
+      batches.emplace_back(batch->bytes, mapped);
+    }
+  }
+  return batches;
+}
+
+void LogStore::Segment::refresh() {
+  uint64_t indexed = index.endPosition();
+  if (!mapped.map(*file, file->size())) {
+    return;
+  }
+  // A segment indexed for the first time is read front to back
+  if (indexed == 0) {
+    mapped.advise(io::MappedFile::Access::Sequential);
+  }
+  index.extend(mapped.bytes());
+  if (indexed == 0) {
+    mapped.advise(io::MappedFile::Access::Normal);
+  }
+}
+
+LogStore::PartitionLog &LogStore::partitionLog(const std::string &dir) {
+  std::lock_guard lock(partitions_mutex_);
+  auto &log = partitions_[dir];
+  if (!log) {
+    log = std::make_unique<PartitionLog>();
+  }
+  return *log;
+}
+
+void LogStore::refreshSegments(PartitionLog &log, const std::string &dir) {
+  std::error_code ec;
+  auto mtime = std::filesystem::last_write_time(dir, ec);
+  if (ec) {
+    log.segments.clear();
+    return;
+  }
+  if (!log.segments.empty() && mtime == log.dir_mtime) {
+    return;
+  }
+  log.dir_mtime = mtime;
+
+  std::vector<int64_t> base_offsets;
+  for (const auto &entry : std::filesystem::directory_iterator(dir, ec)) {
+    if (auto base_offset = io::PathResolver::parseSegmentFileName(entry.path().filename())) {
+      base_offsets.push_back(*base_offset);
+    }
+  }
+  std::sort(base_offsets.begin(), base_offsets.end());
+
+  // Keep the indexes of segments we already know about
+  std::vector<Segment> segments;
+  segments.reserve(base_offsets.size());
+  for (int64_t base_offset : base_offsets) {
+    auto known = std::find_if(log.segments.begin(), log.segments.end(),
+                              [&](const Segment &s) { return s.base_offset == base_offset; });
+    if (known != log.segments.end()) {
+      segments.push_back(std::move(*known));
+      continue;
+    }
+
+    auto path = dir + "/" + io::PathResolver::segmentFileName(base_offset);
+    auto file = std::make_shared<io::FileHandle>(path);
+    if (file->valid()) {
+      segments.push_back(Segment {base_offset, std::move(file), {}, nullptr, {}});
+    }
+  }
+  log.segments = std::move(segments);
+}
+
+size_t LogStore::segmentFor(const PartitionLog &log, int64_t offset) {
+  auto it = std::upper_bound(
+      log.segments.begin(), log.segments.end(), offset,
+      [](int64_t value, const Segment &segment) { return value < segment.base_offset; });
+  return it == log.segments.begin() ? 0 : static_cast<size_t>(it - log.segments.begin()) - 1;
+}
+
+bool LogStore::appendSegmentRange(Segment &segment, int64_t fetch_offset, uint64_t &remaining,
+                                  PartitionRange &range) {
+  segment.refresh();
+
+  // The index lands on a batch at or before the offset; step forward to the batch holding it
+  uint64_t end = segment.index.endPosition();
+  uint64_t start = segment.index.lookup(fetch_offset);
+  auto log = segment.mapped.bytes().first(end);
+  while (auto header = readBatchHeader(log, start)) {
+    if (header->last_offset >= fetch_offset) {
+      break;
+    }
+    start += header->size;
+  }
+
+  // The very first batch of the range goes out even if it alone is over the limit
+  bool first_batch = range.regions.empty();
+  uint64_t position = start;
+  while (auto header = readBatchHeader(log, position)) {
+    bool first = first_batch && position == start;
+    if (!first && position - start + header->size > remaining) {
+      break;
+    }
+    position += header->size;
+  }
+
+  uint64_t length = position - start;
+  remaining -= std::min(length, remaining);
+  if (length > 0) {
+    range.regions.push_back(FileRegion {segment.file, start, length});
+  }
+  return position == end;
+}
+
+std::expected<PartitionRange, StorageError>
+LogStore::readPartitionRange(const std::string &topic_name, int32_t partition_id,
+                             int64_t fetch_offset, uint64_t max_bytes) {
+  common::trace::Span span("LogStore::readPartitionRange");
+  auto dir = resolver_.partitionDir(topic_name, partition_id);
+  auto &log = partitionLog(dir);
+  std::lock_guard lock(log.mutex);
+
+  refreshSegments(log, dir);
+  PartitionRange range;
+  if (log.segments.empty()) {
+    return range;
+  }
+
+  auto &active = log.segments.back();
+  active.refresh();
+  range.log_start_offset = log.segments.front().base_offset;
+  range.high_watermark = active.nextOffset();
+  if (fetch_offset == range.high_watermark) {
+    return range;
+  }
+  if (fetch_offset < range.log_start_offset || fetch_offset > range.high_watermark) {
+    return std::unexpected(StorageError(ErrorCode::OffsetOutOfRange));
+  }
+
+  uint64_t remaining = max_bytes;
+  for (size_t i = segmentFor(log, fetch_offset); i < log.segments.size(); i++) {
+    if (!appendSegmentRange(log.segments[i], fetch_offset, remaining, range)) {
+      break;
+    }
+  }
+  return range;
+}
+
+std::expected<void, StorageError> LogStore::rollSegment(PartitionLog &log, const std::string &dir,
+                                                       int64_t base_offset) {
+  auto path = dir + "/" + io::PathResolver::segmentFileName(base_offset);
+  auto writer = std::make_shared<io::FileHandle>(path, O_WRONLY | O_CREAT);
+  auto file = std::make_shared<io::FileHandle>(path);
+  if (!writer->valid() || !file->valid()) {
+    return std::unexpected(StorageError(ErrorCode::IoError, "Failed to create segment " + path));
+  }
+
+  log.segments.push_back(Segment {base_offset, std::move(file), {}, std::move(writer), {}});
+  return {};
+}
+
+std::expected<void, StorageError> LogStore::openWriter(Segment &segment, const std::string &dir) {
+  auto path = dir + "/" + io::PathResolver::segmentFileName(segment.base_offset);
+  segment.writer = std::make_shared<io::FileHandle>(path, O_WRONLY);
+  if (!segment.writer->valid()) {
+    segment.writer.reset();
+    return std::unexpected(StorageError(ErrorCode::IoError, "Failed to open segment " + path));
+  }
+
+  segment.refresh();
+  if (segment.file->size() > segment.index.endPosition() &&
+      ftruncate(segment.writer->get(), static_cast<off_t>(segment.index.endPosition())) != 0) {
+    return std::unexpected(StorageError(ErrorCode::IoError, "Failed to truncate " + path));
+  }
+  return {};
+}
+
+std::expected<AppendResult, StorageError> LogStore::append(const std::string &topic_name,
+                                                          int32_t partition_id,
+                                                          std::vector<uint8_t> records) {
+  auto batches = validateBatches(records);
+  if (!batches) {
+    return std::unexpected(batches.error());
+  }
+
+  ValidatedRecords record_set {std::move(records), std::move(*batches)};
+  auto group = appendGroup(topic_name, partition_id, std::span(&record_set, 1));
+  if (!group) {
+    return std::unexpected(group.error());
+  }
+  if (group->error) {
+    return std::unexpected(*group->error);
+  }
+  return group->results.front();
+}
+
+// pwritev(2) all of `iov` at `position`, resuming after short writes
+static bool writeAll(int fd, std::vector<iovec> &iov, uint64_t position) {
+  size_t first = 0;
+  while (first < iov.size()) {
+    int count = static_cast<int>(std::min<size_t>(iov.size() - first, IOV_MAX));
+    ssize_t n = pwritev(fd, iov.data() + first, count, static_cast<off_t>(position));
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n <= 0) {
+      return false;
+    }
+
+    position += static_cast<uint64_t>(n);
+    auto written = static_cast<size_t>(n);
+    while (first < iov.size() && written >= iov[first].iov_len) {
+      written -= iov[first].iov_len;
+      first++;
+    }
+    if (written > 0) {
+      iov[first].iov_base = static_cast<char *>(iov[first].iov_base) + written;
+      iov[first].iov_len -= written;
+    }
+  }
+  return true;
+}
+
+std::expected<LogStore::GroupAppend, StorageError>
+LogStore::appendGroup(const std::string &topic_name, int32_t partition_id,
+                      std::span<ValidatedRecords> record_sets) {
+  common::trace::Span span("LogStore::appendGroup");
+  auto dir = resolver_.partitionDir(topic_name, partition_id);
+  auto &log = partitionLog(dir);
+  std::lock_guard lock(log.mutex);
+
+  std::error_code ec;
+  std::filesystem::create_directories(dir, ec);
+  if (ec) {
+    return std::unexpected(StorageError(ErrorCode::IoError, "Failed to create " + dir));
+  }
+
+  refreshSegments(log, dir);
+  if (log.segments.empty()) {
+    if (auto rolled = rollSegment(log, dir, 0); !rolled) {
+      return std::unexpected(rolled.error());
+    }
+  }
+
+  auto *active = &log.segments.back();
+  if (!active->writer) {
+    if (auto opened = openWriter(*active, dir); !opened) {
+      return std::unexpected(opened.error());
+    }
+  }
+  active->refresh();
+
+  GroupAppend group;
+  uint64_t position = active->index.endPosition();
+  int64_t next_offset = active->nextOffset();
+  std::vector<iovec> iov;
+  uint64_t gathered = 0;
+  size_t written = 0;
+
+  // Write what has been gathered for the active segment. A failed write is cut off again so the
+  // segment never ends in a torn batch.
+  auto flush = [&]() -> std::expected<void, StorageError> {
+    if (iov.empty()) {
+      return {};
+    }
+    if (!writeAll(active->writer->get(), iov, position)) {
+      [[maybe_unused]] int rc = ftruncate(active->writer->get(), static_cast<off_t>(position));
+      return std::unexpected(StorageError(ErrorCode::IoError, "Failed to append to " + dir));
+    }
+    position += gathered;
+    iov.clear();
+    gathered = 0;
+    written = group.results.size();
+    active->refresh();
+    group.files.push_back(active->writer);
+    return {};
+  };
+
+  // Record sets flushed to earlier segments are already visible to readers, so they keep their
+  // results; only the ones that never reached the disk fail
+  auto stop = [&](StorageError error) -> GroupAppend {
+    group.results.resize(written);
+    group.error = std::move(error);
+    return std::move(group);
+  };
+
+  for (auto &record_set : record_sets) {
+    auto &bytes = record_set.bytes;
+    if (position + gathered > 0 && position + gathered + bytes.size() > segment_bytes_) {
+      if (auto flushed = flush(); !flushed) {
+        return stop(flushed.error());
+      }
+      if (auto rolled = rollSegment(log, dir, next_offset); !rolled) {
+        return stop(rolled.error());
+      }
+      active = &log.segments.back();
+      position = 0;
+    }
+
+    // Rewrite each batch's base offset; it is outside the CRC, so the checksum stays valid
+    group.results.push_back({next_offset, log.segments.front().base_offset});
+    size_t pos = 0;
+    for (const auto &batch : record_set.batches) {
+      uint64_t base_be =
+          (static_cast<uint64_t>(htonl(static_cast<uint32_t>(next_offset))) << 32) |
+          htonl(static_cast<uint32_t>(static_cast<uint64_t>(next_offset) >> 32));
+      std::memcpy(bytes.data() + pos, &base_be, sizeof(base_be));
+      next_offset += batch.last_offset + 1;
+      pos += batch.size;
+    }
+
+    iov.push_back({bytes.data(), bytes.size()});
+    gathered += bytes.size();
+  }
+
+  if (auto flushed = flush(); !flushed) {
+    return stop(flushed.error());
+  }
+  return group;
 }
 
 } // namespace storage::log
@@ -0,0 +1,177 @@
+#include "log/log_writer.hpp"
+#include "log/batch_header.hpp"
+#include <algorithm>
+#include <future>
+#include <memory>
+#include <tuple>
+
+namespace storage::log {
+
+LogWriter::LogWriter(LogStore &store, FsyncPolicy policy)
+    : store_(store), policy_(policy), thread_([this] { run(); }) {}
+
+LogWriter::~LogWriter() { stop(); }
+
+void LogWriter::stop() {
+  {
+    std::lock_guard lock(mutex_);
+    stopping_ = true;
+  }
+  wake_.notify_one();
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+}
+
+void LogWriter::append(const std::string &topic_name, int32_t partition_id,
+                       std::vector<uint8_t> records, Acknowledge done) {
+  auto batches = validateBatches(records);
+  if (!batches) {
+    done(std::unexpected(batches.error()));
+    return;
+  }
+
+  {
+    std::unique_lock lock(mutex_);
+    if (stopping_) {
+      lock.unlock();
+      done(std::unexpected(StorageError(ErrorCode::IoError, "Log writer is stopped")));
+      return;
+    }
+    queue_.push_back(
+        {topic_name, partition_id, {std::move(records), std::move(*batches)}, std::move(done)});
+  }
+  wake_.notify_one();
+}
+
+std::expected<AppendResult, StorageError> LogWriter::append(const std::string &topic_name,
+                                                           int32_t partition_id,
+                                                           std::vector<uint8_t> records) {
+  // Owned by the acknowledgement, which the writer may still hold once get() has returned
+  auto acknowledged = std::make_shared<std::promise<std::expected<AppendResult, StorageError>>>();
+  auto result = acknowledged->get_future();
+  append(topic_name, partition_id, std::move(records),
+         [acknowledged](auto outcome) { acknowledged->set_value(std::move(outcome)); });
+  return result.get();
+}
+
+void LogWriter::run() {
+  std::unique_lock lock(mutex_);
+  while (true) {
+    auto woken = [this] { return !queue_.empty() || stopping_; };
+    if (unacked_.empty()) {
+      wake_.wait(lock, woken);
+    } else {
+      // Only the Interval policy keeps appends unacknowledged; wake up when the next sync is due
+      wake_.wait_until(lock, last_sync_ + policy_.interval, woken);
+    }
+
+    std::vector<Pending> queued;
+    queued.swap(queue_);
+    bool stopping = stopping_;
+    lock.unlock();
+
+    writeQueued(std::move(queued));
+    if (stopping || syncDue()) {
+      acknowledge(sync());
+    } else if (policy_.mode != FsyncPolicy::Mode::Interval) {
+      acknowledge(true);
+    }
+
+    lock.lock();
+    if (stopping && queue_.empty()) {
+      return;
+    }
+  }
+}
+
+void LogWriter::writeQueued(std::vector<Pending> queued) {
+  std::stable_sort(queued.begin(), queued.end(), [](const Pending &a, const Pending &b) {
+    return std::tie(a.topic_name, a.partition_id) < std::tie(b.topic_name, b.partition_id);
+  });
+
+  for (auto first = queued.begin(); first != queued.end();) {
+    auto last = std::find_if(first, queued.end(), [&](const Pending &pending) {
+      return pending.topic_name != first->topic_name ||
+             pending.partition_id != first->partition_id;
+    });
+
+    std::vector<ValidatedRecords> record_sets;
+    record_sets.reserve(static_cast<size_t>(last - first));
+    for (auto it = first; it != last; ++it) {
+      record_sets.push_back(std::move(it->records));
+    }
+
+    auto group = store_.appendGroup(first->topic_name, first->partition_id, record_sets);
+    writes_.fetch_add(1, std::memory_order_relaxed);
+    if (!group) {
+      for (auto it = first; it != last; ++it) {
+        it->done(std::unexpected(group.error()));
+      }
+      first = last;
+      continue;
+    }
+
+    for (auto &file : group->files) {
+      if (std::find(unsynced_files_.begin(), unsynced_files_.end(), file) ==
+          unsynced_files_.end()) {
+        unsynced_files_.push_back(std::move(file));
+      }
+    }
+
+    // A group cut short fails only the record sets that were not written
+    for (auto it = first; it != last; ++it) {
+      auto i = static_cast<size_t>(it - first);
+      if (i < group->results.size()) {
+        unsynced_bytes_ += record_sets[i].bytes.size();
+        unacked_.push_back({std::move(it->done), group->results[i]});
+      } else {
+        it->done(std::unexpected(*group->error));
+      }
+    }
+    first = last;
+  }
+}
+
+bool LogWriter::syncDue() const {
+  switch (policy_.mode) {
+  case FsyncPolicy::Mode::EveryBatch:
+    return !unsynced_files_.empty();
+  case FsyncPolicy::Mode::Interval:
+    return !unacked_.empty() &&
+           std::chrono::steady_clock::now() >= last_sync_ + policy_.interval;
+  case FsyncPolicy::Mode::Bytes:
+    return unsynced_bytes_ >= policy_.bytes;
+  case FsyncPolicy::Mode::Os:
+    return false;
+  }
+  return false;
+}
+
+bool LogWriter::sync() {
+  bool synced = true;
+  for (const auto &file : unsynced_files_) {
+    synced = file->sync() && synced;
+  }
+  if (!unsynced_files_.empty()) {
+    syncs_.fetch_add(1, std::memory_order_relaxed);
+  }
+  unsynced_files_.clear();
+  unsynced_bytes_ = 0;
+  last_sync_ = std::chrono::steady_clock::now();
+  return synced;
+}
+
+void LogWriter::acknowledge(bool synced) {
+  for (auto &unacked : unacked_) {
+    if (synced) {
+      unacked.done(unacked.result);
+    } else {
+      unacked.done(
+          std::unexpected(StorageError(ErrorCode::IoError, "Failed to sync appended records")));
+    }
+  }
+  unacked_.clear();
+}
+
+} // namespace storage::log
@@ -0,0 +1,32 @@
+#include "log/offset_index.hpp"
+#include "log/batch_header.hpp"
+#include <algorithm>
+
+namespace storage::log {
+
+void OffsetIndex::extend(std::span<const uint8_t> segment) {
+  while (auto header = readBatchHeader(segment, end_position_)) {
+    if (entries_.empty()) {
+      start_offset_ = header->base_offset;
+    }
+    if (entries_.empty() || bytes_since_entry_ >= INDEX_INTERVAL_BYTES) {
+      entries_.push_back({header->base_offset, end_position_});
+      bytes_since_entry_ = 0;
+    }
+    bytes_since_entry_ += header->size;
+    end_position_ += header->size;
+    next_offset_ = header->last_offset + 1;
+  }
+}
+
+uint64_t OffsetIndex::lookup(int64_t offset) const {
+  auto it = std::upper_bound(
+      entries_.begin(), entries_.end(), offset,
+      [](int64_t value, const Entry &entry) { return value < entry.offset; });
+  if (it == entries_.begin()) {
+    return 0;
+  }
+  return std::prev(it)->position;
+}
+
+} // namespace storage::log
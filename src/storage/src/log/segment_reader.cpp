@@ -0,0 +1,15 @@
+#include "log/segment_reader.hpp"
+
+namespace storage::log {
+
+std::optional<SegmentReader::Batch> SegmentReader::next() {
+  auto header = readBatchHeader(segment_, position_);
+  if (!header) {
+    return std::nullopt;
+  }
+  Batch batch {*header, position_, segment_.subspan(position_, header->size)};
+  position_ += header->size;
+  return batch;
+}
+
+} // namespace storage::log
@@ -1,4 +1,5 @@
 #include "metadata/metadata_decoder.hpp"
+#include "varint.hpp"
 #include <cstdint>
 
 namespace storage::metadata {
@@ -19,6 +20,26 @@ int32_t readInt32BE(std::span<const uint8_t> data, size_t &pos) {
   return v;
 }
 
+uint32_t readUnsignedVarint(std::span<const uint8_t> data, size_t &pos, const char *field) {
+  uint32_t v;
+  size_t used = common::decodeVarint32(data.data() + pos, data.size() - pos, v);
+  if (used == 0) {
+    throw StorageError(ErrorCode::DecodeError,
+                       std::string("Metadata decode: invalid varint for ") + field);
+  }
+  pos += used;
+  return v;
+}
+
+// Length of a compact string or array: the varint holds length + 1, and 0 (null) is invalid here
+size_t readCompactLength(std::span<const uint8_t> data, size_t &pos, const char *field) {
+  uint32_t length = readUnsignedVarint(data, pos, field);
+  if (length == 0) {
+    throw StorageError(ErrorCode::DecodeError, std::string("Metadata decode: null ") + field);
+  }
+  return length - 1;
+}
+
 uint128_t readUint128(std::span<const uint8_t> data, size_t &pos) {
   checkBounds(data, pos, 16, "uuid");
   uint128_t v = 0;
@@ -38,14 +59,7 @@ TopicInfo decodeTopicRecord(std::span<const uint8_t> data) {
 
   size_t pos = HEADER_SIZE;
 
-  checkBounds(data, pos, 1, "name_length");
-  int name_len = static_cast<int>(data[pos]) - 1;
-  pos++;
-  if (name_len < 0) {
-    throw StorageError(ErrorCode::DecodeError, "Invalid topic name length");
-  }
-  size_t name_length = static_cast<size_t>(name_len);
-
+  size_t name_length = readCompactLength(data, pos, "name_length");
   if (name_length > data.size() - pos) {
     throw StorageError(ErrorCode::DecodeError, "Topic name extends past buffer");
   }
@@ -70,25 +84,24 @@ PartitionInfo decodePartitionRecord(std::span<const uint8_t> data) {
   info.partition_id = readInt32BE(data, pos);
   info.topic_id = TopicId {readUint128(data, pos)};
 
-  checkBounds(data, pos, 1, "replica_count");
-  int replica_count = static_cast<int>(data[pos++]) - 1;
-  if (replica_count < 0 || pos + static_cast<size_t>(replica_count) * 4 > data.size()) {
-    throw StorageError(ErrorCode::DecodeError, "Invalid replica count or buffer too short");
-  }
-  for (int i = 0; i < replica_count; i++) {
+  size_t replica_count = readCompactLength(data, pos, "replica_count");
+  checkBounds(data, pos, replica_count * 4, "replicas");
+  for (size_t i = 0; i < replica_count; i++) {
     info.replicas.push_back(readInt32BE(data, pos));
   }
 
-  checkBounds(data, pos, 1, "isr_count");
-  int isr_count = static_cast<int>(data[pos++]) - 1;
-  if (isr_count < 0 || pos + static_cast<size_t>(isr_count) * 4 > data.size()) {
-    throw StorageError(ErrorCode::DecodeError, "Invalid isr count or buffer too short");
-  }
-  for (int i = 0; i < isr_count; i++) {
+  size_t isr_count = readCompactLength(data, pos, "isr_count");
+  checkBounds(data, pos, isr_count * 4, "isr");
+  for (size_t i = 0; i < isr_count; i++) {
     info.isr.push_back(readInt32BE(data, pos));
   }
 
-  pos += 2; // Skip removing and adding replicas arrays
+  // Skip the removing and adding replicas arrays
+  for (const char *field : {"removing_replicas", "adding_replicas"}) {
+    size_t count = readCompactLength(data, pos, field);
+    checkBounds(data, pos, count * 4, field);
+    pos += count * 4;
+  }
 
   info.leader_id = readInt32BE(data, pos);
   info.leader_epoch = readInt32BE(data, pos);
@@ -1,48 +1,125 @@
 #include "metadata/metadata_store.hpp"
-#include "log/batch_scanner.hpp"
+#include "log/segment_reader.hpp"
 #include "metadata/metadata_decoder.hpp"
 #include "metadata/record_extractor.hpp"
-#include <fstream>
+#include "trace.hpp"
+#include <algorithm>
+#include <vector>
 
 namespace storage::metadata {
 
-MetadataStore::MetadataStore(io::PathResolver resolver) : resolver_(std::move(resolver)) {}
+MetadataStore::MetadataStore(io::PathResolver resolver, std::chrono::milliseconds check_interval)
+    : resolver_(std::move(resolver)), check_interval_(check_interval) {}
 
-std::expected<ClusterSnapshot, StorageError> MetadataStore::loadClusterSnapshot() {
-  ClusterSnapshot snapshot;
-  std::ifstream file(resolver_.clusterMetadataPath(), std::ios::binary);
-  if (!file.is_open()) {
-    return snapshot;
+std::expected<std::shared_ptr<const ClusterSnapshot>, StorageError>
+MetadataStore::loadClusterSnapshot() {
+  common::trace::Span span("MetadataStore::loadClusterSnapshot");
+  auto current = snapshot_.load(std::memory_order_acquire);
+  auto now = std::chrono::steady_clock::now();
+  if (current && now < next_check_.load(std::memory_order_relaxed)) {
+    return current;
   }
 
+  // Once a snapshot exists, readers only check for new metadata when no one else is already
+  // doing so; everyone else keeps using the published snapshot.
+  std::unique_lock lock(refresh_mutex_, std::defer_lock);
+  if (current) {
+    if (!lock.try_lock()) {
+      return current;
+    }
+  } else {
+    lock.lock();
+  }
+
+  next_check_.store(now + check_interval_, std::memory_order_relaxed);
+  if (auto result = tail(); !result) {
+    return std::unexpected(result.error());
+  }
+  return snapshot_.load(std::memory_order_acquire);
+}
+
+std::expected<void, StorageError> MetadataStore::tail() {
+  auto path = resolver_.clusterMetadataPath();
+  if (file_ && file_->valid() && !file_->refersTo(path)) {
+    // A new log was moved into place; rebuild from its start, whatever its size
+    mapped_ = io::MappedFile();
+    file_.reset();
+    consumed_ = 0;
+    rebuild_ = true;
+  }
+  if (!file_ || !file_->valid()) {
+    file_ = std::make_unique<io::FileHandle>(path);
+  }
+  if (!file_->valid()) {
+    if (rebuild_ || !snapshot_.load(std::memory_order_relaxed)) {
+      snapshot_.store(std::make_shared<const ClusterSnapshot>(), std::memory_order_release);
+      rebuild_ = false;
+    }
+    return {};
+  }
+
+  uint64_t size = file_->size();
+  if (size < consumed_) {
+    // The log was truncated in place; start over
+    consumed_ = 0;
+    rebuild_ = true;
+  }
+  auto current = rebuild_ ? nullptr : snapshot_.load(std::memory_order_relaxed);
+  if (current && size == consumed_) {
+    return {};
+  }
+
+  if (!mapped_.map(*file_, size)) {
+    return std::unexpected(StorageError(ErrorCode::IoError, "Failed to map metadata log"));
+  }
+  mapped_.advise(io::MappedFile::Access::Sequential, consumed_);
+
+  auto next = current ? std::make_shared<ClusterSnapshot>(*current)
+                      : std::make_shared<ClusterSnapshot>();
+  // A batch still being written is picked up on a later call
+  log::SegmentReader reader(mapped_.bytes(), consumed_);
   try {
-    log::BatchScanner scanner(file);
-    auto batches = scanner.scanAll();
-
-    for (const auto &batch : batches) {
-      auto values = extractRecordValues(batch);
-      for (const auto &value : values) {
-        if (value.size() < 2) {
-          continue;
-        }
-        if (value[1] == TOPIC_RECORD) {
-          auto topic = decodeTopicRecord(value);
-          TopicInfo &info = snapshot.topics_by_id[topic.topic_id];
-          info = std::move(topic);
-        } else if (value[1] == PARTITION_RECORD) {
-          auto partition = decodePartitionRecord(value);
-          auto it = snapshot.topics_by_id.find(partition.topic_id);
-          if (it != snapshot.topics_by_id.end()) {
-            it->second.partitions.push_back(std::move(partition));
-          }
-        }
+    while (auto batch = reader.next()) {
+      for (const auto &value : extractRecordValues(batch->bytes)) {
+        applyRecord(*next, value);
       }
     }
   } catch (const StorageError &e) {
     return std::unexpected(e);
   }
 
-  return snapshot;
+  consumed_ = reader.position();
+  rebuild_ = false;
+  snapshot_.store(std::move(next), std::memory_order_release);
+  return {};
+}
+
+void MetadataStore::applyRecord(ClusterSnapshot &snapshot, std::span<const uint8_t> value) {
+  if (value.size() < 2) {
+    return;
+  }
+
+  if (value[1] == TOPIC_RECORD) {
+    auto topic = decodeTopicRecord(value);
+    snapshot.upsertTopic(topic.topic_id, std::move(topic.name));
+  } else if (value[1] == PARTITION_RECORD) {
+    auto partition = decodePartitionRecord(value);
+    auto *topic = snapshot.findById(partition.topic_id);
+    if (!topic) {
+      return;
+    }
+
+    // Partitions stay ordered by id; a repeated record replaces the earlier state
+    auto &partitions = topic->partitions;
+    auto pos = std::lower_bound(
+        partitions.begin(), partitions.end(), partition.partition_id,
+        [](const PartitionInfo &p, int32_t id) { return p.partition_id < id; });
+    if (pos != partitions.end() && pos->partition_id == partition.partition_id) {
+      *pos = std::move(partition);
+    } else {
+      partitions.insert(pos, std::move(partition));
+    }
+  }
 }
 
 } // namespace storage::metadata
@@ -1,81 +1,83 @@
 #include "metadata/record_extractor.hpp"
+#include "varint.hpp"
 
 namespace storage::metadata {
 
 namespace {
-int32_t readVarint(std::span<const uint8_t> &data) {
-  int32_t value = 0;
-  int shift = 0;
-  while (!data.empty()) {
-    uint8_t byte = data[0];
-    data = data.subspan(1);
-    value |= static_cast<int32_t>(byte & 0x7f) << shift;
-    if (!(byte & 0x80)) {
-      break;
-    }
-    shift += 7;
+// Record batch v2 layout: the records follow a 61-byte header ending in the record count
+constexpr size_t ATTRIBUTES_OFFSET = 21;
+constexpr size_t RECORD_COUNT_OFFSET = 57;
+constexpr size_t RECORDS_OFFSET = 61;
+constexpr uint8_t COMPRESSION_MASK = 0x07;
+
+// Zigzag varint at the front of `data`, which moves past it; false if there is none
+template <typename T> bool readZigZag(std::span<const uint8_t> &data, T &value) {
+  size_t used;
+  if constexpr (sizeof(T) == sizeof(int64_t)) {
+    used = common::decodeZigZag64(data.data(), data.size(), value);
+  } else {
+    used = common::decodeZigZag32(data.data(), data.size(), value);
   }
-  return value;
+  data = data.subspan(used);
+  return used != 0;
 }
 
-int32_t readZigZagVarint(std::span<const uint8_t> &data) {
-  int32_t n = readVarint(data);
-  return (n >> 1) ^ -(n & 1);
+int32_t readInt32BE(std::span<const uint8_t> data, size_t pos) {
+  return static_cast<int32_t>((data[pos] << 24) | (data[pos + 1] << 16) | (data[pos + 2] << 8) |
+                              data[pos + 3]);
 }
 
 } // namespace
 
 std::vector<std::vector<uint8_t>> extractRecordValues(std::span<const uint8_t> batch) {
   std::vector<std::vector<uint8_t>> values;
-  if (batch.size() < 12) {
+  if (batch.size() < RECORDS_OFFSET) {
+    return values;
+  }
+  // Metadata batches are never compressed; anything else is not ours to decode
+  if (batch[ATTRIBUTES_OFFSET + 1] & COMPRESSION_MASK) {
     return values;
   }
-  std::span<const uint8_t> rest = batch.subspan(12);
 
-  constexpr size_t MAX_RECORDS = 10000;
-  constexpr size_t MAX_FIELD = 1024 * 1024;
+  constexpr int32_t MAX_RECORDS = 10000;
+  constexpr int32_t MAX_FIELD = 1024 * 1024;
 
-  while (!rest.empty() && values.size() < MAX_RECORDS) {
-    if (rest.size() < 1) {
-      break;
-    }
-    int32_t length = readVarint(rest);
-    if (length <= 0 || rest.size() < static_cast<size_t>(length)) {
+  int32_t record_count = readInt32BE(batch, RECORD_COUNT_OFFSET);
+  std::span<const uint8_t> rest = batch.subspan(RECORDS_OFFSET);
+
+  for (int32_t i = 0; i < record_count && i < MAX_RECORDS && !rest.empty(); i++) {
+    int32_t length;
+    if (!readZigZag(rest, length) || length <= 0 || rest.size() < static_cast<size_t>(length)) {
       break;
     }
-    auto rec_data = rest.subspan(0, length);
-    rest = rest.subspan(length);
+    auto rec_data = rest.subspan(0, static_cast<size_t>(length));
+    rest = rest.subspan(static_cast<size_t>(length));
 
-    // Skip: attributes (1), timestamp_delta (varint), offset_delta (varint)
-    if (rec_data.size() < 1) {
+    // Skip: attributes (1), timestamp_delta (varlong), offset_delta (varint)
+    int64_t timestamp_delta;
+    int32_t offset_delta;
+    rec_data = rec_data.subspan(1);
+    if (!readZigZag(rec_data, timestamp_delta) || !readZigZag(rec_data, offset_delta)) {
       continue;
     }
-    rec_data = rec_data.subspan(1);
-    readZigZagVarint(rec_data);
-    readZigZagVarint(rec_data);
 
-    // Key: zigzag varint length + bytes
-    if (rec_data.empty()) {
+    // Key: zigzag varint length + bytes, -1 for a null key
+    int32_t key_len;
+    if (!readZigZag(rec_data, key_len) || key_len > MAX_FIELD ||
+        (key_len > 0 && rec_data.size() < static_cast<size_t>(key_len))) {
       continue;
     }
-    int32_t key_len = readZigZagVarint(rec_data);
-    if (key_len < 0 || key_len > static_cast<int32_t>(MAX_FIELD) ||
-        rec_data.size() < static_cast<size_t>(key_len)) {
-      continue;
+    if (key_len > 0) {
+      rec_data = rec_data.subspan(static_cast<size_t>(key_len));
     }
-    rec_data = rec_data.subspan(key_len);
 
     // Value: zigzag varint length + bytes
-    if (rec_data.empty()) {
-      continue;
-    }
-    int32_t value_len = readZigZagVarint(rec_data);
-    if (value_len < 0 || value_len > static_cast<int32_t>(MAX_FIELD) ||
+    int32_t value_len;
+    if (!readZigZag(rec_data, value_len) || value_len < 0 || value_len > MAX_FIELD ||
         rec_data.size() < static_cast<size_t>(value_len)) {
       continue;
     }
-    std::vector<uint8_t> value(rec_data.begin(), rec_data.begin() + value_len);
-    values.push_back(std::move(value));
+    values.emplace_back(rec_data.begin(), rec_data.begin() + value_len);
   }
 
   return values;
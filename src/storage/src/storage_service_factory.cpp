@@ -3,8 +3,9 @@
 
 namespace storage {
 
-std::unique_ptr<IStorageService> createStorageService(std::string base_path) {
-  return std::make_unique<internal::StorageServiceImpl>(std::move(base_path));
+std::unique_ptr<IStorageService> createStorageService(std::string base_path,
+                                                     FsyncPolicy fsync_policy) {
+  return std::make_unique<internal::StorageServiceImpl>(std::move(base_path), fsync_policy);
 }
 
 } // namespace storage
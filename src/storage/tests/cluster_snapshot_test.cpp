@@ -0,0 +1,47 @@
+#include "storage_types.hpp"
+#include <gtest/gtest.h>
+
+using namespace storage;
+
+TEST(ClusterSnapshotTest, FindsTopicsByIdAndName) {
+  ClusterSnapshot snapshot;
+  for (uint32_t i = 0; i < 10000; i++) {
+    uint128_t id = (static_cast<uint128_t>(i) << 64) | (i * 7919u);
+    snapshot.upsertTopic(TopicId {id}, "topic-" + std::to_string(i));
+  }
+
+  ASSERT_EQ(snapshot.topics().size(), 10000u);
+  for (uint32_t i = 0; i < 10000; i += 97) {
+    uint128_t id = (static_cast<uint128_t>(i) << 64) | (i * 7919u);
+    const auto *by_id = snapshot.findById(TopicId {id});
+    ASSERT_NE(by_id, nullptr);
+    EXPECT_EQ(by_id->name, "topic-" + std::to_string(i));
+    EXPECT_EQ(snapshot.findByName("topic-" + std::to_string(i)), by_id);
+  }
+  EXPECT_EQ(snapshot.findByName("topic-10000"), nullptr);
+  EXPECT_EQ(snapshot.findById(TopicId {12345}), nullptr);
+}
+
+TEST(ClusterSnapshotTest, UpsertKeepsPartitionsAndFollowsRename) {
+  ClusterSnapshot snapshot;
+  snapshot.upsertTopic(TopicId {1}, "old").partitions.push_back(PartitionInfo {});
+  snapshot.upsertTopic(TopicId {1}, "new");
+
+  EXPECT_EQ(snapshot.topics().size(), 1u);
+  EXPECT_EQ(snapshot.findByName("old"), nullptr);
+  ASSERT_NE(snapshot.findByName("new"), nullptr);
+  EXPECT_EQ(snapshot.findByName("new")->partitions.size(), 1u);
+}
+
+TEST(ClusterSnapshotTest, CopyHasItsOwnIndexes) {
+  ClusterSnapshot original;
+  original.upsertTopic(TopicId {1}, "a");
+
+  ClusterSnapshot copy = original;
+  copy.upsertTopic(TopicId {2}, "b");
+
+  EXPECT_EQ(original.findByName("b"), nullptr);
+  ASSERT_NE(copy.findByName("a"), nullptr);
+  EXPECT_NE(copy.findByName("a"), original.findByName("a"));
+  EXPECT_EQ(copy.findById(TopicId {2})->name, "b");
+}
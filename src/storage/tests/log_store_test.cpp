@@ -0,0 +1,262 @@
+#include "crc32c.hpp"
+#include "io/file_handle.hpp"
+#include "io/mapped_file.hpp"
+#include "log/log_store.hpp"
+#include "log/offset_index.hpp"
+#include <arpa/inet.h>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <gtest/gtest.h>
+
+using namespace storage;
+
+namespace {
+
+// Batch header with `record_count` offsets from `base_offset`, padded to `size` bytes in total
+std::vector<uint8_t> makeBatch(int64_t base_offset, int32_t record_count, size_t size = 80) {
+  std::vector<uint8_t> batch(size, 0);
+  uint64_t offset_be = (static_cast<uint64_t>(htonl(static_cast<uint32_t>(base_offset))) << 32) |
+                       htonl(static_cast<uint32_t>(base_offset >> 32));
+  uint32_t length_be = htonl(static_cast<uint32_t>(size - 12));
+  uint32_t delta_be = htonl(static_cast<uint32_t>(record_count - 1));
+  std::memcpy(batch.data(), &offset_be, 8);
+  std::memcpy(batch.data() + 8, &length_be, 4);
+  std::memcpy(batch.data() + 23, &delta_be, 4);
+  return batch;
+}
+
+// Produced form of makeBatch: magic 2 and a valid CRC32C, as a producer would send it
+std::vector<uint8_t> makeProducedBatch(int32_t record_count, size_t size = 80) {
+  auto batch = makeBatch(0, record_count, size);
+  batch[16] = 2;
+  uint32_t crc_be = htonl(common::crc32c(batch.data() + 21, batch.size() - 21));
+  std::memcpy(batch.data() + 17, &crc_be, 4);
+  return batch;
+}
+
+class LogStoreTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    base_ = std::filesystem::temp_directory_path() /
+            ("log_store_test_" + std::to_string(::getpid()));
+    std::filesystem::create_directories(base_ / "topic-0");
+  }
+
+  void TearDown() override { std::filesystem::remove_all(base_); }
+
+  std::filesystem::path logPath(int64_t base_offset = 0) const {
+    return base_ / "topic-0" / io::PathResolver::segmentFileName(base_offset);
+  }
+
+  void appendLog(const std::vector<std::vector<uint8_t>> &chunks, int64_t segment = 0) {
+    std::ofstream out(logPath(segment), std::ios::binary | std::ios::app);
+    for (const auto &chunk : chunks) {
+      out.write(reinterpret_cast<const char *>(chunk.data()),
+                static_cast<std::streamsize>(chunk.size()));
+    }
+  }
+
+  std::filesystem::path base_;
+};
+
+} // namespace
+
+TEST_F(LogStoreTest, RangeCoversCompleteBatchesOnly) {
+  auto first = makeBatch(0, 2);
+  auto second = makeBatch(2, 3);
+  auto partial = makeBatch(5, 1);
+  partial.resize(40);
+  appendLog({first, second, partial});
+
+  log::LogStore store {io::PathResolver(base_.string())};
+  auto range = store.readPartitionRange("topic", 0, 0, 1 << 20);
+  ASSERT_TRUE(range.has_value());
+  EXPECT_EQ(range->log_start_offset, 0);
+  EXPECT_EQ(range->high_watermark, 5);
+  ASSERT_EQ(range->regions.size(), 1u);
+  EXPECT_EQ(range->regions[0].offset, 0u);
+  EXPECT_EQ(range->regions[0].length, first.size() + second.size());
+  EXPECT_TRUE(range->regions[0].file->valid());
+}
+
+TEST_F(LogStoreTest, StartsAtBatchHoldingFetchOffset) {
+  appendLog({makeBatch(0, 2), makeBatch(2, 3), makeBatch(5, 1)});
+
+  log::LogStore store {io::PathResolver(base_.string())};
+  auto range = store.readPartitionRange("topic", 0, 3, 1 << 20);
+  ASSERT_TRUE(range.has_value());
+  ASSERT_EQ(range->regions.size(), 1u);
+  EXPECT_EQ(range->regions[0].offset, 80u);
+  EXPECT_EQ(range->regions[0].length, 160u);
+}
+
+TEST_F(LogStoreTest, StopsAtMaxBytesButReturnsOneBatch) {
+  appendLog({makeBatch(0, 1), makeBatch(1, 1), makeBatch(2, 1)});
+
+  log::LogStore store {io::PathResolver(base_.string())};
+  auto range = store.readPartitionRange("topic", 0, 0, 170);
+  ASSERT_TRUE(range.has_value());
+  EXPECT_EQ(range->regions[0].length, 160u);
+
+  range = store.readPartitionRange("topic", 0, 1, 10);
+  ASSERT_TRUE(range.has_value());
+  EXPECT_EQ(range->regions[0].offset, 80u);
+  EXPECT_EQ(range->regions[0].length, 80u);
+}
+
+TEST_F(LogStoreTest, SeesBatchesAppendedAfterFirstRead) {
+  appendLog({makeBatch(0, 1)});
+  log::LogStore store {io::PathResolver(base_.string())};
+  ASSERT_EQ(store.readPartitionRange("topic", 0, 0, 1 << 20)->high_watermark, 1);
+
+  appendLog({makeBatch(1, 4)});
+  auto range = store.readPartitionRange("topic", 0, 1, 1 << 20);
+  ASSERT_TRUE(range.has_value());
+  EXPECT_EQ(range->high_watermark, 5);
+  EXPECT_EQ(range->regions[0].offset, 80u);
+}
+
+TEST_F(LogStoreTest, FetchAtLogEndIsEmptyAndBeyondIsOutOfRange) {
+  appendLog({makeBatch(0, 2)});
+  log::LogStore store {io::PathResolver(base_.string())};
+
+  auto range = store.readPartitionRange("topic", 0, 2, 1 << 20);
+  ASSERT_TRUE(range.has_value());
+  EXPECT_TRUE(range->regions.empty());
+
+  auto beyond = store.readPartitionRange("topic", 0, 3, 1 << 20);
+  ASSERT_FALSE(beyond.has_value());
+  EXPECT_EQ(beyond.error().code(), ErrorCode::OffsetOutOfRange);
+}
+
+TEST_F(LogStoreTest, MissingLogHasNoRegions) {
+  log::LogStore store {io::PathResolver(base_.string())};
+  auto range = store.readPartitionRange("absent", 0, 0, 1 << 20);
+  ASSERT_TRUE(range.has_value());
+  EXPECT_TRUE(range->regions.empty());
+}
+
+TEST_F(LogStoreTest, ReadsAcrossSegments) {
+  appendLog({makeBatch(0, 2), makeBatch(2, 2)}, 0);
+  appendLog({makeBatch(4, 2), makeBatch(6, 2)}, 4);
+  appendLog({makeBatch(8, 2)}, 8);
+
+  log::LogStore store {io::PathResolver(base_.string())};
+  auto range = store.readPartitionRange("topic", 0, 3, 1 << 20);
+  ASSERT_TRUE(range.has_value());
+  EXPECT_EQ(range->log_start_offset, 0);
+  EXPECT_EQ(range->high_watermark, 10);
+  ASSERT_EQ(range->regions.size(), 3u);
+  EXPECT_EQ(range->regions[0].offset, 80u);
+  EXPECT_EQ(range->regions[0].length, 80u);
+  EXPECT_EQ(range->regions[1].length, 160u);
+  EXPECT_EQ(range->regions[2].length, 80u);
+
+  // Byte limit stops inside the second segment
+  range = store.readPartitionRange("topic", 0, 5, 100);
+  ASSERT_TRUE(range.has_value());
+  ASSERT_EQ(range->regions.size(), 1u);
+  EXPECT_EQ(range->regions[0].offset, 0u);
+  EXPECT_EQ(range->regions[0].length, 80u);
+
+  auto all = store.readPartition("topic", 0);
+  ASSERT_TRUE(all.has_value());
+  EXPECT_EQ(all->size(), 5u);
+  // Batches of one segment are views into the same mapping
+  EXPECT_EQ((*all)[0].owner(), (*all)[1].owner());
+  EXPECT_NE((*all)[0].owner(), (*all)[3].owner());
+  EXPECT_EQ((*all)[1].data(), (*all)[0].data() + (*all)[0].size());
+}
+
+TEST_F(LogStoreTest, PicksUpRolledAndDeletedSegments) {
+  appendLog({makeBatch(0, 2)}, 0);
+  log::LogStore store {io::PathResolver(base_.string())};
+  ASSERT_EQ(store.readPartitionRange("topic", 0, 0, 1 << 20)->high_watermark, 2);
+
+  appendLog({makeBatch(2, 3)}, 2);
+  auto range = store.readPartitionRange("topic", 0, 2, 1 << 20);
+  ASSERT_TRUE(range.has_value());
+  EXPECT_EQ(range->high_watermark, 5);
+
+  std::filesystem::remove(logPath(0));
+  auto trimmed = store.readPartitionRange("topic", 0, 0, 1 << 20);
+  ASSERT_FALSE(trimmed.has_value());
+  EXPECT_EQ(trimmed.error().code(), ErrorCode::OffsetOutOfRange);
+  EXPECT_EQ(store.readPartitionRange("topic", 0, 2, 1 << 20)->log_start_offset, 2);
+}
+
+TEST_F(LogStoreTest, IndexIsSparse) {
+  std::vector<std::vector<uint8_t>> batches;
+  for (int64_t offset = 0; offset < 100; offset++) {
+    batches.push_back(makeBatch(offset, 1, 1024));
+  }
+  appendLog(batches);
+
+  io::FileHandle file(logPath().string());
+  io::MappedFile mapped;
+  ASSERT_TRUE(mapped.map(file, file.size()));
+  log::OffsetIndex index;
+  index.extend(mapped.bytes());
+  EXPECT_EQ(index.nextOffset(), 100);
+  EXPECT_EQ(index.entries().size(), 25u);
+  EXPECT_EQ(index.lookup(0), 0u);
+  EXPECT_EQ(index.lookup(5), 4u * 1024);
+  EXPECT_EQ(index.lookup(99), 96u * 1024);
+}
+
+TEST_F(LogStoreTest, AppendAssignsOffsetsFromLogEnd) {
+  appendLog({makeBatch(0, 2)});
+  log::LogStore store {io::PathResolver(base_.string())};
+
+  auto records = makeProducedBatch(3);
+  auto second = makeProducedBatch(1);
+  records.insert(records.end(), second.begin(), second.end());
+  auto appended = store.append("topic", 0, records);
+  ASSERT_TRUE(appended.has_value());
+  EXPECT_EQ(appended->base_offset, 2);
+  EXPECT_EQ(appended->log_start_offset, 0);
+
+  auto range = store.readPartitionRange("topic", 0, 5, 1 << 20);
+  ASSERT_TRUE(range.has_value());
+  EXPECT_EQ(range->high_watermark, 6);
+  ASSERT_EQ(range->regions.size(), 1u);
+  EXPECT_EQ(range->regions[0].offset, 80u + 80u);
+  EXPECT_EQ(store.append("topic", 0, makeProducedBatch(1))->base_offset, 6);
+}
+
+TEST_F(LogStoreTest, AppendCreatesMissingPartition) {
+  log::LogStore store {io::PathResolver(base_.string())};
+  auto appended = store.append("fresh", 2, makeProducedBatch(4));
+  ASSERT_TRUE(appended.has_value());
+  EXPECT_EQ(appended->base_offset, 0);
+  EXPECT_TRUE(std::filesystem::exists(base_ / "fresh-2" / io::PathResolver::segmentFileName(0)));
+}
+
+TEST_F(LogStoreTest, AppendRollsSegments) {
+  log::LogStore store {io::PathResolver(base_.string()), 200};
+  for (int i = 0; i < 5; i++) {
+    ASSERT_TRUE(store.append("topic", 0, makeProducedBatch(2)).has_value());
+  }
+  EXPECT_TRUE(std::filesystem::exists(logPath(4)));
+  EXPECT_TRUE(std::filesystem::exists(logPath(8)));
+
+  auto range = store.readPartitionRange("topic", 0, 0, 1 << 20);
+  ASSERT_TRUE(range.has_value());
+  EXPECT_EQ(range->high_watermark, 10);
+  EXPECT_EQ(range->regions.size(), 3u);
+}
+
+TEST_F(LogStoreTest, AppendRejectsCorruptBatches) {
+  log::LogStore store {io::PathResolver(base_.string())};
+  auto batch = makeProducedBatch(1);
+  batch.back() ^= 0xff;
+  auto appended = store.append("topic", 0, batch);
+  ASSERT_FALSE(appended.has_value());
+  EXPECT_EQ(appended.error().code(), ErrorCode::CorruptMessage);
+
+  auto truncated = makeProducedBatch(1);
+  truncated.resize(70);
+  EXPECT_FALSE(store.append("topic", 0, truncated).has_value());
+  EXPECT_FALSE(std::filesystem::exists(logPath()));
+}
@@ -0,0 +1,238 @@
+#include "crc32c.hpp"
+#include "log/log_store.hpp"
+#include "log/log_writer.hpp"
+#include <algorithm>
+#include <atomic>
+#include <arpa/inet.h>
+#include <condition_variable>
+#include <cstring>
+#include <filesystem>
+#include <gtest/gtest.h>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+using namespace storage;
+
+namespace {
+
+// Produced record batch holding `record_count` offsets, with a valid CRC32C
+std::vector<uint8_t> makeProducedBatch(int32_t record_count, size_t size = 80) {
+  std::vector<uint8_t> batch(size, 0);
+  uint32_t length_be = htonl(static_cast<uint32_t>(size - 12));
+  uint32_t delta_be = htonl(static_cast<uint32_t>(record_count - 1));
+  std::memcpy(batch.data() + 8, &length_be, 4);
+  batch[16] = 2;
+  std::memcpy(batch.data() + 23, &delta_be, 4);
+  uint32_t crc_be = htonl(common::crc32c(batch.data() + 21, batch.size() - 21));
+  std::memcpy(batch.data() + 17, &crc_be, 4);
+  return batch;
+}
+
+class LogWriterTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    base_ = std::filesystem::temp_directory_path() /
+            ("log_writer_test_" + std::to_string(::getpid()));
+    std::filesystem::create_directories(base_);
+  }
+
+  void TearDown() override { std::filesystem::remove_all(base_); }
+
+  std::filesystem::path base_;
+};
+
+} // namespace
+
+TEST_F(LogWriterTest, ConcurrentAppendsGetDistinctOffsets) {
+  constexpr int THREADS = 8;
+  constexpr int APPENDS = 25;
+  log::LogStore store {io::PathResolver(base_.string())};
+  std::vector<int64_t> offsets(THREADS * APPENDS);
+  uint64_t writes = 0;
+  {
+    log::LogWriter writer(store, {FsyncPolicy::Mode::EveryBatch});
+    std::vector<std::thread> producers;
+    for (int t = 0; t < THREADS; t++) {
+      producers.emplace_back([&, t] {
+        for (int i = 0; i < APPENDS; i++) {
+          auto appended = writer.append("topic", 0, makeProducedBatch(2));
+          offsets[static_cast<size_t>(t * APPENDS + i)] = appended ? appended->base_offset : -1;
+        }
+      });
+    }
+    for (auto &producer : producers) {
+      producer.join();
+    }
+    writes = writer.writeCount();
+    EXPECT_LE(writes, static_cast<uint64_t>(THREADS * APPENDS));
+    EXPECT_EQ(writer.syncCount(), writes);
+  }
+
+  std::sort(offsets.begin(), offsets.end());
+  for (size_t i = 0; i < offsets.size(); i++) {
+    ASSERT_EQ(offsets[i], static_cast<int64_t>(2 * i));
+  }
+  auto range = store.readPartitionRange("topic", 0, 0, 1 << 20);
+  ASSERT_TRUE(range.has_value());
+  EXPECT_EQ(range->high_watermark, 2 * THREADS * APPENDS);
+}
+
+TEST_F(LogWriterTest, AppendsAreVisibleOnceAcknowledged) {
+  log::LogStore store {io::PathResolver(base_.string())};
+  log::LogWriter writer(store);
+
+  auto first = writer.append("topic", 1, makeProducedBatch(3));
+  ASSERT_TRUE(first.has_value());
+  EXPECT_EQ(first->base_offset, 0);
+  EXPECT_EQ(store.readPartitionRange("topic", 1, 0, 1 << 20)->high_watermark, 3);
+
+  EXPECT_EQ(writer.append("topic", 1, makeProducedBatch(1))->base_offset, 3);
+  EXPECT_EQ(writer.syncCount(), 0u);
+}
+
+TEST_F(LogWriterTest, QueuedAppendsAreAcknowledgedOnTheWriterThread) {
+  log::LogStore store {io::PathResolver(base_.string())};
+  log::LogWriter writer(store, {FsyncPolicy::Mode::Interval, std::chrono::milliseconds(300)});
+
+  std::mutex mutex;
+  std::condition_variable acked;
+  std::vector<std::pair<int32_t, int64_t>> offsets;
+  std::vector<std::thread::id> threads;
+  for (int32_t partition = 0; partition < 3; partition++) {
+    writer.append("topic", partition, makeProducedBatch(partition + 1),
+                  [&, partition](std::expected<AppendResult, StorageError> result) {
+                    std::lock_guard lock(mutex);
+                    offsets.emplace_back(partition, result ? result->base_offset : -1);
+                    threads.push_back(std::this_thread::get_id());
+                    acked.notify_one();
+                  });
+  }
+  {
+    // Nothing is acknowledged before the first sync is due
+    std::unique_lock lock(mutex);
+    EXPECT_TRUE(offsets.empty());
+    ASSERT_TRUE(acked.wait_for(lock, std::chrono::seconds(5), [&] { return offsets.size() == 3; }));
+  }
+
+  std::sort(offsets.begin(), offsets.end());
+  EXPECT_EQ(offsets, (std::vector<std::pair<int32_t, int64_t>> {{0, 0}, {1, 0}, {2, 0}}));
+  for (auto thread : threads) {
+    EXPECT_NE(thread, std::this_thread::get_id());
+  }
+  EXPECT_EQ(writer.syncCount(), 1u);
+}
+
+TEST_F(LogWriterTest, RejectedRecordsAreAcknowledgedOnTheCallingThread) {
+  log::LogStore store {io::PathResolver(base_.string())};
+  log::LogWriter writer(store);
+
+  auto batch = makeProducedBatch(1);
+  batch.back() ^= 0xff;
+  bool rejected = false;
+  writer.append("topic", 0, batch, [&rejected](std::expected<AppendResult, StorageError> result) {
+    rejected = !result && result.error().code() == ErrorCode::CorruptMessage;
+  });
+  EXPECT_TRUE(rejected);
+}
+
+TEST_F(LogWriterTest, StopAcknowledgesHeldBackAppendsThenFailsNewOnes) {
+  log::LogStore store {io::PathResolver(base_.string())};
+  log::LogWriter writer(store, {FsyncPolicy::Mode::Interval, std::chrono::hours(1)});
+
+  std::atomic<int64_t> base_offset {-1};
+  writer.append("topic", 0, makeProducedBatch(2),
+                [&base_offset](std::expected<AppendResult, StorageError> result) {
+                  base_offset = result ? result->base_offset : -2;
+                });
+  writer.stop();
+  EXPECT_EQ(base_offset.load(), 0);
+  EXPECT_EQ(writer.syncCount(), 1u);
+
+  auto late = writer.append("topic", 0, makeProducedBatch(1));
+  ASSERT_FALSE(late.has_value());
+  EXPECT_EQ(late.error().code(), ErrorCode::IoError);
+}
+
+TEST_F(LogWriterTest, IntervalPolicyAcknowledgesAfterSync) {
+  log::LogStore store {io::PathResolver(base_.string())};
+  log::LogWriter writer(store, {FsyncPolicy::Mode::Interval, std::chrono::milliseconds(20)});
+
+  for (int i = 0; i < 3; i++) {
+    ASSERT_TRUE(writer.append("topic", 0, makeProducedBatch(1)).has_value());
+    EXPECT_EQ(writer.syncCount(), static_cast<uint64_t>(i + 1));
+  }
+}
+
+TEST_F(LogWriterTest, BytesPolicySyncsOncePastThreshold) {
+  log::LogStore store {io::PathResolver(base_.string())};
+  FsyncPolicy policy {FsyncPolicy::Mode::Bytes};
+  policy.bytes = 200;
+  log::LogWriter writer(store, policy);
+
+  ASSERT_TRUE(writer.append("topic", 0, makeProducedBatch(1)).has_value());
+  ASSERT_TRUE(writer.append("topic", 0, makeProducedBatch(1)).has_value());
+  EXPECT_EQ(writer.syncCount(), 0u);
+  ASSERT_TRUE(writer.append("topic", 0, makeProducedBatch(1)).has_value());
+  EXPECT_EQ(writer.syncCount(), 1u);
+}
+
+TEST_F(LogWriterTest, RejectsCorruptRecordsWithoutWriting) {
+  log::LogStore store {io::PathResolver(base_.string())};
+  log::LogWriter writer(store);
+
+  auto batch = makeProducedBatch(1);
+  batch.back() ^= 0xff;
+  auto appended = writer.append("topic", 0, batch);
+  ASSERT_FALSE(appended.has_value());
+  EXPECT_EQ(appended.error().code(), ErrorCode::CorruptMessage);
+  EXPECT_EQ(writer.writeCount(), 0u);
+}
+
+TEST_F(LogWriterTest, GroupWriteRollsSegments) {
+  log::LogStore store {io::PathResolver(base_.string()), 200};
+  std::vector<log::ValidatedRecords> record_sets;
+  for (int i = 0; i < 5; i++) {
+    auto bytes = makeProducedBatch(2);
+    auto batches = log::validateBatches(bytes);
+    ASSERT_TRUE(batches.has_value());
+    record_sets.push_back({std::move(bytes), std::move(*batches)});
+  }
+
+  auto group = store.appendGroup("topic", 0, record_sets);
+  ASSERT_TRUE(group.has_value());
+  ASSERT_EQ(group->results.size(), 5u);
+  EXPECT_EQ(group->results[4].base_offset, 8);
+  EXPECT_EQ(group->files.size(), 3u);
+  EXPECT_EQ(store.readPartitionRange("topic", 0, 0, 1 << 20)->regions.size(), 3u);
+}
+
+TEST_F(LogWriterTest, GroupCutShortByAFailedRollKeepsTheWrittenPrefix) {
+  log::LogStore store {io::PathResolver(base_.string()), 200};
+  std::vector<log::ValidatedRecords> record_sets;
+  for (int i = 0; i < 5; i++) {
+    auto bytes = makeProducedBatch(2);
+    auto batches = log::validateBatches(bytes);
+    ASSERT_TRUE(batches.has_value());
+    record_sets.push_back({std::move(bytes), std::move(*batches)});
+  }
+
+  // The segment starting at offset 4 cannot be created: its name dangles into a missing directory
+  auto dir = base_ / "topic-0";
+  std::filesystem::create_directories(dir);
+  auto blocked = dir / io::PathResolver::segmentFileName(4);
+  std::filesystem::create_symlink(base_ / "missing" / "segment", blocked);
+
+  auto group = store.appendGroup("topic", 0, record_sets);
+  ASSERT_TRUE(group.has_value());
+  ASSERT_EQ(group->results.size(), 2u);
+  EXPECT_EQ(group->results[1].base_offset, 2);
+  ASSERT_TRUE(group->error.has_value());
+  EXPECT_EQ(group->error->code(), ErrorCode::IoError);
+
+  // A retry of the failed record sets continues after the ones already written
+  std::filesystem::remove(blocked);
+  auto retried = store.append("topic", 0, makeProducedBatch(2));
+  ASSERT_TRUE(retried.has_value());
+  EXPECT_EQ(retried->base_offset, 4);
+}
@@ -39,3 +39,39 @@ TEST(MetadataDecoderTest, TopicRecordValid) {
   EXPECT_EQ(topic.name, "test");
   EXPECT_EQ(static_cast<uint64_t>(topic.topic_id.value), 0u);
 }
+
+TEST(MetadataDecoderTest, TopicRecordLongName) {
+  // A 200-byte name takes a two-byte varint length (201)
+  std::vector<uint8_t> data {0, 0, 0, 0xc9, 0x01};
+  data.insert(data.end(), 200, 'x');
+  data.insert(data.end(), 16, 0);
+  data.back() = 7;
+
+  auto topic = decodeTopicRecord(data);
+  EXPECT_EQ(topic.name, std::string(200, 'x'));
+  EXPECT_EQ(static_cast<uint64_t>(topic.topic_id.value), 7u);
+}
+
+TEST(MetadataDecoderTest, PartitionRecordWithReassignment) {
+  std::vector<uint8_t> data(3 + 4 + 16, 0);
+  data[6] = 2; // partition 2
+  auto array = [&](std::vector<uint8_t> values) {
+    data.push_back(static_cast<uint8_t>(values.size() + 1));
+    for (uint8_t value : values) {
+      data.insert(data.end(), {0, 0, 0, value});
+    }
+  };
+  array({1, 2, 3}); // replicas
+  array({1, 2});    // isr
+  array({3});       // removing
+  array({4, 5});    // adding
+  data.insert(data.end(), {0, 0, 0, 1, 0, 0, 0, 6, 0, 0, 0, 9});
+
+  auto partition = decodePartitionRecord(data);
+  EXPECT_EQ(partition.partition_id, 2);
+  EXPECT_EQ(partition.replicas, (std::vector<int32_t> {1, 2, 3}));
+  EXPECT_EQ(partition.isr, (std::vector<int32_t> {1, 2}));
+  EXPECT_EQ(partition.leader_id, 1);
+  EXPECT_EQ(partition.leader_epoch, 6);
+  EXPECT_EQ(partition.partition_epoch, 9);
+}
@@ -0,0 +1,209 @@
+#include "metadata/metadata_store.hpp"
+#include <arpa/inet.h>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <gtest/gtest.h>
+
+using namespace storage;
+
+namespace {
+
+void putVarint(std::vector<uint8_t> &out, int64_t value) {
+  uint64_t n = (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+  do {
+    uint8_t byte = n & 0x7f;
+    n >>= 7;
+    out.push_back(n ? byte | 0x80 : byte);
+  } while (n);
+}
+
+void putInt32(std::vector<uint8_t> &out, int32_t value) {
+  uint32_t be = htonl(static_cast<uint32_t>(value));
+  out.insert(out.end(), reinterpret_cast<uint8_t *>(&be), reinterpret_cast<uint8_t *>(&be) + 4);
+}
+
+void putUuid(std::vector<uint8_t> &out, uint8_t last) {
+  out.insert(out.end(), 15, 0);
+  out.push_back(last);
+}
+
+std::vector<uint8_t> topicRecord(const std::string &name, uint8_t id) {
+  std::vector<uint8_t> value {1, 2, 0, static_cast<uint8_t>(name.size() + 1)};
+  value.insert(value.end(), name.begin(), name.end());
+  putUuid(value, id);
+  value.push_back(0);
+  return value;
+}
+
+std::vector<uint8_t> partitionRecord(int32_t partition, uint8_t topic_id) {
+  std::vector<uint8_t> value {1, 3, 1};
+  putInt32(value, partition);
+  putUuid(value, topic_id);
+  value.push_back(2);
+  putInt32(value, 1); // replicas
+  value.push_back(2);
+  putInt32(value, 1); // isr
+  value.push_back(1);
+  value.push_back(1);
+  putInt32(value, 1); // leader
+  putInt32(value, 0); // leader epoch
+  putInt32(value, 0); // partition epoch
+  return value;
+}
+
+// Record batch v2 with a null key per record; the CRC is not checked when loading metadata
+std::vector<uint8_t> batch(const std::vector<std::vector<uint8_t>> &values) {
+  std::vector<uint8_t> records;
+  for (size_t i = 0; i < values.size(); i++) {
+    std::vector<uint8_t> body {0};
+    putVarint(body, 0);
+    putVarint(body, static_cast<int64_t>(i));
+    putVarint(body, -1);
+    putVarint(body, static_cast<int64_t>(values[i].size()));
+    body.insert(body.end(), values[i].begin(), values[i].end());
+    putVarint(body, 0);
+    putVarint(records, static_cast<int64_t>(body.size()));
+    records.insert(records.end(), body.begin(), body.end());
+  }
+
+  std::vector<uint8_t> out(61, 0);
+  uint32_t length = htonl(static_cast<uint32_t>(49 + records.size()));
+  uint32_t count = htonl(static_cast<uint32_t>(values.size()));
+  std::memcpy(out.data() + 8, &length, 4);
+  out[16] = 2; // magic
+  std::memcpy(out.data() + 57, &count, 4);
+  out.insert(out.end(), records.begin(), records.end());
+  return out;
+}
+
+// Look at the log on every load, so each test sees its appends straight away
+constexpr std::chrono::milliseconds CHECK_EVERY_CALL {0};
+
+class MetadataStoreTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    base_ = std::filesystem::temp_directory_path() /
+            ("metadata_store_test_" + std::to_string(::getpid()));
+    std::filesystem::create_directories(base_ / "__cluster_metadata-0");
+  }
+
+  void TearDown() override { std::filesystem::remove_all(base_); }
+
+  void append(const std::vector<uint8_t> &bytes,
+              std::ios::openmode mode = std::ios::binary | std::ios::app) {
+    std::ofstream out(base_ / "__cluster_metadata-0" / "00000000000000000000.log", mode);
+    out.write(reinterpret_cast<const char *>(bytes.data()),
+              static_cast<std::streamsize>(bytes.size()));
+  }
+
+  std::filesystem::path base_;
+};
+
+} // namespace
+
+TEST_F(MetadataStoreTest, MissingLogGivesEmptySnapshot) {
+  metadata::MetadataStore store {io::PathResolver("/nonexistent-path-12345")};
+  auto snapshot = store.loadClusterSnapshot();
+  ASSERT_TRUE(snapshot);
+  EXPECT_TRUE((*snapshot)->topics().empty());
+}
+
+TEST_F(MetadataStoreTest, LoadsTopicsAndPartitions) {
+  append(batch({topicRecord("foo", 1), partitionRecord(1, 1), partitionRecord(0, 1)}));
+
+  metadata::MetadataStore store {io::PathResolver(base_.string()), CHECK_EVERY_CALL};
+  auto snapshot = store.loadClusterSnapshot();
+  ASSERT_TRUE(snapshot);
+  ASSERT_EQ((*snapshot)->topics().size(), 1u);
+  const auto *topic = (*snapshot)->findByName("foo");
+  ASSERT_NE(topic, nullptr);
+  EXPECT_EQ(topic, (*snapshot)->findById(TopicId {1}));
+  ASSERT_EQ(topic->partitions.size(), 2u);
+  EXPECT_EQ(topic->partitions[0].partition_id, 0);
+  EXPECT_EQ(topic->partitions[1].partition_id, 1);
+}
+
+TEST_F(MetadataStoreTest, ReusesSnapshotUntilLogGrows) {
+  append(batch({topicRecord("foo", 1), partitionRecord(0, 1)}));
+  metadata::MetadataStore store {io::PathResolver(base_.string()), CHECK_EVERY_CALL};
+  auto first = *store.loadClusterSnapshot();
+  EXPECT_EQ(*store.loadClusterSnapshot(), first);
+
+  append(batch({topicRecord("bar", 2), partitionRecord(0, 2)}));
+  auto second = *store.loadClusterSnapshot();
+  EXPECT_NE(second, first);
+  EXPECT_EQ(first->topics().size(), 1u);
+  EXPECT_EQ(second->topics().size(), 2u);
+}
+
+TEST_F(MetadataStoreTest, WaitsForPartiallyWrittenBatch) {
+  append(batch({topicRecord("foo", 1)}));
+  auto next = batch({topicRecord("bar", 2)});
+  std::vector<uint8_t> head(next.begin(), next.begin() + 20);
+  std::vector<uint8_t> tail(next.begin() + 20, next.end());
+  append(head);
+
+  metadata::MetadataStore store {io::PathResolver(base_.string()), CHECK_EVERY_CALL};
+  EXPECT_EQ((*store.loadClusterSnapshot())->topics().size(), 1u);
+
+  append(tail);
+  EXPECT_EQ((*store.loadClusterSnapshot())->topics().size(), 2u);
+}
+
+TEST_F(MetadataStoreTest, RebuildsWhenANewLogIsRenamedOverTheOld) {
+  append(batch({topicRecord("foo", 1), partitionRecord(0, 1)}));
+  metadata::MetadataStore store {io::PathResolver(base_.string()), CHECK_EVERY_CALL};
+  EXPECT_NE((*store.loadClusterSnapshot())->findByName("foo"), nullptr);
+
+  // Longer than the old log, so its size alone does not give the replacement away
+  auto dir = base_ / "__cluster_metadata-0";
+  {
+    std::ofstream out(dir / "replacement.log", std::ios::binary);
+    for (const auto &bytes : {batch({topicRecord("bar", 2), partitionRecord(0, 2)}),
+                              batch({topicRecord("baz", 3)})}) {
+      out.write(reinterpret_cast<const char *>(bytes.data()),
+                static_cast<std::streamsize>(bytes.size()));
+    }
+  }
+  std::filesystem::rename(dir / "replacement.log", dir / "00000000000000000000.log");
+
+  auto snapshot = *store.loadClusterSnapshot();
+  EXPECT_EQ(snapshot->topics().size(), 2u);
+  EXPECT_EQ(snapshot->findByName("foo"), nullptr);
+  EXPECT_NE(snapshot->findByName("bar"), nullptr);
+  EXPECT_NE(snapshot->findByName("baz"), nullptr);
+}
+
+TEST_F(MetadataStoreTest, FailedRebuildStartsOverFromEmpty) {
+  append(batch({topicRecord("foo", 1), partitionRecord(0, 1)}));
+  metadata::MetadataStore store {io::PathResolver(base_.string()), CHECK_EVERY_CALL};
+  EXPECT_NE((*store.loadClusterSnapshot())->findByName("foo"), nullptr);
+
+  // The replacement holds a topic record cut off after its header
+  auto dir = base_ / "__cluster_metadata-0";
+  {
+    auto bytes = batch({{1, 2, 0}});
+    std::ofstream out(dir / "replacement.log", std::ios::binary);
+    out.write(reinterpret_cast<const char *>(bytes.data()),
+              static_cast<std::streamsize>(bytes.size()));
+  }
+  std::filesystem::rename(dir / "replacement.log", dir / "00000000000000000000.log");
+  EXPECT_FALSE(store.loadClusterSnapshot().has_value());
+
+  // Rewritten in place, so only the pending rebuild says the old topics are gone
+  append(batch({topicRecord("bar", 2)}), std::ios::binary | std::ios::trunc);
+  auto snapshot = *store.loadClusterSnapshot();
+  EXPECT_EQ(snapshot->findByName("foo"), nullptr);
+  EXPECT_NE(snapshot->findByName("bar"), nullptr);
+}
+
+TEST_F(MetadataStoreTest, ChecksTheLogAtMostOncePerInterval) {
+  append(batch({topicRecord("foo", 1)}));
+  metadata::MetadataStore store {io::PathResolver(base_.string()), std::chrono::hours(1)};
+  auto first = *store.loadClusterSnapshot();
+
+  append(batch({topicRecord("bar", 2)}));
+  EXPECT_EQ(*store.loadClusterSnapshot(), first);
+}
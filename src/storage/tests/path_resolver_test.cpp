@@ -14,3 +14,18 @@ TEST(PathResolverTest, PartitionLogPath) {
   EXPECT_EQ(resolver.partitionLogPath("my-topic", 0), "/data/my-topic-0/00000000000000000000.log");
   EXPECT_EQ(resolver.partitionLogPath("test", 5), "/data/test-5/00000000000000000000.log");
 }
+
+TEST(PathResolverTest, SegmentLogPath) {
+  PathResolver resolver("/data");
+  EXPECT_EQ(resolver.partitionDir("t", 1), "/data/t-1");
+  EXPECT_EQ(resolver.segmentLogPath("t", 1, 4096), "/data/t-1/00000000000000004096.log");
+}
+
+TEST(PathResolverTest, ParseSegmentFileName) {
+  EXPECT_EQ(PathResolver::parseSegmentFileName("00000000000000004096.log"), 4096);
+  EXPECT_EQ(PathResolver::parseSegmentFileName(PathResolver::segmentFileName(123456789)),
+            123456789);
+  EXPECT_FALSE(PathResolver::parseSegmentFileName("00000000000000004096.index").has_value());
+  EXPECT_FALSE(PathResolver::parseSegmentFileName("0000000000000000409x.log").has_value());
+  EXPECT_FALSE(PathResolver::parseSegmentFileName("leader-epoch-checkpoint").has_value());
+}
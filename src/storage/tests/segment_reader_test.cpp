@@ -0,0 +1,125 @@
+#include "io/file_handle.hpp"
+#include "io/mapped_file.hpp"
+#include "log/segment_reader.hpp"
+#include <arpa/inet.h>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <unistd.h>
+#include <vector>
+
+using namespace storage;
+
+namespace {
+
+// Batch header with `record_count` offsets from `base_offset`, padded to `size` bytes in total
+std::vector<uint8_t> makeBatch(int64_t base_offset, int32_t record_count, size_t size = 80) {
+  std::vector<uint8_t> batch(size, static_cast<uint8_t>(base_offset));
+  uint64_t offset_be = (static_cast<uint64_t>(htonl(static_cast<uint32_t>(base_offset))) << 32) |
+                       htonl(static_cast<uint32_t>(base_offset >> 32));
+  uint32_t length_be = htonl(static_cast<uint32_t>(size - 12));
+  uint32_t delta_be = htonl(static_cast<uint32_t>(record_count - 1));
+  std::memcpy(batch.data(), &offset_be, 8);
+  std::memcpy(batch.data() + 8, &length_be, 4);
+  std::memcpy(batch.data() + 23, &delta_be, 4);
+  return batch;
+}
+
+class SegmentReaderTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    path_ = std::filesystem::temp_directory_path() /
+            ("segment_reader_test_" + std::to_string(::getpid()) + ".log");
+    std::ofstream(path_, std::ios::binary | std::ios::trunc);
+  }
+
+  void TearDown() override { std::filesystem::remove(path_); }
+
+  void append(const std::vector<uint8_t> &bytes) {
+    std::ofstream out(path_, std::ios::binary | std::ios::app);
+    out.write(reinterpret_cast<const char *>(bytes.data()),
+              static_cast<std::streamsize>(bytes.size()));
+  }
+
+  std::filesystem::path path_;
+};
+
+} // namespace
+
+TEST_F(SegmentReaderTest, WalksBatchesInPlace) {
+  auto first = makeBatch(0, 3);
+  auto second = makeBatch(3, 2, 120);
+  append(first);
+  append(second);
+
+  io::FileHandle file(path_.string());
+  io::MappedFile mapped;
+  ASSERT_TRUE(mapped.map(file, file.size()));
+  mapped.advise(io::MappedFile::Access::Sequential);
+
+  log::SegmentReader reader(mapped.bytes());
+  auto batch = reader.next();
+  ASSERT_TRUE(batch);
+  EXPECT_EQ(batch->header.base_offset, 0);
+  EXPECT_EQ(batch->header.last_offset, 2);
+  EXPECT_EQ(batch->position, 0u);
+  EXPECT_EQ(batch->bytes.data(), mapped.bytes().data());
+  EXPECT_TRUE(std::equal(batch->bytes.begin(), batch->bytes.end(), first.begin(), first.end()));
+
+  batch = reader.next();
+  ASSERT_TRUE(batch);
+  EXPECT_EQ(batch->header.base_offset, 3);
+  EXPECT_EQ(batch->position, first.size());
+  EXPECT_EQ(batch->bytes.size(), second.size());
+
+  EXPECT_FALSE(reader.next());
+  EXPECT_EQ(reader.position(), first.size() + second.size());
+}
+
+TEST_F(SegmentReaderTest, StopsBeforePartialBatch) {
+  append(makeBatch(0, 1));
+  auto partial = makeBatch(1, 1);
+  partial.resize(40);
+  append(partial);
+
+  io::FileHandle file(path_.string());
+  io::MappedFile mapped;
+  ASSERT_TRUE(mapped.map(file, file.size()));
+
+  log::SegmentReader reader(mapped.bytes());
+  EXPECT_TRUE(reader.next());
+  EXPECT_FALSE(reader.next());
+  EXPECT_EQ(reader.position(), 80u);
+}
+
+TEST_F(SegmentReaderTest, MappingGrowsWithTheFile) {
+  append(makeBatch(0, 1));
+  io::FileHandle file(path_.string());
+  io::MappedFile mapped;
+  ASSERT_TRUE(mapped.map(file, file.size()));
+  EXPECT_EQ(mapped.size(), 80u);
+
+  // Past a page boundary, so the mapping has to move or grow
+  for (int64_t offset = 1; offset < 100; offset++) {
+    append(makeBatch(offset, 1));
+  }
+  ASSERT_TRUE(mapped.map(file, file.size()));
+  EXPECT_EQ(mapped.size(), 8000u);
+
+  log::SegmentReader reader(mapped.bytes(), 80);
+  int64_t expected = 1;
+  while (auto batch = reader.next()) {
+    EXPECT_EQ(batch->header.base_offset, expected++);
+    EXPECT_EQ(batch->bytes.back(), static_cast<uint8_t>(batch->header.base_offset));
+  }
+  EXPECT_EQ(expected, 100);
+}
+
+TEST_F(SegmentReaderTest, EmptyFileMapsToNothing) {
+  io::FileHandle file(path_.string());
+  io::MappedFile mapped;
+  ASSERT_TRUE(mapped.map(file, file.size()));
+  EXPECT_TRUE(mapped.bytes().empty());
+  EXPECT_FALSE(log::SegmentReader(mapped.bytes()).next());
+}
@@ -7,7 +7,7 @@ TEST(StorageServiceTest, CreateAndLoadEmptySnapshot) {
 
   auto snapshot = service->loadClusterSnapshot();
   ASSERT_TRUE(snapshot);
-  EXPECT_TRUE(snapshot->topics_by_id.empty());
+  EXPECT_TRUE((*snapshot)->topics().empty());
 }
 
 TEST(StorageServiceTest, FindTopicByNameEmptySnapshot) {
@@ -15,8 +15,8 @@ TEST(StorageServiceTest, FindTopicByNameEmptySnapshot) {
   auto snapshot = service->loadClusterSnapshot();
   ASSERT_TRUE(snapshot);
 
-  auto topic = service->findTopicByName(*snapshot, "nonexistent");
-  EXPECT_FALSE(topic.has_value());
+  auto topic = service->findTopicByName(**snapshot, "nonexistent");
+  EXPECT_EQ(topic, nullptr);
 }
 
 TEST(StorageServiceTest, ReadPartitionDataMissingFile) {